@@ -0,0 +1,334 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <map>
+#include <numeric>
+#include <string_view>
+#include <type_traits>
+#include <utilities/dsl/evaluator.hpp>
+#include <utilities/timer.hpp>
+#include <utility>
+#include <vector>
+
+namespace utilities::dsl {
+
+/// The estimated cost of evaluating a node, or a set of nodes
+struct CostEstimate {
+    /// The number of floating-point operations
+    double flops = 0.0;
+
+    /// The number of bytes read and written
+    double bytes = 0.0;
+
+    /// The size, in bytes, of the value the node makes
+    double memory = 0.0;
+
+    /// Adds the costs of @p rhs to *this
+    CostEstimate& operator+=(const CostEstimate& rhs) noexcept {
+        flops += rhs.flops;
+        bytes += rhs.bytes;
+        memory += rhs.memory;
+        return *this;
+    }
+
+    /// Are the costs of *this and @p rhs the same?
+    bool operator==(const CostEstimate& rhs) const noexcept {
+        return flops == rhs.flops && bytes == rhs.bytes &&
+               memory == rhs.memory;
+    }
+
+    /// Are the costs of *this and @p rhs different?
+    bool operator!=(const CostEstimate& rhs) const noexcept {
+        return !((*this) == rhs);
+    }
+};
+
+/// The estimated costs of evaluating a DAG, see estimate_cost
+struct CostReport {
+    /// Element i is the estimate for node i of the DAG
+    std::vector<CostEstimate> nodes;
+
+    /// The sum of the estimates of the nodes
+    CostEstimate total;
+
+    /// The most memory the values of the nodes occupy at any one time
+    double peak_memory = 0.0;
+
+    /** @brief The flops of each node.
+     *
+     *  @return The flops of the nodes, in the form expected by
+     *          ParallelOptions::costs.
+     *
+     *  @throw std::bad_alloc if there is a problem allocating the result.
+     *                        Strong throw guarantee.
+     */
+    std::vector<double> flops() const {
+        std::vector<double> rv;
+        rv.reserve(nodes.size());
+        for(const auto& node : nodes) rv.push_back(node.flops);
+        return rv;
+    }
+};
+
+/** @brief Estimates the cost of evaluating @p dag.
+ *
+ *  @tparam DAGType The type of the DAG.
+ *  @tparam CostModelType The type of the user's cost model.
+ *
+ *  The DSL does not know what the leaves are, so the costs come from
+ *  @p model. Like the model of reorder_multiply_chains, it describes each
+ *  value by a "shape", an object of any (copyable) type which it chooses,
+ *  e.g., the dimensions of a matrix. It must provide:
+ *
+ *  - `shape(dag, i)`, the shape of the (non-operation) leaf or constant
+ *    node `i`,
+ *  - `result(dag, i, args)`, the shape of the value of the operation node
+ *    `i`, where `args` is an `std::vector` of the shapes of its children,
+ *    and
+ *  - `estimate(dag, i, args, shape)`, a CostEstimate for node `i` whose
+ *    value has shape `shape`. For leaves and constants `args` is empty; the
+ *    Evaluator copies them into a buffer, which may or may not be worth
+ *    counting.
+ *
+ *  The nodes are visited once, in the order the Evaluator evaluates them.
+ *  The peak memory is found by replaying that order: the value of a node is
+ *  live from when it is made until its last user has been evaluated. This
+ *  ignores the in-place kernels, which reuse the memory of their left
+ *  operand, so it is an upper bound.
+ *
+ *  @param[in] dag The (non-empty) DAG to estimate the cost of.
+ *  @param[in] model The cost model.
+ *
+ *  @return The per-node estimates and their totals.
+ *
+ *  @throw std::bad_alloc if there is a problem allocating the report.
+ *                        Strong throw guarantee.
+ *  @throw ??? Throws if @p model throws. Strong throw guarantee.
+ */
+template<typename DAGType, typename CostModelType>
+CostReport estimate_cost(const DAGType& dag, CostModelType& model) {
+    using size_type  = typename DAGType::size_type;
+    using shape_type = std::decay_t<decltype(model.shape(dag, size_type{}))>;
+
+    const auto n = dag.size();
+    CostReport rv;
+    rv.nodes.reserve(n);
+
+    // The DAG is topologically sorted, so shapes[c] exists when needed
+    std::vector<shape_type> shapes;
+    shapes.reserve(n);
+    std::vector<shape_type> args;
+    std::vector<size_type> remaining(n);
+    for(size_type i = 0; i < n; ++i) remaining[i] = dag.use_count(i);
+
+    double live = 0.0;
+    for(size_type i = 0; i < n; ++i) {
+        args.clear();
+        for(size_type j = 0; j < dag.n_children(i); ++j)
+            args.push_back(shapes[dag.child(i, j)]);
+
+        const bool is_operation = dag.kind(i) != NodeKind::leaf;
+        if(is_operation)
+            shapes.push_back(model.result(dag, i, args));
+        else
+            shapes.push_back(model.shape(dag, i));
+
+        const auto estimate = model.estimate(dag, i, args, shapes.back());
+        rv.nodes.push_back(estimate);
+        rv.total += estimate;
+
+        // The children are released after the node is made
+        live += estimate.memory;
+        rv.peak_memory = std::max(rv.peak_memory, live);
+        for(size_type j = 0; j < dag.n_children(i); ++j) {
+            const auto c = dag.child(i, j);
+            if(--remaining[c] == 0) live -= rv.nodes[c].memory;
+        }
+    }
+    return rv;
+}
+
+/// How well the estimates of a CostReport predicted the measured times
+struct CostCalibration {
+    /// Type used for indexing
+    using size_type = std::size_t;
+
+    /// The fitted cost of a flop, in seconds
+    double seconds_per_flop = 0.0;
+
+    /// The fitted cost of moving a byte, in seconds
+    double seconds_per_byte = 0.0;
+
+    /// Element i is the measured time of node i, in seconds
+    std::vector<double> measured;
+
+    /// Element i is the time node i was predicted to take, in seconds
+    std::vector<double> predicted;
+
+    /// Element i is true if node i was timed
+    std::vector<bool> timed;
+
+    /// The time, in seconds, the fit predicts for @p estimate
+    double predict(const CostEstimate& estimate) const noexcept {
+        return seconds_per_flop * estimate.flops +
+               seconds_per_byte * estimate.bytes;
+    }
+
+    /** @brief The timed nodes, the most mispredicted first.
+     *
+     *  Nodes are ranked by the absolute difference between their measured
+     *  and predicted times, so the nodes at the front are the ones where
+     *  the model is most wrong about where the time goes.
+     *
+     *  @return The indices of the timed nodes.
+     *
+     *  @throw std::bad_alloc if there is a problem allocating the result.
+     *                        Strong throw guarantee.
+     */
+    std::vector<size_type> mispredicted() const {
+        std::vector<size_type> rv;
+        for(size_type i = 0; i < timed.size(); ++i)
+            if(timed[i]) rv.push_back(i);
+        auto error = [this](size_type i) {
+            return std::abs(measured[i] - predicted[i]);
+        };
+        std::stable_sort(rv.begin(), rv.end(), [&](size_type l, size_type r) {
+            return error(l) > error(r);
+        });
+        return rv;
+    }
+};
+
+/** @brief Fits the estimates of @p report to measured times.
+ *
+ *  The time of each node is modeled as
+ *  `seconds_per_flop * flops + seconds_per_byte * bytes`, and the two
+ *  coefficients are found by (non-negative) least squares over the timed
+ *  nodes. The fitted coefficients calibrate the model for the machine, and
+ *  the nodes whose times are predicted worst (see
+ *  CostCalibration::mispredicted) point to where the model, or the kernels,
+ *  need attention.
+ *
+ *  @param[in] report The estimates for the DAG.
+ *  @param[in] seconds Maps the index of a node to its measured time, in
+ *                     seconds. Nodes which are not in @p seconds are
+ *                     untimed and indices not in @p report are ignored.
+ *
+ *  @return The fit, and the measured and predicted times of each node.
+ *
+ *  @throw std::bad_alloc if there is a problem allocating the result.
+ *                        Strong throw guarantee.
+ */
+inline CostCalibration calibrate(const CostReport& report,
+                                 const std::map<std::size_t, double>& seconds) {
+    using size_type = CostCalibration::size_type;
+
+    const auto n = report.nodes.size();
+    CostCalibration rv;
+    rv.measured.assign(n, 0.0);
+    rv.predicted.assign(n, 0.0);
+    rv.timed.assign(n, false);
+
+    for(const auto& [i, t] : seconds) {
+        if(i >= n) continue;
+        rv.measured[i] = t;
+        rv.timed[i]    = true;
+    }
+
+    // Normal equations of the two-parameter least-squares fit
+    double ff = 0.0, fb = 0.0, bb = 0.0, ft = 0.0, bt = 0.0, tt = 0.0;
+    for(size_type i = 0; i < n; ++i) {
+        if(!rv.timed[i]) continue;
+        const auto f = report.nodes[i].flops;
+        const auto b = report.nodes[i].bytes;
+        const auto t = rv.measured[i];
+        ff += f * f, fb += f * b, bb += b * b;
+        ft += f * t, bt += b * t, tt += t * t;
+    }
+
+    // Sum of the squared residuals for coefficients a and b
+    auto residual = [&](double a, double b) {
+        return tt - 2.0 * (a * ft + b * bt) + a * a * ff + 2.0 * a * b * fb +
+               b * b * bb;
+    };
+
+    // Either coefficient alone, keeping whichever fits better
+    const double a1 = ff > 0.0 ? std::max(ft / ff, 0.0) : 0.0;
+    const double b1 = bb > 0.0 ? std::max(bt / bb, 0.0) : 0.0;
+    if(residual(a1, 0.0) <= residual(0.0, b1)) {
+        rv.seconds_per_flop = a1;
+    } else {
+        rv.seconds_per_byte = b1;
+    }
+
+    // Both, if flops and bytes are independent and both coefficients are
+    // physical (non-negative)
+    const auto det = ff * bb - fb * fb;
+    if(det > 1e-12 * ff * bb) {
+        const auto a = (ft * bb - bt * fb) / det;
+        const auto b = (bt * ff - ft * fb) / det;
+        if(a >= 0.0 && b >= 0.0) {
+            rv.seconds_per_flop = a;
+            rv.seconds_per_byte = b;
+        }
+    }
+
+    for(size_type i = 0; i < n; ++i)
+        rv.predicted[i] = rv.predict(report.nodes[i]);
+    return rv;
+}
+
+/** @brief Fits the estimates of @p report to the timings in @p timer.
+ *
+ *  @p timer should have been filled by `Evaluator::evaluate(dag, timer)`
+ *  for the DAG @p report is for; timings whose keys are not of the form
+ *  made by dag_timer_key are ignored. The remaining timings are fitted as
+ *  described by the overload taking the times of the nodes.
+ *
+ *  @param[in] report The estimates for the DAG.
+ *  @param[in] timer The timings of the DAG's nodes.
+ *
+ *  @return The fit, and the measured and predicted times of each node.
+ *
+ *  @throw std::bad_alloc if there is a problem allocating the result.
+ *                        Strong throw guarantee.
+ */
+inline CostCalibration calibrate(const CostReport& report,
+                                 const Timer& timer) {
+    using seconds_type = std::chrono::duration<double>;
+
+    std::map<std::size_t, double> seconds;
+    constexpr std::string_view prefix = "node ";
+    for(const auto& [desc, dt] : timer) {
+        std::string_view key(desc);
+        if(key.substr(0, prefix.size()) != prefix) continue;
+        key.remove_prefix(prefix.size());
+        std::size_t i      = 0;
+        const auto end     = key.data() + key.size();
+        const auto [p, ec] = std::from_chars(key.data(), end, i);
+        if(ec != std::errc{} || p != end) continue;
+        seconds[i] = std::chrono::duration_cast<seconds_type>(dt).count();
+    }
+    return calibrate(report, seconds);
+}
+
+} // namespace utilities::dsl
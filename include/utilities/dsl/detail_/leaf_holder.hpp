@@ -15,11 +15,45 @@
  */
 
 #pragma once
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <type_traits>
+#include <utility>
 
 namespace utilities::dsl::detail_ {
 
+/// Type of the identifiers returned by type_id
+using type_id_type = const void*;
+
+/** @brief Each specialization has its own (unique) static member.
+ *
+ *  The member is deliberately NOT const. Linkers may merge identical
+ *  read-only constants (identical COMDAT folding), which would give two
+ *  types the same address, but they never merge writable data.
+ */
+template<typename T>
+struct TypeIdTag {
+    inline static char value = 0;
+};
+
+/** @brief Returns an identifier for @p T which is cheap to compare.
+ *
+ *  Comparing `typeid`s means a virtual call (to get the object's type_info)
+ *  and, on some platforms, a string comparison. The identifier returned here
+ *  is the address of a per-type variable, so comparing two of them is a
+ *  single pointer comparison.
+ *
+ *  @note Across shared library boundaries (e.g., with hidden visibility) a
+ *        type may end up with more than one identifier. Code using type_id
+ *        should therefore treat different identifiers as "maybe different"
+ *        and fall back to RTTI.
+ */
+template<typename T>
+constexpr type_id_type type_id() noexcept {
+    return &TypeIdTag<T>::value;
+}
+
 /** @brief Defines API for interacting with type-erased leaf objects.
  *
  *  Leaves of the DSL are held in a type-erased state. This class defines the
@@ -37,11 +71,62 @@ public:
     /// Deep polymorphic copy ctor
     leaf_pointer clone() const { return clone_(); }
 
+    /** @brief Deep polymorphic copy into caller-provided storage.
+     *
+     *  @param[in] buffer Where to construct the copy. Must be large enough,
+     *                    and suitably aligned, for the most derived type of
+     *                    *this.
+     *
+     *  @return A pointer to the copy. The caller is responsible for calling
+     *          its destructor (but not for freeing it).
+     *
+     *  @throw ??? if copying the wrapped object throws. Strong throw
+     *             guarantee.
+     */
+    LeafHolderBase* clone_into(void* buffer) const {
+        return clone_into_(buffer);
+    }
+
+    /** @brief Polymorphic move into caller-provided storage.
+     *
+     *  Only used for holders whose move ctor does not throw.
+     *
+     *  @param[in] buffer Where to construct the new holder. Must be large
+     *                    enough, and suitably aligned, for the most derived
+     *                    type of *this.
+     *
+     *  @return A pointer to the new holder. *this is left in a valid, but
+     *          otherwise unspecified state.
+     *
+     *  @throw None No throw guarantee.
+     */
+    LeafHolderBase* move_into(void* buffer) noexcept {
+        return move_into_(buffer);
+    }
+
     /// Polymorphic value comparison
     bool are_equal(const LeafHolderBase& rhs) const noexcept {
+        if(m_type_id_ == rhs.m_type_id_) return are_equal_(rhs);
         return are_equal_(rhs) && rhs.are_equal_(*this);
     }
 
+    /// The size (in bytes) of the most derived type of *this
+    std::size_t holder_size() const noexcept { return holder_size_(); }
+
+    /// The alignment of the most derived type of *this
+    std::size_t holder_alignment() const noexcept {
+        return holder_alignment_();
+    }
+
+    /// Identifies the unqualified type of the wrapped object, see type_id
+    type_id_type type_id() const noexcept { return m_type_id_; }
+
+    /// Is the wrapped object read-only?
+    bool holds_const() const noexcept { return m_is_const_; }
+
+    /// Does *this alias the wrapped object (rather than own a copy of it)?
+    bool is_alias() const noexcept { return m_is_alias_; }
+
     /** @brief Used to determine if *this contains an object of type @p T.
      *
      *  @tparam The cv-qualified type to look for.
@@ -59,6 +144,8 @@ public:
      */
     template<typename T>
     bool contains_type() const noexcept {
+        if(m_type_id_ == detail_::type_id<std::decay_t<T>>())
+            return m_is_const_ == std::is_const_v<T>;
         return contains_type_(std::is_const_v<T>, typeid(T));
     }
 
@@ -79,6 +166,8 @@ public:
      */
     template<typename T>
     bool is_convertible() const noexcept {
+        if(m_type_id_ == detail_::type_id<std::decay_t<T>>())
+            return std::is_const_v<T> || !m_is_const_;
         return is_convertible_(std::is_const_v<T>, typeid(T));
     }
 
@@ -88,9 +177,11 @@ protected:
 
     /// Instances of LeafHolderBase will always be created by derived class
     ///@{
-    LeafHolderBase()                      = default;
+    LeafHolderBase(type_id_type type, bool is_const,
+                   bool is_alias = false) noexcept :
+      m_type_id_(type), m_is_const_(is_const), m_is_alias_(is_alias) {}
     LeafHolderBase(const LeafHolderBase&) = default;
-    LeafHolderBase(LeafHolderBase&&)      = delete;
+    LeafHolderBase(LeafHolderBase&&)      = default;
     LeafHolderBase& operator=(const LeafHolderBase&) = delete;
     LeafHolderBase& operator=(LeafHolderBase&&) = delete;
     ///@}
@@ -98,6 +189,18 @@ protected:
     /// Derived class overrides to implement clone. See clone description.
     virtual leaf_pointer clone_() const = 0;
 
+    /// Derived class overrides to implement clone_into
+    virtual LeafHolderBase* clone_into_(void* buffer) const = 0;
+
+    /// Derived class overrides to implement move_into
+    virtual LeafHolderBase* move_into_(void* buffer) noexcept = 0;
+
+    /// Derived class overrides to implement holder_size
+    virtual std::size_t holder_size_() const noexcept = 0;
+
+    /// Derived class overrides to implement holder_alignment
+    virtual std::size_t holder_alignment_() const noexcept = 0;
+
     /// Derived class overrides to implement are_equal. See are_equal desc.
     virtual bool are_equal_(const LeafHolderBase& rhs) const noexcept = 0;
 
@@ -108,6 +211,16 @@ protected:
     /// Derived class overrides to implement is_convertible
     virtual bool is_convertible_(bool is_const,
                                  const rtti_type& type) const noexcept = 0;
+
+private:
+    /// The result of type_id for the unqualified type of the wrapped object
+    type_id_type m_type_id_;
+
+    /// Is the wrapped object const?
+    bool m_is_const_;
+
+    /// Is the wrapped object aliased?
+    bool m_is_alias_;
 };
 
 /** @brief API for interacting with the leaf when its type is known.
@@ -170,13 +283,21 @@ public:
     const_reference value() const { return value_(); }
 
 protected:
-    LeafHolder() {
+    explicit LeafHolder(bool is_alias = false) :
+      LeafHolderBase(detail_::type_id<value_type>(), is_const, is_alias) {
         // This class shouldn't have references
         static_assert(std::is_same_v<std::remove_reference_t<T>, T>);
     }
 
     /// Implements are_equal by downcasting and comparing returns of value()
     bool are_equal_(const LeafHolderBase& rhs) const noexcept override {
+        // Fast path, we know the type so we can downcast statically
+        if(rhs.type_id() == type_id()) {
+            if(rhs.holds_const())
+                return value() == downcast_<const value_type>(rhs).value();
+            return value() == downcast_<value_type>(rhs).value();
+        }
+
         using mutable_type = LeafHolder<value_type>;
         auto prhs          = dynamic_cast<const mutable_type*>(&rhs);
         if(prhs != nullptr) return value() == prhs->value();
@@ -202,6 +323,12 @@ protected:
         return contains_type_(is_const, type);
     }
 
+    /// Casts @p rhs, which must hold a @p U, to a LeafHolder<U>
+    template<typename U>
+    static const LeafHolder<U>& downcast_(const LeafHolderBase& rhs) noexcept {
+        return static_cast<const LeafHolder<U>&>(rhs);
+    }
+
     /// Derived class should override to implement value
     ///@{
     virtual reference value_()             = 0;
@@ -250,7 +377,7 @@ public:
 
     /// Creates a holder which alias @p value if @p T is an lvalue type.
     explicit QualifiedLeafHolder(T value) :
-      m_value_(make_holder_(std::forward<T>(value))) {}
+      base_type(is_lvalue), m_value_(make_holder_(std::forward<T>(value))) {}
 
     /// Determines if the value in *this compares equal to the value in @p rhs.
     bool operator==(const QualifiedLeafHolder& rhs) const noexcept {
@@ -271,6 +398,26 @@ protected:
         return std::make_unique<my_type>(*this);
     }
 
+    /// Implements clone_into by calling object's copy ctor
+    LeafHolderBase* clone_into_(void* buffer) const override {
+        return ::new(buffer) my_type(*this);
+    }
+
+    /// Implements move_into by calling object's move ctor
+    LeafHolderBase* move_into_(void* buffer) noexcept override {
+        return ::new(buffer) my_type(std::move(*this));
+    }
+
+    /// Implements holder_size
+    std::size_t holder_size_() const noexcept override {
+        return sizeof(my_type);
+    }
+
+    /// Implements holder_alignment
+    std::size_t holder_alignment_() const noexcept override {
+        return alignof(my_type);
+    }
+
     /// Implements value by appropriately unwrapping the holder
     reference value_() override { return unwrap_holder_(m_value_); }
 
@@ -17,9 +17,22 @@
 #pragma once
 #include <utilities/dsl/add.hpp>
 #include <utilities/dsl/binary_op.hpp>
+#include <utilities/dsl/cost_estimate.hpp>
 #include <utilities/dsl/divide.hpp>
+#include <utilities/dsl/evaluation_cache.hpp>
+#include <utilities/dsl/evaluator.hpp>
+#include <utilities/dsl/expression_arena.hpp>
+#include <utilities/dsl/expression_dag.hpp>
+#include <utilities/dsl/flatten.hpp>
 #include <utilities/dsl/function_call.hpp>
 #include <utilities/dsl/multiply.hpp>
+#include <utilities/dsl/multiply_chain.hpp>
 #include <utilities/dsl/n_ary_op.hpp>
+#include <utilities/dsl/product.hpp>
+#include <utilities/dsl/serialization.hpp>
+#include <utilities/dsl/simplify.hpp>
+#include <utilities/dsl/static_op.hpp>
+#include <utilities/dsl/structural_hash.hpp>
 #include <utilities/dsl/subtract.hpp>
+#include <utilities/dsl/sum.hpp>
 #include <utilities/dsl/term.hpp>
\ No newline at end of file
@@ -34,15 +34,24 @@ class BinaryOp;
 template<typename LHSType, typename RHSType>
 class Divide;
 
+template<typename... Args>
+class FunctionCall;
+
 template<typename LHSType, typename RHSType>
 class Multiply;
 
 template<typename DerivedType, typename... Args>
 class NAryOp;
 
+template<typename... Args>
+class Product;
+
 template<typename LHSType, typename RHSType>
 class Subtract;
 
+template<typename... Args>
+class Sum;
+
 template<typename DerivedType>
 class Term;
 
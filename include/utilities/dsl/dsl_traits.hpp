@@ -29,4 +29,47 @@ struct IsTerm<Term<T>> : public std::true_type {};
 template<typename T>
 constexpr bool is_term_v = IsTerm<T>::value;
 
+/// The kinds of nodes an expression tree can contain
+enum class NodeKind { leaf, add, subtract, multiply, divide, function_call };
+
+/** @brief Works out which kind of node @p T is.
+ *
+ *  The primary template is used for anything which is not one of the DSL's
+ *  operations, i.e., anything which is a leaf of the tree.
+ */
+template<typename T>
+struct NodeKindOf : std::integral_constant<NodeKind, NodeKind::leaf> {};
+
+template<typename LHSType, typename RHSType>
+struct NodeKindOf<Add<LHSType, RHSType>>
+  : std::integral_constant<NodeKind, NodeKind::add> {};
+
+template<typename LHSType, typename RHSType>
+struct NodeKindOf<Subtract<LHSType, RHSType>>
+  : std::integral_constant<NodeKind, NodeKind::subtract> {};
+
+template<typename LHSType, typename RHSType>
+struct NodeKindOf<Multiply<LHSType, RHSType>>
+  : std::integral_constant<NodeKind, NodeKind::multiply> {};
+
+template<typename LHSType, typename RHSType>
+struct NodeKindOf<Divide<LHSType, RHSType>>
+  : std::integral_constant<NodeKind, NodeKind::divide> {};
+
+template<typename... Args>
+struct NodeKindOf<Sum<Args...>>
+  : std::integral_constant<NodeKind, NodeKind::add> {};
+
+template<typename... Args>
+struct NodeKindOf<Product<Args...>>
+  : std::integral_constant<NodeKind, NodeKind::multiply> {};
+
+template<typename... Args>
+struct NodeKindOf<FunctionCall<Args...>>
+  : std::integral_constant<NodeKind, NodeKind::function_call> {};
+
+/// The NodeKind of @p T (cv-qualifiers are ignored)
+template<typename T>
+constexpr NodeKind node_kind_v = NodeKindOf<std::remove_cv_t<T>>::value;
+
 } // namespace utilities::dsl
\ No newline at end of file
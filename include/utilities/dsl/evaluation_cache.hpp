@@ -0,0 +1,332 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utilities/dsl/evaluator.hpp>
+#include <utilities/dsl/structural_hash.hpp>
+#include <vector>
+
+namespace utilities::dsl {
+
+/** @brief Remembers the values of subexpressions between evaluations.
+ *
+ *  @tparam EvaluatorType The type of the Evaluator whose kernels are used.
+ *
+ *  Iterative algorithms evaluate the same expression over and over, usually
+ *  with only some of the leaves changing between iterations. EvaluationCache
+ *  stores the value of every operation it evaluates, keyed by the node's
+ *  structural hash (see structural_hash.hpp) combined with the version
+ *  stamps of the leaves below it. When the expression is evaluated again,
+ *  only the operations whose keys are not in the cache, i.e., those on the
+ *  paths from the changed leaves to the root, are recomputed; the children
+ *  of a cached operation are not re-evaluated. Computing the keys is linear
+ *  in the size of the DAG, and evaluating an expression (rather than a DAG)
+ *  also walks and hashes the whole tree to make the DAG. Callers evaluating
+ *  the same expression repeatedly should make the DAG once and evaluate it;
+ *  the keys pick up version stamps bumped since the DAG was made.
+ *
+ *  The DSL aliases leaves, so it can not tell when one is modified. Users
+ *  must call `mark_changed(leaf)` after modifying a leaf, which bumps the
+ *  leaf's version stamp. This includes literals (doubles and strings) the
+ *  expression aliases, e.g., `alpha` in `alpha * A`, which are leaves of the
+ *  DAG (see make_dag). Literals the expression owns are part of the
+ *  structural hash (and the DAG), so changing them means making a new
+ *  expression and needs no stamp.
+ *
+ *  The cache has a memory budget. The size of a value is measured by a
+ *  user-supplied function (`sizeof(result_type)` by default) and, once an
+ *  evaluation finishes, the least recently used values are evicted until the
+ *  budget is met. The result of the most recent evaluation is always kept.
+ *
+ *  Keys are 64-bit hashes, so, as with any hash-consing scheme, two
+ *  different subexpressions whose keys collide would share a value.
+ */
+template<typename EvaluatorType>
+class EvaluationCache {
+public:
+    /// Type of the Evaluator whose kernels are used
+    using evaluator_type = EvaluatorType;
+
+    /// Type of the values
+    using result_type = typename evaluator_type::result_type;
+
+    /// Type used for counting and sizes
+    using size_type = std::size_t;
+
+    /// Type of the DAGs *this evaluates
+    using DAG = typename evaluator_type::DAG;
+
+    /// Type of the function measuring the size of a value
+    using size_function = std::function<size_type(const result_type&)>;
+
+    /// Type of a version stamp
+    using version_type = std::uint64_t;
+
+    /** @brief Creates an empty cache.
+     *
+     *  @param[in] budget The total size of the cached values *this should
+     *                    not exceed. Default is 0, which means no limit.
+     *  @param[in] size_of Measures the size of a value. Default is
+     *                     `sizeof(result_type)`, i.e., @p budget counts
+     *                     bytes for types which own no memory.
+     *
+     *  @throw ??? Throws if moving @p size_of throws. Same throw guarantee.
+     */
+    explicit EvaluationCache(size_type budget = 0, size_function size_of = {}) :
+      m_budget_(budget), m_size_of_(std::move(size_of)) {
+        if(!m_size_of_)
+            m_size_of_ = [](const result_type&) { return sizeof(result_type); };
+    }
+
+    /** @brief Evaluates @p expr, reusing cached values where possible.
+     *
+     *  @tparam T The type of @p expr.
+     *
+     *  Converts @p expr into a DAG with `evaluator.make_dag` and evaluates
+     *  that. Making the DAG walks all of @p expr, cached or not, so prefer
+     *  the DAG overload when evaluating the same expression repeatedly.
+     *
+     *  @param[in] evaluator The Evaluator whose kernels are used.
+     *  @param[in] expr The expression to evaluate.
+     *
+     *  @return The value of @p expr. Valid until the next call to evaluate or
+     *          clear.
+     *
+     *  @throw ??? Throws if a kernel throws. The cache stays consistent.
+     */
+    template<typename T>
+    const result_type& evaluate(evaluator_type& evaluator, const T& expr) {
+        return evaluate(evaluator, evaluator.make_dag(expr));
+    }
+
+    /** @brief Evaluates @p dag, reusing cached values where possible.
+     *
+     *  @param[in] evaluator The Evaluator whose kernels are used.
+     *  @param[in] dag The (non-empty) DAG to evaluate.
+     *
+     *  @return The value of @p dag. Valid until the next call to evaluate or
+     *          clear.
+     *
+     *  @throw std::logic_error if a node which is not cached has no kernel.
+     *                          The cache stays consistent.
+     *  @throw ??? Throws if a kernel throws. The cache stays consistent.
+     */
+    const result_type& evaluate(evaluator_type& evaluator, const DAG& dag);
+
+    /** @brief Records that @p leaf has been modified.
+     *
+     *  @tparam T The type of @p leaf.
+     *
+     *  Cached values which depend on @p leaf will not be used again (and
+     *  will eventually be evicted). Leaves are identified by address, so
+     *  @p leaf must be the object the expression aliases.
+     *
+     *  @param[in] leaf The leaf which was modified.
+     *
+     *  @throw std::bad_alloc if there is a problem recording the stamp. Strong
+     *                        throw guarantee.
+     */
+    template<typename T>
+    void mark_changed(const T& leaf) {
+        ++m_versions_[detail_::address_hash(leaf)];
+    }
+
+    /// Removes every cached value (version stamps are kept)
+    void clear() noexcept {
+        m_entries_.clear();
+        m_lru_.clear();
+        m_used_ = 0;
+    }
+
+    /// The number of cached values
+    size_type size() const noexcept { return m_entries_.size(); }
+
+    /// The total size of the cached values
+    size_type memory_usage() const noexcept { return m_used_; }
+
+    /// The number of operations whose values were found in the cache
+    size_type hits() const noexcept { return m_hits_; }
+
+    /// The number of operations which had to be computed
+    size_type misses() const noexcept { return m_misses_; }
+
+private:
+    /// Type of the keys
+    using key_type = std::size_t;
+
+    /// A cached value
+    struct Entry {
+        result_type value;
+        size_type size;
+        typename std::list<key_type>::iterator position;
+    };
+
+    /// The version stamp of the leaf with address hash @p hash
+    version_type version_(std::size_t hash) const {
+        auto it = m_versions_.find(hash);
+        return it == m_versions_.end() ? 0 : it->second;
+    }
+
+    /// Marks @p entry as the most recently used
+    void touch_(Entry& entry) {
+        m_lru_.splice(m_lru_.begin(), m_lru_, entry.position);
+    }
+
+    /// Removes @p key from the cache
+    void erase_(key_type key);
+
+    /// Evicts values until the budget is met, keeping the newest one
+    void trim_();
+
+    /// The memory budget, 0 for none
+    size_type m_budget_;
+
+    /// Measures the size of values
+    size_function m_size_of_;
+
+    /// The cached values
+    std::unordered_map<key_type, Entry> m_entries_;
+
+    /// The keys of the cached values, most recently used first
+    std::list<key_type> m_lru_;
+
+    /// The total size of the cached values
+    size_type m_used_ = 0;
+
+    /// Version stamps of the leaves, by address hash
+    std::unordered_map<std::size_t, version_type> m_versions_;
+
+    /// Values of the leaves (which are not cached) needed by this evaluation
+    std::deque<result_type> m_scratch_;
+
+    /// Statistics
+    size_type m_hits_   = 0;
+    size_type m_misses_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+// -- Out of line inline definitions
+// -----------------------------------------------------------------------------
+
+template<typename EvaluatorType>
+const typename EvaluatorType::result_type&
+EvaluationCache<EvaluatorType>::evaluate(evaluator_type& evaluator,
+                                         const DAG& dag) {
+    const auto n = dag.size();
+
+    // Operations are keyed by their hash and their children's keys, so a
+    // new version of a leaf changes the keys of everything above it
+    std::vector<key_type> keys(n);
+    for(size_type i = 0; i < n; ++i) {
+        const auto hash = dag.hash(i);
+        if(dag.kind(i) == NodeKind::leaf) {
+            keys[i] = detail_::hash_combine(hash, version_(hash));
+            continue;
+        }
+        keys[i] = hash;
+        for(size_type j = 0; j < dag.n_children(i); ++j)
+            keys[i] = detail_::hash_combine(keys[i], keys[dag.child(i, j)]);
+    }
+
+    // Work down from the root, the children of cached nodes aren't needed
+    std::vector<const result_type*> values(n, nullptr);
+    std::vector<bool> needed(n, false);
+    needed[dag.root()] = true;
+    for(size_type i = n; i-- > 0;) {
+        if(!needed[i]) continue;
+        if(dag.kind(i) != NodeKind::leaf) {
+            auto it = m_entries_.find(keys[i]);
+            if(it != m_entries_.end()) {
+                ++m_hits_;
+                touch_(it->second);
+                values[i] = &it->second.value;
+                continue;
+            }
+            ++m_misses_;
+        }
+        for(size_type j = 0; j < dag.n_children(i); ++j)
+            needed[dag.child(i, j)] = true;
+    }
+
+    // Evaluate what is needed, children come before their parents
+    typename evaluator_type::argument_list args;
+    size_type n_scratch = 0;
+    for(size_type i = 0; i < n; ++i) {
+        if(!needed[i] || values[i] != nullptr) continue;
+
+        const bool is_leaf = dag.kind(i) == NodeKind::leaf;
+        result_type* out   = nullptr;
+        if(is_leaf) {
+            if(n_scratch == m_scratch_.size()) m_scratch_.emplace_back();
+            out = &m_scratch_[n_scratch++];
+        } else {
+            auto [it, inserted] = m_entries_.try_emplace(keys[i]);
+            if(!inserted) { // Only possible if two keys collide
+                values[i] = &it->second.value;
+                continue;
+            }
+            m_lru_.push_front(keys[i]);
+            it->second.position = m_lru_.begin();
+            it->second.size     = 0;
+            out                 = &it->second.value;
+        }
+
+        args.clear();
+        for(size_type j = 0; j < dag.n_children(i); ++j)
+            args.push_back(values[dag.child(i, j)]);
+        try {
+            evaluator.run_node_(dag, i, {0, out, false}, args);
+        } catch(...) {
+            if(!is_leaf) erase_(keys[i]);
+            throw;
+        }
+        values[i] = out;
+
+        if(!is_leaf) {
+            auto& entry = m_entries_.at(keys[i]);
+            entry.size  = m_size_of_(entry.value);
+            m_used_ += entry.size;
+        }
+    }
+
+    // The result must survive trimming, so make it the most recently used
+    const auto root = dag.root();
+    if(dag.kind(root) != NodeKind::leaf) touch_(m_entries_.at(keys[root]));
+    trim_();
+    return *values[root];
+}
+
+template<typename EvaluatorType>
+void EvaluationCache<EvaluatorType>::erase_(key_type key) {
+    auto it = m_entries_.find(key);
+    m_used_ -= it->second.size;
+    m_lru_.erase(it->second.position);
+    m_entries_.erase(it);
+}
+
+template<typename EvaluatorType>
+void EvaluationCache<EvaluatorType>::trim_() {
+    if(m_budget_ == 0) return;
+    while(m_used_ > m_budget_ && m_lru_.size() > 1) erase_(m_lru_.back());
+}
+
+} // namespace utilities::dsl
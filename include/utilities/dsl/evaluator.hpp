@@ -0,0 +1,1380 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utilities/dsl/add.hpp>
+#include <utilities/dsl/divide.hpp>
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/expression_dag.hpp>
+#include <utilities/dsl/function_call.hpp>
+#include <utilities/dsl/multiply.hpp>
+#include <utilities/dsl/structural_hash.hpp>
+#include <utilities/dsl/subtract.hpp>
+#include <utilities/timer.hpp>
+#include <utility>
+#include <vector>
+
+namespace utilities::dsl {
+namespace detail_ {
+
+/** @brief Does @p KernelType have an in-place kernel for @p kind?
+ *
+ *  The in-place kernels are named after the compound assignment operators,
+ *  e.g., the in-place kernel for NodeKind::add is `add_assign(lhs, rhs)`,
+ *  which should behave like `lhs += rhs`.
+ */
+template<typename KernelType, typename ResultType, NodeKind kind,
+         typename = void>
+struct HasInPlaceKernel : std::false_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasInPlaceKernel<
+  KernelType, ResultType, NodeKind::add,
+  std::void_t<decltype(std::declval<KernelType&>().add_assign(
+    std::declval<ResultType&>(), std::declval<const ResultType&>()))>>
+  : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasInPlaceKernel<
+  KernelType, ResultType, NodeKind::subtract,
+  std::void_t<decltype(std::declval<KernelType&>().subtract_assign(
+    std::declval<ResultType&>(), std::declval<const ResultType&>()))>>
+  : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasInPlaceKernel<
+  KernelType, ResultType, NodeKind::multiply,
+  std::void_t<decltype(std::declval<KernelType&>().multiply_assign(
+    std::declval<ResultType&>(), std::declval<const ResultType&>()))>>
+  : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasInPlaceKernel<
+  KernelType, ResultType, NodeKind::divide,
+  std::void_t<decltype(std::declval<KernelType&>().divide_assign(
+    std::declval<ResultType&>(), std::declval<const ResultType&>()))>>
+  : std::true_type {};
+
+/** @brief Does @p KernelType have an out-of-place kernel for @p kind?
+ *
+ *  The out-of-place kernels are named after the operation, e.g., the kernel
+ *  for NodeKind::add is `add(out, lhs, rhs)`.
+ */
+template<typename KernelType, typename ResultType, NodeKind kind,
+         typename = void>
+struct HasBinaryKernel : std::false_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasBinaryKernel<
+  KernelType, ResultType, NodeKind::add,
+  std::void_t<decltype(std::declval<KernelType&>().add(
+    std::declval<ResultType&>(), std::declval<const ResultType&>(),
+    std::declval<const ResultType&>()))>> : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasBinaryKernel<
+  KernelType, ResultType, NodeKind::subtract,
+  std::void_t<decltype(std::declval<KernelType&>().subtract(
+    std::declval<ResultType&>(), std::declval<const ResultType&>(),
+    std::declval<const ResultType&>()))>> : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasBinaryKernel<
+  KernelType, ResultType, NodeKind::multiply,
+  std::void_t<decltype(std::declval<KernelType&>().multiply(
+    std::declval<ResultType&>(), std::declval<const ResultType&>(),
+    std::declval<const ResultType&>()))>> : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasBinaryKernel<
+  KernelType, ResultType, NodeKind::divide,
+  std::void_t<decltype(std::declval<KernelType&>().divide(
+    std::declval<ResultType&>(), std::declval<const ResultType&>(),
+    std::declval<const ResultType&>()))>> : std::true_type {};
+
+/** @brief Does @p KernelType have a fused kernel for the n-ary @p kind?
+ *
+ *  The fused kernels are overloads of the out-of-place kernels which take
+ *  all of the operands at once, e.g., `add(out, args)` where `args` is an
+ *  `std::vector` of pointers to the operands (like for function_call). They
+ *  exist for the associative operations, add and multiply.
+ */
+template<typename KernelType, typename ResultType, NodeKind kind,
+         typename = void>
+struct HasNAryKernel : std::false_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasNAryKernel<
+  KernelType, ResultType, NodeKind::add,
+  std::void_t<decltype(std::declval<KernelType&>().add(
+    std::declval<ResultType&>(),
+    std::declval<const std::vector<const ResultType*>&>()))>>
+  : std::true_type {};
+
+template<typename KernelType, typename ResultType>
+struct HasNAryKernel<
+  KernelType, ResultType, NodeKind::multiply,
+  std::void_t<decltype(std::declval<KernelType&>().multiply(
+    std::declval<ResultType&>(),
+    std::declval<const std::vector<const ResultType*>&>()))>>
+  : std::true_type {};
+
+/// Can @p KernelType convert a @p T leaf into a @p ResultType?
+template<typename KernelType, typename ResultType, typename T,
+         typename = void>
+struct HasLeafKernel : std::false_type {};
+
+template<typename KernelType, typename ResultType, typename T>
+struct HasLeafKernel<KernelType, ResultType, T,
+                     std::void_t<decltype(std::declval<KernelType&>().leaf(
+                       std::declval<ResultType&>(), std::declval<const T&>()))>>
+  : std::true_type {};
+
+} // namespace detail_
+
+template<typename EvaluatorType>
+class EvaluationCache;
+
+/** @brief The description under which node @p i of a DAG is timed.
+ *
+ *  @param[in] i The index of the node.
+ *
+ *  @return The key of node @p i's timing in a Timer filled by
+ *          `Evaluator::evaluate(dag, timer)`.
+ *
+ *  @throw std::bad_alloc if there is a problem allocating the key. Strong
+ *                        throw guarantee.
+ */
+inline std::string dag_timer_key(std::size_t i) {
+    return "node " + std::to_string(i);
+}
+
+/// Options controlling how Evaluator::evaluate_parallel runs a DAG
+struct ParallelOptions {
+    /// The number of ready nodes searched for one which needs no new buffer
+    static constexpr std::size_t max_scan = 64;
+
+    /// The maximum number of threads, 0 means hardware_concurrency()
+    std::size_t nthreads = 0;
+
+    /** @brief The number of buffers which may hold values at once, 0 means no
+     *         limit.
+     *
+     *  With a limit, ready nodes are started strictly in order of importance
+     *  (see costs), rather than preferring the ones a thread just made ready.
+     *  While the limit is reached, only nodes which do not need a new buffer
+     *  (e.g., in-place operations) are started; to bound the time spent
+     *  holding the scheduler's lock, only the `max_scan` most important
+     *  ready nodes are considered. If nothing is running and none of those
+     *  can run, the most important one is started anyway, so the limit is
+     *  exceeded rather than deadlocking.
+     */
+    std::size_t max_buffers = 0;
+
+    /** @brief The estimated cost of each node of the DAG.
+     *
+     *  Ready nodes on the longest (most expensive) path to the root are
+     *  started first. If empty, leaves cost 0 and every other node costs 1.
+     */
+    std::vector<double> costs;
+};
+
+/** @brief Evaluates expression trees by dispatching to user-supplied kernels.
+ *
+ *  @tparam ResultType The type every node of the tree evaluates to. Must be
+ *                     default constructible.
+ *  @tparam KernelType The type of the object implementing the operations.
+ *
+ *  The DSL only builds trees, what the nodes mean is up to the user. An
+ *  Evaluator walks a tree and calls the kernel for each node. The kernels are
+ *  member functions of a KernelType object:
+ *
+ *  - `leaf(out, value)` converts a leaf (of whatever type) into a ResultType.
+ *  - `add(out, lhs, rhs)`, `subtract(out, lhs, rhs)`, `multiply(out, lhs,
+ *    rhs)`, and `divide(out, lhs, rhs)` set `out` to the result of the
+ *    respective operation.
+ *  - `function_call(out, fxn, args)` sets `out` to the result of calling
+ *    `fxn` (the first object of the FunctionCall, which is not evaluated) with
+ *    `args`, an `std::vector` of pointers to the evaluated arguments.
+ *
+ *  Sums and products with more than two operands (see Sum and Product) are
+ *  accumulated into a single buffer: the fused kernel, `add(out, args)` or
+ *  `multiply(out, args)` with `args` as for function_call, is called if it
+ *  exists, otherwise the in-place kernel is applied to each operand in turn,
+ *  and otherwise the out-of-place kernel is.
+ *
+ *  Only the kernels for the node kinds which actually appear in a tree need to
+ *  exist. `out` is a buffer which may hold the result of an earlier kernel, so
+ *  kernels must overwrite it. Optionally, a binary operation may also have an
+ *  in-place kernel, e.g., `add_assign(lhs, rhs)`. If present, the in-place
+ *  kernel is used and the result is written into the buffer holding the
+ *  left operand, rather than into a new temporary.
+ *
+ *  The tree is walked with an explicit stack, rather than by recursion, so
+ *  the depth of the tree is not limited by the call stack. Buffers are
+ *  recycled as soon as their value has been consumed and are kept between
+ *  calls to evaluate, so repeatedly evaluating similar trees does not
+ *  allocate new buffers.
+ *
+ *  Trees which repeat subexpressions, e.g., `(A*B) + (A*B)/c`, can first be
+ *  converted into a DAG with make_dag. make_dag merges structurally equal
+ *  subtrees (see structural_hash.hpp), so evaluating the DAG evaluates each
+ *  unique subexpression once. Buffers in the DAG are released after their
+ *  last use and in-place kernels are only used when the left operand is not
+ *  needed again (if there is only an in-place kernel, the left operand is
+ *  copied first). The DAG can also be rewritten, e.g., by simplify, before
+ *  it is evaluated. In the DAG, double literals the tree owns are constants,
+ *  i.e., their values are copied when the DAG is made. Literals the tree
+ *  aliases, e.g., `alpha` in `alpha * A`, are leaves like any other aliased
+ *  object, so a DAG which is reused sees their current values. Both are
+ *  loaded with `leaf(out, double)`.
+ *
+ *  Independent nodes of a DAG, e.g., the two products in `(A*B) + (C*D)`,
+ *  can be evaluated concurrently with evaluate_parallel. This requires the
+ *  kernels to be safe to call from several threads at once.
+ */
+template<typename ResultType, typename KernelType>
+class Evaluator {
+public:
+    /// Type every node evaluates to
+    using result_type = ResultType;
+
+    /// Type of the object implementing the kernels
+    using kernel_type = KernelType;
+
+    /// Type used for counting and indexing
+    using size_type = std::size_t;
+
+    /// Type of the arguments passed to the function_call kernel
+    using argument_list = std::vector<const result_type*>;
+
+    /// Type of the DAGs made by and evaluated by *this
+    using DAG = ExpressionDAG<Evaluator>;
+
+    /** @brief Creates an Evaluator which uses @p kernels.
+     *
+     *  @param[in] kernels The object implementing the kernels. Default is a
+     *                     default constructed kernel_type.
+     *
+     *  @throw ??? Throws if moving @p kernels throws. Same throw guarantee.
+     */
+    explicit Evaluator(kernel_type kernels = kernel_type{}) :
+      m_kernels_(std::move(kernels)) {}
+
+    /// The object implementing the kernels
+    ///@{
+    kernel_type& kernels() noexcept { return m_kernels_; }
+    const kernel_type& kernels() const noexcept { return m_kernels_; }
+    ///@}
+
+    /** @brief Evaluates @p expr.
+     *
+     *  @tparam T The type of @p expr. Can be a Term or a leaf.
+     *
+     *  @param[in] expr The expression to evaluate.
+     *
+     *  @return A read-only reference to the result. The reference is to one of
+     *          *this's buffers and is valid until the next call to evaluate.
+     *
+     *  @throw ??? Throws if a kernel throws or if allocating a buffer throws.
+     *             *this remains usable, but the result of the previous call is
+     *             no longer valid.
+     */
+    template<typename T>
+    const result_type& evaluate(const T& expr);
+
+    /** @brief Converts @p expr into a DAG without common subexpressions.
+     *
+     *  @tparam T The type of @p expr. Can be a Term or a leaf.
+     *
+     *  Subtrees are merged if they are structurally equal. Like evaluate, the
+     *  tree is walked with an explicit stack. The structural hash of each
+     *  node is looked up before its children are visited, so the children of
+     *  a repeated subtree are not visited at all.
+     *
+     *  Doubles @p expr owns (those passed to the operations as rvalues) are
+     *  folded into constants, so changing them requires making a new DAG.
+     *  Literals @p expr aliases become leaves, which are read each time the
+     *  DAG is evaluated.
+     *
+     *  @param[in] expr The expression to convert. Must outlive the result.
+     *
+     *  @return The DAG of @p expr.
+     *
+     *  @throw std::bad_alloc if there is a problem allocating the DAG. Strong
+     *                        throw guarantee.
+     */
+    template<typename T>
+    DAG make_dag(const T& expr) const;
+
+    /** @brief Evaluates the expression represented by @p dag.
+     *
+     *  Each node of @p dag is evaluated exactly once. Since rewrites may add
+     *  operations which were not in the original tree, the kernels needed
+     *  are looked up when the node is evaluated.
+     *
+     *  @param[in] dag The (non-empty) DAG to evaluate.
+     *
+     *  @return A read-only reference to the result. The reference is to one of
+     *          *this's buffers and is valid until the next call to evaluate.
+     *
+     *  @throw std::logic_error if there is no kernel for one of the nodes.
+     *                          *this remains usable, but the result of the
+     *                          previous call is no longer valid.
+     *  @throw ??? Throws if a kernel throws or if allocating a buffer throws.
+     *             *this remains usable, but the result of the previous call is
+     *             no longer valid.
+     */
+    const result_type& evaluate(const DAG& dag);
+
+    /** @brief Evaluates @p dag, timing each node.
+     *
+     *  This is `evaluate(dag)`, except that the kernel of each node is timed
+     *  and recorded in @p timer under `dag_timer_key(i)`. Only the kernels
+     *  are timed, not the bookkeeping between them. The timings can be
+     *  compared with the estimates of estimate_cost (see calibrate).
+     *
+     *  @note Timer keeps the first timing recorded under a key, so
+     *        @p timer should not already hold timings of another DAG.
+     *
+     *  @param[in] dag The (non-empty) DAG to evaluate.
+     *  @param[in,out] timer Where the timings are recorded.
+     *
+     *  @return A read-only reference to the result. The reference is to one of
+     *          *this's buffers and is valid until the next call to evaluate.
+     *
+     *  @throw std::logic_error if there is no kernel for one of the nodes.
+     *                          *this remains usable, but the result of the
+     *                          previous call is no longer valid.
+     *  @throw ??? Throws if a kernel throws or if allocating a buffer (or a
+     *             timing) throws. *this remains usable, but the result of the
+     *             previous call is no longer valid.
+     */
+    const result_type& evaluate(const DAG& dag, Timer& timer);
+
+    /** @brief Evaluates @p dag using multiple threads.
+     *
+     *  The scheduling is centralized: one lock guards the nodes which are
+     *  ready to be evaluated (their children have been evaluated) along with
+     *  the buffers, and the threads take turns holding it to pick a node and
+     *  to record its value. The kernels run without holding the lock, so
+     *  this scales as long as the kernels take much longer than the
+     *  bookkeeping. The ready nodes are kept in one list per thread; a thread
+     *  takes the newest node from its own list, which tends to reuse the
+     *  values it just made, and otherwise the most important of the oldest
+     *  nodes of the other lists. With `options.max_buffers` set, the ready
+     *  nodes are kept in a single list instead, ordered by importance. Nodes
+     *  on the most expensive paths to the root, according to
+     *  `options.costs`, are more important.
+     *
+     *  The kernels are called concurrently and must be thread-safe. With one
+     *  thread this is the same as `evaluate(dag)`.
+     *
+     *  @param[in] dag The (non-empty) DAG to evaluate.
+     *  @param[in] options How many threads to use, how much memory to use,
+     *                     and how expensive the nodes are. See
+     *                     ParallelOptions.
+     *
+     *  @return A read-only reference to the result. The reference is to one of
+     *          *this's buffers and is valid until the next call to evaluate.
+     *
+     *  @throw std::invalid_argument if `options.costs` is neither empty nor
+     *                               the size of @p dag. Strong throw
+     *                               guarantee.
+     *  @throw std::system_error if a thread can not be started. *this remains
+     *                           usable.
+     *  @throw ??? Throws the first exception thrown by a kernel, after all
+     *             running kernels have finished. *this remains usable, but
+     *             the result of the previous call is no longer valid.
+     */
+    const result_type& evaluate_parallel(const DAG& dag,
+                                         const ParallelOptions& options = {});
+
+    /// The number of buffers *this has created
+    size_type buffer_count() const noexcept { return m_buffers_.size(); }
+
+private:
+    /// Type of a function processing a node of the tree
+    using task_function = void (*)(Evaluator&, const void*);
+
+    /// A pending piece of work: a node and what to do with it
+    struct Task {
+        const void* node;
+        task_function fxn;
+    };
+
+    /// Is @p T a node with children (vs. a leaf)?
+    template<typename T>
+    static constexpr bool is_operation_v = node_kind_v<T> != NodeKind::leaf;
+
+    /// Schedules @p object to be visited
+    template<typename T>
+    void push_task_(const T& object);
+
+    /// Converts a leaf into a buffer
+    template<typename T>
+    static void load_(Evaluator& self, const void* node);
+
+    /// Schedules the children of an operation, then the operation itself
+    template<typename T>
+    static void visit_(Evaluator& self, const void* node);
+
+    /// Combines the (evaluated) children of an operation
+    template<typename T>
+    static void apply_(Evaluator& self, const void* node);
+
+    /// Schedules the children in the range [First, N) in reverse order
+    template<std::size_t First, typename T, std::size_t... Is>
+    void push_children_(const T& node, std::index_sequence<Is...>);
+
+    /// Index of the first child of a @p T node which is evaluated
+    template<typename T>
+    static constexpr std::size_t first_child_v =
+      node_kind_v<T> == NodeKind::function_call ? 1 : 0;
+
+    /// Calls the out-of-place kernel for the binary operation @p kind
+    template<NodeKind kind>
+    void binary_kernel_(result_type& out, const result_type& lhs,
+                        const result_type& rhs);
+
+    /// Calls the in-place kernel for the binary operation @p kind
+    template<NodeKind kind>
+    void in_place_kernel_(result_type& lhs, const result_type& rhs);
+
+    /// Does the binary operation @p kind have an in-place kernel?
+    template<NodeKind kind>
+    static constexpr bool has_in_place_v =
+      detail_::HasInPlaceKernel<KernelType, ResultType, kind>::value;
+
+    /// Does the binary operation @p kind have an out-of-place kernel?
+    template<NodeKind kind>
+    static constexpr bool has_binary_v =
+      detail_::HasBinaryKernel<KernelType, ResultType, kind>::value;
+
+    /// Does the operation @p kind have a fused n-ary kernel?
+    template<NodeKind kind>
+    static constexpr bool has_n_ary_v =
+      detail_::HasNAryKernel<KernelType, ResultType, kind>::value;
+
+    /// Is the result of @p kind with @p n operands written over the lhs?
+    template<NodeKind kind>
+    static constexpr bool uses_lhs_(size_type n) noexcept {
+        return has_in_place_v<kind> && !(has_n_ary_v<kind> && n > 2);
+    }
+
+    /// Builds the DAG for make_dag
+    class DAGBuilder;
+
+    /// Runs evaluate_parallel
+    class Scheduler;
+
+    /// Evaluates the nodes which are not cached
+    friend class EvaluationCache<Evaluator>;
+
+    /// Where a node of a DAG writes its value
+    struct Step {
+        /// The index of the buffer
+        size_type slot;
+
+        /// The buffer
+        result_type* out;
+
+        /// Is the buffer the lhs's (i.e., is this an in-place operation)?
+        bool lhs_taken;
+    };
+
+    /// Gets ready to evaluate @p dag
+    void start_dag_(const DAG& dag);
+
+    /// Can node @p i of @p dag be done in place, i.e., without a new buffer?
+    bool takes_lhs_(const DAG& dag, size_type i) const;
+
+    /// Picks node @p i's buffer and puts its children's values in @p args
+    Step prepare_(const DAG& dag, size_type i, argument_list& args);
+
+    /// Calls the kernel for node @p i, only touches the buffers in the args
+    void run_node_(const DAG& dag, size_type i, const Step& step,
+                   const argument_list& args);
+
+    /// Records node @p i's value and releases the children which are done
+    void finish_(const DAG& dag, size_type i, const Step& step);
+
+    /// Evaluates node @p i of @p dag, which is a leaf of type @p T
+    template<typename T>
+    static void run_leaf_(Evaluator& self, const DAG& dag, size_type i,
+                          result_type& out, const argument_list& args);
+
+    /// Evaluates node @p i of @p dag, which is a FunctionCall of type @p T
+    template<typename T>
+    static void run_function_call_(Evaluator& self, const DAG& dag,
+                                   size_type i, result_type& out,
+                                   const argument_list& args);
+
+    /// Evaluates node @p i of @p dag, which is a constant
+    void run_constant_(const DAG& dag, size_type i, result_type& out);
+
+    /// Evaluates an operation other than a function call
+    template<NodeKind kind>
+    void run_operation_(const Step& step, const argument_list& args);
+
+    /// Marks every buffer as unused
+    void reset_buffers_();
+
+    /// Index of an unused buffer, making one if needed
+    size_type acquire_();
+
+    /// Marks buffer @p i as unused
+    void release_(size_type i) { m_free_.push_back(i); }
+
+    /// Removes and returns the index of the most recent value
+    size_type pop_value_() {
+        const auto i = m_values_.back();
+        m_values_.pop_back();
+        return i;
+    }
+
+    /// The object implementing the kernels
+    kernel_type m_kernels_;
+
+    /// All of the buffers (a deque so references to them stay valid)
+    std::deque<result_type> m_buffers_;
+
+    /// Indices of the buffers which are not in use
+    std::vector<size_type> m_free_;
+
+    /// Work which still needs to be done
+    std::vector<Task> m_tasks_;
+
+    /// Indices of the buffers holding evaluated, but unconsumed, nodes
+    std::vector<size_type> m_values_;
+
+    /// Scratch space for the arguments of function calls
+    argument_list m_args_;
+
+    /// When evaluating a DAG, the buffer holding each node's value
+    std::vector<size_type> m_slots_;
+
+    /// When evaluating a DAG, the number of unevaluated uses of each node
+    std::vector<size_type> m_remaining_;
+};
+
+template<typename ResultType, typename KernelType>
+class Evaluator<ResultType, KernelType>::DAGBuilder {
+public:
+    explicit DAGBuilder(DAG& dag) : m_dag_(dag) {}
+
+    /// Schedules @p object to be added to the DAG
+    template<typename T>
+    void push_task_(const T& object) {
+        m_tasks_.push_back(Task{&object, &visit_<T>});
+    }
+
+    /// Processes tasks until there are none left, returns the root
+    size_type run() {
+        while(!m_tasks_.empty()) {
+            const auto task = m_tasks_.back();
+            m_tasks_.pop_back();
+            task.fxn(*this, task.node);
+        }
+        return m_indices_.back();
+    }
+
+private:
+    /// Type of a function processing a node of the tree
+    using task_function = void (*)(DAGBuilder&, const void*);
+
+    /// A pending piece of work: a node and what to do with it
+    struct Task {
+        const void* node;
+        task_function fxn;
+    };
+
+    /// Type of the function comparing two nodes
+    using equal_function = bool (*)(const void*, const void*);
+
+    /// A node of the tree which has been added to the DAG
+    struct Entry {
+        const void* object;
+        equal_function equal;
+        size_type index;
+    };
+
+    template<typename T>
+    static bool equal_(const void* lhs, const void* rhs) {
+        return structurally_equal(*static_cast<const T*>(lhs),
+                                  *static_cast<const T*>(rhs));
+    }
+
+    template<typename T>
+    static bool equal_callable_(const void* lhs, const void* rhs) {
+        const auto& l = static_cast<const T*>(lhs)->template object<0>();
+        const auto& r = static_cast<const T*>(rhs)->template object<0>();
+        return structurally_equal(l, r);
+    }
+
+    /// Equality of aliased literals, they must be the same object
+    static bool same_object_(const void* lhs, const void* rhs) {
+        return lhs == rhs;
+    }
+
+    /// Uses the leaf for the aliased literal @p node, adding it if needed
+    template<typename T>
+    static void visit_alias_(DAGBuilder& self, const void* node) {
+        const auto& object = *static_cast<const T*>(node);
+        const auto hash    = detail_::address_hash(object);
+        auto [first, last] = self.m_table_.equal_range(hash);
+        for(; first != last; ++first) {
+            const auto& entry = first->second;
+            if(entry.equal != &same_object_ || entry.object != node) continue;
+            self.m_indices_.push_back(entry.index);
+            return;
+        }
+
+        const auto i = self.m_dag_.add_leaf_(node, &run_leaf_<T>, &same_object_,
+                                             hash, detail_::type_id<T>());
+        self.m_table_.emplace(hash, Entry{node, &same_object_, i});
+        self.m_indices_.push_back(i);
+    }
+
+    /// Uses an existing node equal to @p object, or schedules adding it
+    template<typename T>
+    static void visit_(DAGBuilder& self, const void* node) {
+        const auto& object = *static_cast<const T*>(node);
+        if constexpr(std::is_same_v<T, double>) {
+            self.m_indices_.push_back(self.m_dag_.make_constant(object));
+        } else {
+            const auto hash    = structural_hash(object);
+            auto [first, last] = self.m_table_.equal_range(hash);
+            for(; first != last; ++first) {
+                const auto& entry = first->second;
+                if(entry.equal != &equal_<T>) continue;
+                if(!equal_<T>(entry.object, node)) continue;
+                self.m_indices_.push_back(entry.index);
+                return;
+            }
+
+            if constexpr(is_operation_v<T>) {
+                self.m_tasks_.push_back(Task{node, &emit_<T>});
+                constexpr auto first_child = first_child_v<T>;
+                self.template push_children_<first_child>(
+                  object, std::make_index_sequence<T::N - first_child>{});
+            } else {
+                auto& dag    = self.m_dag_;
+                const auto i = dag.add_leaf_(node, &run_leaf_<T>,
+                                             &equal_<T>, hash,
+                                             detail_::type_id<T>());
+                self.template record_<T>(node, hash, i);
+            }
+        }
+    }
+
+    /// Adds an operation whose children have all been added
+    template<typename T>
+    static void emit_(DAGBuilder& self, const void* node) {
+        constexpr auto kind     = node_kind_v<T>;
+        constexpr std::size_t n = T::N - first_child_v<T>;
+        const auto& op          = *static_cast<const T*>(node);
+        auto& indices           = self.m_indices_;
+        auto& dag               = self.m_dag_;
+        const auto first        = indices.size() - n;
+
+        size_type i;
+        if constexpr(kind == NodeKind::function_call) {
+            auto id   = detail_::type_id<T>();
+            auto seed = detail_::hash_combine(
+              reinterpret_cast<std::size_t>(id),
+              structural_hash(op.template object<0>()));
+            i = dag.add_function_call_(node, &run_function_call_<T>,
+                                       &equal_callable_<T>, seed,
+                                       indices.data() + first, n);
+        } else if constexpr(n == 2) {
+            i = dag.make_binary(kind, indices[first], indices[first + 1]);
+        } else {
+            std::vector<size_type> children(indices.begin() + first,
+                                            indices.end());
+            i = dag.make_nary(kind, children);
+        }
+        indices.resize(first);
+        self.template record_<T>(node, structural_hash(op), i);
+    }
+
+    /// Notes that the tree node @p node became DAG node @p i
+    template<typename T>
+    void record_(const void* node, std::size_t hash, size_type i) {
+        m_table_.emplace(hash, Entry{node, &equal_<T>, i});
+        m_indices_.push_back(i);
+    }
+
+    /// Schedules the children in the range [First, N) in reverse order
+    template<std::size_t First, typename T, std::size_t... Is>
+    void push_children_(const T& node, std::index_sequence<Is...>) {
+        constexpr std::size_t n = sizeof...(Is);
+        (push_child_<First + n - 1 - Is>(node), ...);
+    }
+
+    /// Schedules the I-th child of @p node, aliased literals become leaves
+    template<std::size_t I, typename T>
+    void push_child_(const T& node) {
+        using child_type  = typename T::template object_type<I>;
+        const auto& child = node.template object<I>();
+        if constexpr(detail_::is_literal_v<child_type>) {
+            if(node.template aliases<I>()) {
+                m_tasks_.push_back(Task{&child, &visit_alias_<child_type>});
+                return;
+            }
+        }
+        push_task_(child);
+    }
+
+    /// The DAG being built
+    DAG& m_dag_;
+
+    /// Work which still needs to be done
+    std::vector<Task> m_tasks_;
+
+    /// DAG indices of the nodes which have not been given a parent yet
+    std::vector<size_type> m_indices_;
+
+    /// Maps the structural hashes of tree nodes to their DAG nodes
+    std::unordered_multimap<std::size_t, Entry> m_table_;
+};
+
+// -----------------------------------------------------------------------------
+// -- Out of line inline definitions
+// -----------------------------------------------------------------------------
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+const ResultType& Evaluator<ResultType, KernelType>::evaluate(const T& expr) {
+    // Start from a clean slate, in case the last call threw
+    m_tasks_.clear();
+    m_values_.clear();
+    reset_buffers_();
+
+    push_task_(expr);
+    while(!m_tasks_.empty()) {
+        const auto task = m_tasks_.back();
+        m_tasks_.pop_back();
+        task.fxn(*this, task.node);
+    }
+    return m_buffers_[m_values_.back()];
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+void Evaluator<ResultType, KernelType>::push_task_(const T& object) {
+    if constexpr(is_operation_v<T>) {
+        m_tasks_.push_back(Task{&object, &visit_<T>});
+    } else {
+        m_tasks_.push_back(Task{&object, &load_<T>});
+    }
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+void Evaluator<ResultType, KernelType>::load_(Evaluator& self,
+                                              const void* node) {
+    const auto out = self.acquire_();
+    self.m_kernels_.leaf(self.m_buffers_[out], *static_cast<const T*>(node));
+    self.m_values_.push_back(out);
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+void Evaluator<ResultType, KernelType>::visit_(Evaluator& self,
+                                               const void* node) {
+    const auto& op = *static_cast<const T*>(node);
+    self.m_tasks_.push_back(Task{node, &apply_<T>});
+
+    // The callable of a FunctionCall is handed to the kernel as is
+    constexpr auto first = first_child_v<T>;
+    self.template push_children_<first>(
+      op, std::make_index_sequence<T::N - first>{});
+}
+
+template<typename ResultType, typename KernelType>
+template<std::size_t First, typename T, std::size_t... Is>
+void Evaluator<ResultType, KernelType>::push_children_(
+  const T& node, std::index_sequence<Is...>) {
+    // Tasks are popped LIFO, so push the last child first
+    constexpr std::size_t n = sizeof...(Is);
+    (push_task_(node.template object<First + n - 1 - Is>()), ...);
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+void Evaluator<ResultType, KernelType>::apply_(Evaluator& self,
+                                               const void* node) {
+    constexpr auto kind = node_kind_v<T>;
+    auto& buffers       = self.m_buffers_;
+
+    if constexpr(kind == NodeKind::function_call) {
+        constexpr std::size_t nargs = T::N - 1;
+        const auto& op              = *static_cast<const T*>(node);
+        const auto first            = self.m_values_.size() - nargs;
+        self.m_args_.clear();
+        for(auto i = first; i < self.m_values_.size(); ++i)
+            self.m_args_.push_back(&buffers[self.m_values_[i]]);
+
+        const auto out = self.acquire_();
+        self.m_kernels_.function_call(buffers[out], op.template object<0>(),
+                                      self.m_args_);
+        for(auto i = first; i < self.m_values_.size(); ++i)
+            self.release_(self.m_values_[i]);
+        self.m_values_.resize(first);
+        self.m_values_.push_back(out);
+    } else {
+        constexpr std::size_t n = T::N;
+        const auto first        = self.m_values_.size() - n;
+        self.m_args_.clear();
+        for(auto i = first; i < self.m_values_.size(); ++i)
+            self.m_args_.push_back(&buffers[self.m_values_[i]]);
+
+        // If possible the result overwrites the lhs, else it gets a buffer
+        constexpr bool lhs_taken = uses_lhs_<kind>(n);
+        const auto out = lhs_taken ? self.m_values_[first] : self.acquire_();
+        self.template run_operation_<kind>(Step{out, &buffers[out], lhs_taken},
+                                           self.m_args_);
+        for(auto i = first + (lhs_taken ? 1 : 0); i < self.m_values_.size();
+            ++i)
+            self.release_(self.m_values_[i]);
+        self.m_values_.resize(first);
+        self.m_values_.push_back(out);
+    }
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+typename Evaluator<ResultType, KernelType>::DAG
+Evaluator<ResultType, KernelType>::make_dag(const T& expr) const {
+    DAG dag;
+    DAGBuilder builder(dag);
+    builder.push_task_(expr);
+    dag.compact_(builder.run());
+    return dag;
+}
+
+template<typename ResultType, typename KernelType>
+class Evaluator<ResultType, KernelType>::Scheduler {
+public:
+    /// Works out the order to run the nodes of @p dag in
+    Scheduler(Evaluator& self, const DAG& dag, const ParallelOptions& options);
+
+    /// Evaluates the DAG with @p nthreads threads (including this one)
+    void run(size_type nthreads);
+
+private:
+    /// What each thread does, @p w is the thread's index
+    void work_(size_type w);
+
+    /// Removes a ready node for thread @p w, returns false if there are none
+    bool take_(size_type w, bool no_buffer, size_type& i);
+
+    /// Queues the parents of @p i which are now ready for thread @p w
+    void push_parents_(size_type w, size_type i);
+
+    /// Should node @p a be run before node @p b?
+    bool before_(size_type a, size_type b) const {
+        const auto pa = m_priority_[a];
+        const auto pb = m_priority_[b];
+        return pa > pb || (pa == pb && a < b);
+    }
+
+    /// Orders nodes by before_
+    struct Before {
+        const Scheduler* self;
+        bool operator()(size_type a, size_type b) const {
+            return self->before_(a, b);
+        }
+    };
+
+    /// Makes node @p i ready for thread @p w (see m_queues_ and m_ready_)
+    void push_ready_(size_type w, size_type i);
+
+    /// Are as many buffers in use as are allowed?
+    bool full_() const {
+        const auto live = m_self_.m_buffers_.size() - m_self_.m_free_.size();
+        return m_max_buffers_ != 0 && live >= m_max_buffers_;
+    }
+
+    /// The Evaluator whose buffers and kernels are used
+    Evaluator& m_self_;
+
+    /// The DAG being evaluated
+    const DAG& m_dag_;
+
+    /// The maximum number of buffers in use at once, 0 for no limit
+    size_type m_max_buffers_;
+
+    /// Cost of the most expensive path from each node to the root
+    std::vector<double> m_priority_;
+
+    /// The parents of node i are m_parents_[m_first_parent_[i]] up to, but
+    /// not including, m_parents_[m_first_parent_[i + 1]]
+    std::vector<size_type> m_first_parent_;
+    std::vector<size_type> m_parents_;
+
+    /// The number of each node's children which have not been evaluated
+    std::vector<size_type> m_pending_;
+
+    /// Each thread's ready nodes, the most important is at the back. Only
+    /// used if there is no limit on the number of buffers.
+    std::vector<std::deque<size_type>> m_queues_;
+
+    /// The ready nodes, the most important first. Only used if there is a
+    /// limit on the number of buffers.
+    std::set<size_type, Before> m_ready_{Before{this}};
+
+    /// Guards everything but the kernels
+    std::mutex m_mutex_;
+
+    /// Signals that nodes finished (so others may be ready) or an error
+    std::condition_variable m_cv_;
+
+    /// The number of nodes which have been evaluated
+    size_type m_n_done_ = 0;
+
+    /// The number of kernels currently running
+    size_type m_n_running_ = 0;
+
+    /// The first exception thrown
+    std::exception_ptr m_error_;
+};
+
+template<typename ResultType, typename KernelType>
+Evaluator<ResultType, KernelType>::Scheduler::Scheduler(
+  Evaluator& self, const DAG& dag, const ParallelOptions& options) :
+  m_self_(self), m_dag_(dag), m_max_buffers_(options.max_buffers) {
+    const auto n = dag.size();
+
+    // Invert the child lists (repeated children are repeated parents)
+    m_first_parent_.assign(n + 1, 0);
+    m_pending_.resize(n);
+    for(size_type i = 0; i < n; ++i) {
+        m_pending_[i] = dag.n_children(i);
+        for(size_type j = 0; j < dag.n_children(i); ++j)
+            ++m_first_parent_[dag.child(i, j) + 1];
+    }
+    for(size_type i = 0; i < n; ++i)
+        m_first_parent_[i + 1] += m_first_parent_[i];
+    m_parents_.resize(m_first_parent_.back());
+    auto next = m_first_parent_;
+    for(size_type i = 0; i < n; ++i)
+        for(size_type j = 0; j < dag.n_children(i); ++j)
+            m_parents_[next[dag.child(i, j)]++] = i;
+
+    // Parents come after their children, so work back from the root
+    m_priority_.assign(n, 0.0);
+    for(size_type i = n; i-- > 0;) {
+        double cost = dag.kind(i) == NodeKind::leaf ? 0.0 : 1.0;
+        if(!options.costs.empty()) cost = options.costs[i];
+        double longest = 0.0;
+        for(auto k = m_first_parent_[i]; k < m_first_parent_[i + 1]; ++k)
+            longest = std::max(longest, m_priority_[m_parents_[k]]);
+        m_priority_[i] = cost + longest;
+    }
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::Scheduler::run(size_type nthreads) {
+    m_self_.start_dag_(m_dag_);
+
+    // Deal out the leaves so each queue ends with its most important node
+    std::vector<size_type> ready;
+    for(size_type i = 0; i < m_dag_.size(); ++i)
+        if(m_pending_[i] == 0) ready.push_back(i);
+    std::sort(ready.begin(), ready.end(),
+              [this](size_type a, size_type b) { return before_(b, a); });
+    m_queues_.resize(nthreads);
+    for(size_type k = 0; k < ready.size(); ++k)
+        push_ready_(k % nthreads, ready[k]);
+
+    std::vector<std::thread> threads;
+    try {
+        for(size_type w = 1; w < nthreads; ++w)
+            threads.emplace_back([this, w] { work_(w); });
+    } catch(...) {
+        std::lock_guard<std::mutex> lock(m_mutex_);
+        if(!m_error_) m_error_ = std::current_exception();
+    }
+    m_cv_.notify_all();
+    work_(0);
+    for(auto& t : threads) t.join();
+    if(m_error_) std::rethrow_exception(m_error_);
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::Scheduler::work_(size_type w) {
+    argument_list args;
+    std::unique_lock<std::mutex> lock(m_mutex_);
+    try {
+        while(!m_error_ && m_n_done_ < m_dag_.size()) {
+            size_type i;
+            const bool full = full_();
+            bool found      = take_(w, full, i);
+
+            // Nothing running can free a buffer, so exceed the limit
+            if(!found && full && m_n_running_ == 0) found = take_(w, false, i);
+            if(!found) {
+                m_cv_.wait(lock);
+                continue;
+            }
+
+            ++m_n_running_;
+            const auto step = m_self_.prepare_(m_dag_, i, args);
+            lock.unlock();
+            m_self_.run_node_(m_dag_, i, step, args);
+            lock.lock();
+            --m_n_running_;
+            m_self_.finish_(m_dag_, i, step);
+            ++m_n_done_;
+            push_parents_(w, i);
+            m_cv_.notify_all();
+        }
+    } catch(...) {
+        if(!lock.owns_lock()) lock.lock();
+        if(!m_error_) m_error_ = std::current_exception();
+        m_cv_.notify_all();
+    }
+}
+
+template<typename ResultType, typename KernelType>
+bool Evaluator<ResultType, KernelType>::Scheduler::take_(size_type w,
+                                                         bool no_buffer,
+                                                         size_type& i) {
+    // With a memory limit, locality matters less than keeping the number of
+    // live values down, so the most important node which can run is taken
+    if(m_max_buffers_ != 0) {
+        auto it = m_ready_.begin();
+        for(size_type k = 0; k < ParallelOptions::max_scan; ++k, ++it) {
+            if(it == m_ready_.end()) return false;
+            if(no_buffer && !m_self_.takes_lhs_(m_dag_, *it)) continue;
+            i = *it;
+            m_ready_.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    // Our newest node, it probably uses the values we just made
+    auto& mine = m_queues_[w];
+    if(!mine.empty()) {
+        i = mine.back();
+        mine.pop_back();
+        return true;
+    }
+
+    // Otherwise the most important of the oldest nodes of the others
+    std::deque<size_type>* owner = nullptr;
+    for(auto& queue : m_queues_) {
+        if(queue.empty()) continue;
+        if(owner == nullptr || before_(queue.front(), owner->front()))
+            owner = &queue;
+    }
+    if(owner == nullptr) return false;
+    i = owner->front();
+    owner->pop_front();
+    return true;
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::Scheduler::push_ready_(size_type w,
+                                                               size_type i) {
+    if(m_max_buffers_ != 0)
+        m_ready_.insert(i);
+    else
+        m_queues_[w].push_back(i);
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::Scheduler::push_parents_(
+  size_type w, size_type i) {
+    if(m_max_buffers_ != 0) {
+        for(auto k = m_first_parent_[i]; k < m_first_parent_[i + 1]; ++k)
+            if(--m_pending_[m_parents_[k]] == 0) m_ready_.insert(m_parents_[k]);
+        return;
+    }
+    auto& queue      = m_queues_[w];
+    const auto first = queue.size();
+    for(auto k = m_first_parent_[i]; k < m_first_parent_[i + 1]; ++k) {
+        const auto p = m_parents_[k];
+        if(--m_pending_[p] == 0) queue.push_back(p);
+    }
+    std::sort(queue.begin() + first, queue.end(),
+              [this](size_type a, size_type b) { return before_(b, a); });
+}
+
+template<typename ResultType, typename KernelType>
+const ResultType& Evaluator<ResultType, KernelType>::evaluate(
+  const DAG& dag) {
+    start_dag_(dag);
+    for(size_type i = 0; i < dag.size(); ++i) {
+        const auto step = prepare_(dag, i, m_args_);
+        run_node_(dag, i, step, m_args_);
+        finish_(dag, i, step);
+    }
+    return m_buffers_[m_slots_.back()];
+}
+
+template<typename ResultType, typename KernelType>
+const ResultType& Evaluator<ResultType, KernelType>::evaluate(const DAG& dag,
+                                                             Timer& timer) {
+    start_dag_(dag);
+    for(size_type i = 0; i < dag.size(); ++i) {
+        const auto step = prepare_(dag, i, m_args_);
+        timer.time_it(dag_timer_key(i),
+                      [&]() { run_node_(dag, i, step, m_args_); });
+        finish_(dag, i, step);
+    }
+    return m_buffers_[m_slots_.back()];
+}
+
+template<typename ResultType, typename KernelType>
+const ResultType& Evaluator<ResultType, KernelType>::evaluate_parallel(
+  const DAG& dag, const ParallelOptions& options) {
+    const auto n = dag.size();
+    if(!options.costs.empty() && options.costs.size() != n)
+        throw std::invalid_argument("Need a cost for every node of the DAG");
+
+    auto nthreads = options.nthreads;
+    if(nthreads == 0) nthreads = std::thread::hardware_concurrency();
+    nthreads = std::min<size_type>(nthreads, n);
+    if(nthreads <= 1) return evaluate(dag);
+
+    Scheduler scheduler(*this, dag, options);
+    scheduler.run(nthreads);
+    return m_buffers_[m_slots_.back()];
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::start_dag_(const DAG& dag) {
+    reset_buffers_();
+    m_slots_.assign(dag.size(), 0);
+    m_remaining_ = dag.m_uses_;
+}
+
+template<typename ResultType, typename KernelType>
+bool Evaluator<ResultType, KernelType>::takes_lhs_(const DAG& dag,
+                                                   size_type i) const {
+    bool in_place = false;
+    const auto n  = dag.n_children(i);
+    switch(dag.kind(i)) {
+        case NodeKind::add: in_place = uses_lhs_<NodeKind::add>(n); break;
+        case NodeKind::subtract:
+            in_place = uses_lhs_<NodeKind::subtract>(n);
+            break;
+        case NodeKind::multiply:
+            in_place = uses_lhs_<NodeKind::multiply>(n);
+            break;
+        case NodeKind::divide:
+            in_place = uses_lhs_<NodeKind::divide>(n);
+            break;
+        default: break;
+    }
+    // In place is only safe if nothing else needs the lhs
+    return in_place && m_remaining_[dag.child(i, 0)] == 1;
+}
+
+template<typename ResultType, typename KernelType>
+typename Evaluator<ResultType, KernelType>::Step
+Evaluator<ResultType, KernelType>::prepare_(const DAG& dag, size_type i,
+                                            argument_list& args) {
+    args.clear();
+    for(size_type j = 0; j < dag.n_children(i); ++j)
+        args.push_back(&m_buffers_[m_slots_[dag.child(i, j)]]);
+
+    Step step{0, nullptr, takes_lhs_(dag, i)};
+    step.slot = step.lhs_taken ? m_slots_[dag.child(i, 0)] : acquire_();
+    step.out  = &m_buffers_[step.slot];
+    return step;
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::run_node_(const DAG& dag, size_type i,
+                                                  const Step& step,
+                                                  const argument_list& args) {
+    const auto& node = dag.m_nodes_[i];
+    switch(node.kind) {
+        case NodeKind::leaf:
+            if(node.run == nullptr) {
+                run_constant_(dag, i, *step.out);
+                break;
+            }
+            [[fallthrough]];
+        case NodeKind::function_call:
+            node.run(*this, dag, i, *step.out, args);
+            break;
+        case NodeKind::add: run_operation_<NodeKind::add>(step, args); break;
+        case NodeKind::subtract:
+            run_operation_<NodeKind::subtract>(step, args);
+            break;
+        case NodeKind::multiply:
+            run_operation_<NodeKind::multiply>(step, args);
+            break;
+        case NodeKind::divide:
+            run_operation_<NodeKind::divide>(step, args);
+            break;
+    }
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::finish_(const DAG& dag, size_type i,
+                                                const Step& step) {
+    m_slots_[i] = step.slot;
+    for(size_type j = 0; j < dag.n_children(i); ++j) {
+        const auto c = dag.child(i, j);
+        if(--m_remaining_[c] != 0) continue;
+        if(j == 0 && step.lhs_taken) continue;
+        release_(m_slots_[c]);
+    }
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+void Evaluator<ResultType, KernelType>::run_leaf_(Evaluator& self,
+                                                  const DAG& dag, size_type i,
+                                                  result_type& out,
+                                                  const argument_list&) {
+    const auto* p = static_cast<const T*>(dag.m_nodes_[i].object);
+    using has_leaf = detail_::HasLeafKernel<KernelType, ResultType, T>;
+    if constexpr(has_leaf::value || !std::is_same_v<T, double>) {
+        self.m_kernels_.leaf(out, *p);
+    } else { // Aliased doubles, like constants, may lack a kernel
+        throw std::logic_error("Kernels can not load a constant");
+    }
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::run_constant_(const DAG& dag,
+                                                      size_type i,
+                                                      result_type& out) {
+    using has_leaf = detail_::HasLeafKernel<KernelType, ResultType, double>;
+    if constexpr(has_leaf::value) {
+        m_kernels_.leaf(out, dag.m_nodes_[i].value);
+    } else {
+        throw std::logic_error("Kernels can not load a constant");
+    }
+}
+
+template<typename ResultType, typename KernelType>
+template<typename T>
+void Evaluator<ResultType, KernelType>::run_function_call_(
+  Evaluator& self, const DAG& dag, size_type i, result_type& out,
+  const argument_list& args) {
+    const auto& op = *static_cast<const T*>(dag.m_nodes_[i].object);
+    self.m_kernels_.function_call(out, op.template object<0>(), args);
+}
+
+template<typename ResultType, typename KernelType>
+template<NodeKind kind>
+void Evaluator<ResultType, KernelType>::run_operation_(
+  const Step& step, const argument_list& args) {
+    auto& out    = *step.out;
+    const auto n = args.size();
+    if constexpr(has_n_ary_v<kind>) {
+        if(n > 2) {
+            auto& k = m_kernels_;
+            if constexpr(kind == NodeKind::add) k.add(out, args);
+            if constexpr(kind == NodeKind::multiply) k.multiply(out, args);
+            return;
+        }
+    }
+
+    // Applies the in-place kernel to the operands from the first-th on
+    auto in_place_from = [&](size_type first) {
+        if constexpr(has_in_place_v<kind>) {
+            for(auto j = first; j < n; ++j)
+                in_place_kernel_<kind>(out, *args[j]);
+        }
+    };
+
+    if(step.lhs_taken) {
+        in_place_from(1);
+    } else if constexpr(has_binary_v<kind>) {
+        binary_kernel_<kind>(out, *args[0], *args[1]);
+        if constexpr(has_in_place_v<kind>) {
+            in_place_from(2);
+        } else {
+            // Out-of-place kernels may not alias their inputs
+            result_type temp;
+            for(size_type j = 2; j < n; ++j) {
+                binary_kernel_<kind>(temp, out, *args[j]);
+                using std::swap;
+                swap(out, temp);
+            }
+        }
+    } else if constexpr(has_in_place_v<kind>) {
+        out = *args[0];
+        in_place_from(1);
+    } else {
+        throw std::logic_error("Kernels have no kernel for an operation");
+    }
+}
+
+template<typename ResultType, typename KernelType>
+template<NodeKind kind>
+void Evaluator<ResultType, KernelType>::binary_kernel_(
+  result_type& out, const result_type& lhs, const result_type& rhs) {
+    auto& k = m_kernels_;
+    if constexpr(kind == NodeKind::add) k.add(out, lhs, rhs);
+    if constexpr(kind == NodeKind::subtract) k.subtract(out, lhs, rhs);
+    if constexpr(kind == NodeKind::multiply) k.multiply(out, lhs, rhs);
+    if constexpr(kind == NodeKind::divide) k.divide(out, lhs, rhs);
+}
+
+template<typename ResultType, typename KernelType>
+template<NodeKind kind>
+void Evaluator<ResultType, KernelType>::in_place_kernel_(
+  result_type& lhs, const result_type& rhs) {
+    auto& k = m_kernels_;
+    if constexpr(kind == NodeKind::add) k.add_assign(lhs, rhs);
+    if constexpr(kind == NodeKind::subtract) k.subtract_assign(lhs, rhs);
+    if constexpr(kind == NodeKind::multiply) k.multiply_assign(lhs, rhs);
+    if constexpr(kind == NodeKind::divide) k.divide_assign(lhs, rhs);
+}
+
+template<typename ResultType, typename KernelType>
+void Evaluator<ResultType, KernelType>::reset_buffers_() {
+    m_free_.resize(m_buffers_.size());
+    for(size_type i = 0; i < m_free_.size(); ++i)
+        m_free_[i] = m_free_.size() - i - 1;
+}
+
+template<typename ResultType, typename KernelType>
+typename Evaluator<ResultType, KernelType>::size_type
+Evaluator<ResultType, KernelType>::acquire_() {
+    if(m_free_.empty()) {
+        m_buffers_.emplace_back();
+        return m_buffers_.size() - 1;
+    }
+    const auto i = m_free_.back();
+    m_free_.pop_back();
+    return i;
+}
+
+} // namespace utilities::dsl
@@ -0,0 +1,235 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace utilities::dsl {
+
+class Leaf;
+
+/** @brief A monotonic buffer for the nodes of DSL expression trees.
+ *
+ *  Expression trees are typically built, evaluated once, and thrown away.
+ *  Leaves which are too big to be stored inside of their Leaf object (e.g.,
+ *  sub-expressions held by value) would normally each be allocated on the
+ *  heap. While an ExpressionArena is active on a thread (see Scope), those
+ *  leaves are instead carved out of the arena's blocks by bumping a pointer.
+ *  Destroying a Leaf runs its destructor but does not give the memory back;
+ *  the memory of every tree built in the arena is reclaimed at once by
+ *  `release()` (or by destroying the arena). Note that only the memory is
+ *  reclaimed in O(1); each Leaf is still destroyed individually, so the
+ *  destructors of the held objects run once per leaf.
+ *
+ *  `release()` keeps the blocks around, so building trees in a loop which
+ *  releases the arena at the end of each iteration stops touching the heap
+ *  after the first iteration:
+ *
+ *  @code
+ *  ExpressionArena arena;
+ *  for(auto& task : tasks) {
+ *      {
+ *          ExpressionArena::Scope scope(arena);
+ *          auto expr = build_expression(task);
+ *          evaluate(expr);
+ *      } // expr is destroyed here
+ *      arena.release();
+ *  }
+ *  @endcode
+ *
+ *  @note Every Leaf whose holder lives in the arena must be destroyed before
+ *        the arena is released or destroyed. The arena counts these leaves
+ *        (see live_leaves), and in debug builds releasing or destroying an
+ *        arena which still has live leaves fails an assertion.
+ */
+class ExpressionArena {
+public:
+    /// Type used for sizes and offsets
+    using size_type = std::size_t;
+
+    /// Default size, in bytes, of the blocks
+    static constexpr size_type default_block_size = 64 * 1024;
+
+    /** @brief Makes *this the active arena on the current thread.
+     *
+     *  The previously active arena (if any) becomes active again when the
+     *  Scope is destroyed, so scopes may be nested.
+     *
+     *  While the Scope is alive, every Leaf which is made, or copied, and
+     *  does not fit inside of itself is allocated in the arena. Such a Leaf
+     *  (and any Leaf it is moved into) may escape the Scope, e.g., by being
+     *  returned, but it must not escape the arena: it has to be destroyed
+     *  before the arena is released. To keep an expression beyond that,
+     *  copy it after the Scope ends (the copy is made on the heap).
+     */
+    class Scope {
+    public:
+        /// Activates @p arena, which must outlive *this
+        explicit Scope(ExpressionArena& arena) noexcept :
+          m_previous_(std::exchange(current_(), &arena)) {}
+
+        /// Reactivates the previously active arena
+        ~Scope() noexcept { current_() = m_previous_; }
+
+        Scope(const Scope&)            = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        /// The arena which was active when *this was created
+        ExpressionArena* m_previous_;
+    };
+
+    /** @brief Creates an arena which has not allocated any memory yet.
+     *
+     *  @param[in] block_size The size, in bytes, of the blocks the arena
+     *                        allocates. Allocations larger than this get a
+     *                        block of their own. Default is
+     *                        `default_block_size`.
+     *
+     *  @throw None No throw guarantee.
+     */
+    explicit ExpressionArena(
+      size_type block_size = default_block_size) noexcept :
+      m_block_size_(block_size > 0 ? block_size : 1) {}
+
+    /// The arena can't be copied or moved (scopes and leaves point to it)
+    ///@{
+    ExpressionArena(const ExpressionArena&)            = delete;
+    ExpressionArena& operator=(const ExpressionArena&) = delete;
+    ///@}
+
+    /// Frees the blocks, all leaves allocated in *this must be destroyed
+    ~ExpressionArena() noexcept {
+        assert(m_live_leaves_ == 0 && "A Leaf outlived its ExpressionArena");
+    }
+
+    /** @brief Returns @p n bytes aligned to @p alignment.
+     *
+     *  @param[in] n The number of bytes needed.
+     *  @param[in] alignment The alignment needed. Must be a power of 2.
+     *
+     *  @return A pointer to the memory. It remains valid until `release()` is
+     *          called or *this is destroyed.
+     *
+     *  @throw std::bad_alloc if a new block is needed and can not be
+     *                        allocated. Strong throw guarantee.
+     */
+    void* allocate(size_type n, size_type alignment) {
+        while(m_current_ < m_blocks_.size()) {
+            if(auto* p = bump_(m_blocks_[m_current_], n, alignment)) return p;
+            ++m_current_;
+            m_offset_ = 0;
+        }
+        const auto size = n + alignment > m_block_size_ ? n + alignment :
+                                                          m_block_size_;
+        m_blocks_.push_back(Block{std::make_unique<unsigned char[]>(size),
+                                  size});
+        m_capacity_ += size;
+        return bump_(m_blocks_.back(), n, alignment);
+    }
+
+    /** @brief Reclaims all of the memory handed out by *this.
+     *
+     *  The blocks are kept for reuse, so this is O(1) regardless of how many
+     *  trees were built in the arena. It does not destroy anything; all of
+     *  the leaves allocated in *this must already have been destroyed.
+     *
+     *  @throw None No throw guarantee.
+     */
+    void release() noexcept {
+        assert(m_live_leaves_ == 0 && "A Leaf outlived its ExpressionArena");
+        m_current_ = 0;
+        m_offset_  = 0;
+        m_used_    = 0;
+    }
+
+    /// The number of bytes handed out since the last release (incl. padding)
+    size_type bytes_used() const noexcept { return m_used_; }
+
+    /// The total size of the blocks owned by *this
+    size_type capacity() const noexcept { return m_capacity_; }
+
+    /// The number of Leaf objects whose holders live in *this
+    size_type live_leaves() const noexcept { return m_live_leaves_; }
+
+    /// The arena active on the current thread (null if there isn't one)
+    static ExpressionArena* current() noexcept { return current_(); }
+
+private:
+    /// Leaf reports the holders it puts in (and removes from) the arena
+    friend class Leaf;
+
+    /// Allocates a holder for a Leaf, see allocate
+    void* allocate_leaf_(size_type n, size_type alignment) {
+        auto* p = allocate(n, alignment);
+        ++m_live_leaves_;
+        return p;
+    }
+
+    /// Notes that a holder allocated by allocate_leaf_ was destroyed
+    void destroy_leaf_() noexcept { --m_live_leaves_; }
+
+    /// A chunk of memory allocations are carved out of
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_type size;
+    };
+
+    /// Takes @p n bytes from @p block, returns nullptr if they don't fit
+    void* bump_(Block& block, size_type n, size_type alignment) noexcept {
+        const auto base  = reinterpret_cast<std::uintptr_t>(block.data.get());
+        const auto first = base + m_offset_;
+        const auto p     = (first + alignment - 1) & ~(alignment - 1);
+        if(p + n > base + block.size) return nullptr;
+        m_used_ += p + n - first;
+        m_offset_ = p + n - base;
+        return reinterpret_cast<void*>(p);
+    }
+
+    /// The thread's active arena
+    static ExpressionArena*& current_() noexcept {
+        thread_local ExpressionArena* arena = nullptr;
+        return arena;
+    }
+
+    /// The size of a (regular) block
+    size_type m_block_size_;
+
+    /// The blocks, in the order they are used
+    std::vector<Block> m_blocks_;
+
+    /// The block allocations currently come from
+    size_type m_current_ = 0;
+
+    /// How far into m_blocks_[m_current_] we are
+    size_type m_offset_ = 0;
+
+    /// See bytes_used
+    size_type m_used_ = 0;
+
+    /// See capacity
+    size_type m_capacity_ = 0;
+
+    /// See live_leaves
+    size_type m_live_leaves_ = 0;
+};
+
+} // namespace utilities::dsl
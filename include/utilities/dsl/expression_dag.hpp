@@ -0,0 +1,492 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/structural_hash.hpp>
+#include <vector>
+
+namespace utilities::dsl {
+
+/** @brief An expression with its common subexpressions merged.
+ *
+ *  @tparam EvaluatorType The type of the Evaluator which made *this. The
+ *                        leaves of the DAG are type-erased, and only the
+ *                        Evaluator knows how to evaluate them.
+ *
+ *  ExpressionDAG objects are made by Evaluator::make_dag. Each node is one of:
+ *
+ *  - a constant, i.e., a double literal from the tree or a value computed by
+ *    a rewrite,
+ *  - another leaf of the tree, which *this aliases,
+ *  - a binary operation (add, subtract, multiply, or divide),
+ *  - a sum or product of more than two operands (see make_nary), or
+ *  - a function call.
+ *
+ *  Nodes are hash-consed: adding a node equal to an existing one returns the
+ *  existing one. The nodes are stored so that each node comes after all of
+ *  its children, the last node being the root.
+ *
+ *  Passes over the DAG are written as rewrite rules (see rewrite and
+ *  simplify.hpp), which use the public accessors to inspect a node and
+ *  make_constant/make_binary/make_nary to build its replacement.
+ */
+template<typename EvaluatorType>
+class ExpressionDAG {
+public:
+    /// Type used for counting and indexing
+    using size_type = std::size_t;
+
+    /// The number of unique nodes (leaves included)
+    size_type size() const noexcept { return m_nodes_.size(); }
+
+    /// Does *this have no nodes?
+    bool empty() const noexcept { return m_nodes_.empty(); }
+
+    /// The index of the root node, i.e., the last node
+    size_type root() const noexcept { return size() - 1; }
+
+    /// The number of nodes which use node @p i as an input
+    size_type use_count(size_type i) const { return m_uses_.at(i); }
+
+    /// The kind of node @p i
+    NodeKind kind(size_type i) const { return m_nodes_.at(i).kind; }
+
+    /// The structural hash of node @p i
+    std::size_t hash(size_type i) const { return m_nodes_.at(i).hash; }
+
+    /// Is node @p i a constant?
+    bool is_constant(size_type i) const {
+        const auto& node = m_nodes_.at(i);
+        return node.kind == NodeKind::leaf && node.run == nullptr;
+    }
+
+    /// Is node @p i a constant equal to @p value?
+    bool is_constant(size_type i, double value) const {
+        return is_constant(i) && m_nodes_[i].value == value;
+    }
+
+    /** @brief The value of the constant node @p i.
+     *
+     *  @throw std::invalid_argument if node @p i is not a constant. Strong
+     *                               throw guarantee.
+     */
+    double value(size_type i) const {
+        if(!is_constant(i))
+            throw std::invalid_argument("Node is not a constant");
+        return m_nodes_[i].value;
+    }
+
+    /** @brief The object wrapped by leaf @p i, if it is a @p T.
+     *
+     *  @tparam T The type the caller thinks the leaf is (cv-qualifiers are
+     *            ignored).
+     *
+     *  @param[in] i The index of the node.
+     *
+     *  @return A pointer to the leaf if node @p i is a (non-constant) leaf of
+     *          type @p T and nullptr otherwise.
+     *
+     *  @throw std::out_of_range if @p i is not a node. Strong throw guarantee.
+     */
+    template<typename T>
+    const T* leaf_as(size_type i) const {
+        const auto& node = m_nodes_.at(i);
+        const auto type  = detail_::type_id<std::remove_cv_t<T>>();
+        if(node.kind != NodeKind::leaf || node.type != type) return nullptr;
+        return static_cast<const T*>(node.object);
+    }
+
+    /// The number of inputs to node @p i
+    size_type n_children(size_type i) const {
+        return m_nodes_.at(i).n_children;
+    }
+
+    /// The index of the @p j-th input to node @p i
+    size_type child(size_type i, size_type j) const {
+        const auto& node = m_nodes_.at(i);
+        if(j >= node.n_children) throw std::out_of_range("No such child");
+        return m_children_[node.first_child + j];
+    }
+
+    /** @brief Adds a constant node.
+     *
+     *  @param[in] value The value of the constant.
+     *
+     *  @return The index of the node, which may be an existing node.
+     *
+     *  @throw std::bad_alloc if there is a problem allocating the node.
+     *                        Strong throw guarantee.
+     */
+    size_type make_constant(double value);
+
+    /** @brief Adds a binary operation node.
+     *
+     *  @param[in] kind The operation. Must be add, subtract, multiply, or
+     *                  divide.
+     *  @param[in] lhs The index of the left operand.
+     *  @param[in] rhs The index of the right operand.
+     *
+     *  @return The index of the node, which may be an existing node.
+     *
+     *  @throw std::invalid_argument if @p kind is not a binary operation.
+     *                               Strong throw guarantee.
+     *  @throw std::out_of_range if @p lhs or @p rhs is not a node. Strong
+     *                           throw guarantee.
+     */
+    size_type make_binary(NodeKind kind, size_type lhs, size_type rhs);
+
+    /** @brief Adds an operation node with any number of operands.
+     *
+     *  Sums and products may have more than two operands (see Sum and
+     *  Product), which the Evaluator accumulates into one buffer. The other
+     *  operations must have exactly two.
+     *
+     *  @param[in] kind The operation. Must be add, subtract, multiply, or
+     *                  divide.
+     *  @param[in] children The indices of the operands, in order. There must
+     *                      be at least two, and exactly two unless @p kind is
+     *                      add or multiply.
+     *
+     *  @return The index of the node, which may be an existing node.
+     *
+     *  @throw std::invalid_argument if @p kind is not an operation, or can
+     *                               not have that many operands. Strong
+     *                               throw guarantee.
+     *  @throw std::out_of_range if one of @p children is not a node. Strong
+     *                           throw guarantee.
+     */
+    size_type make_nary(NodeKind kind, const std::vector<size_type>& children);
+
+    /** @brief Rewrites *this with @p rules until no rule applies.
+     *
+     *  @tparam RuleTypes The types of the rules.
+     *
+     *  A rule is a callable with the signature
+     *  `size_type(ExpressionDAG&, size_type i)`. It returns @p i if it does not
+     *  apply to node @p i, and the index of the (possibly new) replacement
+     *  node otherwise. The nodes are visited children first, so when a rule
+     *  sees a node its children have already been rewritten. Nodes which are
+     *  no longer used are removed at the end of each sweep over the DAG.
+     *
+     *  Rules must eventually stop applying. As a safeguard, at most
+     *  `max_sweeps` sweeps are made.
+     *
+     *  @param[in] rules The rules to apply, in order.
+     *
+     *  @return True if any rule applied and false otherwise.
+     *
+     *  @throw ??? Throws if a rule throws. *this is left in a valid, but
+     *             unspecified, state.
+     */
+    template<typename... RuleTypes>
+    bool rewrite(RuleTypes&&... rules);
+
+    /** @brief Makes one pass over *this, replacing nodes with @p fxn.
+     *
+     *  @tparam FunctionType The type of @p fxn.
+     *
+     *  This is the primitive rewrite is built on, and is useful for passes
+     *  which first analyze the whole DAG (and thus need to know which
+     *  original node they are replacing). @p fxn has the signature
+     *  `size_type(ExpressionDAG&, size_type i, size_type j)`. It is called
+     *  for each node @p i of *this, children first. @p j is node @p i with
+     *  its children replaced by their replacements (and may be @p i). The
+     *  return is the replacement of node @p i. Once every node has been
+     *  visited, nodes which are no longer used are removed.
+     *
+     *  @param[in] fxn The function choosing the replacements.
+     *
+     *  @return True if any node was replaced and false otherwise.
+     *
+     *  @throw ??? Throws if @p fxn throws. *this is left in a valid, but
+     *             unspecified, state.
+     */
+    template<typename FunctionType>
+    bool transform(FunctionType&& fxn);
+
+    /// The maximum number of sweeps rewrite makes
+    static constexpr size_type max_sweeps = 64;
+
+private:
+    /// The Evaluator builds and evaluates the DAG
+    friend EvaluatorType;
+
+    /// Type of the function which evaluates a leaf or a function call
+    using run_function = void (*)(EvaluatorType&, const ExpressionDAG&,
+                                  size_type,
+                                  typename EvaluatorType::result_type&,
+                                  const typename EvaluatorType::argument_list&);
+
+    /// Type of the function which compares two leaves or callables
+    using equal_function = bool (*)(const void*, const void*);
+
+    /// A unique (sub)expression
+    struct Node {
+        /// What sort of node this is
+        NodeKind kind;
+
+        /// Hashed together with the children's hashes to make hash
+        std::size_t seed;
+
+        /// The structural hash of the node
+        std::size_t hash;
+
+        /// The children are m_children_[first_child, first_child + n_children)
+        size_type first_child;
+        size_type n_children;
+
+        /// The value of a constant
+        double value;
+
+        /// The leaf, or the FunctionCall holding the callable
+        const void* object;
+
+        /// Evaluates leaves and function calls, null for everything else
+        run_function run;
+
+        /// Compares leaves or callables, null for everything else
+        equal_function equal;
+
+        /// The type of a (non-constant) leaf, null for everything else
+        detail_::type_id_type type;
+    };
+
+    /// Adds a (non-constant) leaf
+    size_type add_leaf_(const void* object, run_function run,
+                        equal_function equal, std::size_t hash,
+                        detail_::type_id_type type) {
+        Node node{NodeKind::leaf, hash, hash, 0, 0, 0.0, object, run, equal,
+                  type};
+        return intern_(node, nullptr);
+    }
+
+    /// Adds a function call whose (evaluated) arguments are @p children
+    size_type add_function_call_(const void* object, run_function run,
+                                 equal_function equal, std::size_t seed,
+                                 const size_type* children, size_type n) {
+        Node node{NodeKind::function_call, seed, seed, 0, n, 0.0, object, run,
+                  equal, nullptr};
+        return intern_(node, children);
+    }
+
+    /// Returns an existing node equal to @p node, or adds @p node
+    size_type intern_(Node node, const size_type* children);
+
+    /// Does existing node @p i equal @p node with @p children?
+    bool equal_(size_type i, const Node& node,
+                const size_type* children) const;
+
+    /// Replaces node @p i's children using @p map, returns the new node
+    size_type remap_(size_type i, const std::vector<size_type>& map);
+
+    /// Removes nodes which @p root doesn't depend on, recounts uses
+    void compact_(size_type root);
+
+    /// The unique nodes
+    std::vector<Node> m_nodes_;
+
+    /// The children of all of the nodes, node i's are contiguous
+    std::vector<size_type> m_children_;
+
+    /// m_uses_[i] is the number of nodes using node i
+    std::vector<size_type> m_uses_;
+
+    /// Maps the (full) hash of a node to its index
+    std::unordered_multimap<std::size_t, size_type> m_lookup_;
+};
+
+// -----------------------------------------------------------------------------
+// -- Out of line inline definitions
+// -----------------------------------------------------------------------------
+
+template<typename EvaluatorType>
+typename ExpressionDAG<EvaluatorType>::size_type
+ExpressionDAG<EvaluatorType>::make_constant(double value) {
+    const auto hash = structural_hash(value);
+    Node node{NodeKind::leaf, hash, hash, 0, 0, value, nullptr, nullptr,
+              nullptr, nullptr};
+    return intern_(node, nullptr);
+}
+
+template<typename EvaluatorType>
+typename ExpressionDAG<EvaluatorType>::size_type
+ExpressionDAG<EvaluatorType>::make_binary(NodeKind kind, size_type lhs,
+                                          size_type rhs) {
+    if(kind == NodeKind::leaf || kind == NodeKind::function_call)
+        throw std::invalid_argument("Not a binary operation");
+    if(lhs >= size() || rhs >= size())
+        throw std::out_of_range("Operand is not a node");
+    const size_type children[] = {lhs, rhs};
+    const auto seed            = static_cast<std::size_t>(kind);
+    Node node{kind, seed, seed, 0, 2, 0.0, nullptr, nullptr, nullptr, nullptr};
+    return intern_(node, children);
+}
+
+template<typename EvaluatorType>
+typename ExpressionDAG<EvaluatorType>::size_type
+ExpressionDAG<EvaluatorType>::make_nary(
+  NodeKind kind, const std::vector<size_type>& children) {
+    const auto n = children.size();
+    if(n == 2) return make_binary(kind, children[0], children[1]);
+    if(kind != NodeKind::add && kind != NodeKind::multiply)
+        throw std::invalid_argument("Only sums and products are n-ary");
+    if(n < 2) throw std::invalid_argument("Need at least two operands");
+    for(auto c : children)
+        if(c >= size()) throw std::out_of_range("Operand is not a node");
+    const auto seed = static_cast<std::size_t>(kind);
+    Node node{kind, seed, seed, 0, n, 0.0, nullptr, nullptr, nullptr, nullptr};
+    return intern_(node, children.data());
+}
+
+template<typename EvaluatorType>
+template<typename... RuleTypes>
+bool ExpressionDAG<EvaluatorType>::rewrite(RuleTypes&&... rules) {
+    // Guards against rules which bounce between two forms
+    constexpr size_type max_steps = 64;
+
+    auto apply = [&](ExpressionDAG& dag, size_type, size_type j) {
+        for(size_type step = 0; step < max_steps; ++step) {
+            const auto old = j;
+            ((j = rules(dag, j)), ...);
+            if(j == old) break;
+        }
+        return j;
+    };
+
+    bool rv = false;
+    for(size_type sweep = 0; sweep < max_sweeps; ++sweep) {
+        if(!transform(apply)) break;
+        rv = true;
+    }
+    return rv;
+}
+
+template<typename EvaluatorType>
+template<typename FunctionType>
+bool ExpressionDAG<EvaluatorType>::transform(FunctionType&& fxn) {
+    if(empty()) return false;
+    const auto n = size();
+    std::vector<size_type> map(n);
+    bool changed = false;
+    for(size_type i = 0; i < n; ++i) {
+        map[i]  = fxn(*this, i, remap_(i, map));
+        changed = changed || (map[i] != i);
+    }
+
+    // fxn may have added nodes, even if it didn't use them
+    compact_(map[n - 1]);
+    return changed;
+}
+
+template<typename EvaluatorType>
+typename ExpressionDAG<EvaluatorType>::size_type
+ExpressionDAG<EvaluatorType>::intern_(Node node, const size_type* children) {
+    // Operations hash their seed together with their children's hashes
+    auto hash = node.seed;
+    for(size_type j = 0; j < node.n_children; ++j)
+        hash = detail_::hash_combine(hash, m_nodes_[children[j]].hash);
+
+    auto [first, last] = m_lookup_.equal_range(hash);
+    for(; first != last; ++first)
+        if(equal_(first->second, node, children)) return first->second;
+
+    node.hash        = hash;
+    node.first_child = m_children_.size();
+    const auto i     = size();
+    m_children_.insert(m_children_.end(), children,
+                       children + node.n_children);
+    m_nodes_.push_back(node);
+    m_uses_.push_back(0);
+    for(size_type j = 0; j < node.n_children; ++j) ++m_uses_[children[j]];
+    m_lookup_.emplace(hash, i);
+    return i;
+}
+
+template<typename EvaluatorType>
+bool ExpressionDAG<EvaluatorType>::equal_(size_type i, const Node& node,
+                                          const size_type* children) const {
+    const auto& other = m_nodes_[i];
+    if(other.kind != node.kind || other.n_children != node.n_children)
+        return false;
+    if(other.run != node.run || other.equal != node.equal) return false;
+    for(size_type j = 0; j < node.n_children; ++j)
+        if(m_children_[other.first_child + j] != children[j]) return false;
+
+    if(node.kind == NodeKind::leaf && node.run == nullptr)
+        return other.value == node.value;
+    if(node.equal != nullptr) return node.equal(other.object, node.object);
+    return true;
+}
+
+template<typename EvaluatorType>
+typename ExpressionDAG<EvaluatorType>::size_type
+ExpressionDAG<EvaluatorType>::remap_(size_type i,
+                                     const std::vector<size_type>& map) {
+    const auto node = m_nodes_[i]; // Copy, intern_ may reallocate
+    bool changed    = false;
+    std::vector<size_type> children(node.n_children);
+    for(size_type j = 0; j < node.n_children; ++j) {
+        children[j] = map[m_children_[node.first_child + j]];
+        changed = changed || children[j] != m_children_[node.first_child + j];
+    }
+    if(!changed) return i;
+
+    return intern_(node, children.data());
+}
+
+template<typename EvaluatorType>
+void ExpressionDAG<EvaluatorType>::compact_(size_type root) {
+    // Children always precede their parents, so one backwards pass finds
+    // everything root depends on
+    std::vector<bool> keep(root + 1, false);
+    keep[root] = true;
+    for(auto i = root + 1; i-- > 0;) {
+        if(!keep[i]) continue;
+        const auto& node = m_nodes_[i];
+        for(size_type j = 0; j < node.n_children; ++j)
+            keep[m_children_[node.first_child + j]] = true;
+    }
+
+    std::vector<Node> nodes;
+    std::vector<size_type> children;
+    std::vector<size_type> new_index(root + 1);
+    for(size_type i = 0; i <= root; ++i) {
+        if(!keep[i]) continue;
+        auto node        = m_nodes_[i];
+        const auto first = node.first_child;
+        node.first_child = children.size();
+        for(size_type j = 0; j < node.n_children; ++j)
+            children.push_back(new_index[m_children_[first + j]]);
+        new_index[i] = nodes.size();
+        nodes.push_back(node);
+    }
+
+    m_nodes_    = std::move(nodes);
+    m_children_ = std::move(children);
+    m_uses_.assign(size(), 0);
+    m_lookup_.clear();
+    for(size_type i = 0; i < size(); ++i) {
+        for(size_type j = 0; j < n_children(i); ++j) ++m_uses_[child(i, j)];
+        m_lookup_.emplace(m_nodes_[i].hash, i);
+    }
+}
+
+} // namespace utilities::dsl
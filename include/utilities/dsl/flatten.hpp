@@ -0,0 +1,228 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utilities/dsl/add.hpp>
+#include <utilities/dsl/divide.hpp>
+#include <utilities/dsl/function_call.hpp>
+#include <utilities/dsl/multiply.hpp>
+#include <utilities/dsl/product.hpp>
+#include <utilities/dsl/subtract.hpp>
+#include <utilities/dsl/sum.hpp>
+#include <utility>
+#include <vector>
+
+/** @file flatten.hpp
+ *
+ *  Because Add and Multiply are binary, `a + b + c + d` is a chain of three
+ *  Adds, and evaluating it one link at a time makes a temporary for each
+ *  link. The functions in this file merge such chains into a single Sum (or
+ *  Product), whose operands the Evaluator accumulates into one buffer.
+ *
+ *  - flatten does this for an expression tree, at compile time.
+ *  - flatten_chains does this for an ExpressionDAG, at runtime.
+ *
+ *  Only the grouping changes, the operands stay in their original order.
+ */
+
+namespace utilities::dsl {
+
+template<typename T>
+auto flatten(T&& expr);
+
+namespace detail_ {
+
+/// Is @p T an operation flatten descends into?
+template<typename T>
+constexpr bool is_flattenable_v =
+  std::is_base_of_v<Term<T>, T> && node_kind_v<T> != NodeKind::leaf;
+
+/// Makes an OpType out of the objects in @p objects
+template<template<typename...> class OpType, typename TupleType>
+auto make_from_tuple_(TupleType&& objects) {
+    // References in the tuple are aliased objects, values are owned objects
+    auto fxn = [](auto&&... args) {
+        using op_type = OpType<std::remove_reference_t<decltype(args)>...>;
+        return op_type(std::forward<decltype(args)>(args)...);
+    };
+    return std::apply(fxn, std::forward<TupleType>(objects));
+}
+
+/// Wraps the (flattened) @p I-th object of @p op in a tuple
+template<std::size_t I, typename OpType>
+auto flatten_object_(OpType& op) {
+    using reference  = decltype(op.template object<I>());
+    using value_type = std::decay_t<reference>;
+    if constexpr(is_flattenable_v<value_type>) {
+        return std::make_tuple(flatten(op.template object<I>()));
+    } else if constexpr(TermTraits<value_type>::is_dsl_term_v) {
+        return std::tuple<value_type>(op.template object<I>());
+    } else {
+        // Keeps the const-ness the object was aliased with
+        return std::tuple<reference>(op.template object<I>());
+    }
+}
+
+/// The flattened objects of @p op
+template<typename OpType, std::size_t... Is>
+auto flatten_objects_(OpType& op, std::index_sequence<Is...>) {
+    return std::tuple_cat(flatten_object_<Is>(op)...);
+}
+
+template<NodeKind Kind, typename OpType, std::size_t... Is>
+auto chain_operands_(OpType& op, std::index_sequence<Is...>);
+
+/// The operands the @p I-th object of @p op contributes to a Kind chain
+template<NodeKind Kind, std::size_t I, typename OpType>
+auto chain_object_(OpType& op) {
+    using value_type = std::decay_t<decltype(op.template object<I>())>;
+    if constexpr(is_flattenable_v<value_type> &&
+                 node_kind_v<value_type> == Kind) {
+        auto& child = op.template object<I>();
+        constexpr auto n = value_type::N;
+        return chain_operands_<Kind>(child, std::make_index_sequence<n>{});
+    } else {
+        return flatten_object_<I>(op);
+    }
+}
+
+/// The operands of the Kind chain rooted at @p op, left to right
+template<NodeKind Kind, typename OpType, std::size_t... Is>
+auto chain_operands_(OpType& op, std::index_sequence<Is...>) {
+    return std::tuple_cat(chain_object_<Kind, Is>(op)...);
+}
+
+} // namespace detail_
+
+/** @brief Merges the chains of additions and multiplications in @p expr.
+ *
+ *  @tparam T The type of @p expr. Must be one of the DSL's operations.
+ *
+ *  Each maximal chain of Adds and Sums in @p expr becomes a single Sum and
+ *  each maximal chain of Multiplys and Products becomes a single Product,
+ *  e.g., `a * b * c + d + e` becomes `sum(product(a, b, c), d, e)`. The
+ *  other operations are rebuilt with their objects flattened.
+ *
+ *  Terms, doubles, and strings are copied into the result. The other
+ *  objects are aliased, with the const-ness @p expr gives them (if @p expr
+ *  is const they become const). So, if @p expr was made from temporaries
+ *  which are not part of the DSL, @p expr must outlive the result.
+ *
+ *  @param[in] expr The expression to flatten.
+ *
+ *  @return The flattened expression.
+ *
+ *  @throw std::bad_alloc if copying the objects fails. Strong throw
+ *                        guarantee.
+ */
+template<typename T>
+auto flatten(T&& expr) {
+    using clean_type = std::decay_t<T>;
+    static_assert(detail_::is_flattenable_v<clean_type>,
+                  "Only the DSL's operations can be flattened");
+
+    constexpr auto kind = node_kind_v<clean_type>;
+    constexpr auto is   = std::make_index_sequence<clean_type::N>{};
+    auto& op            = expr;
+    if constexpr(kind == NodeKind::add) {
+        auto operands = detail_::chain_operands_<kind>(op, is);
+        return detail_::make_from_tuple_<Sum>(std::move(operands));
+    } else if constexpr(kind == NodeKind::multiply) {
+        auto operands = detail_::chain_operands_<kind>(op, is);
+        return detail_::make_from_tuple_<Product>(std::move(operands));
+    } else {
+        auto objects = detail_::flatten_objects_(op, is);
+        if constexpr(kind == NodeKind::subtract) {
+            return detail_::make_from_tuple_<Subtract>(std::move(objects));
+        } else if constexpr(kind == NodeKind::divide) {
+            return detail_::make_from_tuple_<Divide>(std::move(objects));
+        } else {
+            return detail_::make_from_tuple_<FunctionCall>(std::move(objects));
+        }
+    }
+}
+
+/** @brief Merges the chains of additions and multiplications in @p dag.
+ *
+ *  @tparam DAGType The type of @p dag.
+ *
+ *  This is flatten for DAGs. An addition (multiplication) whose only user
+ *  is also an addition (multiplication) is merged into its user, and the
+ *  resulting chains are replaced by n-ary nodes (see
+ *  ExpressionDAG::make_nary). Nodes used more than once stay separate, so
+ *  common subexpressions are still only evaluated once.
+ *
+ *  Most of the rules in simplify.hpp only look at binary operations, so
+ *  @p dag should be simplified (and its products reordered) first.
+ *
+ *  @param[in,out] dag The DAG to flatten.
+ *
+ *  @return True if any chain was merged and false otherwise.
+ *
+ *  @throw std::bad_alloc if there is insufficient memory. @p dag is left in
+ *                        a valid, but unspecified, state.
+ */
+template<typename DAGType>
+bool flatten_chains(DAGType& dag) {
+    using size_type = typename DAGType::size_type;
+    const auto n    = dag.size();
+    auto is_chain   = [&](size_type i) {
+        const auto kind = dag.kind(i);
+        return kind == NodeKind::add || kind == NodeKind::multiply;
+    };
+
+    // An operation is interior to a chain if its only user is the same kind
+    std::vector<bool> interior(n, false);
+    for(size_type i = 0; i < n; ++i) {
+        if(!is_chain(i)) continue;
+        for(size_type j = 0; j < dag.n_children(i); ++j) {
+            const auto c = dag.child(i, j);
+            if(dag.kind(c) == dag.kind(i) && dag.use_count(c) == 1)
+                interior[c] = true;
+        }
+    }
+
+    // The replacement of each (original) node
+    std::vector<size_type> new_index(n);
+    auto fxn = [&](DAGType& d, size_type i, size_type j) {
+        new_index[i] = j;
+        if(!is_chain(i) || interior[i]) return j;
+
+        // The operands of the chain rooted at i, left to right
+        std::vector<size_type> operands;
+        bool merged = false;
+        std::vector<size_type> todo{i};
+        while(!todo.empty()) {
+            const auto k = todo.back();
+            todo.pop_back();
+            if(k != i && !interior[k]) {
+                operands.push_back(new_index[k]);
+                continue;
+            }
+            merged = merged || k != i;
+            for(auto c = d.n_children(k); c-- > 0;)
+                todo.push_back(d.child(k, c));
+        }
+        if(merged) new_index[i] = d.make_nary(d.kind(i), operands);
+        return new_index[i];
+    };
+    return dag.transform(fxn);
+}
+
+} // namespace utilities::dsl
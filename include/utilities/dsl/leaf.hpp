@@ -15,8 +15,10 @@
  */
 
 #pragma once
+#include <cstddef>
 #include <stdexcept>
 #include <utilities/dsl/detail_/leaf_holder.hpp>
+#include <utilities/dsl/expression_arena.hpp>
 #include <utility>
 
 namespace utilities::dsl {
@@ -26,6 +28,12 @@ namespace utilities::dsl {
  *  This class type-erases a true leaf of the AST (nodes with no descendents)
  *  or an effective leaf (node and descendents of that node are treated as
  *  a single entity).
+ *
+ *  Most leaves are small (an aliasing pointer, or a double held by value), so
+ *  Leaf stores holders of up to `inline_size` bytes in a buffer inside of
+ *  itself. Larger holders (and holders which may throw when moved) are
+ *  allocated from the thread's active ExpressionArena, if there is one, and
+ *  on the heap otherwise.
  */
 class Leaf {
 private:
@@ -36,6 +44,16 @@ private:
     using leaf_pointer = typename leaf_holder::leaf_pointer;
 
 public:
+    /// Holders up to this many bytes are stored inside the Leaf
+    static constexpr std::size_t inline_size = 6 * sizeof(void*);
+
+    /// Is a holder of type @p HolderType stored inside the Leaf?
+    template<typename HolderType>
+    static constexpr bool is_stored_inline_v =
+      sizeof(HolderType) <= inline_size &&
+      alignof(HolderType) <= alignof(std::max_align_t) &&
+      std::is_nothrow_move_constructible_v<HolderType>;
+
     /** @brief Creates an empty Leaf object.
      *
      *  The object resulting from the default ctor is equivalent to one value-
@@ -58,7 +76,44 @@ public:
      *
      *  @throw None No throw guarantee.
      */
-    explicit Leaf(leaf_pointer holder) : m_holder_(std::move(holder)) {}
+    explicit Leaf(leaf_pointer holder) noexcept {
+        set_holder_(holder.release(), storage::heap);
+    }
+
+    /** @brief Creates a Leaf which wraps a holder of type @p HolderType.
+     *
+     *  @tparam HolderType The type of the holder to create. Must derive from
+     *                     LeafHolderBase.
+     *  @tparam Args The types of the arguments to @p HolderType's ctor.
+     *
+     *  This is the ctor used by make_leaf. The holder is constructed in place,
+     *  inside of *this if `is_stored_inline_v<HolderType>` is true, and
+     *  otherwise in the active ExpressionArena (or on the heap if no arena is
+     *  active).
+     *
+     *  @param[in] args The arguments to forward to @p HolderType's ctor.
+     *
+     *  @throw std::bad_alloc if the holder must be allocated and allocation
+     *                        fails. Strong throw guarantee.
+     *  @throw ??? if @p HolderType's ctor throws. Strong throw guarantee.
+     */
+    template<typename HolderType, typename... Args>
+    explicit Leaf(std::in_place_type_t<HolderType>, Args&&... args) {
+        static_assert(std::is_base_of_v<leaf_holder, HolderType>);
+        constexpr auto size  = sizeof(HolderType);
+        constexpr auto align = alignof(HolderType);
+        if constexpr(is_stored_inline_v<HolderType>) {
+            auto* p = ::new(m_buffer_) HolderType(std::forward<Args>(args)...);
+            set_holder_(p, storage::inline_buffer);
+        } else if(auto* arena = ExpressionArena::current()) {
+            void* buf = arena->allocate_leaf_(size, align);
+            auto* p   = ::new(buf) HolderType(std::forward<Args>(args)...);
+            set_holder_(p, storage::arena, arena);
+        } else {
+            auto* p = new HolderType(std::forward<Args>(args)...);
+            set_holder_(p, storage::heap);
+        }
+    }
 
     /** @brief Creates a new leaf by copying @p rhs.
      *
@@ -67,18 +122,44 @@ public:
      *  its object and will alias the type-erased object in @p rhs if @p rhs
      *  aliases the object.
      *
+     *  The copy is stored following the same rules as the in-place ctor, i.e.,
+     *  it is stored in the active ExpressionArena (if any) when it does not
+     *  fit inside of *this, regardless of where @p rhs's object lives.
+     *
      *  @param[in] rhs The Leaf to copy.
      *
      *  @throw std::bad_alloc if there is a problem copying @p rhs. Strong throw
      *                        guarantee.
      */
-    Leaf(const Leaf& rhs) :
-      m_holder_(rhs.has_value() ? rhs.m_holder_->clone() : nullptr) {}
+    Leaf(const Leaf& rhs) {
+        if(!rhs.has_value()) return;
+        const auto& holder = *rhs.m_holder_;
+        if(rhs.m_storage_ == storage::inline_buffer) {
+            set_holder_(holder.clone_into(m_buffer_), storage::inline_buffer);
+        } else if(auto* arena = ExpressionArena::current()) {
+            const auto size  = holder.holder_size();
+            const auto align = holder.holder_alignment();
+            auto* buf        = arena->allocate_leaf_(size, align);
+            auto* p          = holder.clone_into(buf);
+            set_holder_(p, storage::arena, arena);
+        } else {
+            set_holder_(holder.clone().release(), storage::heap);
+        }
+    }
 
     /** @brief Creates a new Leaf by taking the state from @p rhs.
      *
-     *  This method transfers the type-erased object in @p rhs into *this. No
-     *  reallocation happens and all references to the object remain valid.
+     *  This method transfers the type-erased object in @p rhs into *this. If
+     *  the object is stored on the heap (or in an arena) the pointer to it is
+     *  stolen and all references to it remain valid.
+     *
+     *  Small objects are stored inside of the Leaf. Those are move
+     *  constructed into *this instead, which invalidates references to the
+     *  object held by @p rhs. For a Leaf which aliases an object only the
+     *  pointer is moved, so references to the aliased object remain valid;
+     *  for a Leaf which holds its object by value, references obtained from
+     *  @p rhs (e.g., via `value`) dangle after the move. This differs from
+     *  the heap-only Leaf, where moves never invalidated such references.
      *
      *  @param[in,out] rhs The object to take the state from. After the call
      *                     @p rhs will be in a valid, but otherwise undefined
@@ -86,7 +167,10 @@ public:
      *
      *  @throw None No throw guarantee.
      */
-    Leaf(Leaf&& rhs) noexcept = default;
+    Leaf(Leaf&& rhs) noexcept { take_(rhs); }
+
+    /// Releases the type-erased object (if there is one)
+    ~Leaf() noexcept { reset(); }
 
     /** @brief Overwrites *this with a copy of @p rhs.
      *
@@ -122,7 +206,12 @@ public:
      *
      *  @throw None No throw guarantee.
      */
-    Leaf& operator=(Leaf&& rhs) noexcept = default;
+    Leaf& operator=(Leaf&& rhs) noexcept {
+        if(this == &rhs) return *this;
+        reset();
+        take_(rhs);
+        return *this;
+    }
 
     /** @brief Determines if *this contains a type-erased object.
      *
@@ -134,7 +223,21 @@ public:
      *
      *  @throw None No throw guarantee.
      */
-    bool has_value() const noexcept { return static_cast<bool>(m_holder_); }
+    bool has_value() const noexcept { return m_holder_ != nullptr; }
+
+    /** @brief Does *this alias its object?
+     *
+     *  Leaves made from lvalues alias the object, leaves made from rvalues
+     *  own a copy of it.
+     *
+     *  @return True if *this aliases an object and false if it owns its
+     *          object or is empty.
+     *
+     *  @throw None No throw guarantee.
+     */
+    bool is_alias() const noexcept {
+        return has_value() && m_holder_->is_alias();
+    }
 
     /** @brief Provides type-safe access to the value.
      *
@@ -189,7 +292,14 @@ public:
      *
      *  @throw None No throw guarantee.
      */
-    void reset() noexcept { m_holder_ = nullptr; }
+    void reset() noexcept {
+        if(m_storage_ == storage::heap)
+            delete m_holder_;
+        else if(m_holder_ != nullptr) // The memory belongs to someone else
+            m_holder_->~leaf_holder();
+        if(m_arena_ != nullptr) m_arena_->destroy_leaf_();
+        set_holder_(nullptr, storage::heap);
+    }
 
     /** @brief Exchanges the state of *this with that of @p other.
      *
@@ -199,7 +309,12 @@ public:
      *
      *  @throw None No throw guarantee.
      */
-    void swap(Leaf& other) { m_holder_.swap(other.m_holder_); }
+    void swap(Leaf& other) noexcept {
+        if(this == &other) return;
+        Leaf temp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(temp);
+    }
 
     /** @brief Determines if *this and @p rhs are value equal.
      *
@@ -249,8 +364,49 @@ private:
         throw std::runtime_error("Wrapped object is not convertible to T");
     }
 
-    /// The type-erased object
-    leaf_pointer m_holder_;
+    /// Makes *this take the object in @p rhs, *this must be empty
+    void take_(Leaf& rhs) noexcept {
+        if(!rhs.has_value()) return;
+        if(rhs.m_storage_ == storage::inline_buffer) {
+            auto* p = rhs.m_holder_->move_into(m_buffer_);
+            set_holder_(p, storage::inline_buffer);
+            rhs.reset();
+        } else {
+            set_holder_(rhs.m_holder_, rhs.m_storage_, rhs.m_arena_);
+            rhs.set_holder_(nullptr, storage::heap);
+        }
+    }
+
+    /// Where a holder can live
+    enum class storage : unsigned char { inline_buffer, heap, arena };
+
+    /// Sets m_holder_ to @p p and caches @p p's type information
+    void set_holder_(leaf_holder* p, storage where,
+                     ExpressionArena* arena = nullptr) noexcept {
+        m_holder_   = p;
+        m_storage_  = where;
+        m_arena_    = arena;
+        m_type_id_  = p ? p->type_id() : nullptr;
+        m_is_const_ = p ? p->holds_const() : false;
+    }
+
+    /// The type-erased object, where it lives is given by m_storage_
+    leaf_holder* m_holder_ = nullptr;
+
+    /// m_holder_->type_id() (or null), cached so value() can skip RTTI
+    detail_::type_id_type m_type_id_ = nullptr;
+
+    /// m_holder_->holds_const(), cached for the same reason
+    bool m_is_const_ = false;
+
+    /// Where m_holder_ lives (m_buffer_, the heap, or an ExpressionArena)
+    storage m_storage_ = storage::heap;
+
+    /// The arena m_holder_ lives in, if m_storage_ is storage::arena
+    ExpressionArena* m_arena_ = nullptr;
+
+    /// Storage for small holders
+    alignas(std::max_align_t) unsigned char m_buffer_[inline_size];
 };
 
 /** @brief Wraps an object in a Leaf object.
@@ -264,7 +420,7 @@ private:
 template<typename T>
 auto make_leaf(T&& value) {
     using holder_type = detail_::QualifiedLeafHolder<T&&>;
-    return Leaf(std::make_unique<holder_type>(std::forward<T>(value)));
+    return Leaf(std::in_place_type<holder_type>, std::forward<T>(value));
 }
 
 /** @brief Extracts an object from a Leaf object.
@@ -294,15 +450,29 @@ decltype(auto) unwrap_leaf(LeafType&& leaf) {
 
 template<typename T>
 const std::decay_t<T>& Leaf::value() const {
+    using value_type = std::decay_t<T>;
+
+    // Fast path: compare the type id and const-ness, then downcast statically
+    if(m_type_id_ == detail_::type_id<value_type>()) {
+        if(!m_is_const_) {
+            using holder_type = detail_::LeafHolder<value_type>;
+            return static_cast<const holder_type*>(m_holder_)->value();
+        }
+        if constexpr(std::is_const_v<T>) {
+            using holder_type = detail_::LeafHolder<const value_type>;
+            return static_cast<const holder_type*>(m_holder_)->value();
+        }
+    }
+
+    // Slow path: errors, or type ids which differ across library boundaries
     assert_convertible_<T>(); // Stops us from trying to do const->non-const
 
-    using value_type  = std::decay_t<T>;
     using holder_type = detail_::LeafHolder<value_type>;
-    auto p            = dynamic_cast<const holder_type*>(m_holder_.get());
+    auto p            = dynamic_cast<const holder_type*>(m_holder_);
     if(p != nullptr) return p->value();
 
     using const_holder = detail_::LeafHolder<const value_type>;
-    auto const_p       = dynamic_cast<const const_holder*>(m_holder_.get());
+    auto const_p       = dynamic_cast<const const_holder*>(m_holder_);
     if(const_p != nullptr) return const_p->value();
     throw std::runtime_error("Wrapped value is not of type T");
 }
@@ -0,0 +1,331 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/expression_dag.hpp>
+#include <utility>
+#include <vector>
+
+namespace utilities::dsl {
+
+/// Chains with more factors than this are ordered greedily by default
+inline constexpr std::size_t default_max_dp_chain = 16;
+
+namespace detail_ {
+
+/** @brief Works out the cheapest way to evaluate one chain of multiplications.
+ *
+ *  @tparam DAGType The type of the DAG holding the chain.
+ *  @tparam CostModelType The type of the user's cost model.
+ *
+ *  See reorder_multiply_chains for the requirements on CostModelType.
+ */
+template<typename DAGType, typename CostModelType>
+class MultiplyChainPlanner {
+public:
+    using size_type  = typename DAGType::size_type;
+    using shape_type = std::decay_t<decltype(std::declval<CostModelType&>()
+                                               .shape(std::declval<DAGType&>(),
+                                                      size_type{}))>;
+
+    MultiplyChainPlanner(DAGType& dag, CostModelType& model) :
+      m_dag_(dag), m_model_(model) {}
+
+    /// Sets the factors of the chain, in order
+    void set_factors(const std::vector<size_type>& factors) {
+        m_factors_ = factors;
+        m_shapes_.clear();
+        for(auto f : factors) m_shapes_.push_back(m_model_.shape(m_dag_, f));
+    }
+
+    /// Cost of multiplying two shapes
+    double cost(const shape_type& lhs, const shape_type& rhs) {
+        return static_cast<double>(m_model_.cost(lhs, rhs));
+    }
+
+    /// Shape of the product of two shapes
+    shape_type multiply(const shape_type& lhs, const shape_type& rhs) {
+        return m_model_.multiply(lhs, rhs);
+    }
+
+    /// The shape of the node @p i (which is not a constant)
+    shape_type shape(size_type i) { return m_model_.shape(m_dag_, i); }
+
+    /// Builds the cheapest product found with dynamic programming
+    std::pair<double, size_type> dynamic_programming();
+
+    /// Builds a cheap product by repeatedly doing the cheapest multiplication
+    std::pair<double, size_type> greedy();
+
+private:
+    DAGType& m_dag_;
+    CostModelType& m_model_;
+    std::vector<size_type> m_factors_;
+    std::vector<shape_type> m_shapes_;
+};
+
+template<typename DAGType, typename CostModelType>
+auto MultiplyChainPlanner<DAGType, CostModelType>::dynamic_programming()
+  -> std::pair<double, size_type> {
+    // Textbook matrix-chain ordering, entry [i * n + j] is for factors i..j
+    const auto n = m_factors_.size();
+    std::vector<double> costs(n * n, 0.0);
+    std::vector<size_type> splits(n * n, 0);
+    std::vector<std::optional<shape_type>> shapes(n * n);
+    for(size_type i = 0; i < n; ++i) shapes[i * n + i] = m_shapes_[i];
+
+    for(size_type length = 2; length <= n; ++length) {
+        for(size_type i = 0; i + length <= n; ++i) {
+            const auto j = i + length - 1;
+            auto best    = std::numeric_limits<double>::infinity();
+            for(size_type k = i; k < j; ++k) {
+                const auto& l = *shapes[i * n + k];
+                const auto& r = *shapes[(k + 1) * n + j];
+                const auto c  = costs[i * n + k] + costs[(k + 1) * n + j] +
+                               cost(l, r);
+                if(c < best || k == i) {
+                    best              = c;
+                    splits[i * n + j] = k;
+                }
+            }
+            const auto k      = splits[i * n + j];
+            costs[i * n + j]  = best;
+            shapes[i * n + j] = multiply(*shapes[i * n + k],
+                                         *shapes[(k + 1) * n + j]);
+        }
+    }
+
+    // Build the tree, ranges are popped after their halves have been built
+    struct Range {
+        size_type i;
+        size_type j;
+        bool expanded;
+    };
+    std::vector<Range> todo{{0, n - 1, false}};
+    std::vector<size_type> built;
+    while(!todo.empty()) {
+        auto range = todo.back();
+        todo.pop_back();
+        if(range.i == range.j) {
+            built.push_back(m_factors_[range.i]);
+        } else if(range.expanded) {
+            const auto rhs = built.back();
+            built.pop_back();
+            const auto lhs = built.back();
+            built.pop_back();
+            built.push_back(m_dag_.make_binary(NodeKind::multiply, lhs, rhs));
+        } else {
+            const auto k = splits[range.i * n + range.j];
+            todo.push_back({range.i, range.j, true});
+            todo.push_back({k + 1, range.j, false});
+            todo.push_back({range.i, k, false});
+        }
+    }
+    return {costs[n - 1], built.back()};
+}
+
+template<typename DAGType, typename CostModelType>
+auto MultiplyChainPlanner<DAGType, CostModelType>::greedy()
+  -> std::pair<double, size_type> {
+    auto nodes  = m_factors_;
+    auto shapes = m_shapes_;
+
+    // pair_costs[k] is the cost of multiplying factors k and k + 1
+    std::vector<double> pair_costs;
+    for(size_type k = 0; k + 1 < nodes.size(); ++k)
+        pair_costs.push_back(cost(shapes[k], shapes[k + 1]));
+
+    double total = 0.0;
+    while(nodes.size() > 1) {
+        size_type k = 0;
+        for(size_type l = 1; l < pair_costs.size(); ++l)
+            if(pair_costs[l] < pair_costs[k]) k = l;
+
+        total += pair_costs[k];
+        nodes[k] = m_dag_.make_binary(NodeKind::multiply, nodes[k],
+                                      nodes[k + 1]);
+        shapes[k] = multiply(shapes[k], shapes[k + 1]);
+        nodes.erase(nodes.begin() + k + 1);
+        shapes.erase(shapes.begin() + k + 1);
+        pair_costs.erase(pair_costs.begin() + k);
+
+        // Only the pairs involving the new factor changed
+        if(k > 0) pair_costs[k - 1] = cost(shapes[k - 1], shapes[k]);
+        if(k < pair_costs.size())
+            pair_costs[k] = cost(shapes[k], shapes[k + 1]);
+    }
+    return {total, nodes.front()};
+}
+
+} // namespace detail_
+
+/** @brief Re-parenthesizes chains of multiplications to minimize their cost.
+ *
+ *  @tparam DAGType The type of the DAG, usually `Evaluator<...>::DAG`.
+ *  @tparam CostModelType The type of @p model.
+ *
+ *  The DSL builds `A * B * C * D` as `((A * B) * C) * D`. For tensor
+ *  contractions the order the multiplications are done in can change the
+ *  cost by orders of magnitude. This pass finds each maximal chain of
+ *  multiplications in @p dag, i.e., a multiplication together with all of
+ *  the multiplications feeding into it which are not used anywhere else,
+ *  flattens it into a list of factors, and asks @p model for the costs of
+ *  the possible orders. Chains of up to @p max_dp_size factors are ordered
+ *  optimally with dynamic programming (O(n^3) calls to the model), longer
+ *  chains greedily (the cheapest multiplication of two adjacent factors is
+ *  done first, O(n) calls to the model). A chain is only replaced if the new
+ *  order is cheaper than the current one.
+ *
+ *  The order of the (non-constant) factors is never changed, only the
+ *  parentheses. Constants are taken out of the chain, multiplied together,
+ *  and applied to the result of the chain. Products with more than two
+ *  operands (see flatten.hpp) are not part of any chain; they are treated
+ *  as factors.
+ *
+ *  @p model must provide:
+ *
+ *  - `shape(dag, i)` which returns the shape of node `i`, e.g., by looking
+ *    at `dag.leaf_as<MyTensor>(i)`. The shape can be of any copyable type.
+ *  - `cost(lhs, rhs)` which returns the cost (convertible to double) of
+ *    multiplying an object of shape `lhs` by one of shape `rhs`.
+ *  - `multiply(lhs, rhs)` which returns the shape of the product.
+ *
+ *  @param[in,out] dag The DAG to optimize.
+ *  @param[in] model The cost model.
+ *  @param[in] max_dp_size Chains with more factors than this are ordered
+ *                         greedily. Default is default_max_dp_chain.
+ *
+ *  @return True if any chain was reordered and false otherwise.
+ *
+ *  @throw ??? Throws if @p model throws. @p dag is left in a valid, but
+ *             unspecified, state.
+ */
+template<typename DAGType, typename CostModelType>
+bool reorder_multiply_chains(DAGType& dag, CostModelType& model,
+                             std::size_t max_dp_size = default_max_dp_chain) {
+    using size_type = typename DAGType::size_type;
+    const auto n    = dag.size();
+    // n-ary products are left as they are, i.e., they are factors
+    auto is_multiply = [&](size_type i) {
+        return dag.kind(i) == NodeKind::multiply && dag.n_children(i) == 2;
+    };
+
+    // A multiplication is interior to a chain if its only user multiplies
+    std::vector<bool> interior(n, false);
+    for(size_type i = 0; i < n; ++i) {
+        if(!is_multiply(i)) continue;
+        for(size_type j = 0; j < 2; ++j) {
+            const auto c = dag.child(i, j);
+            if(is_multiply(c) && dag.use_count(c) == 1) interior[c] = true;
+        }
+    }
+
+    // The factors of each chain, from left to right (by original index)
+    std::vector<std::vector<size_type>> factors(n);
+    for(size_type i = 0; i < n; ++i) {
+        if(!is_multiply(i) || interior[i]) continue;
+        std::vector<size_type> todo{i};
+        while(!todo.empty()) {
+            const auto j = todo.back();
+            todo.pop_back();
+            if(j != i && !interior[j]) {
+                factors[i].push_back(j);
+                continue;
+            }
+            todo.push_back(dag.child(j, 1));
+            todo.push_back(dag.child(j, 0));
+        }
+    }
+
+    // The cost of the chain rooted at i as currently parenthesized
+    detail_::MultiplyChainPlanner<DAGType, CostModelType> planner(dag, model);
+    using shape_type = typename decltype(planner)::shape_type;
+    std::vector<size_type> new_index(n);
+    auto current_cost = [&](size_type i) {
+        struct Value {
+            std::optional<shape_type> shape; // Not set for constants
+            double cost;
+        };
+        std::vector<std::pair<size_type, bool>> todo{{i, false}};
+        std::vector<Value> values;
+        while(!todo.empty()) {
+            auto [j, expanded] = todo.back();
+            todo.pop_back();
+            if(j != i && !interior[j]) {
+                const auto k = new_index[j];
+                if(dag.is_constant(k))
+                    values.push_back({std::nullopt, 0.0});
+                else
+                    values.push_back({planner.shape(k), 0.0});
+            } else if(!expanded) {
+                todo.push_back({j, true});
+                todo.push_back({dag.child(j, 1), false});
+                todo.push_back({dag.child(j, 0), false});
+            } else {
+                auto r = std::move(values.back());
+                values.pop_back();
+                auto& l = values.back();
+                l.cost += r.cost;
+                if(!l.shape) {
+                    l.shape = std::move(r.shape);
+                } else if(r.shape) {
+                    l.cost += planner.cost(*l.shape, *r.shape);
+                    l.shape = planner.multiply(*l.shape, *r.shape);
+                }
+            }
+        }
+        return values.back().cost;
+    };
+
+    auto fxn = [&](DAGType& d, size_type i, size_type j) {
+        new_index[i] = j;
+        if(factors[i].empty()) return j;
+
+        double scalar    = 1.0;
+        bool has_scalars = false;
+        std::vector<size_type> chain;
+        for(auto f : factors[i]) {
+            const auto k = new_index[f];
+            if(d.is_constant(k)) {
+                scalar *= d.value(k);
+                has_scalars = true;
+            } else {
+                chain.push_back(k);
+            }
+        }
+        if(chain.size() < 3) return j;
+
+        planner.set_factors(chain);
+        auto [cost, root] = chain.size() <= max_dp_size ?
+                              planner.dynamic_programming() :
+                              planner.greedy();
+        if(!(cost < current_cost(i))) return j;
+
+        if(has_scalars)
+            root = d.make_binary(NodeKind::multiply, d.make_constant(scalar),
+                                 root);
+        new_index[i] = root;
+        return root;
+    };
+    return dag.transform(fxn);
+}
+
+} // namespace utilities::dsl
@@ -18,6 +18,7 @@
 #include <array>
 #include <type_traits>
 #include <utilities/dsl/leaf.hpp>
+#include <utilities/dsl/structural_hash.hpp>
 #include <utilities/dsl/term.hpp>
 #include <utilities/dsl/term_traits.hpp>
 
@@ -96,6 +97,9 @@ public:
      *
      *  @tparam I The offset of the object the user wants.
      *
+     *  Since the object may be modified through the return, this invalidates
+     *  the cached structural hash of *this.
+     *
      *  @return A (possibly) mutable reference to the `I`-th object. The
      *          mutable-ness of the return is controlled by TermTraits<Args>.
      *
@@ -104,6 +108,7 @@ public:
      */
     template<std::size_t I>
     object_reference<I> object() {
+        m_hash_.reset();
         return unwrap_leaf<type_i<I>>(m_objects_[I]);
     }
 
@@ -126,10 +131,43 @@ public:
         return unwrap_leaf<type_i<I>>(m_objects_[I]);
     }
 
+    /** @brief Does *this alias the `I`-th object?
+     *
+     *  @tparam I The offset of the object.
+     *
+     *  Objects passed as lvalues are aliased, objects passed as rvalues are
+     *  copied (or moved) into *this.
+     *
+     *  @return True if the `I`-th object is aliased and false otherwise.
+     *
+     *  @throw None No throw guarantee.
+     */
+    template<std::size_t I>
+    bool aliases() const noexcept {
+        return m_objects_[I].is_alias();
+    }
+
     // -------------------------------------------------------------------------
     // -- Utility methods
     // -------------------------------------------------------------------------
 
+    /** @brief The structural hash of the tree rooted at *this.
+     *
+     *  The hash combines the type of *this with the structural hashes of its
+     *  objects (see structural_hash); literals *this aliases are hashed by
+     *  address, so changing their values does not invalidate the cached
+     *  hash. It is computed the first time it is requested and cached, so
+     *  hashing a tree is linear in its size and hashing it again is constant
+     *  time. Obtaining a mutable reference to one of the objects invalidates
+     *  the cache.
+     *
+     *  @return The structural hash of *this.
+     *
+     *  @throw ??? Throws if hashing one of the leaves throws. Same throw
+     *             guarantee.
+     */
+    std::size_t hash() const;
+
     /** @brief Is *this the same n-ary op as @p other?
      *
      *  @tparam DerivedType2 The type @p other implements.
@@ -178,14 +216,43 @@ private:
     template<typename DerivedType2, typename... Args2>
     friend class NAryOp;
 
+    /// Combines the hashes of the objects with indices @p Is
+    template<std::size_t... Is>
+    std::size_t hash_objects_(std::size_t seed,
+                              std::index_sequence<Is...>) const;
+
     /// The arguments to *this
     std::array<leaf_type, N> m_objects_;
+
+    /// The structural hash of *this, zero if not computed yet
+    mutable detail_::CachedHash m_hash_;
 };
 
 // -----------------------------------------------------------------------------
 // -- Out of line inline definitions
 // -----------------------------------------------------------------------------
 
+template<typename DerivedType, typename... Args>
+std::size_t NAryOp<DerivedType, Args...>::hash() const {
+    auto rv = m_hash_.load();
+    if(rv != 0) return rv;
+
+    auto id = reinterpret_cast<std::size_t>(detail_::type_id<DerivedType>());
+    rv      = hash_objects_(id, std::make_index_sequence<N>{});
+    if(rv == 0) rv = 1; // Zero is reserved for "not computed"
+    m_hash_.store(rv);
+    return rv;
+}
+
+template<typename DerivedType, typename... Args>
+template<std::size_t... Is>
+std::size_t NAryOp<DerivedType, Args...>::hash_objects_(
+  std::size_t seed, std::index_sequence<Is...>) const {
+    using detail_::hash_combine;
+    ((seed = hash_combine(seed, detail_::child_hash<Is>(*this))), ...);
+    return seed;
+}
+
 template<typename DerivedType, typename... Args>
 template<typename DerivedType2, typename... Args2>
 bool NAryOp<DerivedType, Args...>::operator==(
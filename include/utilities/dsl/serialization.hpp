@@ -0,0 +1,1020 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utilities/dsl/detail_/leaf_holder.hpp>
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/term_traits.hpp>
+#include <utility>
+#include <vector>
+
+/** @file serialization.hpp
+ *
+ *  A serialized expression is a single buffer made of fixed-size records, so
+ *  it can be read in place (e.g., out of a memory-mapped file). All integers
+ *  and doubles are stored in the byte order of the machine which wrote them,
+ *  and buffers written with a different byte order are rejected when they
+ *  are read. In order the buffer contains:
+ *
+ *  - a 32 byte header: the magic bytes "UDSL", then the format version and
+ *    the number of nodes, children, constants, leaves, and codecs, then the
+ *    byte order mark 0x01020304 (all `uint32_t`),
+ *  - the node table, 8 bytes per node: the NodeKind (`uint8_t`), what the
+ *    node is (operation, constant, or leaf; `uint8_t`), the number of
+ *    children (`uint16_t`), and a payload (`uint32_t`). For operations the
+ *    payload is the offset of the node's first child in the child table, for
+ *    constants it is the index into the constant table, and for leaves it is
+ *    the leaf's id. Nodes are stored in post-order, so children always come
+ *    before their parents and the root is the last node,
+ *  - the child table, the node index (`uint32_t`) of each child,
+ *  - the constant table, the value (`double`) of each floating-point leaf,
+ *  - the leaf table, 24 bytes per leaf: the index of the codec which wrote
+ *    the leaf or 0xFFFFFFFF if no codec did (`uint32_t`), padding, and the
+ *    offset and size of the leaf's bytes in the blob (`uint64_t` each),
+ *  - the codec table, the offset and size of each codec's name in the blob
+ *    (`uint64_t` each), and
+ *  - the blob.
+ */
+
+namespace utilities::dsl {
+
+class LeafCodecs;
+class LeafBindings;
+class SerializedExpression;
+
+template<typename T>
+class LoadedExpression;
+
+namespace detail_ {
+class ExpressionWriter;
+class ExpressionReader;
+
+/// The first four bytes of a serialized expression
+inline constexpr std::string_view serial_magic = "UDSL";
+
+/// The version of the format written by serialize
+inline constexpr std::uint32_t serial_version = 2;
+
+/// Written in the writer's byte order, so a reader can tell if it differs
+inline constexpr std::uint32_t serial_byte_order = 0x01020304;
+
+/// Codec index of a leaf which was not written by a codec
+inline constexpr std::uint32_t serial_no_codec = 0xFFFFFFFF;
+
+/// Sizes (in bytes) of the records making up a serialized expression
+///@{
+inline constexpr std::size_t serial_header_size = 32;
+inline constexpr std::size_t serial_node_size   = 8;
+inline constexpr std::size_t serial_leaf_size   = 24;
+inline constexpr std::size_t serial_codec_size  = 16;
+///@}
+
+/// What a node of a serialized expression is
+enum class SerialTag : std::uint8_t { operation, constant, leaf };
+
+/// Appends the bytes of @p value to @p out
+template<typename T>
+void write_pod(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+/// Reads a @p T from @p p, which need not be aligned
+template<typename T>
+T read_pod(const char* p) noexcept {
+    T rv;
+    std::memcpy(&rv, p, sizeof(T));
+    return rv;
+}
+
+/// Is @p T a leaf the DSL aliases (as opposed to holding by value)?
+template<typename T>
+constexpr bool is_aliased_leaf_v =
+  node_kind_v<T> == NodeKind::leaf && !TermTraits<T>::is_dsl_term_v;
+
+} // namespace detail_
+
+/** @brief Knows how to convert leaves of registered types to and from bytes.
+ *
+ *  The DSL can not know how to serialize the objects users put in their
+ *  expressions (tensors, matrices, ...). LeafCodecs maps a leaf type to a
+ *  named pair of functions: one which appends the object's bytes to a
+ *  buffer, and one which makes an object from a view of those bytes. The
+ *  name is stored with the serialized expression and checked when it is
+ *  loaded, so a leaf is never decoded by the wrong codec.
+ *
+ *  A codec for `std::string` leaves is always registered.
+ */
+class LeafCodecs {
+public:
+    /// Registers the codec for `std::string` leaves
+    LeafCodecs() {
+        add<std::string>(
+          "std::string",
+          [](const std::string& s, std::string& out) { out.append(s); },
+          [](std::string_view bytes) { return std::string(bytes); });
+    }
+
+    /** @brief Registers (or replaces) the codec for leaves of type @p T.
+     *
+     *  @tparam T The type of the leaves.
+     *  @tparam EncoderType Callable with signature
+     *                      `void(const T&, std::string&)`.
+     *  @tparam DecoderType Callable with signature `T(std::string_view)`.
+     *
+     *  @param[in] name A name for the codec. Must be the same when the
+     *                  expression is saved and loaded.
+     *  @param[in] encode Appends the bytes of a T to the provided buffer.
+     *  @param[in] decode Makes a T from a view of the bytes @p encode wrote.
+     *                    The view points into the serialized expression.
+     *
+     *  @throw std::bad_alloc if there is a problem allocating memory. Weak
+     *                        throw guarantee.
+     */
+    template<typename T, typename EncoderType, typename DecoderType>
+    void add(std::string name, EncoderType encode, DecoderType decode) {
+        Codec codec;
+        codec.name   = std::move(name);
+        codec.encode = [encode](const void* p, std::string& out) {
+            encode(*static_cast<const T*>(p), out);
+        };
+        codec.decode = [decode](std::string_view bytes) {
+            return std::shared_ptr<void>(std::make_shared<T>(decode(bytes)));
+        };
+        m_codecs_[detail_::type_id<T>()] = std::move(codec);
+    }
+
+    /// Is there a codec for leaves of type @p T?
+    template<typename T>
+    bool contains() const noexcept {
+        return m_codecs_.count(detail_::type_id<T>()) > 0;
+    }
+
+private:
+    friend class detail_::ExpressionWriter;
+    friend class detail_::ExpressionReader;
+
+    /// A registered codec, type-erased
+    struct Codec {
+        std::string name;
+        std::function<void(const void*, std::string&)> encode;
+        std::function<std::shared_ptr<void>(std::string_view)> decode;
+    };
+
+    /// The codec for type @p T, or nullptr if there is none
+    template<typename T>
+    const Codec* find_() const noexcept {
+        auto itr = m_codecs_.find(detail_::type_id<T>());
+        return itr == m_codecs_.end() ? nullptr : &itr->second;
+    }
+
+    /// The codecs, keyed by the type they handle
+    std::unordered_map<detail_::type_id_type, Codec> m_codecs_;
+};
+
+/** @brief Supplies the objects for leaves which were not serialized.
+ *
+ *  Leaves without a codec are saved as a reference: the serialized
+ *  expression records that there was a leaf, but not its value. When the
+ *  expression is loaded the leaf must be bound to an existing object, which
+ *  the loaded expression then aliases (just like the original aliased its
+ *  leaves). Binding a leaf also takes precedence over its codec, which is
+ *  how a saved expression can be re-pointed at live objects.
+ *
+ *  Leaves are identified by their id. Ids are assigned in the order the
+ *  leaves are first encountered when the tree is walked depth-first, left
+ *  to right, and a leaf appearing more than once has a single id.
+ */
+class LeafBindings {
+public:
+    /// Type used for leaf ids
+    using size_type = std::size_t;
+
+    /** @brief Binds the leaf with id @p id to @p object.
+     *
+     *  @tparam T The type of the object, may be const-qualified. A const
+     *            object can only be bound to leaves which the loaded
+     *            expression aliases as const.
+     *
+     *  @param[in] id The id of the leaf.
+     *  @param[in] object The object to use for the leaf. Must outlive any
+     *                    expression loaded with *this.
+     *
+     *  @throw std::bad_alloc if there is a problem allocating memory. Strong
+     *                        throw guarantee.
+     */
+    template<typename T>
+    void bind(size_type id, T& object) {
+        using clean_type = std::remove_const_t<T>;
+        auto* p          = const_cast<clean_type*>(&object);
+        m_objects_[id]   = {detail_::type_id<clean_type>(), p,
+                            std::is_const_v<T>};
+    }
+
+    /// The number of bound leaves
+    size_type size() const noexcept { return m_objects_.size(); }
+
+private:
+    friend class detail_::ExpressionReader;
+
+    /// An object bound to a leaf
+    struct Binding {
+        /// The type of the object, without const
+        detail_::type_id_type type;
+
+        /// The object (const_cast away if @p is_const)
+        void* object;
+
+        /// Was the object bound as const?
+        bool is_const;
+    };
+
+    /// The object bound to leaf @p id, or nullptr if none is
+    template<typename T>
+    const Binding* find_(size_type id) const {
+        auto itr = m_objects_.find(id);
+        if(itr == m_objects_.end()) return nullptr;
+        if(itr->second.type != detail_::type_id<T>())
+            throw std::runtime_error("Leaf " + std::to_string(id) +
+                                     " is bound to an object of the wrong "
+                                     "type");
+        return &itr->second;
+    }
+
+    /// The bound objects, keyed by leaf id
+    std::map<size_type, Binding> m_objects_;
+};
+
+/** @brief A read-only, zero-copy view of a serialized expression.
+ *
+ *  SerializedExpression validates the buffer it is given (sizes, indices,
+ *  and that children come before their parents) once, when it is created.
+ *  After that the accessors read the records directly out of the buffer;
+ *  nothing is copied or decoded up front. This makes it cheap to inspect
+ *  (or load parts of) large saved expressions, e.g., the contents of a
+ *  FileTokenizer.
+ *
+ *  @note SerializedExpression does not own the buffer. It must outlive
+ *        *this.
+ */
+class SerializedExpression {
+public:
+    /// Type used for counting and indexing
+    using size_type = std::size_t;
+
+    /** @brief Creates a view of the serialized expression in @p bytes.
+     *
+     *  @param[in] bytes The serialized expression. Must outlive *this.
+     *
+     *  @throw std::runtime_error if @p bytes is not a valid serialized
+     *                            expression. Strong throw guarantee.
+     */
+    explicit SerializedExpression(std::string_view bytes);
+
+    /// The number of nodes
+    size_type size() const noexcept { return m_n_nodes_; }
+
+    /// The index of the root node (nodes are stored in post-order)
+    size_type root() const noexcept { return m_n_nodes_ - 1; }
+
+    /// The number of (distinct) non-constant leaves
+    size_type n_leaves() const noexcept { return m_n_leaves_; }
+
+    /// The kind of node @p i
+    NodeKind kind(size_type i) const {
+        return static_cast<NodeKind>(m_bytes_[node_(i)]);
+    }
+
+    /// Is node @p i a floating-point constant?
+    bool is_constant(size_type i) const {
+        return tag_(i) == detail_::SerialTag::constant;
+    }
+
+    /// The number of children of node @p i
+    size_type n_children(size_type i) const {
+        return read_<std::uint16_t>(node_(i) + 2);
+    }
+
+    /** @brief The index of the @p j-th child of node @p i.
+     *
+     *  @throw std::out_of_range if @p i is not a node index or node @p i
+     *                           does not have a @p j-th child.
+     */
+    size_type child(size_type i, size_type j) const {
+        if(j >= n_children(i))
+            throw std::out_of_range("Node does not have that many children");
+        const auto offset = read_<std::uint32_t>(node_(i) + 4) + j;
+        return read_<std::uint32_t>(m_children_ + 4 * offset);
+    }
+
+    /** @brief The value of the constant node @p i.
+     *
+     *  @throw std::out_of_range if @p i is not the index of a constant.
+     */
+    double value(size_type i) const {
+        if(!is_constant(i))
+            throw std::out_of_range("Node is not a constant");
+        const auto index = read_<std::uint32_t>(node_(i) + 4);
+        return read_<double>(m_constants_ + 8 * size_type(index));
+    }
+
+    /** @brief The id of the (non-constant) leaf node @p i.
+     *
+     *  @throw std::out_of_range if @p i is not the index of such a leaf.
+     */
+    size_type leaf_id(size_type i) const {
+        if(tag_(i) != detail_::SerialTag::leaf)
+            throw std::out_of_range("Node is not a leaf");
+        return read_<std::uint32_t>(node_(i) + 4);
+    }
+
+    /** @brief The name of the codec which wrote leaf @p id.
+     *
+     *  @return The name, or an empty view if the leaf was saved as a
+     *          reference (or is an empty object).
+     */
+    std::string_view codec(size_type id) const {
+        const auto index = read_<std::uint32_t>(leaf_(id));
+        if(index == detail_::serial_no_codec) return {};
+        const auto record = m_codecs_ + detail_::serial_codec_size * index;
+        return blob_(record);
+    }
+
+    /// The bytes the codec of leaf @p id wrote, a view into the buffer
+    std::string_view data(size_type id) const { return blob_(leaf_(id) + 8); }
+
+    /// The entire serialized expression
+    std::string_view bytes() const noexcept { return m_bytes_; }
+
+private:
+    /// Reads a @p T at byte @p offset of the buffer
+    template<typename T>
+    T read_(size_type offset) const noexcept {
+        return detail_::read_pod<T>(m_bytes_.data() + offset);
+    }
+
+    /// Offset of node @p i's record
+    size_type node_(size_type i) const {
+        if(i >= m_n_nodes_) throw std::out_of_range("Node index out of range");
+        return detail_::serial_header_size + detail_::serial_node_size * i;
+    }
+
+    /// Offset of leaf @p id's record
+    size_type leaf_(size_type id) const {
+        if(id >= m_n_leaves_) throw std::out_of_range("Leaf id out of range");
+        return m_leaves_ + detail_::serial_leaf_size * id;
+    }
+
+    /// What node @p i is
+    detail_::SerialTag tag_(size_type i) const {
+        return static_cast<detail_::SerialTag>(m_bytes_[node_(i) + 1]);
+    }
+
+    /// The blob range described by the (offset, size) pair at @p record
+    std::string_view blob_(size_type record) const noexcept {
+        const auto offset = read_<std::uint64_t>(record);
+        const auto size   = read_<std::uint64_t>(record + 8);
+        return m_bytes_.substr(m_blob_ + offset, size);
+    }
+
+    /// Throws if the records are not consistent with one another
+    void validate_() const;
+
+    /// The serialized expression
+    std::string_view m_bytes_;
+
+    /// The counts from the header
+    ///@{
+    size_type m_n_nodes_     = 0;
+    size_type m_n_children_  = 0;
+    size_type m_n_constants_ = 0;
+    size_type m_n_leaves_    = 0;
+    size_type m_n_codecs_    = 0;
+    ///@}
+
+    /// Offsets of the tables after the node table
+    ///@{
+    size_type m_children_  = 0;
+    size_type m_constants_ = 0;
+    size_type m_leaves_    = 0;
+    size_type m_codecs_    = 0;
+    size_type m_blob_      = 0;
+    ///@}
+};
+
+/** @brief An expression which was loaded by deserialize.
+ *
+ *  @tparam T The type of the expression.
+ *
+ *  Expressions alias their leaves, so something has to own the leaves which
+ *  were decoded when the expression was loaded. LoadedExpression owns them,
+ *  together with the expression aliasing them. Leaves which were bound (see
+ *  LeafBindings) are not owned.
+ *
+ *  Copies share the decoded leaves.
+ */
+template<typename T>
+class LoadedExpression {
+public:
+    /// Type of the expression
+    using expression_type = T;
+
+    /// The loaded expression
+    ///@{
+    expression_type& expression() noexcept { return *m_expression_; }
+    const expression_type& expression() const noexcept {
+        return *m_expression_;
+    }
+    ///@}
+
+    /** @brief The object used for leaf @p id.
+     *
+     *  @tparam U The type of the object. Must be const-qualified if the leaf
+     *            was bound to a const object.
+     *
+     *  @param[in] id The id of the leaf.
+     *
+     *  @return A pointer to the object, or nullptr if the leaf is a literal.
+     *
+     *  @throw std::out_of_range if @p id is not the id of a leaf. Strong
+     *                           throw guarantee.
+     *  @throw std::runtime_error if the leaf is not a @p U, or if @p U is
+     *                            not const and the leaf is bound to a const
+     *                            object. Strong throw guarantee.
+     */
+    template<typename U>
+    U* leaf(std::size_t id) const {
+        const auto& p = m_leaves_.at(id);
+        if(!p) return nullptr;
+        if(m_types_[id] != detail_::type_id<std::remove_const_t<U>>())
+            throw std::runtime_error("Leaf " + std::to_string(id) +
+                                     " is not of the requested type");
+        if(m_const_[id] && !std::is_const_v<U>)
+            throw std::runtime_error("Leaf " + std::to_string(id) +
+                                     " is bound to a const object");
+        return static_cast<U*>(p.get());
+    }
+
+private:
+    friend class detail_::ExpressionReader;
+
+    /// The objects for each leaf (bound leaves are non-owning)
+    std::vector<std::shared_ptr<void>> m_leaves_;
+
+    /// The type of each leaf's object (nullptr for literals)
+    std::vector<detail_::type_id_type> m_types_;
+
+    /// Element i is true if leaf i is bound to a const object
+    std::vector<bool> m_const_;
+
+    /// The expression
+    std::optional<expression_type> m_expression_;
+};
+
+namespace detail_ {
+
+/// Implements serialize
+class ExpressionWriter {
+public:
+    /// Type used for counting and indexing
+    using size_type = std::size_t;
+
+    /// Writes leaves with @p codecs
+    explicit ExpressionWriter(const LeafCodecs& codecs) : m_codecs_(codecs) {}
+
+    /// Adds @p object (and its children) to the tables, returns its index
+    template<typename T>
+    std::uint32_t write(const T& object);
+
+    /// Assembles the serialized expression
+    std::string finish() const;
+
+private:
+    /// A record of the node table
+    struct Node {
+        NodeKind kind;
+        SerialTag tag;
+        std::uint16_t arity;
+        std::uint32_t payload;
+    };
+
+    /// A record of the leaf table
+    struct LeafRecord {
+        std::uint32_t codec;
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    /// Writes the children of @p object, returns their indices
+    template<typename T, std::size_t... Is>
+    std::array<std::uint32_t, sizeof...(Is)> write_children_(
+      const T& object, std::index_sequence<Is...>) {
+        // Braced initialization guarantees left-to-right evaluation
+        return {write(object.template object<Is>())...};
+    }
+
+    /// Adds the leaf @p object to the leaf table (if new), returns its id
+    template<typename T>
+    std::uint32_t add_leaf_(const T& object);
+
+    /// Index of the codec named @p name, adding it if needed
+    std::uint32_t codec_index_(const std::string& name);
+
+    /// Adds @p node, returns its index
+    std::uint32_t push_node_(Node node);
+
+    /// Throws if @p n is too big for a uint32_t
+    static std::uint32_t to_u32_(size_type n);
+
+    /// Used to encode the leaves
+    const LeafCodecs& m_codecs_;
+
+    /// The tables
+    ///@{
+    std::vector<Node> m_nodes_;
+    std::vector<std::uint32_t> m_children_;
+    std::vector<double> m_constants_;
+    std::vector<LeafRecord> m_leaves_;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> m_codec_names_;
+    std::string m_blob_;
+    ///@}
+
+    /// Maps (type, address) of aliased leaves to their ids
+    std::map<std::pair<type_id_type, const void*>, std::uint32_t> m_leaf_ids_;
+
+    /// Maps codec names to their indices
+    std::map<std::string, std::uint32_t> m_codec_ids_;
+};
+
+/// Implements deserialize
+class ExpressionReader {
+public:
+    /// Type used for counting and indexing
+    using size_type = std::size_t;
+
+    /// Reads @p view, with leaves from @p codecs or @p bindings
+    ExpressionReader(const SerializedExpression& view,
+                     const LeafCodecs& codecs, const LeafBindings& bindings) :
+      m_view_(view),
+      m_codecs_(codecs),
+      m_bindings_(bindings),
+      m_types_(view.n_leaves(), nullptr),
+      m_const_(view.n_leaves(), false) {}
+
+    /// Loads the expression of type @p T
+    template<typename T>
+    LoadedExpression<T> load();
+
+private:
+    /// Makes the @p T stored in node @p i
+    template<typename T>
+    T read_(size_type i);
+
+    /// Makes the operation of type @p T stored in node @p i
+    template<typename T, std::size_t... Is>
+    T read_op_(size_type i, std::index_sequence<Is...>) {
+        return T(read_child_<T, Is>(m_view_.child(i, Is))...);
+    }
+
+    /// The I-th child of a @p T, stored in node @p i
+    template<typename T, std::size_t I>
+    decltype(auto) read_child_(size_type i);
+
+    /// The object for the aliased leaf stored in node @p i, @p is_const is
+    /// true if the expression aliases it as const
+    template<typename T>
+    T& leaf_(size_type i, bool is_const);
+
+    /// The id of the leaf in node @p i
+    size_type leaf_id_(size_type i) const;
+
+    /// Decodes leaf @p id with the codec for @p T
+    template<typename T>
+    std::shared_ptr<void> decode_(size_type id) const;
+
+    /// Throws saying node @p i is not a @p what
+    [[noreturn]] static void mismatch_(size_type i, const std::string& what) {
+        throw std::runtime_error("Node " + std::to_string(i) +
+                                 " is not a " + what);
+    }
+
+    /// The expression being read
+    const SerializedExpression& m_view_;
+
+    /// Used to decode leaves
+    const LeafCodecs& m_codecs_;
+
+    /// Objects for the bound leaves
+    const LeafBindings& m_bindings_;
+
+    /// The objects for each leaf
+    std::vector<std::shared_ptr<void>> m_leaves_;
+
+    /// The type each leaf was loaded as
+    std::vector<type_id_type> m_types_;
+
+    /// Element i is true if leaf i is bound to a const object
+    std::vector<bool> m_const_;
+};
+
+} // namespace detail_
+
+/** @brief Serializes the expression @p expr.
+ *
+ *  @tparam T The type of the expression. Can be any operation of the DSL,
+ *            including the static operations.
+ *
+ *  The expression is written in the format described at the top of this
+ *  file. Floating-point leaves are stored as constants. Each other leaf is
+ *  stored once, however many times it appears, and is:
+ *  - encoded by its codec in @p codecs, if there is one,
+ *  - recorded as an empty object, if its type is empty and default
+ *    constructible (e.g., the callable of a FunctionCall), or
+ *  - recorded as a reference, which must be bound when the expression is
+ *    loaded (see LeafBindings).
+ *
+ *  @param[in] expr The expression to serialize.
+ *  @param[in] codecs The codecs for the leaves. Defaults to the builtin
+ *                    codecs.
+ *
+ *  @return The serialized expression.
+ *
+ *  @throw std::length_error if the expression has too many nodes for the
+ *                           format. Strong throw guarantee.
+ *  @throw ??? Throws if a codec throws. Strong throw guarantee.
+ */
+template<typename T>
+std::string serialize(const T& expr, const LeafCodecs& codecs = {}) {
+    static_assert(node_kind_v<T> != NodeKind::leaf,
+                  "Only expressions can be serialized");
+    detail_::ExpressionWriter writer(codecs);
+    writer.write(expr);
+    return writer.finish();
+}
+
+/** @brief Loads the expression of type @p T from @p view.
+ *
+ *  @tparam T The type of the expression. Serialized expressions do not
+ *            record C++ types, so this must be the type of the expression
+ *            which was serialized (up to the const-ness of the leaves).
+ *
+ *  Leaves are taken from @p bindings if they are bound, otherwise they are
+ *  decoded with their codec from @p codecs (the codec must have the same
+ *  name as the one which saved them). Empty leaves are default constructed.
+ *
+ *  @param[in] view The serialized expression.
+ *  @param[in] codecs The codecs for the leaves. Defaults to the builtin
+ *                    codecs.
+ *  @param[in] bindings Objects for the leaves. Defaults to none.
+ *
+ *  @return The loaded expression.
+ *
+ *  @throw std::runtime_error if the structure of @p view does not match
+ *                            @p T, if a leaf is neither bound nor can be
+ *                            decoded, or if a leaf is bound to an object of
+ *                            the wrong type. Strong throw guarantee.
+ *  @throw ??? Throws if a codec throws. Strong throw guarantee.
+ */
+template<typename T>
+LoadedExpression<T> deserialize(const SerializedExpression& view,
+                                const LeafCodecs& codecs     = {},
+                                const LeafBindings& bindings = {}) {
+    static_assert(node_kind_v<T> != NodeKind::leaf,
+                  "Only expressions can be deserialized");
+    return detail_::ExpressionReader(view, codecs, bindings).load<T>();
+}
+
+/** @brief Overloads deserialize for a buffer which has not been validated.
+ *
+ *  @param[in] bytes The serialized expression. Must outlive the call, but
+ *                   not the returned expression.
+ *  @param[in] codecs The codecs for the leaves. Defaults to the builtin
+ *                    codecs.
+ *  @param[in] bindings Objects for the leaves. Defaults to none.
+ *
+ *  @return The loaded expression.
+ *
+ *  @throw std::runtime_error if @p bytes is not a valid serialized
+ *                            expression, or for any of the reasons the
+ *                            main overload throws. Strong throw guarantee.
+ */
+template<typename T>
+LoadedExpression<T> deserialize(std::string_view bytes,
+                                const LeafCodecs& codecs     = {},
+                                const LeafBindings& bindings = {}) {
+    return deserialize<T>(SerializedExpression(bytes), codecs, bindings);
+}
+
+// -----------------------------------------------------------------------------
+// -- Out of line inline definitions
+// -----------------------------------------------------------------------------
+
+inline SerializedExpression::SerializedExpression(std::string_view bytes) :
+  m_bytes_(bytes) {
+    using namespace detail_;
+    if(bytes.size() < serial_header_size ||
+       bytes.substr(0, 4) != serial_magic)
+        throw std::runtime_error("Not a serialized expression");
+    if(read_<std::uint32_t>(28) != serial_byte_order)
+        throw std::runtime_error("Serialized expression has a different "
+                                 "byte order (or predates version 2)");
+    if(read_<std::uint32_t>(4) != serial_version)
+        throw std::runtime_error("Unsupported serialized expression version");
+
+    m_n_nodes_     = read_<std::uint32_t>(8);
+    m_n_children_  = read_<std::uint32_t>(12);
+    m_n_constants_ = read_<std::uint32_t>(16);
+    m_n_leaves_    = read_<std::uint32_t>(20);
+    m_n_codecs_    = read_<std::uint32_t>(24);
+
+    // The counts are 32-bit, so none of these can overflow
+    m_children_  = serial_header_size + serial_node_size * m_n_nodes_;
+    m_constants_ = m_children_ + 4 * m_n_children_;
+    m_leaves_    = m_constants_ + 8 * m_n_constants_;
+    m_codecs_    = m_leaves_ + serial_leaf_size * m_n_leaves_;
+    m_blob_      = m_codecs_ + serial_codec_size * m_n_codecs_;
+    if(m_blob_ > bytes.size())
+        throw std::runtime_error("Serialized expression is truncated");
+    if(m_n_nodes_ == 0)
+        throw std::runtime_error("Serialized expression has no nodes");
+    validate_();
+}
+
+inline void SerializedExpression::validate_() const {
+    using namespace detail_;
+    auto fail = [](const std::string& what) {
+        throw std::runtime_error("Corrupt serialized expression: " + what);
+    };
+
+    const auto blob_size = m_bytes_.size() - m_blob_;
+    auto check_range     = [&](size_type record, const char* what) {
+        const auto offset = read_<std::uint64_t>(record);
+        const auto size   = read_<std::uint64_t>(record + 8);
+        if(offset > blob_size || size > blob_size - offset) fail(what);
+    };
+
+    for(size_type i = 0; i < m_n_nodes_; ++i) {
+        const auto record  = node_(i);
+        const auto kind    = static_cast<std::uint8_t>(m_bytes_[record]);
+        const auto tag     = static_cast<std::uint8_t>(m_bytes_[record + 1]);
+        const auto arity   = size_type(read_<std::uint16_t>(record + 2));
+        const auto payload = size_type(read_<std::uint32_t>(record + 4));
+        if(kind > static_cast<std::uint8_t>(NodeKind::function_call))
+            fail("unknown node kind");
+        const auto is_leaf = kind == static_cast<std::uint8_t>(NodeKind::leaf);
+
+        if(tag == static_cast<std::uint8_t>(SerialTag::operation)) {
+            if(is_leaf || arity == 0) fail("operation without children");
+            if(payload + arity > m_n_children_) fail("child out of range");
+            for(size_type j = 0; j < arity; ++j) {
+                const auto c = read_<std::uint32_t>(m_children_ +
+                                                    4 * (payload + j));
+                if(c >= i) fail("child does not precede its parent");
+            }
+        } else if(tag == static_cast<std::uint8_t>(SerialTag::constant)) {
+            if(!is_leaf || arity != 0) fail("constant with children");
+            if(payload >= m_n_constants_) fail("constant out of range");
+        } else if(tag == static_cast<std::uint8_t>(SerialTag::leaf)) {
+            if(!is_leaf || arity != 0) fail("leaf with children");
+            if(payload >= m_n_leaves_) fail("leaf out of range");
+        } else {
+            fail("unknown node tag");
+        }
+    }
+
+    for(size_type id = 0; id < m_n_leaves_; ++id) {
+        const auto record = leaf_(id);
+        const auto codec  = read_<std::uint32_t>(record);
+        if(codec != serial_no_codec && codec >= m_n_codecs_)
+            fail("codec out of range");
+        check_range(record + 8, "leaf data out of range");
+    }
+
+    for(size_type i = 0; i < m_n_codecs_; ++i)
+        check_range(m_codecs_ + serial_codec_size * i,
+                    "codec name out of range");
+}
+
+namespace detail_ {
+
+template<typename T>
+std::uint32_t ExpressionWriter::write(const T& object) {
+    constexpr auto kind = node_kind_v<T>;
+    if constexpr(kind != NodeKind::leaf) {
+        static_assert(T::N <= 0xFFFF, "Too many children for the format");
+        const auto children =
+          write_children_(object, std::make_index_sequence<T::N>{});
+        const auto first = to_u32_(m_children_.size());
+        m_children_.insert(m_children_.end(), children.begin(), children.end());
+        return push_node_({kind, SerialTag::operation, T::N, first});
+    } else if constexpr(std::is_floating_point_v<T>) {
+        m_constants_.push_back(static_cast<double>(object));
+        const auto index = to_u32_(m_constants_.size() - 1);
+        return push_node_({kind, SerialTag::constant, 0, index});
+    } else {
+        return push_node_({kind, SerialTag::leaf, 0, add_leaf_(object)});
+    }
+}
+
+template<typename T>
+std::uint32_t ExpressionWriter::add_leaf_(const T& object) {
+    // Aliased leaves are shared, literals (strings) are not
+    const std::pair<type_id_type, const void*> key{type_id<T>(), &object};
+    if constexpr(is_aliased_leaf_v<T>) {
+        auto itr = m_leaf_ids_.find(key);
+        if(itr != m_leaf_ids_.end()) return itr->second;
+    }
+
+    LeafRecord record{serial_no_codec, m_blob_.size(), 0};
+    if(const auto* codec = m_codecs_.find_<T>()) {
+        record.codec  = codec_index_(codec->name); // May add to the blob
+        record.offset = m_blob_.size();
+        codec->encode(&object, m_blob_);
+        record.size = m_blob_.size() - record.offset;
+    }
+    // Leaves without a codec are empty objects or references, loading tells
+    // them apart by their type
+
+    const auto id = to_u32_(m_leaves_.size());
+    m_leaves_.push_back(record);
+    if constexpr(is_aliased_leaf_v<T>) m_leaf_ids_.emplace(key, id);
+    return id;
+}
+
+inline std::uint32_t ExpressionWriter::codec_index_(const std::string& name) {
+    auto itr = m_codec_ids_.find(name);
+    if(itr != m_codec_ids_.end()) return itr->second;
+    const auto index = to_u32_(m_codec_names_.size());
+    m_codec_names_.emplace_back(m_blob_.size(), name.size());
+    m_blob_.append(name);
+    m_codec_ids_.emplace(name, index);
+    return index;
+}
+
+inline std::uint32_t ExpressionWriter::push_node_(Node node) {
+    m_nodes_.push_back(node);
+    return to_u32_(m_nodes_.size() - 1);
+}
+
+inline std::uint32_t ExpressionWriter::to_u32_(size_type n) {
+    if(n >= serial_no_codec)
+        throw std::length_error("Expression is too large to serialize");
+    return static_cast<std::uint32_t>(n);
+}
+
+inline std::string ExpressionWriter::finish() const {
+    std::string rv;
+    rv.reserve(serial_header_size + serial_node_size * m_nodes_.size() +
+               4 * m_children_.size() + 8 * m_constants_.size() +
+               serial_leaf_size * m_leaves_.size() +
+               serial_codec_size * m_codec_names_.size() + m_blob_.size());
+
+    rv.append(serial_magic);
+    write_pod(rv, serial_version);
+    write_pod(rv, to_u32_(m_nodes_.size()));
+    write_pod(rv, to_u32_(m_children_.size()));
+    write_pod(rv, to_u32_(m_constants_.size()));
+    write_pod(rv, to_u32_(m_leaves_.size()));
+    write_pod(rv, to_u32_(m_codec_names_.size()));
+    write_pod(rv, serial_byte_order);
+
+    for(const auto& node : m_nodes_) {
+        write_pod(rv, static_cast<std::uint8_t>(node.kind));
+        write_pod(rv, static_cast<std::uint8_t>(node.tag));
+        write_pod(rv, node.arity);
+        write_pod(rv, node.payload);
+    }
+    for(auto c : m_children_) write_pod(rv, c);
+    for(auto c : m_constants_) write_pod(rv, c);
+    for(const auto& leaf : m_leaves_) {
+        write_pod(rv, leaf.codec);
+        write_pod(rv, std::uint32_t{0});
+        write_pod(rv, leaf.offset);
+        write_pod(rv, leaf.size);
+    }
+    for(const auto& [offset, size] : m_codec_names_) {
+        write_pod(rv, offset);
+        write_pod(rv, size);
+    }
+    rv.append(m_blob_);
+    return rv;
+}
+
+template<typename T>
+LoadedExpression<T> ExpressionReader::load() {
+    m_leaves_.assign(m_view_.n_leaves(), nullptr);
+    LoadedExpression<T> rv;
+    rv.m_expression_.emplace(read_<T>(m_view_.root()));
+    rv.m_leaves_ = std::move(m_leaves_);
+    rv.m_types_  = m_types_;
+    rv.m_const_  = m_const_;
+    return rv;
+}
+
+template<typename T>
+T ExpressionReader::read_(size_type i) {
+    constexpr auto kind = node_kind_v<T>;
+    if constexpr(kind != NodeKind::leaf) {
+        if(m_view_.kind(i) != kind || m_view_.is_constant(i) ||
+           m_view_.n_children(i) != T::N)
+            mismatch_(i, "matching operation");
+        return read_op_<T>(i, std::make_index_sequence<T::N>{});
+    } else if constexpr(std::is_floating_point_v<T>) {
+        if(!m_view_.is_constant(i)) mismatch_(i, "constant");
+        return static_cast<T>(m_view_.value(i));
+    } else {
+        // A literal leaf (e.g., std::string), it is held by value
+        const auto id = leaf_id_(i);
+        return *static_cast<const T*>(decode_<T>(id).get());
+    }
+}
+
+template<typename T, std::size_t I>
+decltype(auto) ExpressionReader::read_child_(size_type i) {
+    using child_type = typename T::template object_type<I>;
+    if constexpr(is_aliased_leaf_v<child_type>) {
+        // Respects the const-ness the expression aliases the leaf with
+        using reference_type = typename T::template object_reference<I>;
+        constexpr bool is_const =
+          std::is_const_v<std::remove_reference_t<reference_type>>;
+        reference_type rv = leaf_<child_type>(i, is_const);
+        return rv;
+    } else {
+        return read_<child_type>(i);
+    }
+}
+
+template<typename T>
+T& ExpressionReader::leaf_(size_type i, bool is_const) {
+    const auto id = leaf_id_(i);
+    auto& object  = m_leaves_[id];
+    if(object) {
+        if(m_types_[id] != type_id<T>())
+            throw std::runtime_error("Leaf " + std::to_string(id) +
+                                     " is used with more than one type");
+    } else if(auto* binding = m_bindings_.find_<T>(id)) {
+        // Aliasing ctor with an empty owner, the bound object isn't owned
+        const std::shared_ptr<void> no_owner;
+        object       = std::shared_ptr<void>(no_owner, binding->object);
+        m_const_[id] = binding->is_const;
+    } else if(!m_view_.codec(id).empty()) {
+        object = decode_<T>(id);
+    } else if constexpr(std::is_empty_v<T> &&
+                        std::is_default_constructible_v<T>) {
+        object = std::make_shared<T>();
+    } else {
+        throw std::runtime_error("Leaf " + std::to_string(id) +
+                                 " was not serialized and is not bound");
+    }
+    m_types_[id] = type_id<T>();
+    if(m_const_[id] && !is_const)
+        throw std::runtime_error("Leaf " + std::to_string(id) +
+                                 " is bound to a const object, but the "
+                                 "expression aliases it as mutable");
+    return *static_cast<T*>(object.get());
+}
+
+inline std::size_t ExpressionReader::leaf_id_(size_type i) const {
+    if(m_view_.is_constant(i) || m_view_.kind(i) != NodeKind::leaf)
+        mismatch_(i, "leaf");
+    return m_view_.leaf_id(i);
+}
+
+template<typename T>
+std::shared_ptr<void> ExpressionReader::decode_(size_type id) const {
+    const auto* codec = m_codecs_.find_<T>();
+    const auto name   = m_view_.codec(id);
+    if(codec == nullptr || codec->name != name)
+        throw std::runtime_error("Leaf " + std::to_string(id) +
+                                 " was saved by codec '" + std::string(name) +
+                                 "', which is not registered for its type");
+    return codec->decode(m_view_.data(id));
+}
+
+} // namespace detail_
+} // namespace utilities::dsl
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/expression_dag.hpp>
+
+/** @file simplify.hpp
+ *
+ *  Rewrite rules for ExpressionDAG objects. Each rule is a function object
+ *  which, given a DAG and the index of a node, returns the index of the node
+ *  to replace it with (or the original index if the rule does not apply).
+ *  They are meant to be passed to ExpressionDAG::rewrite, either one at a
+ *  time or, more commonly, all together via simplify.
+ *
+ *  The rules assume the usual algebra: addition is commutative, scalars
+ *  (i.e., constants) commute with everything, and multiplication distributes
+ *  over addition and subtraction. Multiplication of two non-constants is
+ *  NOT assumed to be commutative (think matrix products) unless requested.
+ *
+ *  The rules only look at binary operations. Sums and products with more
+ *  operands (see flatten.hpp) are left alone, so DAGs should be simplified
+ *  before their chains are flattened.
+ */
+
+namespace utilities::dsl {
+namespace detail_ {
+
+/// Is @p kind one of the binary operations?
+constexpr bool is_binary(NodeKind kind) noexcept {
+    return kind == NodeKind::add || kind == NodeKind::subtract ||
+           kind == NodeKind::multiply || kind == NodeKind::divide;
+}
+
+/// Is node @p i a binary operation (n-ary sums and products are not)?
+template<typename DAGType>
+bool is_binary_node(const DAGType& dag, typename DAGType::size_type i) {
+    return is_binary(dag.kind(i)) && dag.n_children(i) == 2;
+}
+
+/// Is node @p i of the form `c * X` with c a constant?
+template<typename DAGType>
+bool is_scaled(const DAGType& dag, typename DAGType::size_type i) {
+    return dag.kind(i) == NodeKind::multiply && dag.n_children(i) == 2 &&
+           dag.is_constant(dag.child(i, 0));
+}
+
+} // namespace detail_
+
+/** @brief Evaluates operations whose inputs are constants.
+ *
+ *  In addition to `a op b` with constant a and b, this also combines
+ *  constants separated by another node:
+ *
+ *  - `a * (b * X)` becomes `(a * b) * X`, and
+ *  - `(a * X) / b` becomes `(a / b) * X`.
+ *
+ *  Division by a constant zero is never folded.
+ */
+struct FoldConstants {
+    template<typename DAGType>
+    auto operator()(DAGType& dag, typename DAGType::size_type i) const {
+        const auto kind = dag.kind(i);
+        if(!detail_::is_binary_node(dag, i)) return i;
+        const auto l = dag.child(i, 0);
+        const auto r = dag.child(i, 1);
+
+        if(dag.is_constant(l) && dag.is_constant(r)) {
+            const auto a = dag.value(l);
+            const auto b = dag.value(r);
+            switch(kind) {
+                case NodeKind::add: return dag.make_constant(a + b);
+                case NodeKind::subtract: return dag.make_constant(a - b);
+                case NodeKind::multiply: return dag.make_constant(a * b);
+                default: return b == 0.0 ? i : dag.make_constant(a / b);
+            }
+        }
+
+        if(kind == NodeKind::multiply && dag.is_constant(l) &&
+           detail_::is_scaled(dag, r)) {
+            const auto c = dag.value(l) * dag.value(dag.child(r, 0));
+            return dag.make_binary(kind, dag.make_constant(c), dag.child(r, 1));
+        }
+
+        if(kind == NodeKind::divide && dag.is_constant(r) &&
+           dag.value(r) != 0.0 && detail_::is_scaled(dag, l)) {
+            const auto c = dag.value(dag.child(l, 0)) / dag.value(r);
+            return dag.make_binary(NodeKind::multiply, dag.make_constant(c),
+                                   dag.child(l, 1));
+        }
+        return i;
+    }
+};
+
+/** @brief Removes multiplication/division by 1 and addition/subtraction of 0.
+ *
+ *  Specifically: `1 * X`, `X * 1`, `X / 1`, `0 + X`, `X + 0`, and `X - 0` all
+ *  become `X`.
+ */
+struct RemoveIdentities {
+    template<typename DAGType>
+    auto operator()(DAGType& dag, typename DAGType::size_type i) const {
+        const auto kind = dag.kind(i);
+        if(!detail_::is_binary_node(dag, i)) return i;
+        const auto l = dag.child(i, 0);
+        const auto r = dag.child(i, 1);
+
+        switch(kind) {
+            case NodeKind::add:
+                if(dag.is_constant(l, 0.0)) return r;
+                return dag.is_constant(r, 0.0) ? l : i;
+            case NodeKind::subtract: return dag.is_constant(r, 0.0) ? l : i;
+            case NodeKind::multiply:
+                if(dag.is_constant(l, 1.0)) return r;
+                return dag.is_constant(r, 1.0) ? l : i;
+            default: return dag.is_constant(r, 1.0) ? l : i;
+        }
+    }
+};
+
+/** @brief Puts the operands of commutative operations in a canonical order.
+ *
+ *  Constants go on the left of additions and multiplications. Otherwise, the
+ *  operands of additions (and, if `commutative_multiply` is set, of
+ *  multiplications) are sorted by their structural hashes. Afterwards,
+ *  `A + B` and `B + A` are the same node, and the other rules only need to
+ *  look for constants on the left.
+ */
+struct CanonicalOrder {
+    /// Can the operands of a multiplication be swapped?
+    bool commutative_multiply = false;
+
+    template<typename DAGType>
+    auto operator()(DAGType& dag, typename DAGType::size_type i) const {
+        const auto kind = dag.kind(i);
+        if(kind != NodeKind::add && kind != NodeKind::multiply) return i;
+        if(dag.n_children(i) != 2) return i;
+        const auto l = dag.child(i, 0);
+        const auto r = dag.child(i, 1);
+
+        const auto l_const = dag.is_constant(l);
+        const auto r_const = dag.is_constant(r);
+        bool swap          = r_const && !l_const;
+        if(l_const == r_const && l != r) {
+            if(kind == NodeKind::add || commutative_multiply) {
+                const auto hl = dag.hash(l);
+                const auto hr = dag.hash(r);
+                swap          = hr < hl || (hr == hl && r < l);
+            }
+        }
+        return swap ? dag.make_binary(kind, r, l) : i;
+    }
+};
+
+/** @brief Pulls common scalars out of sums and products.
+ *
+ *  - `(a * X) * Y` and `X * (a * Y)` become `a * (X * Y)`,
+ *  - `a * X + a * Y` becomes `a * (X + Y)`,
+ *  - `a * X + b * X` becomes `(a + b) * X`, and
+ *  - `a * X + X` and `X + b * X` become `(a + 1) * X` and `(1 + b) * X`.
+ *
+ *  The rules for sums apply to differences too.
+ */
+struct FactorScalars {
+    template<typename DAGType>
+    auto operator()(DAGType& dag, typename DAGType::size_type i) const {
+        using detail_::is_scaled;
+        const auto kind = dag.kind(i);
+        if(!detail_::is_binary_node(dag, i) || kind == NodeKind::divide)
+            return i;
+        const auto l = dag.child(i, 0);
+        const auto r = dag.child(i, 1);
+
+        if(kind == NodeKind::multiply) {
+            if(dag.is_constant(l) || dag.is_constant(r)) return i;
+            if(is_scaled(dag, l)) {
+                const auto xy = dag.make_binary(kind, dag.child(l, 1), r);
+                return dag.make_binary(kind, dag.child(l, 0), xy);
+            }
+            if(is_scaled(dag, r)) {
+                const auto xy = dag.make_binary(kind, l, dag.child(r, 1));
+                return dag.make_binary(kind, dag.child(r, 0), xy);
+            }
+            return i;
+        }
+
+        // Split each side into a scalar and the rest, X is 1 * X
+        const bool l_scaled = is_scaled(dag, l);
+        const bool r_scaled = is_scaled(dag, r);
+        if(!l_scaled && !r_scaled) return i;
+        const auto x = l_scaled ? dag.child(l, 1) : l;
+        const auto y = r_scaled ? dag.child(r, 1) : r;
+        const auto a = l_scaled ? dag.value(dag.child(l, 0)) : 1.0;
+        const auto b = r_scaled ? dag.value(dag.child(r, 0)) : 1.0;
+
+        if(x == y) {
+            const auto c = kind == NodeKind::add ? a + b : a - b;
+            return dag.make_binary(NodeKind::multiply, dag.make_constant(c), x);
+        }
+        if(l_scaled && r_scaled && a == b) {
+            const auto xy = dag.make_binary(kind, x, y);
+            return dag.make_binary(NodeKind::multiply, dag.child(l, 0), xy);
+        }
+        return i;
+    }
+};
+
+/** @brief Distributes a scalar into a sum when that saves operations.
+ *
+ *  `c * (a * X + b * Y)` becomes `(c * a) * X + (c * b) * Y`, which has one
+ *  multiplication fewer once the constants are folded. Constant terms are
+ *  also accepted, e.g., `c * (a + b * Y)` becomes `(c * a) + (c * b) * Y`.
+ *  The same holds for differences.
+ */
+struct DistributeScalars {
+    template<typename DAGType>
+    auto operator()(DAGType& dag, typename DAGType::size_type i) const {
+        if(!detail_::is_scaled(dag, i)) return i;
+        const auto c   = dag.child(i, 0);
+        const auto sum = dag.child(i, 1);
+        const auto op  = dag.kind(sum);
+        if(op != NodeKind::add && op != NodeKind::subtract) return i;
+        if(dag.n_children(sum) != 2) return i;
+
+        const auto l = dag.child(sum, 0);
+        const auto r = dag.child(sum, 1);
+        auto scalable = [&](auto j) {
+            return dag.is_constant(j) || detail_::is_scaled(dag, j);
+        };
+        if(!scalable(l) || !scalable(r)) return i;
+
+        // Either c * constant, or (c * a) * X
+        auto scale = [&](auto j) {
+            if(dag.is_constant(j))
+                return dag.make_constant(dag.value(c) * dag.value(j));
+            const auto ca = dag.value(c) * dag.value(dag.child(j, 0));
+            return dag.make_binary(NodeKind::multiply, dag.make_constant(ca),
+                                   dag.child(j, 1));
+        };
+        const auto new_l = scale(l);
+        const auto new_r = scale(r);
+        return dag.make_binary(op, new_l, new_r);
+    }
+};
+
+/** @brief Simplifies @p dag with all of the rules in this file.
+ *
+ *  @tparam DAGType The type of the DAG, usually `Evaluator<...>::DAG`.
+ *
+ *  @param[in,out] dag The DAG to simplify.
+ *  @param[in] commutative_multiply Can the operands of multiplications be
+ *                                  swapped? Default is false.
+ *
+ *  @return True if @p dag was changed and false otherwise.
+ *
+ *  @throw std::bad_alloc if there is a problem allocating new nodes. @p dag
+ *                        is left in a valid, but unspecified, state.
+ */
+template<typename DAGType>
+bool simplify(DAGType& dag, bool commutative_multiply = false) {
+    return dag.rewrite(CanonicalOrder{commutative_multiply}, FoldConstants{},
+                       RemoveIdentities{}, FactorScalars{},
+                       DistributeScalars{});
+}
+
+} // namespace utilities::dsl
@@ -0,0 +1,493 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/structural_hash.hpp>
+#include <utilities/dsl/term_traits.hpp>
+#include <utility>
+
+/** @file static_op.hpp
+ *
+ *  The terms of the DSL (Add, Multiply, etc.) store their objects as Leaf
+ *  objects, which type-erase them. This lets trees be built and manipulated
+ *  at runtime, but it also means every access goes through the type-erasure,
+ *  so the compiler can not see through, and fuse, even simple scalar
+ *  expressions. This file implements an opt-in alternative: StaticOp stores
+ *  its objects in an `std::tuple`, using the same rules as TermTraits (terms
+ *  and literals by value, everything else by pointer), so the entire
+ *  expression is known at compile time.
+ *
+ *  Static expressions are started by wrapping a leaf with static_term, e.g.,
+ *  `static_term(a) * b + c`, and can be evaluated with static_evaluate. Since
+ *  they have the same interface as the other terms (`N`, `object<I>()`,
+ *  `hash()`, and a NodeKind), Evaluator, make_dag, structural_hash, etc. also
+ *  work with them.
+ */
+
+namespace utilities::dsl {
+
+template<NodeKind Kind, typename... Args>
+class StaticOp;
+
+template<typename T>
+class StaticRef;
+
+namespace detail_ {
+
+/// Is @p T a StaticOp?
+template<typename T>
+struct IsStaticOp : std::false_type {};
+
+template<NodeKind Kind, typename... Args>
+struct IsStaticOp<StaticOp<Kind, Args...>> : std::true_type {};
+
+/// Is @p T a StaticRef?
+template<typename T>
+struct IsStaticRef : std::false_type {};
+
+template<typename T>
+struct IsStaticRef<StaticRef<T>> : std::true_type {};
+
+/// The type a StaticOp stores an object of type @p T as
+template<typename T>
+using static_holder_t =
+  std::conditional_t<IsStaticOp<std::remove_cv_t<T>>::value,
+                     std::remove_cv_t<T>, typename TermTraits<T>::holder_type>;
+
+/// Works out the type of object a StaticOp made from a @p T holds
+template<typename T>
+struct StaticArg {
+    using type = T;
+};
+
+template<typename T>
+struct StaticArg<StaticRef<T>> {
+    using type = T;
+};
+
+template<typename T>
+struct StaticArg<const StaticRef<T>> {
+    using type = T;
+};
+
+/// The type of object a StaticOp made from a @p T (possibly a reference)
+template<typename T>
+using static_arg_t = typename StaticArg<std::remove_reference_t<T>>::type;
+
+/** @brief Can an object of type @p T (possibly a reference) be an operand?
+ *
+ *  Objects which are not part of the DSL are held by pointer, so they must be
+ *  lvalues; a pointer to a temporary would dangle as soon as the full
+ *  expression ends. Terms and literals are held by value, and a StaticRef
+ *  aliases an lvalue, so they may be temporaries.
+ */
+template<typename T>
+constexpr bool is_static_operand_v =
+  std::is_lvalue_reference_v<T> ||
+  IsStaticRef<std::remove_cv_t<std::remove_reference_t<T>>>::value ||
+  !std::is_pointer_v<static_holder_t<static_arg_t<T>>>;
+
+/// Enables a function if all of @p Ts can be operands
+template<typename... Ts>
+using enable_if_static_operands_t =
+  std::enable_if_t<(is_static_operand_v<Ts> && ...)>;
+
+/// Converts @p input into the holder for a @p T object
+template<typename T, typename U>
+static_holder_t<T> make_static_holder(U&& input) {
+    if constexpr(IsStaticRef<std::decay_t<U>>::value) {
+        return make_static_holder<T>(input.get());
+    } else if constexpr(std::is_pointer_v<static_holder_t<T>>) {
+        return &input;
+    } else {
+        return std::forward<U>(input);
+    }
+}
+
+/// Converts a holder back into a reference to the object
+template<typename HolderType>
+decltype(auto) unwrap_static_holder(HolderType& holder) {
+    if constexpr(std::is_pointer_v<std::remove_cv_t<HolderType>>) {
+        return *holder;
+    } else {
+        return holder;
+    }
+}
+
+} // namespace detail_
+
+/** @brief Base class for the elements of a static expression.
+ *
+ *  @tparam DerivedType Type of the object *this is implementing.
+ *
+ *  This is the static counterpart to Term. The operators copy *this into the
+ *  result (StaticOp objects are small, they only hold pointers and literals)
+ *  and alias or copy @p rhs following the rules of TermTraits. Unlike Term,
+ *  which copies temporaries into its Leaf objects, the operators do not
+ *  accept temporaries which would be aliased (e.g., `static_term(a) *
+ *  make_tensor()`), since they would dangle.
+ */
+template<typename DerivedType>
+class StaticTerm {
+public:
+    /// Creates the static expression `*this + rhs`
+    template<typename RHSType,
+             typename = detail_::enable_if_static_operands_t<RHSType>>
+    auto operator+(RHSType&& rhs) const {
+        return make_op_<NodeKind::add>(std::forward<RHSType>(rhs));
+    }
+
+    /// Creates the static expression `*this - rhs`
+    template<typename RHSType,
+             typename = detail_::enable_if_static_operands_t<RHSType>>
+    auto operator-(RHSType&& rhs) const {
+        return make_op_<NodeKind::subtract>(std::forward<RHSType>(rhs));
+    }
+
+    /// Creates the static expression `*this * rhs`
+    template<typename RHSType,
+             typename = detail_::enable_if_static_operands_t<RHSType>>
+    auto operator*(RHSType&& rhs) const {
+        return make_op_<NodeKind::multiply>(std::forward<RHSType>(rhs));
+    }
+
+    /// Creates the static expression `*this / rhs`
+    template<typename RHSType,
+             typename = detail_::enable_if_static_operands_t<RHSType>>
+    auto operator/(RHSType&& rhs) const {
+        return make_op_<NodeKind::divide>(std::forward<RHSType>(rhs));
+    }
+
+    decltype(auto) downcast() const {
+        return static_cast<const DerivedType&>(*this);
+    }
+
+private:
+    /// Makes the StaticOp for `*this Kind rhs`
+    template<NodeKind Kind, typename RHSType>
+    auto make_op_(RHSType&& rhs) const {
+        using lhs_type = detail_::static_arg_t<DerivedType>;
+        using rhs_type = detail_::static_arg_t<RHSType>;
+        return StaticOp<Kind, lhs_type, rhs_type>(downcast(),
+                                                  std::forward<RHSType>(rhs));
+    }
+};
+
+/** @brief Starts a static expression by aliasing a leaf.
+ *
+ *  @tparam T The (possibly const-qualified) type of the leaf.
+ *
+ *  StaticRef only exists to give the first leaf of a static expression
+ *  operators. When a StaticOp is made from a StaticRef it holds the leaf
+ *  itself (by pointer, or by value for literals), not the StaticRef.
+ */
+template<typename T>
+class StaticRef : public StaticTerm<StaticRef<T>> {
+public:
+    /// Aliases @p object, which must outlive *this and anything made from it
+    explicit StaticRef(T& object) noexcept : m_object_(&object) {}
+
+    /// The aliased object
+    T& get() const noexcept { return *m_object_; }
+
+private:
+    /// The aliased object
+    T* m_object_;
+};
+
+/** @brief An operation whose objects are stored without type-erasure.
+ *
+ *  @tparam Kind Which operation *this represents.
+ *  @tparam Args The (possibly const-qualified) types of the objects. For
+ *               function calls the first object is the callable.
+ *
+ *  StaticOp is the static counterpart to NAryOp. The objects are stored in an
+ *  `std::tuple` of `TermTraits<Args>::holder_type` (StaticOp objects are
+ *  held by value) so there is no type-erasure, no heap allocation, and no
+ *  RTTI. Unlike NAryOp, the structural hash is not cached, since that would
+ *  make every node bigger; it is recomputed each time it is requested.
+ */
+template<NodeKind Kind, typename... Args>
+class StaticOp : public StaticTerm<StaticOp<Kind, Args...>> {
+private:
+    /// The I-th type in Args
+    template<std::size_t I>
+    using type_i = std::tuple_element_t<I, std::tuple<Args...>>;
+
+    /// The traits of the I-th type in Args
+    template<std::size_t I>
+    using traits_i = TermTraits<type_i<I>>;
+
+    /// Disables the variadic ctor when it would be used to copy/move
+    template<typename... Args2>
+    static constexpr bool is_not_copy_v =
+      sizeof...(Args2) == sizeof...(Args) &&
+      !std::disjunction_v<std::is_same<std::decay_t<Args2>, StaticOp>...>;
+
+public:
+    /// The value of "N" in N-ary
+    static constexpr auto N = sizeof...(Args);
+
+    /// The operation *this represents
+    static constexpr NodeKind kind = Kind;
+
+    /// Unqualified type of the I-th object
+    template<std::size_t I>
+    using object_type = typename traits_i<I>::value_type;
+
+    /// Type acting like `object_type<I>&`, but respecting const-ness
+    template<std::size_t I>
+    using object_reference = typename traits_i<I>::reference;
+
+    /// Type acting like `const object_type<I>&`
+    template<std::size_t I>
+    using const_object_reference = typename traits_i<I>::const_reference;
+
+    /** @brief Creates a new operation from @p args.
+     *
+     *  @param[in] args The objects. Terms and literals are copied (or moved),
+     *                  everything else is aliased and must outlive *this.
+     *                  Hence, objects which are aliased must be lvalues;
+     *                  passing a temporary one does not compile.
+     *
+     *  @throw ??? Throws if copying one of @p args throws. Same throw
+     *             guarantee.
+     */
+    template<typename... Args2,
+             typename = std::enable_if_t<is_not_copy_v<Args2...>>,
+             typename = detail_::enable_if_static_operands_t<Args2...>>
+    explicit StaticOp(Args2&&... args) :
+      m_objects_(
+        detail_::make_static_holder<Args>(std::forward<Args2>(args))...) {}
+
+    /// A (possibly) mutable reference to the I-th object
+    template<std::size_t I>
+    object_reference<I> object() {
+        return detail_::unwrap_static_holder(std::get<I>(m_objects_));
+    }
+
+    /// A read-only reference to the I-th object
+    template<std::size_t I>
+    const_object_reference<I> object() const {
+        return detail_::unwrap_static_holder(std::get<I>(m_objects_));
+    }
+
+    /// Does *this alias the I-th object? Literals are never aliased.
+    template<std::size_t I>
+    static constexpr bool aliases() noexcept {
+        return std::is_pointer_v<detail_::static_holder_t<type_i<I>>>;
+    }
+
+    /** @brief The structural hash of the tree rooted at *this.
+     *
+     *  Computed the same way as NAryOp::hash, but not cached.
+     *
+     *  @return The structural hash of *this.
+     *
+     *  @throw ??? Throws if hashing one of the leaves throws. Same throw
+     *             guarantee.
+     */
+    std::size_t hash() const {
+        auto id = reinterpret_cast<std::size_t>(detail_::type_id<StaticOp>());
+        return hash_objects_(id, std::make_index_sequence<N>{});
+    }
+
+    /** @brief Is *this the same operation, on the same values, as @p other?
+     *
+     *  Like NAryOp, const-ness of the objects is not considered.
+     *
+     *  @param[in] other The operation to compare to.
+     *
+     *  @return True if *this is value equal to @p other and false otherwise.
+     *
+     *  @throw None No throw guarantee.
+     */
+    template<NodeKind Kind2, typename... Args2>
+    bool operator==(const StaticOp<Kind2, Args2...>& other) const noexcept {
+        using types_type  = std::tuple<std::remove_cv_t<Args>...>;
+        using types2_type = std::tuple<std::remove_cv_t<Args2>...>;
+        constexpr bool same_types = std::is_same_v<types_type, types2_type>;
+        if constexpr(Kind != Kind2 || !same_types) {
+            return false;
+        } else {
+            return equal_(other, std::make_index_sequence<N>{});
+        }
+    }
+
+    /// Is *this different than @p other? See operator==
+    template<NodeKind Kind2, typename... Args2>
+    bool operator!=(const StaticOp<Kind2, Args2...>& other) const noexcept {
+        return !((*this) == other);
+    }
+
+private:
+    /// Combines the hashes of the objects with indices @p Is
+    template<std::size_t... Is>
+    std::size_t hash_objects_(std::size_t seed,
+                              std::index_sequence<Is...>) const {
+        using detail_::hash_combine;
+        ((seed = hash_combine(seed, detail_::child_hash<Is>(*this))), ...);
+        return seed;
+    }
+
+    /// Compares the objects with indices @p Is
+    template<typename OtherType, std::size_t... Is>
+    bool equal_(const OtherType& other, std::index_sequence<Is...>) const {
+        return ((object<Is>() == other.template object<Is>()) && ...);
+    }
+
+    /// The objects
+    std::tuple<detail_::static_holder_t<Args>...> m_objects_;
+};
+
+/// Static counterparts of Add, Subtract, Multiply, Divide, and FunctionCall
+///@{
+template<typename LHSType, typename RHSType>
+using StaticAdd = StaticOp<NodeKind::add, LHSType, RHSType>;
+
+template<typename LHSType, typename RHSType>
+using StaticSubtract = StaticOp<NodeKind::subtract, LHSType, RHSType>;
+
+template<typename LHSType, typename RHSType>
+using StaticMultiply = StaticOp<NodeKind::multiply, LHSType, RHSType>;
+
+template<typename LHSType, typename RHSType>
+using StaticDivide = StaticOp<NodeKind::divide, LHSType, RHSType>;
+
+template<typename... Args>
+using StaticFunctionCall = StaticOp<NodeKind::function_call, Args...>;
+///@}
+
+template<NodeKind Kind, typename... Args>
+struct NodeKindOf<StaticOp<Kind, Args...>>
+  : std::integral_constant<NodeKind, Kind> {};
+
+/** @brief Starts a static expression.
+ *
+ *  @tparam T The (possibly const-qualified) type of @p object.
+ *
+ *  @param[in] object The leaf to start the expression with. Must outlive the
+ *                    expression.
+ *
+ *  @return A StaticRef to @p object, which has the operators of StaticTerm.
+ *
+ *  @throw None No throw guarantee.
+ */
+template<typename T>
+StaticRef<T> static_term(T& object) noexcept {
+    return StaticRef<T>(object);
+}
+
+/** @brief Creates the static expression for calling @p fxn with @p args.
+ *
+ *  @tparam FxnType The type of the callable.
+ *  @tparam Args The types of the arguments.
+ *
+ *  @param[in] fxn The callable. Held like any other object, i.e., it is
+ *                 aliased and must be an lvalue.
+ *  @param[in] args The arguments.
+ *
+ *  @return The StaticFunctionCall.
+ *
+ *  @throw ??? Throws if copying one of the objects throws. Same throw
+ *             guarantee.
+ */
+template<typename FxnType, typename... Args,
+         typename = detail_::enable_if_static_operands_t<FxnType, Args...>>
+auto static_call(FxnType&& fxn, Args&&... args) {
+    using op_type = StaticFunctionCall<detail_::static_arg_t<FxnType>,
+                                       detail_::static_arg_t<Args>...>;
+    return op_type(std::forward<FxnType>(fxn), std::forward<Args>(args)...);
+}
+
+namespace detail_ {
+
+/// Calls the callable of @p expr with its evaluated arguments
+template<typename T, std::size_t... Is>
+decltype(auto) static_call_(const T& expr, std::index_sequence<Is...>);
+
+/// Sums (or multiplies) the evaluated operands of @p expr, left to right
+template<NodeKind Kind, typename T, std::size_t... Is>
+decltype(auto) static_fold_(const T& expr, std::index_sequence<Is...>);
+
+} // namespace detail_
+
+/** @brief Evaluates @p expr with the operators of its leaves.
+ *
+ *  @tparam T The type of @p expr.
+ *
+ *  The leaves are combined with their own `+`, `-`, `*`, and `/`, and function
+ *  calls call their callable, so, e.g., for a static expression of doubles
+ *  the compiler sees `a * b + c` and can inline and fuse it. Any term with
+ *  the DSL's interface can be evaluated, but for the type-erased terms each
+ *  access goes through the Leaf.
+ *
+ *  @param[in] expr The expression to evaluate.
+ *
+ *  @return The value of @p expr. For a leaf this is a reference to the leaf.
+ *
+ *  @throw ??? Throws if one of the operations throws. Same throw guarantee.
+ */
+template<typename T>
+decltype(auto) static_evaluate(const T& expr) {
+    constexpr auto kind = node_kind_v<T>;
+    if constexpr(kind == NodeKind::leaf) {
+        if constexpr(detail_::IsStaticRef<T>::value) {
+            return expr.get();
+        } else {
+            return (expr);
+        }
+    } else if constexpr(kind == NodeKind::function_call) {
+        constexpr auto nargs = T::N - 1;
+        return detail_::static_call_(expr, std::make_index_sequence<nargs>{});
+    } else if constexpr(kind == NodeKind::add ||
+                        kind == NodeKind::multiply) {
+        // Sums and products may have more than two operands
+        return detail_::static_fold_<kind>(expr,
+                                           std::make_index_sequence<T::N>{});
+    } else {
+        decltype(auto) lhs = static_evaluate(expr.template object<0>());
+        decltype(auto) rhs = static_evaluate(expr.template object<1>());
+        if constexpr(kind == NodeKind::subtract) {
+            return lhs - rhs;
+        } else {
+            return lhs / rhs;
+        }
+    }
+}
+
+template<typename T, std::size_t... Is>
+decltype(auto) detail_::static_call_(const T& expr,
+                                     std::index_sequence<Is...>) {
+    const auto& fxn = expr.template object<0>();
+    return fxn(static_evaluate(expr.template object<Is + 1>())...);
+}
+
+template<NodeKind Kind, typename T, std::size_t... Is>
+decltype(auto) detail_::static_fold_(const T& expr,
+                                     std::index_sequence<Is...>) {
+    if constexpr(Kind == NodeKind::add) {
+        return (... + static_evaluate(expr.template object<Is>()));
+    } else {
+        return (... * static_evaluate(expr.template object<Is>()));
+    }
+}
+
+} // namespace utilities::dsl
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utilities/dsl/detail_/leaf_holder.hpp>
+#include <utilities/dsl/dsl_traits.hpp>
+#include <utilities/dsl/term_traits.hpp>
+#include <utility>
+
+/** @file structural_hash.hpp
+ *
+ *  Structural hashing and comparison of expression trees. Two (sub)trees are
+ *  structurally equal if they have the same types, the leaves the DSL aliases
+ *  are the same objects, and the leaves the DSL holds by value (literals like
+ *  doubles and strings) compare equal. This is what common subexpression
+ *  elimination needs: it is cheap (aliased objects, e.g., tensors, are never
+ *  compared element-wise) and two structurally equal subtrees always have
+ *  the same value.
+ *
+ *  Literals passed to an operation as lvalues are aliased too, e.g., `alpha`
+ *  in `alpha * A`. Their values may change after the tree is made (and
+ *  hashed), so within an operation they are treated like any other aliased
+ *  leaf: they are hashed by address and are only structurally equal to the
+ *  same object. A literal the operation owns is never equal to an aliased
+ *  one, even if the values currently match.
+ */
+
+namespace utilities::dsl {
+namespace detail_ {
+
+/// Does std::hash<T> exist?
+template<typename T, typename = void>
+struct IsStdHashable : std::false_type {};
+
+template<typename T>
+struct IsStdHashable<
+  T, std::void_t<decltype(std::hash<T>{}(std::declval<const T&>()))>>
+  : std::true_type {};
+
+/// Mixes @p value into @p seed (the boost::hash_combine recipe)
+constexpr std::size_t hash_combine(std::size_t seed,
+                                   std::size_t value) noexcept {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+/** @brief Caches a node's structural hash.
+ *
+ *  Zero means "not computed yet". The cache is atomic so that a tree may be
+ *  hashed from several threads; all of them compute the same value, so
+ *  relaxed ordering suffices. Copies copy the cached value.
+ */
+class CachedHash {
+public:
+    CachedHash() noexcept = default;
+    CachedHash(const CachedHash& other) noexcept : m_value_(other.load()) {}
+    CachedHash& operator=(const CachedHash& rhs) noexcept {
+        store(rhs.load());
+        return *this;
+    }
+
+    std::size_t load() const noexcept {
+        return m_value_.load(std::memory_order_relaxed);
+    }
+    void store(std::size_t value) noexcept {
+        m_value_.store(value, std::memory_order_relaxed);
+    }
+    void reset() noexcept { store(0); }
+
+private:
+    std::atomic<std::size_t> m_value_{0};
+};
+
+} // namespace detail_
+
+template<typename T, typename U>
+bool structurally_equal(const T& lhs, const U& rhs);
+
+namespace detail_ {
+
+/// Is @p T a literal, i.e., a leaf which is part of the DSL?
+template<typename T>
+constexpr bool is_literal_v =
+  node_kind_v<T> == NodeKind::leaf && TermTraits<T>::is_dsl_term_v;
+
+/// Hashes the leaf @p object by its type and address
+template<typename T>
+std::size_t address_hash(const T& object) noexcept {
+    using value_type = typename TermTraits<T>::value_type;
+
+    auto id      = reinterpret_cast<std::size_t>(type_id<value_type>());
+    auto address = reinterpret_cast<std::size_t>(&object);
+    return hash_combine(id, address);
+}
+
+} // namespace detail_
+
+/** @brief Computes the structural hash of @p object.
+ *
+ *  @tparam T The type of @p object. Either one of the DSL's operations or a
+ *            leaf.
+ *
+ *  For operations this returns the hash cached in the node (computing it if
+ *  needed). Leaves which the DSL aliases are hashed by address, leaves the
+ *  DSL holds by value are hashed with std::hash (or only by type if there is
+ *  no std::hash for them). Literals an operation aliases are
+ *  hashed by the operation, by address.
+ *
+ *  @param[in] object The (sub)tree to hash.
+ *
+ *  @return A hash consistent with structurally_equal.
+ *
+ *  @throw ??? Throws if std::hash throws for a leaf. Same throw guarantee.
+ */
+template<typename T>
+std::size_t structural_hash(const T& object) {
+    using traits_type = TermTraits<T>;
+    using value_type  = typename traits_type::value_type;
+    if constexpr(node_kind_v<T> != NodeKind::leaf) {
+        return object.hash();
+    } else {
+        auto id = reinterpret_cast<std::size_t>(detail_::type_id<value_type>());
+        if constexpr(!traits_type::is_dsl_term_v) {
+            return detail_::address_hash(object);
+        } else if constexpr(detail_::IsStdHashable<value_type>::value) {
+            return detail_::hash_combine(id, std::hash<value_type>{}(object));
+        } else {
+            return id;
+        }
+    }
+}
+
+namespace detail_ {
+
+/** @brief The structural hash of the @p I-th child of the operation @p op.
+ *
+ *  Literals @p op aliases are hashed by address, since their values may
+ *  change after the hash is cached.
+ */
+template<std::size_t I, typename T>
+std::size_t child_hash(const T& op) {
+    using child_type  = typename T::template object_type<I>;
+    const auto& child = op.template object<I>();
+    if constexpr(is_literal_v<child_type>) {
+        if(op.template aliases<I>()) return address_hash(child);
+    }
+    return structural_hash(child);
+}
+
+/// Are the @p I-th children of @p lhs and @p rhs structurally equal?
+template<std::size_t I, typename T>
+bool child_structurally_equal(const T& lhs, const T& rhs) {
+    using child_type = typename T::template object_type<I>;
+    const auto& l    = lhs.template object<I>();
+    const auto& r    = rhs.template object<I>();
+    if constexpr(is_literal_v<child_type>) {
+        const bool is_alias = lhs.template aliases<I>();
+        if(is_alias != rhs.template aliases<I>()) return false;
+        if(is_alias) return &l == &r;
+    }
+    return structurally_equal(l, r);
+}
+
+/// Compares the children of two operations of type @p T
+template<typename T, std::size_t... Is>
+bool children_structurally_equal(const T& lhs, const T& rhs,
+                                 std::index_sequence<Is...>) {
+    return (child_structurally_equal<Is>(lhs, rhs) && ...);
+}
+
+} // namespace detail_
+
+/** @brief Are @p lhs and @p rhs structurally equal?
+ *
+ *  @tparam T The type of @p lhs.
+ *  @tparam U The type of @p rhs.
+ *
+ *  See the description of this file for the definition of structurally
+ *  equal. Unlike operator==, the types must match exactly (up to top-level
+ *  cv-qualifiers).
+ *
+ *  @param[in] lhs The first (sub)tree.
+ *  @param[in] rhs The second (sub)tree.
+ *
+ *  @return True if the trees are structurally equal and false otherwise.
+ *
+ *  @throw ??? Throws if comparing by-value leaves throws. Same throw
+ *             guarantee.
+ */
+template<typename T, typename U>
+bool structurally_equal(const T& lhs, const U& rhs) {
+    if constexpr(!std::is_same_v<std::remove_cv_t<T>, std::remove_cv_t<U>>) {
+        return false;
+    } else if constexpr(node_kind_v<T> != NodeKind::leaf) {
+        if(&lhs == &rhs) return true;
+        if(lhs.hash() != rhs.hash()) return false;
+        return detail_::children_structurally_equal(
+          lhs, rhs, std::make_index_sequence<T::N>{});
+    } else if constexpr(!TermTraits<T>::is_dsl_term_v) {
+        return &lhs == &rhs;
+    } else {
+        return lhs == rhs;
+    }
+}
+
+} // namespace utilities::dsl
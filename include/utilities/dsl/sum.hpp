@@ -0,0 +1,116 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <type_traits>
+#include <utilities/dsl/n_ary_op.hpp>
+#include <utility>
+
+namespace utilities::dsl {
+
+/** @brief Represents the addition of any number of terms.
+ *
+ *  @tparam Args The const-qualified types of the terms being added, in
+ *               order.
+ *
+ *  Add only has two operands, so an expression like `a + b + c + d` is a
+ *  chain of Adds. Evaluating such a chain one pair at a time goes through a
+ *  temporary per link. Sum instead holds all of the operands, which lets the
+ *  Evaluator hand them to the backend in one go (see the n-ary kernels in
+ *  evaluator.hpp) so that the result is accumulated into a single buffer.
+ *  The operands are NOT reordered, i.e., addition is assumed to be associative,
+ *  but not commutative.
+ *
+ *  Sum objects are made with sum(), by appending to a Sum with `+`, or by
+ *  flattening an existing expression (see flatten.hpp).
+ */
+template<typename... Args>
+class Sum : public NAryOp<Sum<Args...>, Args...> {
+private:
+    /// Type of *this
+    using my_type = Sum<Args...>;
+
+    /// Type *this inherits from
+    using op_type = NAryOp<my_type, Args...>;
+
+public:
+    /// Reuse the base class's ctor
+    using op_type::op_type;
+
+    /** @brief Appends @p rhs to the operands of *this.
+     *
+     *  @tparam RHSType The type of @p rhs.
+     *
+     *  Unlike the other terms, which nest, `sum(a, b) + c` is the same as
+     *  `sum(a, b, c)`.
+     *
+     *  Terms, doubles, and strings are copied out of *this, the other
+     *  operands alias the same objects *this does.
+     *
+     *  @param[in] rhs The object to append.
+     *
+     *  @return A Sum whose operands are those of *this followed by @p rhs.
+     *
+     *  @throw std::bad_alloc if copying the operands fails. Strong throw
+     *                        guarantee.
+     */
+    template<typename RHSType>
+    auto operator+(RHSType&& rhs) {
+        return append_(std::forward<RHSType>(rhs),
+                       std::make_index_sequence<op_type::N>{});
+    }
+
+private:
+    /// Implements operator+ by unpacking the operands of *this
+    template<typename RHSType, std::size_t... Is>
+    auto append_(RHSType&& rhs, std::index_sequence<Is...>) {
+        using rhs_type    = std::remove_reference_t<RHSType>;
+        using result_type = Sum<Args..., rhs_type>;
+        return result_type(operand_<Is>()..., std::forward<RHSType>(rhs));
+    }
+
+    /// The I-th operand, copied if it is part of the DSL and aliased if not
+    template<std::size_t I>
+    decltype(auto) operand_() {
+        using object_type = typename op_type::template object_type<I>;
+        if constexpr(TermTraits<object_type>::is_dsl_term_v) {
+            return object_type(this->template object<I>());
+        } else {
+            return this->template object<I>();
+        }
+    }
+};
+
+/** @brief Makes a Sum of @p args.
+ *
+ *  @tparam Args The types of the operands.
+ *
+ *  Like the other operations, lvalues are aliased and rvalues are copied.
+ *
+ *  @param[in] args The operands, in order. Must be at least two.
+ *
+ *  @return A Sum of @p args.
+ *
+ *  @throw std::bad_alloc if copying the operands fails. Strong throw
+ *                        guarantee.
+ */
+template<typename... Args>
+auto sum(Args&&... args) {
+    static_assert(sizeof...(Args) >= 2, "Need at least two operands");
+    return Sum<std::remove_reference_t<Args>...>(std::forward<Args>(args)...);
+}
+
+} // namespace utilities::dsl
@@ -0,0 +1,479 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "utilities/printing/detail_/serialize_stl.hpp"
+#include "utilities/printing/print_stl.hpp"
+#include <cstdint>
+#include <stdexcept>
+
+/** @file binary_stl.hpp
+ *
+ *  A length-prefixed binary format for the STL containers supported by
+ *  print_stl.hpp, meant for checkpointing intermediate results. The format
+ *  is:
+ *
+ *  - Arithmetic values are stored as their object representation, i.e., in
+ *    the byte order of the machine which wrote them. `bool` is one byte.
+ *  - Sizes are `std::uint64_t`s.
+ *  - Ranges (the sequence containers, sets, maps, strings) are stored as
+ *    their size followed by their elements. The elements of a map are its
+ *    keys and values, interleaved. Container adaptors (`std::queue`,
+ *    `std::stack`, and `std::priority_queue`) are stored as their underlying
+ *    container.
+ *  - Ranges of contiguous arithmetic values (`std::vector<double>`,
+ *    `std::array<int, 3>`, `std::string`, ...) are stored as their size,
+ *    zero padding up to the alignment of the elements, and then the raw
+ *    elements. The padding is relative to the start of the output, so that
+ *    the elements can be used in place when the data is read back (see
+ *    BinaryReader).
+ *  - `std::pair` and `std::tuple` are stored as their elements.
+ *  - `std::optional` is stored as a one byte flag followed, if the flag is
+ *    1, by the value.
+ *
+ *  Nothing identifies the types in the output; the reader must ask for the
+ *  same types the writer wrote. Since the byte order and the sizes of the
+ *  arithmetic types are those of the writer, data written on one platform is
+ *  not meant to be read on another.
+ */
+
+namespace utilities::printing {
+
+/** @brief A read-only view of contiguous elements.
+ *
+ *  Returned by BinaryReader to hand out arrays of arithmetic values without
+ *  copying them out of the buffer being read.
+ *
+ *  @tparam T The type of the elements.
+ */
+template<typename T>
+class ArrayView {
+public:
+    /// Types needed to make this compatible with the STL
+    ///@{
+    using value_type     = T;
+    using size_type      = std::size_t;
+    using const_iterator = const T*;
+    using iterator       = const_iterator;
+    ///@}
+
+    /// Makes an empty view
+    ArrayView() noexcept = default;
+
+    /// Makes a view of the @p n elements starting at @p data
+    ArrayView(const T* data, size_type n) noexcept : m_data_(data), m_n_(n) {}
+
+    /// The first element
+    const T* data() const noexcept { return m_data_; }
+
+    /// The number of elements
+    size_type size() const noexcept { return m_n_; }
+
+    /// Are there no elements?
+    bool empty() const noexcept { return m_n_ == 0; }
+
+    /// The @p i-th element, no bounds checking
+    const T& operator[](size_type i) const noexcept { return m_data_[i]; }
+
+    /// Iterators over the elements
+    ///@{
+    const_iterator begin() const noexcept { return m_data_; }
+    const_iterator end() const noexcept { return m_data_ + m_n_; }
+    ///@}
+
+private:
+    /// The first element
+    const T* m_data_ = nullptr;
+
+    /// The number of elements
+    size_type m_n_ = 0;
+};
+
+/** @brief Writes values to a stream in the format described in
+ *         binary_stl.hpp.
+ *
+ *  Values are written to the stream as they are traversed (through a
+ *  fixed-size buffer) so the output is never assembled in memory. Writing
+ *  several values with the same BinaryWriter keeps the padding consistent
+ *  with a BinaryReader reading them back in the same order.
+ */
+class BinaryWriter {
+public:
+    /// Type used for counting bytes
+    using size_type = std::size_t;
+
+    /// Makes a writer which appends to @p os. @p os must outlive *this.
+    explicit BinaryWriter(std::ostream& os) noexcept : m_os_(os) {}
+
+    /** @brief Writes @p value.
+     *
+     *  @tparam T The type of the value. Must be one of the types listed in
+     *            binary_stl.hpp, or an STL container (recursively) of them.
+     *
+     *  @param[in] value The value to write.
+     *
+     *  @return *this, to allow chaining.
+     *
+     *  @throw ??? if writing to the stream throws. Basic throw guarantee.
+     */
+    template<typename T>
+    BinaryWriter& write(const T& value) {
+        detail_::BufferedWriter out(m_os_);
+        write_(out, value);
+        out.flush();
+        return *this;
+    }
+
+    /// The number of bytes written so far
+    size_type size() const noexcept { return m_offset_; }
+
+private:
+    /// Writes @p n raw bytes
+    void raw_(detail_::BufferedWriter& out, const void* p, size_type n) {
+        out.write(static_cast<const char*>(p), n);
+        m_offset_ += n;
+    }
+
+    /// Writes zeros until the offset is a multiple of @p alignment
+    void pad_(detail_::BufferedWriter& out, size_type alignment) {
+        for(; m_offset_ % alignment; ++m_offset_) out.put('\0');
+    }
+
+    /// Writes a size
+    void size_(detail_::BufferedWriter& out, size_type n) {
+        const auto n64 = static_cast<std::uint64_t>(n);
+        raw_(out, &n64, sizeof(n64));
+    }
+
+    /// Dispatches on the type of @p x
+    template<typename T>
+    void write_(detail_::BufferedWriter& out, const T& x) {
+        using namespace detail_;
+        if constexpr(std::is_same_v<T, bool>) {
+            const char c = x ? 1 : 0;
+            raw_(out, &c, 1);
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            raw_(out, &x, sizeof(T));
+        } else if constexpr(IsStringLike<T>::value) {
+            const std::string_view str(x);
+            size_(out, str.size());
+            raw_(out, str.data(), str.size());
+        } else if constexpr(IsOptional<T>::value) {
+            write_(out, x.has_value());
+            if(x.has_value()) write_(out, *x);
+        } else if constexpr(IsTupleLike<T>::value) {
+            for_each_element(x, [&](const auto& xi) { write_(out, xi); });
+        } else if constexpr(IsAdaptor<T>::value) {
+            write_(out, underlying_container(x));
+        } else if constexpr(IsContiguousArithmetic<T>::value) {
+            using value_type = typename T::value_type;
+            size_(out, x.size());
+            pad_(out, alignof(value_type));
+            raw_(out, x.data(), x.size() * sizeof(value_type));
+        } else if constexpr(IsMap<T>::value) {
+            size_(out, std::distance(std::begin(x), std::end(x)));
+            for(const auto& [k, v] : x) {
+                write_(out, k);
+                write_(out, v);
+            }
+        } else if constexpr(IsRange<T>::value) {
+            size_(out, std::distance(std::begin(x), std::end(x)));
+            for(const auto& xi : x) write_(out, xi);
+        } else {
+            static_assert(always_false_v<T>, "Type can not be written");
+        }
+    }
+
+    /// Where the bytes go
+    std::ostream& m_os_;
+
+    /// How many bytes have been written (used to compute the padding)
+    size_type m_offset_ = 0;
+};
+
+/** @brief Reads values written by BinaryWriter out of a buffer.
+ *
+ *  The reader does not own the buffer; it is typically the contents of a
+ *  checkpoint file (e.g., from a FileTokenizer, which maps the file into
+ *  memory). Values may be read back as the types that were written, which
+ *  copies them out of the buffer, or, for quick restarts, as views into the
+ *  buffer:
+ *
+ *  - strings can be read as `std::string_view`, and
+ *  - contiguous arithmetic ranges can be read as `ArrayView`s.
+ *
+ *  Views may be nested inside other containers, e.g., data written as an
+ *  `std::map<std::string, std::vector<double>>` can be read back as an
+ *  `std::map<std::string_view, ArrayView<double>>` without copying any of
+ *  the strings or doubles.
+ *
+ *  @note ArrayViews require the elements to be suitably aligned in memory,
+ *        which is the case if the start of the buffer is aligned for the
+ *        elements (buffers returned by `new`, `malloc`, and `mmap` are).
+ */
+class BinaryReader {
+public:
+    /// Type used for offsets and counting
+    using size_type = std::size_t;
+
+    /// Makes a reader over @p bytes, which must outlive any views read
+    explicit BinaryReader(std::string_view bytes) noexcept : m_bytes_(bytes) {}
+
+    /** @brief Reads the next value, which must have been written as a T.
+     *
+     *  @tparam T The type to read. Either the type which was written or a
+     *            type with views in place of strings and/or contiguous
+     *            arithmetic ranges.
+     *
+     *  @return The value.
+     *
+     *  @throw std::out_of_range if the buffer ends before the value does.
+     *                           The reader is left at an unspecified
+     *                           position.
+     *  @throw std::runtime_error if the value is not compatible with T (an
+     *                            array size does not match, or an ArrayView
+     *                            would be misaligned). The reader is left at
+     *                            an unspecified position.
+     *  @throw std::bad_alloc if there is insufficient memory for the value.
+     *                        The reader is left at an unspecified position.
+     */
+    template<typename T>
+    T read() {
+        using namespace detail_;
+        if constexpr(std::is_same_v<T, bool>) {
+            return read<char>() != 0;
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            T rv;
+            std::memcpy(&rv, take_(sizeof(T)), sizeof(T));
+            return rv;
+        } else if constexpr(std::is_same_v<T, std::string_view>) {
+            const auto n = size_(1);
+            return std::string_view(take_(n), n);
+        } else if constexpr(IsStringLike<T>::value) {
+            static_assert(IsResizable<T>::value, "Read strings as string_view");
+            return T(read<std::string_view>());
+        } else if constexpr(IsArrayView<T>::value) {
+            using value_type = typename T::value_type;
+            const auto n     = size_(sizeof(value_type));
+            const auto* p    = take_aligned_(n, sizeof(value_type),
+                                             alignof(value_type));
+            if(reinterpret_cast<std::uintptr_t>(p) % alignof(value_type))
+                throw std::runtime_error("BinaryReader: misaligned array");
+            return T(reinterpret_cast<const value_type*>(p), n);
+        } else if constexpr(IsOptional<T>::value) {
+            if(!read<bool>()) return T{};
+            return T(read<typename T::value_type>());
+        } else if constexpr(IsTupleLike<T>::value) {
+            return read_tuple_<T>(
+              std::make_index_sequence<std::tuple_size_v<T>>{});
+        } else if constexpr(IsAdaptor<T>::value) {
+            auto c = read<typename T::container_type>();
+            if constexpr(HasValueCompare<T>::value) // std::priority_queue
+                return T(typename T::value_compare{}, std::move(c));
+            else
+                return T(std::move(c));
+        } else {
+            T rv{};
+            read_range_(rv);
+            return rv;
+        }
+    }
+
+    /// The number of bytes read so far
+    size_type offset() const noexcept { return m_offset_; }
+
+    /// The number of bytes which have not been read
+    size_type remaining() const noexcept { return m_bytes_.size() - m_offset_; }
+
+    /// Has the entire buffer been read?
+    bool done() const noexcept { return remaining() == 0; }
+
+private:
+    /// Is T an ArrayView?
+    ///@{
+    template<typename T>
+    struct IsArrayView : std::false_type {};
+    template<typename T>
+    struct IsArrayView<ArrayView<T>> : std::true_type {};
+    ///@}
+
+    /// Is T an std::array?
+    ///@{
+    template<typename T>
+    struct IsStdArray : std::false_type {};
+    template<typename T, std::size_t N>
+    struct IsStdArray<std::array<T, N>> : std::true_type {};
+    ///@}
+
+    /// Returns the next @p n bytes and advances past them
+    const char* take_(size_type n) {
+        if(n > remaining())
+            throw std::out_of_range("BinaryReader: unexpected end of data");
+        const auto* p = m_bytes_.data() + m_offset_;
+        m_offset_ += n;
+        return p;
+    }
+
+    /// Skips the padding, then returns the next @p n elements of @p size
+    const char* take_aligned_(size_type n, size_type size, size_type align) {
+        take_((align - m_offset_ % align) % align);
+        return take_(n * size);
+    }
+
+    /// Reads a size, checking that @p n elements of @p min_size could fit
+    size_type size_(size_type min_size) {
+        const auto n = read<std::uint64_t>();
+        if(n > remaining() / min_size)
+            throw std::out_of_range("BinaryReader: unexpected end of data");
+        return static_cast<size_type>(n);
+    }
+
+    /// Reads the elements of a pair/tuple, in order
+    template<typename T, std::size_t... Is>
+    T read_tuple_(std::index_sequence<Is...>) {
+        // Braced initialization guarantees left-to-right evaluation
+        return T{read<std::tuple_element_t<Is, T>>()...};
+    }
+
+    /// Reads a range into @p rv, which is empty
+    template<typename T>
+    void read_range_(T& rv) {
+        using namespace detail_;
+        using value_type = typename T::value_type;
+        if constexpr(IsContiguousArithmetic<T>::value) {
+            const auto n     = size_(sizeof(value_type));
+            const auto bytes = n * sizeof(value_type);
+            const auto* p    = take_aligned_(n, sizeof(value_type),
+                                             alignof(value_type));
+            if constexpr(IsStdArray<T>::value) {
+                if(n != rv.size())
+                    throw std::runtime_error("BinaryReader: size mismatch");
+            } else {
+                rv.resize(n);
+            }
+            if(bytes) std::memcpy(rv.data(), p, bytes);
+        } else if constexpr(IsStdArray<T>::value) {
+            if(size_(1) != rv.size())
+                throw std::runtime_error("BinaryReader: size mismatch");
+            for(auto& x : rv) x = read<value_type>();
+        } else if constexpr(IsMap<T>::value) {
+            using key_type    = typename T::key_type;
+            using mapped_type = typename T::mapped_type;
+            const auto n      = size_(1);
+            for(size_type i = 0; i < n; ++i) {
+                auto k = read<key_type>();
+                rv.emplace_hint(rv.end(), std::move(k), read<mapped_type>());
+            }
+        } else if constexpr(IsRange<T>::value) {
+            const auto n = size_(1);
+            auto hint    = insert_point_(rv);
+            for(size_type i = 0; i < n; ++i)
+                hint = insert_(rv, hint, read<value_type>());
+        } else {
+            static_assert(always_false_v<T>, "Type can not be read");
+        }
+    }
+
+    /// Where to insert the first element of @p rv
+    template<typename T>
+    static auto insert_point_(T& rv) {
+        if constexpr(HasBeforeBegin<T>::value)
+            return rv.before_begin();
+        else
+            return rv.end();
+    }
+
+    /// Inserts @p x into @p rv after the last element inserted
+    template<typename T, typename Itr, typename U>
+    static Itr insert_(T& rv, Itr hint, U&& x) {
+        if constexpr(HasBeforeBegin<T>::value) {
+            return rv.insert_after(hint, std::forward<U>(x));
+        } else {
+            rv.insert(hint, std::forward<U>(x));
+            return rv.end();
+        }
+    }
+
+    /// Is T an std::priority_queue?
+    ///@{
+    template<typename T, typename = void>
+    struct HasValueCompare : std::false_type {};
+    template<typename T>
+    struct HasValueCompare<T, std::void_t<typename T::value_compare>>
+      : std::true_type {};
+    ///@}
+
+    /// Is T an std::forward_list?
+    ///@{
+    template<typename T, typename = void>
+    struct HasBeforeBegin : std::false_type {};
+    template<typename T>
+    using before_begin_t = decltype(std::declval<T&>().before_begin());
+    template<typename T>
+    struct HasBeforeBegin<T, std::void_t<before_begin_t<T>>> : std::true_type {
+    };
+    ///@}
+
+    /// The buffer being read
+    std::string_view m_bytes_;
+
+    /// How far into m_bytes_ we are
+    size_type m_offset_ = 0;
+};
+
+/** @brief Writes @p value to @p os in the format described in
+ *         binary_stl.hpp.
+ *
+ *  This is a convenience function for writing a single value. Use a
+ *  BinaryWriter to write several values to the same stream.
+ *
+ *  @tparam T The type of the value. Must be one of the types listed in
+ *            binary_stl.hpp, or an STL container (recursively) of them.
+ *
+ *  @param[in] os The stream to write to.
+ *  @param[in] value The value to write.
+ *
+ *  @return @p os, containing @p value.
+ *
+ *  @throw ??? if writing to @p os throws. Basic throw guarantee.
+ */
+template<typename T>
+std::ostream& write_binary(std::ostream& os, const T& value) {
+    BinaryWriter(os).write(value);
+    return os;
+}
+
+/** @brief Reads a single value, written by `write_binary`, from @p bytes.
+ *
+ *  @tparam T The type to read. See BinaryReader::read.
+ *
+ *  @param[in] bytes The data to read. Must outlive any views in the result.
+ *
+ *  @return The value.
+ *
+ *  @throw std::out_of_range if @p bytes ends before the value does. Strong
+ *                           throw guarantee.
+ *  @throw std::runtime_error if the value is not compatible with T. Strong
+ *                            throw guarantee.
+ *  @throw std::bad_alloc if there is insufficient memory for the value.
+ *                        Strong throw guarantee.
+ */
+template<typename T>
+T read_binary(std::string_view bytes) {
+    return BinaryReader(bytes).read<T>();
+}
+
+} // namespace utilities::printing
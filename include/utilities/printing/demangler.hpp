@@ -16,6 +16,7 @@
 
 #pragma once
 #include <string>
+#include <string_view>
 #include <typeindex>
 
 namespace utilities::printing {
@@ -100,8 +101,92 @@ struct Demangler {
      *                       the returned string. Strong throw guarantee.
      */
     static std::string demangle(const char* t);
+
+    /** @brief Returns the demangled name of the type @p T, from a cache.
+     *
+     *  @tparam T The type of the type we want the name of.
+     *
+     *  @return A view of the demangled type. See the type_index overload for
+     *          details.
+     *
+     *  @throw std::bad_alloc if there is insufficient memory to add the name
+     *                        to the cache. Strong throw guarantee.
+     */
+    template<typename T>
+    static std::string_view demangle_cached();
+
+    /** @brief Returns the demangled name of the type @p t, from a cache.
+     *
+     *  Demangling requires the compiler's ABI library to allocate and build
+     *  the name, which is relatively expensive. This overload demangles each
+     *  type once, the first time it is requested, and stores the result in a
+     *  cache shared by the whole program. Subsequent calls only require a
+     *  lookup (under a shared, i.e. reader, lock). The returned view remains
+     *  valid for the life of the program.
+     *
+     *  This function is thread-safe.
+     *
+     * @param[in] t The type index of the type to print the name of.
+     *
+     * @return A view of the demangled type (if we know how to demangle it for
+     *         your compiler) otherwise the mangled type.
+     *
+     * @throw std::bad_alloc if there is insufficient memory to add the name to
+     *                       the cache. Strong throw guarantee.
+     */
+    static std::string_view demangle_cached(const std::type_index& t);
 };
 
+namespace detail_ {
+
+/// Extracts T from the signature of `type_name<T>`
+constexpr std::string_view type_name_from_signature(
+  std::string_view sig) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    // "... __cdecl utilities::printing::type_name<T>(void)"
+    const auto first = sig.find("type_name<") + 10;
+    const auto last  = sig.rfind(">(void)");
+#else
+    // GCC: "... type_name() [with T = T; std::string_view = ...]"
+    // Clang: "... type_name() [T = T]"
+    const auto first = sig.find("T = ") + 4;
+    auto last        = sig.find(';', first);
+    if(last == std::string_view::npos) last = sig.size() - 1;
+#endif
+    return sig.substr(first, last - first);
+}
+
+} // namespace detail_
+
+/** @brief Returns the name of the type @p T at compile time.
+ *
+ *  The name is extracted from the compiler's pretty-printed signature of this
+ *  function (`__PRETTY_FUNCTION__` or `__FUNCSIG__`), so no RTTI, allocation
+ *  or demangling is needed and the result can be used in constant
+ *  expressions. Use this when the type is known statically, and
+ *  `Demangler::demangle_cached` when all that is available is a
+ *  `std::type_index`.
+ *
+ *  @note The spelling is chosen by the compiler and may differ from that of
+ *        `Demangler::demangle` (e.g., in whether default template arguments
+ *        are shown).
+ *
+ *  @tparam T The type of interest.
+ *
+ *  @return A view of the name of @p T. The view points into a string literal
+ *          and is valid for the life of the program.
+ *
+ *  @throw None No throw guarantee.
+ */
+template<typename T>
+constexpr std::string_view type_name() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return detail_::type_name_from_signature(__FUNCSIG__);
+#else
+    return detail_::type_name_from_signature(__PRETTY_FUNCTION__);
+#endif
+}
+
 //-------------------Implementations--------------------------------------------
 
 template<typename T>
@@ -117,4 +202,9 @@ inline std::string Demangler::demangle(const std::type_index& t) {
     return Demangler::demangle(t.name());
 }
 
+template<typename T>
+std::string_view Demangler::demangle_cached() {
+    return Demangler::demangle_cached(std::type_index(typeid(T)));
+}
+
 } // namespace utilities::printing
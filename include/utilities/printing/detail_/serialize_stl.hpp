@@ -0,0 +1,222 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/** @file serialize_stl.hpp
+ *
+ *  Infrastructure shared by the JSON and binary serializers of the STL.
+ */
+
+namespace utilities::printing::detail_ {
+
+/** @brief Collects small writes into a fixed-size buffer.
+ *
+ *  Each call to `std::ostream::write` constructs a sentry and goes through
+ *  the stream buffer's virtual interface. The serializers produce many tiny
+ *  pieces (delimiters, numbers, length prefixes), so they are gathered into a
+ *  buffer on the stack, which is handed to the stream when it fills up (and
+ *  when the caller is done). Writes too large for the buffer bypass it.
+ */
+class BufferedWriter {
+public:
+    /// Number of bytes collected before they are written to the stream
+    static constexpr std::size_t capacity = 4096;
+
+    explicit BufferedWriter(std::ostream& os) noexcept : m_os_(os) {}
+
+    BufferedWriter(const BufferedWriter&)            = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    /// Writes one byte
+    void put(char c) {
+        if(m_size_ == capacity) flush();
+        m_buffer_[m_size_++] = c;
+    }
+
+    /// Writes @p n bytes starting at @p data
+    void write(const char* data, std::size_t n) {
+        if(n == 0) return;
+        if(m_size_ + n > capacity) flush();
+        if(n >= capacity) {
+            m_os_.write(data, static_cast<std::streamsize>(n));
+            return;
+        }
+        std::memcpy(m_buffer_ + m_size_, data, n);
+        m_size_ += n;
+    }
+
+    /// Writes @p str
+    void write(std::string_view str) { write(str.data(), str.size()); }
+
+    /** @brief Makes room for @p n contiguous bytes.
+     *
+     *  @param[in] n How many bytes the caller wants to write. Must be no more
+     *               than `capacity`.
+     *
+     *  @return Where to write the bytes. The caller must `commit` the number
+     *          it actually wrote.
+     */
+    char* reserve(std::size_t n) {
+        assert(n <= capacity && "Can not reserve more than the capacity");
+        if(m_size_ + n > capacity) flush();
+        return m_buffer_ + m_size_;
+    }
+
+    /// Marks the first @p n bytes returned by `reserve` as written
+    void commit(std::size_t n) noexcept {
+        assert(m_size_ + n <= capacity && "Committed more than was reserved");
+        m_size_ += n;
+    }
+
+    /// Hands the buffered bytes to the stream
+    void flush() {
+        if(m_size_ == 0) return;
+        m_os_.write(m_buffer_, static_cast<std::streamsize>(m_size_));
+        m_size_ = 0;
+    }
+
+private:
+    /// Where the bytes end up
+    std::ostream& m_os_;
+
+    /// Number of bytes in m_buffer_
+    std::size_t m_size_ = 0;
+
+    /// Bytes which have not been handed to m_os_ yet
+    char m_buffer_[capacity];
+};
+
+/// Do objects of type T hold text?
+///@{
+template<typename T>
+struct IsStringLike : std::false_type {};
+template<typename... Ts>
+struct IsStringLike<std::basic_string<char, Ts...>> : std::true_type {};
+template<typename... Ts>
+struct IsStringLike<std::basic_string_view<char, Ts...>> : std::true_type {};
+template<>
+struct IsStringLike<const char*> : std::true_type {};
+template<>
+struct IsStringLike<char*> : std::true_type {};
+template<std::size_t N>
+struct IsStringLike<char[N]> : std::true_type {};
+///@}
+
+/// Is T an std::optional?
+///@{
+template<typename T>
+struct IsOptional : std::false_type {};
+template<typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+///@}
+
+/// Is T an std::pair or an std::tuple?
+///@{
+template<typename T>
+struct IsTupleLike : std::false_type {};
+template<typename T, typename U>
+struct IsTupleLike<std::pair<T, U>> : std::true_type {};
+template<typename... Ts>
+struct IsTupleLike<std::tuple<Ts...>> : std::true_type {};
+///@}
+
+/// Can T be iterated over with std::begin/std::end?
+///@{
+template<typename T, typename = void>
+struct IsRange : std::false_type {};
+template<typename T>
+struct IsRange<T, std::void_t<decltype(std::begin(std::declval<const T&>())),
+                              decltype(std::end(std::declval<const T&>()))>>
+  : std::true_type {};
+///@}
+
+/// Does T map keys to values (i.e., does it define mapped_type)?
+///@{
+template<typename T, typename = void>
+struct IsMap : std::false_type {};
+template<typename T>
+struct IsMap<T, std::void_t<typename T::mapped_type>> : IsRange<T> {};
+///@}
+
+/// Does the map T hold at most one value per key (does insert return a pair)?
+///@{
+template<typename T, typename = void>
+struct HasUniqueKeys : std::false_type {};
+template<typename T>
+using insert_result_t =
+  decltype(std::declval<T&>().insert(std::declval<typename T::value_type>()));
+template<typename T>
+struct HasUniqueKeys<T, std::void_t<decltype(insert_result_t<T>::second)>>
+  : std::true_type {};
+///@}
+
+/// Is T a container adaptor (std::queue, std::stack, std::priority_queue)?
+///@{
+template<typename T, typename = void>
+struct IsAdaptor : std::false_type {};
+template<typename T>
+struct IsAdaptor<T, std::void_t<typename T::container_type>>
+  : std::negation<IsRange<T>> {};
+///@}
+
+/// Does T store arithmetic values contiguously (and not as bits)?
+///@{
+template<typename T, typename = void>
+struct IsContiguousArithmetic : std::false_type {};
+template<typename T>
+struct IsContiguousArithmetic<
+  T, std::void_t<decltype(std::declval<const T&>().data()),
+                 decltype(std::declval<const T&>().size())>>
+  : std::bool_constant<
+      std::is_arithmetic_v<typename T::value_type> &&
+      !std::is_same_v<typename T::value_type, bool> &&
+      std::is_same_v<decltype(std::declval<const T&>().data()),
+                     const typename T::value_type*>> {};
+///@}
+
+/// Can T be resized (and hence filled with a single memcpy)?
+///@{
+template<typename T, typename = void>
+struct IsResizable : std::false_type {};
+template<typename T>
+struct IsResizable<T, std::void_t<decltype(std::declval<T&>().resize(0))>>
+  : std::true_type {};
+///@}
+
+/// Used to reject types in an `if constexpr` chain
+template<typename T>
+inline constexpr bool always_false_v = false;
+
+/// Calls @p fxn with each element of the pair/tuple @p t
+template<typename T, typename Fxn>
+void for_each_element(const T& t, Fxn&& fxn) {
+    std::apply([&fxn](const auto&... xs) { (fxn(xs), ...); }, t);
+}
+
+} // namespace utilities::printing::detail_
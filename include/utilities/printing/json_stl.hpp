@@ -0,0 +1,202 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "utilities/printing/detail_/serialize_stl.hpp"
+#include "utilities/printing/print_stl.hpp"
+#include <charconv>
+#include <cmath>
+
+/** @file json_stl.hpp
+ *
+ *  Writes the STL containers supported by print_stl.hpp as compact JSON. The
+ *  mapping is:
+ *
+ *  - `bool` becomes `true`/`false`, `char` becomes a one character string,
+ *    and the remaining arithmetic types become numbers. Floating-point values
+ *    are written in the shortest form which round-trips; since JSON can't
+ *    represent infinities or NaN, those become `null`.
+ *  - Strings are quoted and escaped. Bytes outside of ASCII are copied as is,
+ *    i.e., strings are assumed to hold UTF-8.
+ *  - `std::optional` is `null` when empty and its value otherwise.
+ *  - `std::pair`, `std::tuple`, and the sequence containers (including sets
+ *    and the container adaptors) become arrays. Adaptors are written in the
+ *    order of their underlying containers.
+ *  - `std::map` and `std::unordered_map` with string keys become objects.
+ *    Other maps (including multimaps) become arrays of `[key, value]` arrays.
+ */
+
+namespace utilities::printing {
+namespace detail_ {
+
+/// Writes values as JSON to a stream
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& os) noexcept : m_out_(os) {}
+
+    /// Writes @p x and hands what's left in the buffer to the stream
+    template<typename T>
+    void operator()(const T& x) {
+        write_(x);
+        m_out_.flush();
+    }
+
+private:
+    /// Dispatches on the type of @p x
+    template<typename T>
+    void write_(const T& x) {
+        if constexpr(std::is_same_v<T, bool>) {
+            m_out_.write(x ? "true" : "false");
+        } else if constexpr(std::is_same_v<T, char>) {
+            string_(std::string_view(&x, 1));
+        } else if constexpr(std::is_arithmetic_v<T>) {
+            number_(x);
+        } else if constexpr(IsStringLike<T>::value) {
+            string_(x);
+        } else if constexpr(IsOptional<T>::value) {
+            if(x.has_value())
+                write_(*x);
+            else
+                m_out_.write("null");
+        } else if constexpr(IsTupleLike<T>::value) {
+            bool first = true;
+            m_out_.put('[');
+            for_each_element(x, [this, &first](const auto& xi) {
+                if(!first) m_out_.put(',');
+                first = false;
+                write_(xi);
+            });
+            m_out_.put(']');
+        } else if constexpr(IsAdaptor<T>::value) {
+            write_(underlying_container(x));
+        } else if constexpr(IsMap<T>::value) {
+            map_(x);
+        } else if constexpr(IsRange<T>::value) {
+            array_(x);
+        } else {
+            static_assert(always_false_v<T>, "Type can not be written as JSON");
+        }
+    }
+
+    /// Writes an arithmetic value (other than bool and char)
+    template<typename T>
+    void number_(T x) {
+        if constexpr(std::is_floating_point_v<T>) {
+            if(!std::isfinite(x)) {
+                m_out_.write("null");
+                return;
+            }
+        }
+        constexpr std::size_t max_chars = 64;
+        char* first                     = m_out_.reserve(max_chars);
+        const auto rv = std::to_chars(first, first + max_chars, x);
+        m_out_.commit(rv.ptr - first);
+    }
+
+    /// Writes @p str quoted, escaping what JSON requires to be escaped
+    void string_(std::string_view str) {
+        static constexpr char hex[] = "0123456789abcdef";
+        m_out_.put('"');
+        std::size_t start = 0;
+        for(std::size_t i = 0; i < str.size(); ++i) {
+            const auto c = static_cast<unsigned char>(str[i]);
+            if(c >= 0x20 && c != '"' && c != '\\') continue;
+            m_out_.write(str.data() + start, i - start);
+            start = i + 1;
+            m_out_.put('\\');
+            switch(c) {
+                case '"': m_out_.put('"'); break;
+                case '\\': m_out_.put('\\'); break;
+                case '\b': m_out_.put('b'); break;
+                case '\f': m_out_.put('f'); break;
+                case '\n': m_out_.put('n'); break;
+                case '\r': m_out_.put('r'); break;
+                case '\t': m_out_.put('t'); break;
+                default:
+                    m_out_.write("u00");
+                    m_out_.put(hex[c >> 4]);
+                    m_out_.put(hex[c & 0xF]);
+            }
+        }
+        m_out_.write(str.data() + start, str.size() - start);
+        m_out_.put('"');
+    }
+
+    /// Writes the elements of @p x as an array
+    template<typename T>
+    void array_(const T& x) {
+        bool first = true;
+        m_out_.put('[');
+        for(const auto& xi : x) {
+            if(!first) m_out_.put(',');
+            first = false;
+            write_(xi);
+        }
+        m_out_.put(']');
+    }
+
+    /// Writes @p x as an object if we can, otherwise as an array of pairs
+    template<typename T>
+    void map_(const T& x) {
+        using key_type = typename T::key_type;
+        constexpr bool is_object =
+          HasUniqueKeys<T>::value && IsStringLike<key_type>::value;
+        if constexpr(is_object) {
+            bool first = true;
+            m_out_.put('{');
+            for(const auto& [k, v] : x) {
+                if(!first) m_out_.put(',');
+                first = false;
+                string_(k);
+                m_out_.put(':');
+                write_(v);
+            }
+            m_out_.put('}');
+        } else {
+            array_(x);
+        }
+    }
+
+    /// Collects the output
+    BufferedWriter m_out_;
+};
+
+} // namespace detail_
+
+/** @brief Writes @p value to @p os as compact JSON.
+ *
+ *  See the documentation of json_stl.hpp for how each type is represented.
+ *  Nothing is converted to an intermediate string; the JSON is written to
+ *  @p os as @p value is traversed, through a fixed-size buffer.
+ *
+ *  @tparam T The type of the value to write. Must be one of the types listed
+ *            in json_stl.hpp, or an STL container (recursively) of them.
+ *
+ *  @param[in] os The stream to write to.
+ *  @param[in] value The value to write.
+ *
+ *  @return @p os, containing the JSON.
+ *
+ *  @throw ??? if writing to @p os throws. Basic throw guarantee.
+ */
+template<typename T>
+std::ostream& write_json(std::ostream& os, const T& value) {
+    detail_::JsonWriter writer(os);
+    writer(value);
+    return os;
+}
+
+} // namespace utilities::printing
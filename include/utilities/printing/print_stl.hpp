@@ -18,6 +18,7 @@
 #include <array>
 #include <deque>
 #include <forward_list>
+#include <ios>
 #include <list>
 #include <map>
 #include <optional>
@@ -39,6 +40,22 @@
  *  to include the header files for the classes you use.
  *
  *  When appropriate, containers are printed like their Python analogs.
+ *
+ *  How much of a container is printed can be limited with the stream
+ *  manipulators `max_elements`, `max_depth`, and `element_precision`, e.g.:
+ *
+ *  @code
+ *  std::vector<double> v(100000000);
+ *  std::cout << max_elements(6) << v; // Prints [0, 0, 0, ..., 0, 0, 0]
+ *  @endcode
+ *
+ *  The outermost container is rendered into a thread-local buffer, which is
+ *  written to the stream with a single call once the container is done.
+ *  Arithmetic elements are formatted with `std::to_chars` (honoring the
+ *  stream's precision and floatfield), so the output is the same as printing
+ *  each element with operator<<, just faster. If printing an element throws,
+ *  the output stops there: what precedes the element has been written, but
+ *  the rest of the container (including the closing brackets) is dropped.
  */
 namespace utilities::printing {
 
@@ -50,26 +67,50 @@ std::ostream& print_element(std::ostream& os, T&& value);
 /** @brief Implements printing of queue-like containers
  *
  *  Queue like containers only allow you to view the elements that are in the
- *  front of the queue or on top of the stack. Hence this function iterates
- *  over the container by getting the first element from a functor (used to
- *  abstract away the fact that different containers have different accessors
- *  for this element), popping that element off, and repeating until the
- *  container is empty. It's consequentially a good idea to use a copy of the
- *  original container.
- *
- * @tparam T The type of the queue-like container we are printing.
- * @tparam Fxn The functor which returns the first element in the queue given
- *             the queue.
+ *  front of the queue or on top of the stack. Rather than copying the
+ *  container and popping elements off of the copy, the overloads of
+ *  operator<< for std::queue and std::stack get at the underlying container
+ *  and pass this function iterators to it, in the order the elements would
+ *  be popped off.
+ *
+ * @tparam Itr The type of the iterators to the elements.
+ *
  * @param[in] os The stream to print to.
- * @param[in] f The functor to use for retrieving elements
- * @param[in] rhs The container to print. The contents of which will be
- *                destroyed.
- * @return @p os containing @p rhs.
+ * @param[in] first An iterator to the element which would be popped first.
+ * @param[in] last An iterator just past the element which would be popped
+ *                 last.
+ * @return @p os containing the elements.
+ *
+ * @throw ??? if std::ostream<< throws. Same guarantee.
+ */
+template<typename Itr>
+std::ostream& print_queue(std::ostream& os, Itr first, Itr last);
+
+/** @brief Implements printing of priority queues.
  *
+ *  The underlying container of a priority queue is a heap, so the elements
+ *  are not stored in the order they would be popped off. This function sorts
+ *  pointers to the elements (the elements themselves are not copied) and
+ *  prints the elements in order of decreasing priority. If only the first
+ *  and last few elements are going to be printed (see `max_elements`) only
+ *  those k elements are selected, which takes O(n log k) time and O(k)
+ *  memory, rather than O(n log n) time and O(n) memory.
+ *
+ * @tparam T The type of the container underlying the priority queue.
+ * @tparam Compare The type of the functor used to compare priorities.
+ *
+ * @param[in] os The stream to print to.
+ * @param[in] c The container underlying the priority queue.
+ * @param[in] comp The functor used to compare priorities.
+ * @return @p os containing the elements of @p c.
+ *
+ * @throw std::bad_alloc if there is insufficient memory to sort the pointers.
+ *                       Weak throw guarantee.
  * @throw ??? if std::ostream<< throws. Same guarantee.
  */
-template<typename T, typename Fxn>
-std::ostream& print_queue(std::ostream& os, Fxn&& f, T&& rhs);
+template<typename T, typename Compare>
+std::ostream& print_priority_queue(std::ostream& os, const T& c,
+                                   const Compare& comp);
 
 /** @brief Prints a list-like container.
  *
@@ -116,13 +157,11 @@ std::ostream& print_associative(std::ostream& os, T&& rhs, char odelim = '{',
 
 /** @brief Function for printing tuple/pairs
  *
- *  Tuples don't support iteration, consequentially this function works by
- *  recursion. At a recursive depth of @p depth this function adds the @p depth
- *  -th element to stream and then forwards the stream and arguments to the
- *  next recursive call. Recursion stops when we've looped over the entire
- *  tuple.
+ *  Tuples don't support iteration, consequentially this function expands
+ *  over the indices of the elements. Elements before @p depth are skipped,
+ *  and the opening delimiter is only printed when @p depth is 0.
  *
- * @tparam depth How deep in the recursion stack are we?
+ * @tparam depth The index of the first element to print.
  * @tparam T The type of the tuple.
  *
  * @param[in] os The stream to print @p rhs to.
@@ -141,8 +180,93 @@ template<std::size_t depth, typename T>
 std::ostream& print_tuple(std::ostream& os, T&& rhs, char odelim = '(',
                           char cdelim = ')');
 
+/// Sets the value of one of the printing options of a stream
+struct SetPrintOption {
+    /// Where the option lives in the stream's extensible storage
+    int index;
+
+    /// The new value of the option
+    long value;
+
+    /// Stores @p opt in @p os. It's a hidden friend so that, inside detail_,
+    /// it does not shadow the operator<< overloads for the STL containers.
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const SetPrintOption& opt) {
+        os.iword(opt.index) = opt.value;
+        return os;
+    }
+};
+
+/// The indices of the printing options in a stream's extensible storage
+struct PrintOptionIndices {
+    int max_elements = std::ios_base::xalloc();
+    int max_depth    = std::ios_base::xalloc();
+    int precision    = std::ios_base::xalloc();
+    int depth        = std::ios_base::xalloc();
+};
+
+/// The indices used by all streams, allocated the first time they are needed
+inline const PrintOptionIndices& print_option_indices() {
+    static const PrintOptionIndices indices;
+    return indices;
+}
+
 } // namespace detail_
 
+/** @brief Limits the number of elements printed per container.
+ *
+ *  After `os << max_elements(n)`, containers printed to `os` with more than
+ *  @p n elements only have their first `ceil(n / 2)` and last `floor(n / 2)`
+ *  elements printed; the elements in between are replaced by `...`. Like
+ *  `std::setprecision`, the setting sticks to the stream until it is changed.
+ *
+ *  @param[in] n The maximum number of elements to print. Zero, the default,
+ *               means all elements are printed.
+ *
+ *  @return A manipulator to insert into the stream.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline detail_::SetPrintOption max_elements(std::size_t n) noexcept {
+    return {detail_::print_option_indices().max_elements, static_cast<long>(n)};
+}
+
+/** @brief Limits how deeply nested containers are printed.
+ *
+ *  After `os << max_depth(n)`, containers nested more than @p n levels deep
+ *  are printed as their delimiters around `...`, e.g., `max_depth(1)` prints
+ *  a vector of vectors as `[[...], [...]]`. The setting sticks to the stream
+ *  until it is changed.
+ *
+ *  @param[in] n The maximum number of levels to print. Zero, the default,
+ *               means there is no limit.
+ *
+ *  @return A manipulator to insert into the stream.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline detail_::SetPrintOption max_depth(std::size_t n) noexcept {
+    return {detail_::print_option_indices().max_depth, static_cast<long>(n)};
+}
+
+/** @brief Sets the precision used for the elements of containers.
+ *
+ *  This is similar to `std::setprecision`, except that the precision is only
+ *  changed while a container is being printed. The precision of the stream
+ *  itself is restored afterwards. The setting sticks to the stream until it
+ *  is changed.
+ *
+ *  @param[in] p The precision to use for elements. A negative value, the
+ *               default, means the stream's precision is used.
+ *
+ *  @return A manipulator to insert into the stream.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline detail_::SetPrintOption element_precision(int p) noexcept {
+    return {detail_::print_option_indices().precision, p < 0 ? 0l : p + 1l};
+}
+
 // Stuff below hwere is just boiler-plate for calling the above functions for
 // ever class in the STL
 
@@ -314,7 +438,7 @@ std::ostream& operator<<(std::ostream& os, const std::pair<T1, T2>& p);
  */
 template<typename T, typename Container, typename Compare>
 std::ostream& operator<<(std::ostream& os,
-                         std::priority_queue<T, Container, Compare> q);
+                         const std::priority_queue<T, Container, Compare>& q);
 
 /** @brief Makes std::queue printable.
  *
@@ -329,7 +453,7 @@ std::ostream& operator<<(std::ostream& os,
  *  @throw ??? if the ostream's operator<< throws. Same exception guarantee.
  */
 template<typename T, typename Container>
-std::ostream& operator<<(std::ostream& os, std::queue<T, Container> q);
+std::ostream& operator<<(std::ostream& os, const std::queue<T, Container>& q);
 
 template<typename T>
 std::ostream& operator<<(std::ostream& os, const std::reference_wrapper<T>& r);
@@ -364,7 +488,7 @@ std::ostream& operator<<(std::ostream& os,
  *  @throw ??? if the ostream's operator<< throws. Same exception guarantee.
  */
 template<typename T, typename Container>
-std::ostream& operator<<(std::ostream& os, std::stack<T, Container> s);
+std::ostream& operator<<(std::ostream& os, const std::stack<T, Container>& s);
 
 /** @brief Makes std::tuple printable.
  *
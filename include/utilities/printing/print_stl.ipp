@@ -18,6 +18,13 @@
 #include "utilities/printing/print_stl.hpp"
 
 #include "utilities/type_traits/is_printable.hpp"
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <iterator>
+#include <locale>
+#include <string>
+#include <string_view>
 
 /** @file print_stl.ipp
  *
@@ -40,62 +47,480 @@ std::ostream& print_element(std::ostream& os, T&& value) {
     }
 }
 
-template<typename T, typename Fxn>
-std::ostream& print_queue(std::ostream& os, Fxn&& f, T&& rhs) {
-    os << '[';
-    bool printed = false;
-    while(!rhs.empty()) {
-        if(printed) os << ", ";
-        print_element(os, f(rhs));
-        rhs.pop();
-        printed = true;
+/** Tracks the nesting depth of the containers being printed to a stream and
+ *  applies the element precision while the outermost one is printed.
+ */
+class ContainerGuard {
+public:
+    explicit ContainerGuard(std::ostream& os) : m_os_(os) {
+        const auto& idx = print_option_indices();
+        m_depth_        = m_os_.iword(idx.depth)++;
+        const auto p    = m_os_.iword(idx.precision);
+        if(m_depth_ == 0 && p > 0) m_old_precision_ = m_os_.precision(p - 1);
+    }
+
+    ~ContainerGuard() noexcept {
+        --m_os_.iword(print_option_indices().depth);
+        if(m_old_precision_ >= 0) m_os_.precision(m_old_precision_);
+    }
+
+    /// Is the container nested too deeply to print its elements?
+    bool too_deep() const {
+        const auto max = m_os_.iword(print_option_indices().max_depth);
+        return max > 0 && m_depth_ >= max;
     }
-    return os << ']';
+
+    /// The maximum number of elements to print, 0 means all of them
+    std::size_t max_elements() const {
+        const auto max = m_os_.iword(print_option_indices().max_elements);
+        return max > 0 ? max : 0;
+    }
+
+private:
+    std::ostream& m_os_;
+    long m_depth_;
+    std::streamsize m_old_precision_ = -1;
+};
+
+/// Is T one of the STL types whose operator<< renders through a Printer?
+///@{
+template<typename T>
+struct UsesPrinter : std::false_type {};
+template<typename T, std::size_t N>
+struct UsesPrinter<std::array<T, N>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::deque<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::forward_list<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::map<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::multimap<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::multiset<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::optional<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::pair<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::priority_queue<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::queue<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::set<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::stack<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::tuple<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::unordered_map<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::unordered_multimap<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::unordered_multiset<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::unordered_set<Ts...>> : std::true_type {};
+template<typename... Ts>
+struct UsesPrinter<std::vector<Ts...>> : std::true_type {};
+///@}
+
+/// Integral types which std::ostream prints as numbers (not characters)
+template<typename T>
+inline constexpr bool is_number_v =
+  std::is_integral_v<T> && !std::is_same_v<T, bool> &&
+  !std::is_same_v<T, char> && !std::is_same_v<T, signed char> &&
+  !std::is_same_v<T, unsigned char> && !std::is_same_v<T, wchar_t> &&
+  !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+/// The characters being rendered on this thread, and the stream they go to
+struct PrintBuffer {
+    std::string chars;
+    std::ostream* owner = nullptr;
+    bool buffered       = false;
+};
+
+/// Each thread reuses one buffer, so rendering does not allocate after warm-up
+inline PrintBuffer& print_buffer() {
+    thread_local PrintBuffer buffer;
+    return buffer;
+}
+
+/** @brief Renders containers into a thread-local buffer.
+ *
+ *  Going through `std::ostream::operator<<` for every element (and every
+ *  delimiter) means constructing a sentry and consulting the locale each
+ *  time. Instead, the outermost container being printed to a stream claims
+ *  the calling thread's PrintBuffer. Delimiters are appended to it,
+ *  arithmetic values are rendered into it with `std::to_chars`, and nested
+ *  containers (whose operator<< makes a Printer of their own) append to the
+ *  same buffer. When the outermost container is done, the buffer is handed
+ *  to the stream with a single `write`.
+ *
+ *  `std::to_chars` is used with the stream's precision and floatfield, so the
+ *  output is identical to that of `operator<<`. Elements which are not
+ *  handled natively (e.g., user-defined types) are printed with operator<<,
+ *  after writing out the buffer to keep everything in order; containers they
+ *  print are written straight to the stream. If the stream's
+ *  state can not be reproduced with `std::to_chars` (a field width is set, a
+ *  non-classic locale is imbued, etc.) the Printer writes straight to the
+ *  stream, exactly like operator<< would.
+ *
+ *  Since the buffer is written out before calling code we don't control, an
+ *  exception thrown while printing an element leaves everything before the
+ *  element in the stream; whatever was buffered afterwards is discarded
+ *  when the outermost Printer is destroyed.
+ */
+class Printer {
+public:
+    /// The buffer is written out early if it grows past this many bytes
+    static constexpr std::size_t max_buffer_size = 1ul << 20;
+
+    explicit Printer(std::ostream& os) : m_os_(os), m_state_(print_buffer()) {
+        if(m_state_.owner == &os) { // Nested in a container printed to os
+            m_buffered_ = m_state_.buffered;
+        } else if(m_state_.owner == nullptr) { // Outermost container
+            m_owner_ = true;
+            m_buffered_ =
+              os.width() == 0 && os.getloc() == std::locale::classic();
+            m_state_.owner    = &os;
+            m_state_.buffered = m_buffered_;
+        }
+        // Else another stream owns the buffer (we are being printed from
+        // inside some operator<<), so we write straight to os
+    }
+
+    ~Printer() noexcept {
+        if(!m_owner_) return;
+        m_state_.chars.clear();
+        m_state_.owner = nullptr;
+    }
+
+    Printer(const Printer&)            = delete;
+    Printer& operator=(const Printer&) = delete;
+
+    /// Prints a delimiter
+    ///@{
+    void put(char c) {
+        if(m_buffered_)
+            m_state_.chars.push_back(c);
+        else
+            m_os_ << c;
+    }
+    void put(std::string_view str) {
+        if(m_buffered_)
+            m_state_.chars.append(str);
+        else
+            m_os_ << str;
+    }
+    ///@}
+
+    /// Prints an element of a container
+    template<typename T>
+    void element(const T& x) {
+        if(!m_buffered_) {
+            print_element(m_os_, x);
+            return;
+        }
+        if(append_(x)) {
+            if(m_state_.chars.size() > max_buffer_size) flush_();
+            return;
+        }
+
+        // Code we don't control writes straight to the stream, so containers
+        // it prints must do so too
+        flush_();
+        m_state_.buffered = false;
+        try {
+            print_element(m_os_, x);
+        } catch(...) {
+            m_state_.buffered = true;
+            throw;
+        }
+        m_state_.buffered = true;
+    }
+
+    /// Writes out the buffer (if *this is the outermost Printer)
+    std::ostream& finish() {
+        if(m_owner_ && m_buffered_) flush_();
+        return m_os_;
+    }
+
+private:
+    /// Tries to append @p x to the buffer, returns false if it can't be
+    template<typename T>
+    bool append_(const T& x) {
+        if constexpr(UsesPrinter<T>::value) {
+            m_os_ << x; // Renders into the same buffer
+            return true;
+        } else if constexpr(is_number_v<T>) {
+            const auto flags = m_os_.flags();
+            const auto base  = flags & std::ios_base::basefield;
+            if(base != std::ios_base::dec && base != 0) return false;
+            if(flags & std::ios_base::showpos) return false;
+            char buffer[64];
+            return append_chars_(std::to_chars(buffer, buffer + 64, x), buffer);
+        } else if constexpr(std::is_floating_point_v<T>) {
+            return append_float_(x);
+        } else if constexpr(std::is_same_v<T, std::string> ||
+                            std::is_same_v<T, std::string_view>) {
+            m_state_.chars.append(x);
+            return true;
+        } else if constexpr(std::is_same_v<T, const char*> ||
+                            std::is_same_v<T, char*>) {
+            if(x == nullptr) return false;
+            m_state_.chars.append(x);
+            return true;
+        } else if constexpr(std::is_same_v<T, char>) {
+            m_state_.chars.push_back(x);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    /// Renders @p x like operator<< would, given the stream's flags
+    template<typename T>
+    bool append_float_(T x) {
+        const auto flags = m_os_.flags();
+        const auto bad   = std::ios_base::showpos | std::ios_base::showpoint |
+                         std::ios_base::uppercase;
+        if(flags & bad) return false;
+
+        const auto precision = m_os_.precision();
+        if(precision < 0) return false;
+
+        const auto floatfield = flags & std::ios_base::floatfield;
+        std::chars_format format;
+        if(floatfield == std::ios_base::fixed)
+            format = std::chars_format::fixed;
+        else if(floatfield == std::ios_base::scientific)
+            format = std::chars_format::scientific;
+        else if(floatfield == std::ios_base::fmtflags{})
+            format = std::chars_format::general;
+        else // hexfloat
+            return false;
+        char buffer[512];
+        const auto rv = std::to_chars(buffer, buffer + sizeof(buffer), x,
+                                      format, static_cast<int>(precision));
+        return append_chars_(rv, buffer);
+    }
+
+    /// Appends [buffer, rv.ptr) if the conversion succeeded
+    bool append_chars_(std::to_chars_result rv, const char* buffer) {
+        if(rv.ec != std::errc{}) return false;
+        m_state_.chars.append(buffer, rv.ptr - buffer);
+        return true;
+    }
+
+    /// Writes the buffer to the stream
+    void flush_() {
+        m_os_.write(m_state_.chars.data(), m_state_.chars.size());
+        m_state_.chars.clear();
+    }
+
+    /// The stream we are printing to
+    std::ostream& m_os_;
+
+    /// This thread's buffer
+    PrintBuffer& m_state_;
+
+    /// Are we rendering into m_state_.chars (vs. writing to m_os_)?
+    bool m_buffered_ = false;
+
+    /// Are we the outermost Printer for m_os_?
+    bool m_owner_ = false;
+};
+
+/** Calls @p print_one on each element in [first, last), separating them with
+ *  commas. If there are more than @p max_n elements (and @p max_n is not 0)
+ *  only the first and last few are printed.
+ */
+template<typename Itr, typename Fxn>
+void print_elements(Printer& p, Itr first, Itr last, std::size_t max_n,
+                    Fxn&& print_one) {
+    std::size_t n = 0;
+    if(max_n > 0) n = std::distance(first, last);
+    if(max_n == 0 || n <= max_n) {
+        for(bool printed = false; first != last; ++first, printed = true) {
+            if(printed) p.put(", ");
+            print_one(*first);
+        }
+        return;
+    }
+
+    const auto nhead = (max_n + 1) / 2;
+    const auto ntail = max_n / 2;
+    for(std::size_t i = 0; i < nhead; ++i, ++first) {
+        if(i) p.put(", ");
+        print_one(*first);
+    }
+    p.put(", ...");
+    std::advance(first, n - nhead - ntail);
+    for(; first != last; ++first) {
+        p.put(", ");
+        print_one(*first);
+    }
+}
+
+/// Returns the container inside the container adaptor @p a, without copying
+template<typename Adaptor>
+const typename Adaptor::container_type& underlying_container(const Adaptor& a) {
+    struct Access : Adaptor {
+        static const auto& get(const Adaptor& a) { return a.*(&Access::c); }
+    };
+    return Access::get(a);
+}
+
+/// Returns the comparison functor of the priority queue @p q
+template<typename PriorityQueue>
+const typename PriorityQueue::value_compare& underlying_compare(
+  const PriorityQueue& q) {
+    struct Access : PriorityQueue {
+        static const auto& get(const PriorityQueue& q) {
+            return q.*(&Access::comp);
+        }
+    };
+    return Access::get(q);
+}
+
+/** Returns pointers to the @p k elements of @p c which come first according
+ *  to @p order, sorted by @p order. Uses a heap of size @p k.
+ */
+template<typename T, typename Order>
+std::vector<const typename T::value_type*> first_k(const T& c, std::size_t k,
+                                                   Order order) {
+    std::vector<const typename T::value_type*> rv;
+    if(k == 0) return rv;
+    rv.reserve(k);
+    for(const auto& x : c) {
+        if(rv.size() < k) {
+            rv.push_back(&x);
+            std::push_heap(rv.begin(), rv.end(), order);
+        } else if(order(&x, rv.front())) {
+            std::pop_heap(rv.begin(), rv.end(), order);
+            rv.back() = &x;
+            std::push_heap(rv.begin(), rv.end(), order);
+        }
+    }
+    std::sort_heap(rv.begin(), rv.end(), order);
+    return rv;
+}
+
+template<typename Itr>
+std::ostream& print_queue(std::ostream& os, Itr first, Itr last) {
+    Printer p(os);
+    ContainerGuard guard(os);
+    p.put('[');
+    if(guard.too_deep()) {
+        if(first != last) p.put("...");
+    } else {
+        print_elements(p, first, last, guard.max_elements(),
+                       [&p](const auto& x) { p.element(x); });
+    }
+    p.put(']');
+    return p.finish();
+}
+
+template<typename T, typename Compare>
+std::ostream& print_priority_queue(std::ostream& os, const T& c,
+                                   const Compare& comp) {
+    Printer p(os);
+    ContainerGuard guard(os);
+    p.put('[');
+    if(guard.too_deep()) {
+        if(!c.empty()) p.put("...");
+        p.put(']');
+        return p.finish();
+    }
+
+    // Highest priority first, ties are broken by address to make this a total
+    // order (needed so the head and tail below never overlap)
+    using pointer = const typename T::value_type*;
+    auto before   = [&comp](pointer a, pointer b) {
+        if(comp(*b, *a)) return true;
+        if(comp(*a, *b)) return false;
+        return std::less<pointer>{}(a, b);
+    };
+    auto after     = [&before](pointer a, pointer b) { return before(b, a); };
+    auto print_one = [&p](pointer x) { p.element(*x); };
+
+    const auto n     = c.size();
+    const auto max_n = guard.max_elements();
+    if(max_n == 0 || n <= max_n) {
+        const auto ptrs = first_k(c, n, before);
+        print_elements(p, ptrs.begin(), ptrs.end(), 0, print_one);
+    } else {
+        const auto head = first_k(c, (max_n + 1) / 2, before);
+        const auto tail = first_k(c, max_n / 2, after);
+        print_elements(p, head.begin(), head.end(), 0, print_one);
+        p.put(", ...");
+        for(auto itr = tail.rbegin(); itr != tail.rend(); ++itr) {
+            p.put(", ");
+            print_one(*itr);
+        }
+    }
+    p.put(']');
+    return p.finish();
 }
 
 template<typename T>
 std::ostream& print_list(std::ostream& os, T&& rhs, char odelim, char cdelim) {
-    os << odelim;
-    bool printed = false;
-    for(const auto& x : rhs) {
-        if(printed) os << ", ";
-        print_element(os, x);
-        printed = true;
+    Printer p(os);
+    ContainerGuard guard(os);
+    p.put(odelim);
+    const auto first = std::begin(rhs);
+    const auto last  = std::end(rhs);
+    if(guard.too_deep()) {
+        if(first != last) p.put("...");
+    } else {
+        print_elements(p, first, last, guard.max_elements(),
+                       [&p](const auto& x) { p.element(x); });
     }
-    return os << cdelim;
+    p.put(cdelim);
+    return p.finish();
 }
 
 template<typename T>
 std::ostream& print_associative(std::ostream& os, T&& rhs, char odelim,
                                 char cdelim) {
-    os << odelim;
-    bool printed = false;
-    for(const auto& x : rhs) {
-        if(printed) os << ", ";
-        os << "(";
-        print_element(os, x.first) << " : ";
-        print_element(os, x.second) << ")";
-        printed = true;
+    Printer p(os);
+    ContainerGuard guard(os);
+    p.put(odelim);
+    const auto first = std::begin(rhs);
+    const auto last  = std::end(rhs);
+    if(guard.too_deep()) {
+        if(first != last) p.put("...");
+    } else {
+        print_elements(p, first, last, guard.max_elements(),
+                       [&p](const auto& x) {
+                           p.put('(');
+                           p.element(x.first);
+                           p.put(" : ");
+                           p.element(x.second);
+                           p.put(')');
+                       });
     }
-    return os << cdelim;
+    p.put(cdelim);
+    return p.finish();
+}
+
+/// Prints the elements of @p rhs with index @p depth and higher
+template<std::size_t depth, typename T, std::size_t... Is>
+void print_tuple_elements(Printer& p, const T& rhs,
+                          std::index_sequence<Is...>) {
+    ((Is >= depth ? (Is > depth ? p.put(", ") : void()),
+      p.element(std::get<Is>(rhs)) : void()),
+     ...);
 }
 
 template<std::size_t depth, typename T>
 std::ostream& print_tuple(std::ostream& os, T&& rhs, char odelim, char cdelim) {
-    constexpr auto max_depth = std::tuple_size_v<std::decay_t<T>>;
-    if constexpr(depth == max_depth && depth == 0) {
-        return os << odelim << cdelim;
-    } else if constexpr(depth == max_depth) {
-        return os << cdelim;
-    } else if constexpr(depth == 0) {
-        os << odelim;
-        print_element(os, std::get<0>(rhs));
-        return print_tuple<depth + 1>(os, std::forward<T>(rhs), odelim, cdelim);
-    } else {
-        os << ", ";
-        print_element(os, std::get<depth>(rhs));
-        return print_tuple<depth + 1>(os, std::forward<T>(rhs), odelim, cdelim);
-    }
+    constexpr auto size = std::tuple_size_v<std::decay_t<T>>;
+    Printer p(os);
+    if constexpr(depth == 0) p.put(odelim);
+    print_tuple_elements<depth>(p, rhs, std::make_index_sequence<size>{});
+    p.put(cdelim);
+    return p.finish();
 }
 
 } // namespace detail_
@@ -136,11 +561,12 @@ std::ostream& operator<<(std::ostream& os,
 
 template<typename T>
 std::ostream& operator<<(std::ostream& os, const std::optional<T>& o) {
+    utilities::printing::detail_::Printer p(os);
     if(o.has_value())
-        utilities::printing::detail_::print_element(os, o.value());
+        p.element(o.value());
     else
-        os << "nullopt";
-    return os;
+        p.put("nullopt");
+    return p.finish();
 }
 
 template<typename T1, typename T2>
@@ -150,15 +576,16 @@ std::ostream& operator<<(std::ostream& os, const std::pair<T1, T2>& p) {
 
 template<typename T, typename Container, typename Compare>
 std::ostream& operator<<(std::ostream& os,
-                         std::priority_queue<T, Container, Compare> q) {
-    auto l = [](const decltype(q)& q) { return q.top(); };
-    return utilities::printing::detail_::print_queue(os, l, std::move(q));
+                         const std::priority_queue<T, Container, Compare>& q) {
+    const auto& c    = utilities::printing::detail_::underlying_container(q);
+    const auto& comp = utilities::printing::detail_::underlying_compare(q);
+    return utilities::printing::detail_::print_priority_queue(os, c, comp);
 }
 
 template<typename T, typename Container>
-std::ostream& operator<<(std::ostream& os, std::queue<T, Container> q) {
-    auto l = [](const decltype(q)& q) { return q.front(); };
-    return utilities::printing::detail_::print_queue(os, l, std::move(q));
+std::ostream& operator<<(std::ostream& os, const std::queue<T, Container>& q) {
+    const auto& c = utilities::printing::detail_::underlying_container(q);
+    return utilities::printing::detail_::print_queue(os, c.begin(), c.end());
 }
 
 template<typename T>
@@ -173,9 +600,10 @@ std::ostream& operator<<(std::ostream& os,
 }
 
 template<typename T, typename Container>
-std::ostream& operator<<(std::ostream& os, std::stack<T, Container> s) {
-    auto l = [](const decltype(s)& s) { return s.top(); };
-    return utilities::printing::detail_::print_queue(os, l, std::move(s));
+std::ostream& operator<<(std::ostream& os, const std::stack<T, Container>& s) {
+    // The top of the stack is the back of the container
+    const auto& c = utilities::printing::detail_::underlying_container(s);
+    return utilities::printing::detail_::print_queue(os, c.rbegin(), c.rend());
 }
 
 template<typename... Types>
@@ -15,15 +15,210 @@
  */
 
 #pragma once
-#include "utilities/strings/string_tools.hpp"
-#include <iostream>
-#include <iterator>
-#include <memory>
+#include "utilities/strings/split_view.hpp"
+#include "utilities/strings/utf8.hpp"
+#include <algorithm>
+#include <mutex>
 #include <ostream>
-#include <sstream>
-#include <vector>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
 
 namespace utilities::printing {
+namespace detail_ {
+
+/** @brief Implements the word wrapping for WordWrapStream.
+ *
+ *  LineWrapper holds the state of the line currently being wrapped: the part
+ *  of the line which has not been written out yet (kept in a buffer which is
+ *  allocated up front) and how much of the line already has been. Wrapped
+ *  text is written to a "sink", which is any object with
+ *  `write(const char*, std::streamsize)` and `put(char)` members (e.g., an
+ *  `std::ostream`).
+ *
+ *  Widths are measured in display columns, not bytes. The text is assumed to
+ *  be UTF-8 and is decoded incrementally (characters may be split across
+ *  writes). Runs of printable ASCII, which is the bulk of what gets wrapped,
+ *  are copied without decoding. Lines are broken at whitespace other than
+ *  newlines; tabs advance to the next multiple of 8 columns.
+ */
+class LineWrapper {
+public:
+    /// The type used to specify the predefined width
+    using width_type = unsigned long;
+
+    /// Makes a wrapper for lines of @p w columns, allocates the buffer
+    explicit LineWrapper(width_type w) : m_w_(w) {
+        // Enough for a line of 4-byte characters, w/o combining marks
+        m_buffer_.reserve(4 * w + 4);
+    }
+
+    /// Wraps the @p n bytes starting at @p s, writing them to @p sink
+    template<typename SinkType>
+    void write(const char* s, std::streamsize n, SinkType& sink) {
+        std::streamsize i = 0;
+        while(i < n) {
+            // Fast path: copies runs of printable ASCII which fit on the line
+            if(!m_spill_ && !m_decoder_.pending()) {
+                const auto used  = m_nchars_ + m_cols_;
+                const auto room  = used >= m_w_ ? 0 : m_w_ - used;
+                const auto limit = std::min<std::streamsize>(room, n - i);
+
+                std::streamsize k    = 0;
+                std::streamsize last = -1; // Offset of the last space
+                for(; k < limit && is_printable_ascii_(s[i + k]); ++k)
+                    if(s[i + k] == ' ') last = k;
+                m_buffer_.append(s + i, k);
+                m_cols_ += k;
+                m_word_cols_ = last < 0 ? m_word_cols_ + k : k - last - 1;
+                i += k;
+            }
+            if(i < n) put(s[i++], sink);
+        }
+    }
+
+    /// Adds the byte @p c to the line, breaking the line if need be
+    template<typename SinkType>
+    void put(char c, SinkType& sink) {
+        if(c == '\n') {
+            end_line_(m_buffer_.size(), sink);
+            return;
+        }
+
+        const bool is_break = strings::detail_::is_whitespace(c);
+
+        // Finishing a word which is too long for any line, it is not broken
+        if(m_spill_) {
+            if(is_break) {
+                end_line_(0, sink);
+                return;
+            }
+            sink.put(c);
+            return;
+        }
+
+        m_buffer_.push_back(c);
+        char32_t cps[2];
+        const auto ncps = m_decoder_.push(c, cps);
+        if(ncps == 0) return; // In the middle of a multi-byte character
+
+        width_type cw = 0;
+        for(std::size_t i = 0; i < ncps; ++i) {
+            if(cps[i] == '\t')
+                cw += tab_size - (m_nchars_ + m_cols_ + cw) % tab_size;
+            else
+                cw += strings::code_point_width(cps[i]);
+        }
+        m_cols_ += cw;
+        m_word_cols_ = is_break ? 0 : m_word_cols_ + cw;
+        if(m_nchars_ + m_cols_ <= m_w_) return; // It fits
+
+        // Doesn't fit, break at c or at the last whitespace (which is dropped)
+        if(is_break) {
+            end_line_(m_buffer_.size() - 1, sink, 1);
+            return;
+        }
+        const auto pos = find_last_break_();
+        if(pos != std::string::npos) {
+            end_line_(pos, sink, 1);
+            return;
+        }
+
+        // No whitespace to break on, but part of the line was already written
+        if(m_nchars_ > 0) {
+            sink.put('\n');
+            m_nchars_ = 0;
+            if(m_cols_ <= m_w_) return;
+        }
+
+        // The current word is longer than the line
+        flush(sink);
+        m_spill_ = true;
+    }
+
+    /// Writes the buffered characters to @p sink as part of the current line
+    template<typename SinkType>
+    void flush(SinkType& sink) {
+        sink.write(m_buffer_.data(), m_buffer_.size());
+        m_buffer_.clear();
+        m_nchars_ += m_cols_;
+        m_cols_      = 0;
+        m_word_cols_ = 0;
+    }
+
+    /// Tab stops are every this many columns
+    static constexpr width_type tab_size = 8;
+
+private:
+    /// Is @p c in [0x20, 0x7F), i.e., one column wide and not a line break?
+    static bool is_printable_ascii_(char c) noexcept {
+        return c >= 0x20 && c < 0x7F;
+    }
+
+    /// Offset of the last whitespace in the buffer, or npos if there is none
+    std::size_t find_last_break_() const noexcept {
+        // Multi-byte UTF-8 characters never contain ASCII bytes
+        for(auto i = m_buffer_.size(); i > 0; --i)
+            if(strings::detail_::is_whitespace(m_buffer_[i - 1])) return i - 1;
+        return std::string::npos;
+    }
+
+    /** Writes out the first @p n bytes of the buffer and a newline. The next
+     *  @p nskip bytes are dropped and the rest (if any), which are always the
+     *  last word of the buffer, start the next line.
+     */
+    template<typename SinkType>
+    void end_line_(std::size_t n, SinkType& sink, std::size_t nskip = 0) {
+        sink.write(m_buffer_.data(), n);
+        sink.put('\n');
+        m_buffer_.erase(0, n + nskip);
+        m_cols_   = m_buffer_.empty() ? 0 : m_word_cols_;
+        m_nchars_ = 0;
+        m_spill_  = false;
+        if(m_buffer_.empty()) m_decoder_.reset();
+    }
+
+    /// The width of the page, in columns
+    width_type m_w_;
+
+    /// How many columns of the current line have been written to the sink
+    width_type m_nchars_ = 0;
+
+    /// Holds the part of the current line not written to the sink yet
+    std::string m_buffer_;
+
+    /// How many columns the characters in m_buffer_ take up
+    width_type m_cols_ = 0;
+
+    /// How many columns the characters after the last whitespace take up
+    width_type m_word_cols_ = 0;
+
+    /// Decodes the characters as they are added to m_buffer_
+    strings::Utf8Decoder m_decoder_;
+
+    /// Are we in the middle of writing a word which is too long for a line?
+    bool m_spill_ = false;
+};
+
+/// The state of one writer of a thread-safe WordWrapStream
+struct ThreadLines {
+    /// Makes the state for lines of @p w characters
+    explicit ThreadLines(LineWrapper::width_type w) : wrapper(w) {}
+
+    /// ThreadLines is the sink of its own wrapper
+    ///@{
+    void write(const char* s, std::streamsize n) { lines.append(s, n); }
+    void put(char c) { lines.push_back(c); }
+    ///@}
+
+    /// The line this writer is currently writing
+    LineWrapper wrapper;
+
+    /// Wrapped lines waiting to be committed to the wrapped stream
+    std::string lines;
+};
+
+} // namespace detail_
 
 /** @brief An std::ostream that automatically wraps its contents if they
  *         exceed the specified width.
@@ -37,11 +232,37 @@ namespace utilities::printing {
  *  does not provide a newline character prior to a line reaching the predefined
  *  width. If a newline character is encountered before that, the internal
  *  counter is reset. Hence this class will preserve pre-existing formatting.
+ *
+ *  Text is collected in a fixed-size line buffer (allocated once, when the
+ *  WordWrapStream is created) and handed to the wrapped stream a line at a
+ *  time. Line breaks are written as `'\n'`, i.e., they do not flush the
+ *  wrapped stream. The partial line in the buffer is written, and the
+ *  wrapped stream is flushed, only when *this is flushed (e.g., via
+ *  `std::flush` or `std::endl`). Destroying *this writes any partial line,
+ *  but does not flush the wrapped stream.
+ *
+ *  A WordWrapStream, like any other `std::ostream`, must only be used by one
+ *  thread at a time; formatted output changes the state of the stream. To
+ *  write from several threads, make a thread-safe WordWrapStream and give
+ *  each thread its own WordWrapStream::Writer. A Writer is a separate
+ *  `std::ostream` (with its own formatting state), which wraps its text
+ *  independently and accumulates it until a `'\n'` is written. At that point
+ *  the wrapped paragraph is written to the wrapped stream as a single unit,
+ *  while holding a lock shared by all of the Writers. Hence paragraphs from
+ *  different threads never interleave, and the lock is only taken once per
+ *  paragraph (never per character). Flushing a Writer commits its partial
+ *  paragraph as well, so it should be done at the end of a line. A Writer
+ *  commits its partial paragraph when it is destroyed, so no state outlives
+ *  the threads which wrote.
+ *
+ *  Writing to a thread-safe WordWrapStream directly works the same way, i.e.,
+ *  paragraphs are committed atomically, but (as for any stream) only one
+ *  thread may do so at a time.
  */
 class WordWrapStream : private std::streambuf, public std::ostream {
 public:
     /// The type used to specify the predefined width
-    using width_type = unsigned long;
+    using width_type = detail_::LineWrapper::width_type;
 
     /** @brief Bestows an existing ostream with word wrapping abalities
      *
@@ -51,95 +272,201 @@ public:
      *               ensure @p os stays in scope.
      * @param[in] w  The predefined width at which word wrapping occurs. Default
      *               is 80 characters.
+     * @param[in] thread_safe If true, multiple threads may write to *this
+     *                        concurrently, each through its own Writer (see
+     *                        class description).
+     *                        Default is false.
      *
-     * @throw std::bad_alloc if there is insufficient memory to make the PIMPL
-     *                       instance. Strong throw guarantee.
+     * @throw std::bad_alloc if there is insufficient memory to make the line
+     *                       buffer. Strong throw guarantee.
      */
-    explicit WordWrapStream(std::ostream* os, width_type w = 80) :
-      std::ostream(this), m_os_(os), m_w_(w) {}
+    explicit WordWrapStream(std::ostream* os, width_type w = 80,
+                            bool thread_safe = false) :
+      std::ostream(this),
+      m_os_(os),
+      m_w_(w),
+      m_thread_safe_(thread_safe),
+      m_wrapper_(thread_safe ? 0 : w),
+      m_lines_(thread_safe ? w : 0) {}
+
+    /// Writes out the partial lines (if any), does not flush the wrapped stream
+    ~WordWrapStream() noexcept override {
+        try {
+            m_wrapper_.flush(*m_os_);
+            m_lines_.wrapper.flush(m_lines_);
+            m_os_->write(m_lines_.lines.data(), m_lines_.lines.size());
+        } catch(...) {}
+    }
+
+    /// Can *this be written to by multiple threads (via Writers)?
+    bool thread_safe() const noexcept { return m_thread_safe_; }
+
+    /// Writes to a thread-safe WordWrapStream from one thread
+    class Writer;
 
 protected:
-    // This function does the heavy lifting
     std::streamsize xsputn(const char* s, std::streamsize n) override {
-        // Break paragraph into sentences
-        auto sentences = strings::split_string(std::string(s, s + n), "\n");
-
-        const auto nsentences = sentences.size();
-        for(std::size_t si = 0; si < nsentences; ++si) { // Loop over sentences
-            auto sentence = sentences[si];
-            while(!sentence.empty()) {
-                const unsigned short size = sentence.size();
-                if(m_nchars_ + size <= m_w_) { // Whole thing fits
-                    (*m_os_) << sentence;
-                    m_nchars_ += size;
-                    break;
-                }
-
-                // Remainder of this while figures out where to break the line
-
-                // How many characters do we have left?
-                const auto char_left = m_w_ - m_nchars_;
-
-                // Find the first space we can break on
-                std::size_t offset = sentence.find(' ', 0);
-
-                // Was there any spaces left?
-                const bool no_spaces_left = (offset == std::string::npos);
-
-                // Aren't on empty line and can't print any part of what remains
-                if((no_spaces_left || offset > char_left) && m_nchars_ > 0) {
-                    (*m_os_) << std::endl;
-                    m_nchars_ = 0;
-                    continue;
-                }
-
-                if(no_spaces_left) {
-                    (*m_os_) << sentence;
-                    break;
-                }
-
-                // See if we can fit more on the line
-                while(offset != std::string::npos) {
-                    auto temp = sentence.find(' ', offset + 1);
-                    if(temp > char_left || temp == std::string::npos) break;
-                    offset = temp;
-                }
-
-                (*m_os_) << sentence.substr(0, offset);
-                (*m_os_) << std::endl;
-                m_nchars_ = 0;
-                sentence  = sentence.substr(offset + 1); // swallow the space
-            }
-            // Print a newline if we have more lines left
-            if(si < nsentences - 1) {
-                (*m_os_) << std::endl;
-                m_nchars_ = 0;
-            }
-
-        } // loop over lines
-        return n;
+        if(!m_thread_safe_) {
+            m_wrapper_.write(s, n, *m_os_);
+            return n;
+        }
+        return write_paragraphs_(m_lines_, s, n);
     }
 
     int overflow(std::streambuf::int_type c) override {
-        if(m_nchars_ == m_w_) {
-            (*m_os_) << std::endl;
-            m_nchars_ = 0;
+        using traits = std::streambuf::traits_type;
+        if(traits::eq_int_type(c, traits::eof())) return traits::not_eof(c);
+        const auto ch = traits::to_char_type(c);
+        if(!m_thread_safe_) {
+            m_wrapper_.put(ch, *m_os_);
+            return c;
         }
-        (*m_os_) << std::streambuf::traits_type::to_char_type(c);
-        ++m_nchars_;
-
+        put_paragraphs_(m_lines_, ch);
         return c;
     }
 
+    // Writes out the partial line and flushes the wrapped stream
+    int sync() override {
+        if(!m_thread_safe_) {
+            m_wrapper_.flush(*m_os_);
+            m_os_->flush();
+            return m_os_->bad() ? -1 : 0;
+        }
+        return sync_paragraphs_(m_lines_);
+    }
+
 private:
+    /// Type of the state of one writer
+    using thread_state = detail_::ThreadLines;
+
+    /// Wraps @p n bytes from @p s into @p state, commits finished paragraphs
+    std::streamsize write_paragraphs_(thread_state& state, const char* s,
+                                      std::streamsize n) {
+        // Only the text up to the last newline completes paragraphs
+        auto nl = n;
+        while(nl > 0 && s[nl - 1] != '\n') --nl;
+        state.wrapper.write(s, nl, state);
+        if(nl > 0) commit_(state);
+        state.wrapper.write(s + nl, n - nl, state);
+        return n;
+    }
+
+    /// Wraps @p c into @p state, commits the paragraph if @p c ends it
+    void put_paragraphs_(thread_state& state, char c) {
+        state.wrapper.put(c, state);
+        if(c == '\n') commit_(state);
+    }
+
+    /// Commits @p state's partial paragraph and flushes the wrapped stream
+    int sync_paragraphs_(thread_state& state) {
+        state.wrapper.flush(state);
+        commit_(state);
+        std::lock_guard<std::mutex> lock(m_mutex_);
+        m_os_->flush();
+        return m_os_->bad() ? -1 : 0;
+    }
+
+    /// Writes the text accumulated in @p state to m_os_ in one go
+    void commit_(thread_state& state) {
+        if(state.lines.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex_);
+            m_os_->write(state.lines.data(), state.lines.size());
+        }
+        state.lines.clear();
+    }
+
     /// Where we write data to if an overflow occurs
     std::ostream* m_os_;
 
     /// The width of the page
     width_type m_w_;
 
-    /// How many characters we've written
-    width_type m_nchars_ = 0;
+    /// Can multiple threads write to *this?
+    bool m_thread_safe_;
+
+    /// Does the wrapping when *this is not thread-safe
+    detail_::LineWrapper m_wrapper_;
+
+    /// The state of direct writes to *this when *this is thread-safe
+    thread_state m_lines_;
+
+    /// Guards writes to m_os_ in thread-safe mode
+    std::mutex m_mutex_;
+};
+
+/** @brief The per-thread front end of a thread-safe WordWrapStream.
+ *
+ *  Each thread which writes to a thread-safe WordWrapStream makes its own
+ *  Writer, e.g.,
+ *
+ *  @code
+ *  WordWrapStream out(&std::cout, 80, true);
+ *  // On each thread
+ *  WordWrapStream::Writer w(out);
+ *  w << "Thread " << i << " says hi" << std::endl;
+ *  @endcode
+ *
+ *  The Writer has its own line buffer and formatting state, and shares only
+ *  the (locked) wrapped stream. It must not outlive the WordWrapStream.
+ */
+class WordWrapStream::Writer : private std::streambuf, public std::ostream {
+public:
+    /** @brief Makes a front end for @p stream.
+     *
+     *  @param[in] stream The thread-safe WordWrapStream to write to. Must
+     *                    outlive *this.
+     *
+     *  @throw std::invalid_argument if @p stream is not thread-safe. Strong
+     *                               throw guarantee.
+     *  @throw std::bad_alloc if there is insufficient memory to make the
+     *                        line buffer. Strong throw guarantee.
+     */
+    explicit Writer(WordWrapStream& stream) :
+      std::ostream(this), m_stream_(&check_(stream)), m_lines_(stream.m_w_) {}
+
+    /// Commits the partial paragraph (if any), does not flush
+    ~Writer() noexcept override {
+        try {
+            m_lines_.wrapper.flush(m_lines_);
+            m_stream_->commit_(m_lines_);
+        } catch(...) {}
+    }
+
+    /// Writers are tied to their thread and their stream
+    ///@{
+    Writer(const Writer&)            = delete;
+    Writer& operator=(const Writer&) = delete;
+    ///@}
+
+protected:
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        return m_stream_->write_paragraphs_(m_lines_, s, n);
+    }
+
+    int overflow(std::streambuf::int_type c) override {
+        using traits = std::streambuf::traits_type;
+        if(traits::eq_int_type(c, traits::eof())) return traits::not_eof(c);
+        m_stream_->put_paragraphs_(m_lines_, traits::to_char_type(c));
+        return c;
+    }
+
+    // Commits the partial paragraph and flushes the wrapped stream
+    int sync() override { return m_stream_->sync_paragraphs_(m_lines_); }
+
+private:
+    /// Throws if @p stream is not thread-safe, returns @p stream otherwise
+    static WordWrapStream& check_(WordWrapStream& stream) {
+        if(!stream.thread_safe())
+            throw std::invalid_argument("WordWrapStream is not thread-safe");
+        return stream;
+    }
+
+    /// The stream whose wrapped stream we write to
+    WordWrapStream* m_stream_;
+
+    /// This writer's line and finished paragraphs
+    thread_state m_lines_;
 };
 
 } // namespace utilities::printing
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "utilities/strings/split_view.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace utilities::strings {
+
+/** @brief Tokenizes a file without reading it into memory.
+ *
+ *  The usual way of parsing a text file is to read it into an `std::string`
+ *  and then call `split_string` on it. For large files (geometries, basis set
+ *  libraries, checkpoint dumps) this requires holding the entire file, and
+ *  then a second copy of it broken into lines, on the heap.
+ *
+ *  FileTokenizer instead maps the file into the address space of the process
+ *  (read-only `mmap`). Lines and fields are handed out as `std::string_view`s
+ *  which point directly into the mapping, so nothing is copied and the
+ *  operating system pages the file in (and out) as it is accessed.
+ *
+ *  Usage looks like:
+ *
+ *  @code
+ *  FileTokenizer file("water.xyz");
+ *  for(auto line : file.lines()) {
+ *      for(auto field : FileTokenizer::fields(line)) {
+ *          // Do something with field
+ *      }
+ *  }
+ *  @endcode
+ *
+ *  On platforms without `mmap` the file is read into a single buffer.
+ *
+ *  @note The views handed out by *this are only valid while *this is alive.
+ */
+class FileTokenizer {
+public:
+    /// Type used for offsets and counting
+    using size_type = std::size_t;
+
+    /// Type of a view of (part of) the file
+    using view_type = std::string_view;
+
+    /// Type of a range over the lines of the file
+    using line_range = SplitView;
+
+    /// Type of a range over the fields of a line
+    using field_range = WhitespaceSplitView;
+
+    /// Creates a FileTokenizer which is not associated with a file
+    FileTokenizer() noexcept = default;
+
+    /** @brief Maps the file at @p path into memory.
+     *
+     *  @param[in] path The path to the file to tokenize.
+     *  @param[in] sequential If true, the operating system is told the file
+     *                        will be read front to back (see
+     *                        `advise_sequential`). Default is false.
+     *
+     *  @throw std::runtime_error if the file can not be opened or mapped.
+     *                            Strong throw guarantee.
+     */
+    explicit FileTokenizer(const std::string& path, bool sequential = false);
+
+    /// Unmaps the file
+    ~FileTokenizer() noexcept;
+
+    /// A mapping can not be shared, but it can be transferred
+    ///@{
+    FileTokenizer(const FileTokenizer&)            = delete;
+    FileTokenizer& operator=(const FileTokenizer&) = delete;
+    FileTokenizer(FileTokenizer&& other) noexcept;
+    FileTokenizer& operator=(FileTokenizer&& rhs) noexcept;
+    ///@}
+
+    /** @brief Hints to the operating system that the file will be read in
+     *         order.
+     *
+     *  This calls `madvise(MADV_SEQUENTIAL)` on the mapping, which typically
+     *  makes the kernel read ahead more aggressively and drop pages after
+     *  they have been read. This is purely a performance hint; it has no
+     *  effect on the results and is a no-op where it is not supported.
+     *
+     *  @throw None No throw guarantee.
+     */
+    void advise_sequential() noexcept;
+
+    /// The entire contents of the file
+    view_type contents() const noexcept { return {m_data_, m_size_}; }
+
+    /// The number of bytes in the file
+    size_type size() const noexcept { return m_size_; }
+
+    /// Is the file empty (or is *this not associated with a file)?
+    bool empty() const noexcept { return m_size_ == 0; }
+
+    /** @brief The lines of the file.
+     *
+     *  Lines are split on `\n` with the same semantics as `split_string`. In
+     *  particular, a file ending in a newline has a trailing empty line.
+     *
+     *  @return A lazy range over the lines of the file.
+     *
+     *  @throw None No throw guarantee.
+     */
+    line_range lines() const noexcept { return split_view(contents(), '\n'); }
+
+    /** @brief The whitespace-separated fields of @p line.
+     *
+     *  @param[in] line The line to split. Usually one of the lines returned by
+     *                  `lines()`, but can be any string.
+     *
+     *  @return A lazy range over the fields of @p line.
+     *
+     *  @throw None No throw guarantee.
+     */
+    static field_range fields(view_type line) noexcept {
+        return split_whitespace(line);
+    }
+
+private:
+    /// Releases the mapping (if there is one)
+    void unmap_() noexcept;
+
+    /// Start of the file's contents
+    const char* m_data_ = nullptr;
+
+    /// Number of bytes in the file
+    size_type m_size_ = 0;
+
+    /// Holds the contents when the platform can't mmap
+    std::unique_ptr<char[]> m_buffer_;
+};
+
+} // namespace utilities::strings
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "utilities/strings/split_view.hpp"
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace utilities::strings {
+
+/// Chunks smaller than this (in bytes) are not worth a thread
+inline constexpr std::size_t default_min_chunk_size = 1ul << 20;
+
+/** @brief Splits a large string on a delimiter using multiple threads.
+ *
+ *  This is the parallel counterpart to `split_string`. @p str is cut into
+ *  one chunk per thread. Each chunk boundary is moved forward to just after
+ *  the next occurrence of @p delim, so that no substring straddles two
+ *  chunks. The chunks are then split concurrently and the results are
+ *  gathered, in their original order, into the returned vector.
+ *
+ *  The substrings are returned as views into @p str, so no characters are
+ *  copied. The result is identical to `split_string(str, delim)` (modulo
+ *  views vs. copies) regardless of the number of threads.
+ *
+ *  @note Delimiters which can overlap themselves (e.g., "aa") would make the
+ *        chunk boundaries ambiguous. For such delimiters, as well as for
+ *        inputs too small to benefit from threading, the split is done
+ *        serially.
+ *
+ *  @param[in] str The string to split. Must outlive the returned views.
+ *  @param[in] delim The string to split on.
+ *  @param[in] nthreads The maximum number of threads to use. Default is 0,
+ *                      which means `std::thread::hardware_concurrency()`.
+ *  @param[in] min_chunk_size The minimum number of bytes each thread should
+ *                            process. Fewer threads than @p nthreads are used
+ *                            if needed to satisfy this. Default is
+ *                            `default_min_chunk_size`.
+ *
+ *  @return An std::vector of views of the substrings.
+ *
+ *  @throw std::bad_alloc if there is insufficient memory for the result.
+ *                        Strong throw guarantee.
+ *  @throw std::system_error if a thread can not be started. Strong throw
+ *                           guarantee.
+ */
+std::vector<std::string_view> parallel_split_string(
+  std::string_view str, std::string_view delim, std::size_t nthreads = 0,
+  std::size_t min_chunk_size = default_min_chunk_size);
+
+/** @brief Overloads parallel_split_string for a single character delimiter.
+ *
+ *  @param[in] str The string to split. Must outlive the returned views.
+ *  @param[in] c The character to split on.
+ *  @param[in] nthreads The maximum number of threads to use. Default is 0,
+ *                      which means `std::thread::hardware_concurrency()`.
+ *  @param[in] min_chunk_size The minimum number of bytes each thread should
+ *                            process. Default is `default_min_chunk_size`.
+ *
+ *  @return An std::vector of views of the substrings.
+ *
+ *  @throw std::bad_alloc if there is insufficient memory for the result.
+ *                        Strong throw guarantee.
+ *  @throw std::system_error if a thread can not be started. Strong throw
+ *                           guarantee.
+ */
+inline std::vector<std::string_view> parallel_split_string(
+  std::string_view str, char c, std::size_t nthreads = 0,
+  std::size_t min_chunk_size = default_min_chunk_size) {
+    return parallel_split_string(str, detail_::char_as_view(c), nthreads,
+                                 min_chunk_size);
+}
+
+} // namespace utilities::strings
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace utilities::strings {
+
+/** @brief Thread-safe, bounded, least-recently-used cache of compiled regular
+ *         expressions.
+ *
+ *  Constructing an `std::regex` compiles the pattern into a state machine,
+ *  which is considerably more expensive than actually running the resulting
+ *  machine on a short string. Code which calls regex-based helpers (e.g.,
+ *  `strings::replace`) in a loop therefore spends most of its time recompiling
+ *  the same handful of patterns. RegexCache memoizes the compiled patterns.
+ *
+ *  The cache holds at most `max_size()` patterns. When a new pattern is
+ *  requested and the cache is full, the pattern which was used least recently
+ *  is evicted. Compiled patterns are handed out as shared pointers so evicting
+ *  a pattern never invalidates a regex which is currently in use.
+ *
+ *  All member functions may be called concurrently. Lookups take a single
+ *  lock; compilation of a missing pattern happens outside the lock so that
+ *  threads looking up other patterns are not blocked by it.
+ *
+ *  Most users will want to use the cache shared by the entire library, which
+ *  is obtained via `RegexCache::global()`.
+ */
+class RegexCache {
+public:
+    /// Type used for counting and indexing
+    using size_type = std::size_t;
+
+    /// Type of the compiled patterns
+    using regex_type = std::regex;
+
+    /// Type of the uncompiled patterns
+    using pattern_type = std::string;
+
+    /// Type of a read-only, shared handle to a compiled pattern
+    using const_regex_pointer = std::shared_ptr<const regex_type>;
+
+    /// The default number of patterns a RegexCache holds
+    static constexpr size_type default_max_size = 64;
+
+    /** @brief Creates an empty cache which holds at most @p max_size patterns.
+     *
+     *  @param[in] max_size The maximum number of patterns to hold. A value of
+     *                      zero disables caching (every lookup is a miss).
+     *                      Default is `default_max_size`.
+     *
+     *  @throw None No throw guarantee.
+     */
+    explicit RegexCache(size_type max_size = default_max_size) noexcept :
+      m_max_size_(max_size) {}
+
+    /// Caches are tied to their mutex and are not copyable/movable
+    ///@{
+    RegexCache(const RegexCache&)            = delete;
+    RegexCache(RegexCache&&)                 = delete;
+    RegexCache& operator=(const RegexCache&) = delete;
+    RegexCache& operator=(RegexCache&&)      = delete;
+    ///@}
+
+    /** @brief Returns the compiled version of @p pattern.
+     *
+     *  If @p pattern is in the cache this is a hit, the pattern is marked as
+     *  most recently used, and the cached regex is returned. Otherwise this is
+     *  a miss, @p pattern is compiled, inserted into the cache (evicting the
+     *  least recently used pattern if the cache is full), and returned.
+     *
+     *  @param[in] pattern The ECMAScript regular expression to compile.
+     *
+     *  @return A shared handle to the compiled regex. The handle remains valid
+     *          even if the pattern is subsequently evicted.
+     *
+     *  @throw std::regex_error if @p pattern is not a valid regular
+     *                          expression. Strong throw guarantee.
+     *  @throw std::bad_alloc if there is insufficient memory to compile or
+     *                        cache the pattern. Strong throw guarantee.
+     */
+    const_regex_pointer get(const pattern_type& pattern);
+
+    /// The number of patterns currently in the cache
+    size_type size() const;
+
+    /// The maximum number of patterns the cache will hold
+    size_type max_size() const noexcept { return m_max_size_.load(); }
+
+    /** @brief Changes the maximum number of patterns the cache holds.
+     *
+     *  If the cache currently holds more than @p max_size patterns, the least
+     *  recently used patterns are evicted until it does not.
+     *
+     *  @param[in] max_size The new maximum number of patterns.
+     *
+     *  @throw None No throw guarantee.
+     */
+    void set_max_size(size_type max_size);
+
+    /// How many calls to `get` found their pattern in the cache
+    size_type hits() const noexcept { return m_hits_.load(); }
+
+    /// How many calls to `get` had to compile their pattern
+    size_type misses() const noexcept { return m_misses_.load(); }
+
+    /// Evicts all patterns and zeroes the hit/miss counters
+    void clear();
+
+    /** @brief The cache shared by all regex users in the library.
+     *
+     *  @return A reference to the library-wide cache. The cache is created,
+     *          with `default_max_size`, the first time this is called.
+     *
+     *  @throw None No throw guarantee.
+     */
+    static RegexCache& global() noexcept;
+
+private:
+    /// Type of the recency list, most recently used pattern is at the front
+    using lru_list = std::list<std::pair<pattern_type, const_regex_pointer>>;
+
+    /// Evicts patterns from the back of the list. Assumes lock is held.
+    void trim_() noexcept;
+
+    /// Guards m_lru_ and m_index_
+    mutable std::mutex m_mutex_;
+
+    /// The cached patterns, ordered from most to least recently used
+    lru_list m_lru_;
+
+    /// Maps patterns to their position in m_lru_
+    std::unordered_map<pattern_type, typename lru_list::iterator> m_index_;
+
+    /// The maximum number of patterns in the cache
+    std::atomic<size_type> m_max_size_;
+
+    /// The number of cache hits
+    std::atomic<size_type> m_hits_ = 0;
+
+    /// The number of cache misses
+    std::atomic<size_type> m_misses_ = 0;
+};
+
+} // namespace utilities::strings
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "utilities/iterators/input_iterator_base.hpp"
+#include <cstddef>
+#include <string_view>
+
+namespace utilities::strings {
+namespace detail_ {
+
+/// Every possible char, used to make std::string_views of single characters
+struct CharTable {
+    constexpr CharTable() : chars() {
+        for(int i = 0; i < 256; ++i) chars[i] = static_cast<char>(i);
+    }
+    char chars[256];
+};
+
+/// Returns a view of @p c which remains valid for the life of the program
+inline std::string_view char_as_view(char c) noexcept {
+    static constexpr CharTable table;
+    return std::string_view(table.chars + static_cast<unsigned char>(c), 1);
+}
+
+/// Is @p c one of the characters std::isspace considers whitespace in "C"?
+constexpr bool is_whitespace(char c) noexcept {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+           c == '\r';
+}
+
+} // namespace detail_
+
+/** @brief Lazily splits a string on a delimiter.
+ *
+ *  SplitView is the non-owning, lazy counterpart to `split_string`. Rather
+ *  than copying each substring into an `std::vector<std::string>`, SplitView
+ *  hands out `std::string_view`s into the original string, one at a time, as
+ *  it is iterated over. Splitting a string with SplitView therefore never
+ *  allocates, which makes it suitable for very large inputs (e.g., memory-
+ *  mapped files).
+ *
+ *  The substrings visited by SplitView are exactly those which
+ *  `split_string` would return for the same inputs, i.e., an empty string
+ *  has no substrings, and a trailing delimiter results in a trailing empty
+ *  substring. If the delimiter is empty the entire string is one substring.
+ *
+ *  @note SplitView does not own the string or the delimiter. Both must
+ *        outlive the SplitView and any iterators obtained from it.
+ */
+class SplitView {
+public:
+    /// Type of the substrings
+    using value_type = std::string_view;
+
+    /// Type used for offsets and counting
+    using size_type = std::size_t;
+
+    /// Iterator over the substrings
+    class const_iterator
+      : public iterators::InputIteratorBase<const_iterator> {
+    public:
+        /// Types needed to make this iterator compatible with the STL
+        ///@{
+        using value_type      = std::string_view;
+        using reference       = const value_type&;
+        using pointer         = const value_type*;
+        using difference_type = std::ptrdiff_t;
+        ///@}
+
+        /// Makes an iterator which is equal to the end iterator
+        const_iterator() noexcept = default;
+
+        /// Makes an iterator pointing at the first substring of @p str
+        const_iterator(std::string_view str, std::string_view delim) noexcept :
+          m_rest_(str), m_delim_(delim), m_at_end_(str.empty()) {
+            if(!m_at_end_) next_();
+        }
+
+        /// Advances to the next substring
+        const_iterator& increment() noexcept {
+            if(m_has_rest_)
+                next_();
+            else
+                m_at_end_ = true;
+            return *this;
+        }
+
+        /// The current substring
+        reference dereference() const noexcept { return m_token_; }
+
+        /// Substrings start at unique positions, so compare the starts
+        bool are_equal(const const_iterator& rhs) const noexcept {
+            if(m_at_end_ || rhs.m_at_end_) return m_at_end_ == rhs.m_at_end_;
+            return m_token_.data() == rhs.m_token_.data();
+        }
+
+    private:
+        /// Peels the next substring off of m_rest_
+        void next_() noexcept {
+            const auto pos = m_delim_.empty() ? std::string_view::npos :
+                                                m_rest_.find(m_delim_);
+            m_has_rest_ = pos != std::string_view::npos;
+            if(m_has_rest_) {
+                m_token_ = m_rest_.substr(0, pos);
+                m_rest_.remove_prefix(pos + m_delim_.size());
+            } else {
+                m_token_ = m_rest_;
+            }
+        }
+
+        /// The part of the string which has not been split yet
+        std::string_view m_rest_;
+
+        /// What we are splitting on
+        std::string_view m_delim_;
+
+        /// The current substring
+        std::string_view m_token_;
+
+        /// Is there anything after m_token_?
+        bool m_has_rest_ = false;
+
+        /// Are we past the last substring?
+        bool m_at_end_ = true;
+    };
+
+    /// The iterator type, SplitView is read-only
+    using iterator = const_iterator;
+
+    /** @brief Creates a view of @p str split on @p delim.
+     *
+     *  @param[in] str The string to split. Must outlive *this.
+     *  @param[in] delim The delimiter to split on. Must outlive *this.
+     *
+     *  @throw None No throw guarantee.
+     */
+    SplitView(std::string_view str, std::string_view delim) noexcept :
+      m_str_(str), m_delim_(delim) {}
+
+    /// An iterator to the first substring
+    const_iterator begin() const noexcept { return {m_str_, m_delim_}; }
+
+    /// An iterator just past the last substring
+    const_iterator end() const noexcept { return {}; }
+
+    /// Does *this have no substrings?
+    bool empty() const noexcept { return m_str_.empty(); }
+
+    /// The string being split
+    std::string_view str() const noexcept { return m_str_; }
+
+    /// The delimiter being split on
+    std::string_view delimiter() const noexcept { return m_delim_; }
+
+private:
+    /// The string being split
+    std::string_view m_str_;
+
+    /// The delimiter
+    std::string_view m_delim_;
+};
+
+/** @brief Lazily splits a string into whitespace-separated fields.
+ *
+ *  Many text formats (geometries, basis set libraries, etc.) separate the
+ *  fields of a line with a variable amount of whitespace. WhitespaceSplitView
+ *  treats each run of whitespace (space, `\t`, `\n`, `\v`, `\f`, `\r`) as a
+ *  single delimiter and skips leading and trailing whitespace, so it never
+ *  visits an empty field. Like SplitView, the fields are `std::string_view`s
+ *  into the original string and iterating never allocates.
+ *
+ *  @note WhitespaceSplitView does not own the string. It must outlive the
+ *        WhitespaceSplitView and any iterators obtained from it.
+ */
+class WhitespaceSplitView {
+public:
+    /// Type of the fields
+    using value_type = std::string_view;
+
+    /// Iterator over the fields
+    class const_iterator
+      : public iterators::InputIteratorBase<const_iterator> {
+    public:
+        /// Types needed to make this iterator compatible with the STL
+        ///@{
+        using value_type      = std::string_view;
+        using reference       = const value_type&;
+        using pointer         = const value_type*;
+        using difference_type = std::ptrdiff_t;
+        ///@}
+
+        /// Makes an iterator which is equal to the end iterator
+        const_iterator() noexcept = default;
+
+        /// Makes an iterator pointing at the first field of @p str
+        explicit const_iterator(std::string_view str) noexcept : m_rest_(str) {
+            next_();
+        }
+
+        /// Advances to the next field
+        const_iterator& increment() noexcept {
+            next_();
+            return *this;
+        }
+
+        /// The current field
+        reference dereference() const noexcept { return m_token_; }
+
+        /// Fields start at unique positions, so compare the starts
+        bool are_equal(const const_iterator& rhs) const noexcept {
+            return m_token_.data() == rhs.m_token_.data();
+        }
+
+    private:
+        /// Peels the next field off of m_rest_, or becomes the end iterator
+        void next_() noexcept {
+            std::size_t i = 0;
+            const auto n  = m_rest_.size();
+            while(i < n && detail_::is_whitespace(m_rest_[i])) ++i;
+            if(i == n) {
+                m_rest_  = {};
+                m_token_ = {};
+                return;
+            }
+            auto j = i;
+            while(j < n && !detail_::is_whitespace(m_rest_[j])) ++j;
+            m_token_ = m_rest_.substr(i, j - i);
+            m_rest_.remove_prefix(j);
+        }
+
+        /// The part of the string which has not been split yet
+        std::string_view m_rest_;
+
+        /// The current field, null data() signals the end
+        std::string_view m_token_;
+    };
+
+    /// The iterator type, WhitespaceSplitView is read-only
+    using iterator = const_iterator;
+
+    /// Creates a view of the fields in @p str. @p str must outlive *this.
+    explicit WhitespaceSplitView(std::string_view str) noexcept : m_str_(str) {}
+
+    /// An iterator to the first field
+    const_iterator begin() const noexcept { return const_iterator(m_str_); }
+
+    /// An iterator just past the last field
+    const_iterator end() const noexcept { return {}; }
+
+    /// Does *this have no fields?
+    bool empty() const noexcept { return begin() == end(); }
+
+    /// The string being split
+    std::string_view str() const noexcept { return m_str_; }
+
+private:
+    /// The string being split
+    std::string_view m_str_;
+};
+
+/** @brief Lazily splits @p str on @p delim.
+ *
+ *  @param[in] str The string to split. Must outlive the returned view.
+ *  @param[in] delim The delimiter. Must outlive the returned view.
+ *
+ *  @return A SplitView over the substrings of @p str.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline SplitView split_view(std::string_view str,
+                            std::string_view delim) noexcept {
+    return SplitView(str, delim);
+}
+
+/** @brief Overloads split_view for a single character delimiter.
+ *
+ *  @param[in] str The string to split. Must outlive the returned view.
+ *  @param[in] c The character to split on.
+ *
+ *  @return A SplitView over the substrings of @p str.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline SplitView split_view(std::string_view str, char c) noexcept {
+    return SplitView(str, detail_::char_as_view(c));
+}
+
+/** @brief Lazily splits @p str into whitespace-separated fields.
+ *
+ *  @param[in] str The string to split. Must outlive the returned view.
+ *
+ *  @return A WhitespaceSplitView over the fields of @p str.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline WhitespaceSplitView split_whitespace(std::string_view str) noexcept {
+    return WhitespaceSplitView(str);
+}
+
+} // namespace utilities::strings
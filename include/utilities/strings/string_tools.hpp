@@ -15,11 +15,18 @@
  */
 
 #pragma once
-#include "utilities/iter_tools/enumerate.hpp"
+#include "utilities/strings/regex_cache.hpp"
+#include "utilities/strings/split_view.hpp"
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <iterator>
 #include <regex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace utilities::strings {
@@ -80,6 +87,136 @@ inline auto split_string(const std::string& str, char c) {
     return split_string(str, std::string(1, c));
 }
 
+namespace detail_ {
+
+/// Views @p x as a string, where @p x is a char or is string-like
+template<typename T>
+std::string_view as_string_view(const T& x) noexcept {
+    if constexpr(std::is_same_v<T, char>) {
+        return char_as_view(x);
+    } else {
+        return std::string_view(x);
+    }
+}
+
+/** @brief Can the range of type @p T be iterated over more than once?
+ *
+ *  Ranges whose iterators are forward iterators can be. The lazy split views
+ *  only have input iterators (they hand out references to state stored in the
+ *  iterator), but calling `begin()` again restarts the split, so they can be
+ *  too.
+ */
+template<typename T>
+struct IsMultipassRange {
+private:
+    using iterator = decltype(std::begin(std::declval<T&>()));
+    using category = typename std::iterator_traits<iterator>::iterator_category;
+
+public:
+    static constexpr bool value =
+      std::is_base_of_v<std::forward_iterator_tag, category>;
+};
+
+template<>
+struct IsMultipassRange<SplitView> : std::true_type {};
+
+template<>
+struct IsMultipassRange<WhitespaceSplitView> : std::true_type {};
+
+template<typename T>
+constexpr bool is_multipass_range_v =
+  IsMultipassRange<std::remove_cv_t<std::remove_reference_t<T>>>::value;
+
+} // namespace detail_
+
+/** @brief Computes the length of the string `join_string` would return.
+ *
+ *  @tparam T The type of the range. Must be iterable more than once.
+ *  @tparam U The type of the delimiter. Either char or string-like.
+ *
+ *  @param[in] split_str The range of strings which would be joined.
+ *  @param[in] delim The delimiter which would be used to join them.
+ *
+ *  @return The number of characters in the joined string.
+ *
+ *  @throw None No throw guarantee.
+ */
+template<typename T, typename U>
+std::size_t joined_size(const T& split_str, const U& delim) noexcept {
+    const auto delim_size = detail_::as_string_view(delim).size();
+    std::size_t n         = 0;
+    bool first            = true;
+    for(const auto& x : split_str) {
+        if(!first) n += delim_size;
+        n += detail_::as_string_view(x).size();
+        first = false;
+    }
+    return n;
+}
+
+/** @brief Writes the contents of a range, glued together by a delimiter, to
+ *         an output iterator.
+ *
+ *  This overload of join_string never allocates. It is the building block of
+ *  the other overloads and is useful when the result should go somewhere
+ *  other than an std::string (e.g., a preallocated character buffer or an
+ *  `std::ostreambuf_iterator`).
+ *
+ *  @tparam T The type of the range. Only needs to be iterable once.
+ *  @tparam U The type of the delimiter. Either char or string-like.
+ *  @tparam OutputIterator An output iterator which accepts chars.
+ *
+ *  @param[in] split_str The range of strings to join.
+ *  @param[in] delim The glue.
+ *  @param[in] out Where to write the result.
+ *
+ *  @return @p out advanced past the last character written.
+ *
+ *  @throw ??? Throws if writing to @p out throws. Weak throw guarantee.
+ */
+template<typename T, typename U, typename OutputIterator>
+OutputIterator join_string(T&& split_str, U&& delim, OutputIterator out) {
+    const auto glue = detail_::as_string_view(delim);
+    bool first      = true;
+    for(const auto& x : split_str) {
+        if(!first) out = std::copy(glue.begin(), glue.end(), out);
+        const auto xview = detail_::as_string_view(x);
+        out              = std::copy(xview.begin(), xview.end(), out);
+        first            = false;
+    }
+    return out;
+}
+
+/** @brief Appends the contents of a range, glued together by a delimiter, to
+ *         @p buffer.
+ *
+ *  If @p split_str can be iterated over more than once, the length of the
+ *  result is computed first and @p buffer grows at most once. Reusing the
+ *  same @p buffer (after clearing it) for many joins thus avoids allocating
+ *  altogether once its capacity is large enough.
+ *
+ *  @tparam T The type of the range.
+ *  @tparam U The type of the delimiter. Either char or string-like.
+ *
+ *  @param[in,out] buffer The string to append the result to.
+ *  @param[in] split_str The range of strings to join.
+ *  @param[in] delim The glue.
+ *
+ *  @return @p buffer, after appending the result.
+ *
+ *  @throw std::bad_alloc if there is insufficient memory to grow @p buffer.
+ *                        Weak throw guarantee.
+ */
+template<typename T, typename U>
+std::string& join_string_into(std::string& buffer, T&& split_str, U&& delim) {
+    if constexpr(detail_::is_multipass_range_v<T>) {
+        buffer.reserve(buffer.size() + joined_size(split_str, delim));
+    }
+    join_string(std::forward<T>(split_str), std::forward<U>(delim),
+                std::back_inserter(buffer));
+    return buffer;
+}
+
 /** @brief Concatenates the contents of a container using the provided delimiter
  *         as glue.
  *
@@ -94,9 +231,13 @@ inline auto split_string(const std::string& str, char c) {
  *  assert(rv == "foo+bar");
  *  @endcode
  *
- * @tparam T The type of the container. Assumed to be forward iterable.
- * @tparam U The type of the delimiter. std::string::operator+=(U) must be
- *           defined. Assumed to be either char or std::string.
+ *  Any range of string-like objects can be joined, including the lazy
+ *  SplitView and WhitespaceSplitView ranges. The result is allocated exactly
+ *  once if the range can be iterated over more than once.
+ *
+ * @tparam T The type of the container. Assumed to be iterable.
+ * @tparam U The type of the delimiter. Assumed to be either char or
+ *           string-like.
  *
  * @param[in] split_str The container holding the split string. The contents of
  *                      @p split_str will be joined to form the result.
@@ -108,20 +249,44 @@ inline auto split_string(const std::string& str, char c) {
  *                       Strong throw guarantee.
  */
 template<typename T, typename U>
-auto join_string(T&& split_str, U&& delim) {
+std::string join_string(T&& split_str, U&& delim) {
+    std::string rv;
+    join_string_into(rv, std::forward<T>(split_str), std::forward<U>(delim));
+    return rv;
+}
+
+namespace detail_ {
+
+/// Replaces each occurance of @p from in @p str with @p to, no regex involved
+inline std::string replace_literal(const std::string& from,
+                                   const std::string& to,
+                                   const std::string& str) {
     std::string rv;
-    for(auto&& [i, x] : utilities::Enumerate(std::forward<T>(split_str))) {
-        rv += x;
-        if(i != split_str.size() - 1) rv += delim;
+    rv.reserve(str.size());
+    std::string::size_type prev = 0;
+    std::string::size_type pos  = 0;
+    while((pos = str.find(from, prev)) != std::string::npos) {
+        rv.append(str, prev, pos - prev);
+        rv += to;
+        prev = pos + from.size();
     }
+    rv.append(str, prev, std::string::npos);
     return rv;
 }
 
+} // namespace detail_
+
 /** @brief Replaces all occurances of @p from in @p str with @p to.
  *
  *  @note Under the hood this uses regex to find @p from so if @p from contains
  *        any special regex characters you'll have to escape them. The
- *        special characters are: `.[]^$+*?{}()\`
+ *        special characters are: `.[]^$+*?{}()\|`
+ *
+ *  Compiled patterns are pulled from (and stored in) `RegexCache::global()`,
+ *  so calling this function repeatedly with the same @p from only compiles
+ *  the pattern once. If neither @p from nor @p to contain any special
+ *  characters the regex machinery is bypassed entirely in favor of a plain
+ *  substring search.
  *
  *  @param[in] from The substring that we are replacing.
  *  @param[in] to The substring each occurance of @p from will be replaced with.
@@ -130,14 +295,23 @@ auto join_string(T&& split_str, U&& delim) {
  *  @return A deep copy of @p str with all occurances of @p from changed to
  *          @p to.
  *
+ *  @throw std::regex_error if @p from is not a valid regular expression.
+ *                          Strong throw guarantee.
  *  @throw std::bad_alloc if there is insufficient memory to create the result.
  *                        Strong throw guarantee.
- *
- *  @TODO: does `regex_replace` actually throw if it can't allocate?
  */
 inline auto replace(const std::string& from, const std::string& to,
                     const std::string& str) {
-    return std::regex_replace(str, std::regex(from), to);
+    constexpr auto special_chars = ".[]^$+*?{}()\\|";
+    const bool literal_from =
+      !from.empty() && from.find_first_of(special_chars) == std::string::npos;
+    // `to` is a format string for regex_replace, '$' starts an escape sequence
+    const bool literal_to = to.find('$') == std::string::npos;
+    if(literal_from && literal_to)
+        return detail_::replace_literal(from, to, str);
+
+    auto r = RegexCache::global().get(from);
+    return std::regex_replace(str, *r, to);
 }
 
 /** @brief Lowercase the entirety of @p str.
@@ -168,4 +342,204 @@ inline std::string toupper_string(std::string str) {
     return str;
 }
 
+namespace detail_ {
+
+/// Arithmetic types other than bool (and char) can be parsed/formatted
+template<typename T>
+inline constexpr bool is_numeric_v =
+  std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+  !std::is_same_v<T, char>;
+
+/// Large enough for the shortest round-trip representation of any numeric type
+inline constexpr std::size_t max_numeric_chars = 64;
+
+/// Removes leading and trailing whitespace from @p str
+inline std::string_view trim_whitespace(std::string_view str) noexcept {
+    while(!str.empty() && is_whitespace(str.front())) str.remove_prefix(1);
+    while(!str.empty() && is_whitespace(str.back())) str.remove_suffix(1);
+    return str;
+}
+
+/// Wraps std::from_chars, requiring it to consume all of [first, last)
+template<typename T>
+T from_chars(const char* first, const char* last, std::string_view token) {
+    T value{};
+    const auto [ptr, ec] = std::from_chars(first, last, value);
+    if(ec == std::errc::result_out_of_range)
+        throw std::out_of_range("Value of '" + std::string(token) +
+                                "' is out of range");
+    if(ec != std::errc() || ptr != last)
+        throw std::invalid_argument("Unable to parse '" + std::string(token) +
+                                    "' as a number");
+    return value;
+}
+
+} // namespace detail_
+
+/** @brief Converts @p str to a number.
+ *
+ *  This is a locale-independent, allocation-free replacement for `std::stod`,
+ *  `std::stoi`, and friends (as well as for reading numbers with streams). It
+ *  is built on `std::from_chars`, and is meant for converting the tokens
+ *  returned by `split_string`, `split_view`, etc.
+ *
+ *  Unlike `std::from_chars`, leading/trailing whitespace and a leading `+`
+ *  are allowed. For floating-point types the exponent may also be introduced
+ *  with Fortran's `D` (or `d`), e.g., `1.5D-03`, which is common in quantum
+ *  chemistry files. Aside from that, @p str must be a number in its entirety
+ *  (e.g., "1.0abc" is an error, not 1.0).
+ *
+ *  @tparam T The type to parse @p str as. Must be an arithmetic type other
+ *            than `bool` or `char`.
+ *
+ *  @param[in] str The string to parse.
+ *
+ *  @return The value of @p str as a @p T.
+ *
+ *  @throw std::invalid_argument if @p str is not a number. Strong throw
+ *                               guarantee.
+ *  @throw std::out_of_range if the value of @p str can not be represented by
+ *                           a @p T. Strong throw guarantee.
+ */
+template<typename T>
+T parse(std::string_view str) {
+    static_assert(detail_::is_numeric_v<T>, "T must be a numeric type");
+
+    const auto token  = detail_::trim_whitespace(str);
+    const char* first = token.data();
+    const char* last  = first + token.size();
+    // std::from_chars doesn't accept a leading '+' (but "+-1" is still bad)
+    if(token.size() > 1 && token[0] == '+' && token[1] != '-') ++first;
+
+    if constexpr(std::is_floating_point_v<T>) {
+        const auto d = std::find_if(
+          first, last, [](char c) { return c == 'D' || c == 'd'; });
+        if(d != last) {
+            // Copy so the Fortran exponent can be turned into a C one
+            std::string_view digits(first, last - first);
+            char buffer[detail_::max_numeric_chars];
+            std::string long_buffer;
+            char* begin = buffer;
+            if(digits.size() > sizeof(buffer)) {
+                long_buffer.assign(digits);
+                begin = long_buffer.data();
+            } else {
+                std::copy(first, last, begin);
+            }
+            begin[d - first] = 'e';
+            return detail_::from_chars<T>(begin, begin + digits.size(), str);
+        }
+    }
+    return detail_::from_chars<T>(first, last, str);
+}
+
+/** @brief Parses each token in @p tokens, writing the values to @p out.
+ *
+ *  This is the batch version of `parse`, meant for converting a column of
+ *  tokens into a contiguous array, e.g.:
+ *
+ *  @code
+ *  std::vector<double> xs(n);
+ *  parse_all<double>(split_whitespace(line), xs.data());
+ *  @endcode
+ *
+ *  @tparam T The type to parse each token as.
+ *  @tparam RangeType The type of the range of tokens. Each element must be
+ *                    implicitly convertible to `std::string_view`.
+ *  @tparam OutputIterator The type of the iterator the values are written to.
+ *
+ *  @param[in] tokens The strings to parse.
+ *  @param[in] out Where to write the first value.
+ *
+ *  @return @p out advanced past the last value written.
+ *
+ *  @throw std::invalid_argument if a token is not a number. Basic throw
+ *                               guarantee, values before the bad token have
+ *                               been written.
+ *  @throw std::out_of_range if a token is out of range for @p T. Basic throw
+ *                           guarantee.
+ */
+template<typename T, typename RangeType, typename OutputIterator>
+OutputIterator parse_all(RangeType&& tokens, OutputIterator out) {
+    for(auto&& token : tokens) {
+        *out = parse<T>(token);
+        ++out;
+    }
+    return out;
+}
+
+/** @brief Parses each token in @p tokens into an std::vector.
+ *
+ *  If @p tokens has random-access iterators the result is allocated once.
+ *
+ *  @tparam T The type to parse each token as.
+ *  @tparam RangeType The type of the range of tokens.
+ *
+ *  @param[in] tokens The strings to parse.
+ *
+ *  @return An std::vector whose i-th element is the value of the i-th token.
+ *
+ *  @throw std::invalid_argument if a token is not a number. Strong throw
+ *                               guarantee.
+ *  @throw std::out_of_range if a token is out of range for @p T. Strong throw
+ *                           guarantee.
+ *  @throw std::bad_alloc if there is insufficient memory for the result.
+ *                        Strong throw guarantee.
+ */
+template<typename T, typename RangeType>
+std::vector<T> parse_all(RangeType&& tokens) {
+    std::vector<T> rv;
+    using iterator = decltype(std::begin(tokens));
+    using category = typename std::iterator_traits<iterator>::iterator_category;
+    if constexpr(std::is_base_of_v<std::random_access_iterator_tag, category>)
+        rv.reserve(std::distance(std::begin(tokens), std::end(tokens)));
+    parse_all<T>(std::forward<RangeType>(tokens), std::back_inserter(rv));
+    return rv;
+}
+
+/** @brief Writes @p value to @p out as a string.
+ *
+ *  This is the allocation-free, locale-independent counterpart to `parse`.
+ *  Values are written with `std::to_chars`, i.e., floating-point values use
+ *  the shortest representation which parses back to exactly @p value.
+ *
+ *  @tparam T The type of the value. Must be an arithmetic type other than
+ *            `bool` or `char`.
+ *  @tparam OutputIterator The type of the character iterator to write to.
+ *
+ *  @param[in] out Where to write the first character.
+ *  @param[in] value The value to write.
+ *
+ *  @return @p out advanced past the last character written.
+ *
+ *  @throw ??? Throws if writing to @p out throws. Same guarantee as @p out.
+ */
+template<typename OutputIterator, typename T>
+OutputIterator format_to(OutputIterator out, T value) {
+    static_assert(detail_::is_numeric_v<T>, "T must be a numeric type");
+    char buffer[detail_::max_numeric_chars];
+    const auto rv = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::copy(buffer, rv.ptr, out);
+}
+
+/** @brief Converts @p value to a string.
+ *
+ *  Same as `format_to`, but the result is returned as a new string. Unlike
+ *  `std::to_string`, floating-point values are not rounded to six digits
+ *  and the result does not depend on the locale.
+ *
+ *  @param[in] value The value to convert.
+ *
+ *  @return @p value as a string.
+ *
+ *  @throw std::bad_alloc if there is insufficient memory for the result.
+ *                        Strong throw guarantee.
+ */
+template<typename T>
+std::string format(T value) {
+    char buffer[detail_::max_numeric_chars];
+    const auto end = format_to(buffer, value);
+    return std::string(buffer, end);
+}
+
 } // namespace utilities::strings
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+namespace utilities::strings {
+namespace detail_ {
+
+/// Code point ranges (inclusive) which take up no columns (combining marks)
+inline constexpr char32_t zero_width_ranges[][2] = {
+  {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x0610, 0x061A},
+  {0x064B, 0x065F}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A}, {0x1AB0, 0x1AFF},
+  {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064},
+  {0x20D0, 0x20FF}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF}};
+
+/// Code point ranges (inclusive) which take up two columns (East Asian wide)
+inline constexpr char32_t wide_ranges[][2] = {
+  {0x1100, 0x115F},   {0x2E80, 0x303E},   {0x3041, 0x33FF},
+  {0x3400, 0x4DBF},   {0x4E00, 0x9FFF},   {0xA000, 0xA4CF},
+  {0xAC00, 0xD7A3},   {0xF900, 0xFAFF},   {0xFE30, 0xFE4F},
+  {0xFF00, 0xFF60},   {0xFFE0, 0xFFE6},   {0x1F300, 0x1F64F},
+  {0x1F900, 0x1F9FF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD}};
+
+/// Is @p cp in one of @p ranges?
+template<std::size_t N>
+constexpr bool in_ranges(char32_t cp, const char32_t (&ranges)[N][2]) noexcept {
+    for(const auto& r : ranges)
+        if(cp >= r[0] && cp <= r[1]) return true;
+    return false;
+}
+
+} // namespace detail_
+
+/** @brief The number of columns @p cp takes up when displayed.
+ *
+ *  This is a lightweight version of POSIX's `wcwidth`. Control characters
+ *  and combining marks take up zero columns, East Asian wide characters (and
+ *  emoji) take up two columns, and everything else takes up one column.
+ *
+ *  @param[in] cp The Unicode code point of interest.
+ *
+ *  @return The number of columns @p cp takes up (0, 1, or 2).
+ *
+ *  @throw None No throw guarantee.
+ */
+constexpr std::size_t code_point_width(char32_t cp) noexcept {
+    if(cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if(cp < 0x0300) return 1;
+    if(detail_::in_ranges(cp, detail_::zero_width_ranges)) return 0;
+    if(detail_::in_ranges(cp, detail_::wide_ranges)) return 2;
+    return 1;
+}
+
+/** @brief Decodes UTF-8 one byte at a time.
+ *
+ *  Utf8Decoder is meant for decoding text which arrives in pieces, e.g.,
+ *  through a stream buffer, where a multi-byte character may be split across
+ *  two writes. The decoder only stores the partially decoded character, so it
+ *  never allocates.
+ *
+ *  Malformed input (stray continuation bytes, truncated or overlong
+ *  sequences, surrogates, etc.) decodes to U+FFFD, the replacement character.
+ */
+class Utf8Decoder {
+public:
+    /// What malformed input decodes to
+    static constexpr char32_t replacement = 0xFFFD;
+
+    /** @brief Adds @p byte to the text being decoded.
+     *
+     *  Most bytes complete zero or one characters. A byte which interrupts a
+     *  multi-byte sequence completes two: the replacement character for the
+     *  truncated sequence, and then (if @p byte is ASCII) @p byte itself.
+     *
+     *  @param[in] byte The next byte of the text.
+     *  @param[out] out Where the completed characters are written. Must have
+     *                  room for two characters.
+     *
+     *  @return The number of characters written to @p out (0, 1, or 2).
+     *
+     *  @throw None No throw guarantee.
+     */
+    std::size_t push(char byte, char32_t* out) noexcept {
+        const auto b  = static_cast<unsigned char>(byte);
+        std::size_t n = 0;
+        if(m_need_ > 0) {
+            if((b & 0xC0) == 0x80) {
+                m_cp_ = (m_cp_ << 6) | (b & 0x3F);
+                if(--m_need_ > 0) return 0;
+                out[0] = is_valid_() ? m_cp_ : replacement;
+                return 1;
+            }
+            out[n++] = replacement;
+            m_need_  = 0;
+        }
+
+        if(b < 0x80) {
+            out[n++] = b;
+        } else if((b & 0xE0) == 0xC0) {
+            start_(b & 0x1F, 1);
+        } else if((b & 0xF0) == 0xE0) {
+            start_(b & 0x0F, 2);
+        } else if((b & 0xF8) == 0xF0) {
+            start_(b & 0x07, 3);
+        } else { // Continuation byte without a lead byte, or invalid lead byte
+            out[n++] = replacement;
+        }
+        return n;
+    }
+
+    /// Is the decoder in the middle of a multi-byte character?
+    bool pending() const noexcept { return m_need_ > 0; }
+
+    /// Discards the partially decoded character (if any)
+    void reset() noexcept { m_need_ = 0; }
+
+private:
+    /// Begins a character with @p need continuation bytes
+    void start_(char32_t bits, unsigned need) noexcept {
+        m_cp_   = bits;
+        m_need_ = need;
+        m_size_ = need + 1;
+    }
+
+    /// Was the character encoded in the fewest bytes, and is it a character?
+    bool is_valid_() const noexcept {
+        constexpr char32_t min_cp[] = {0, 0, 0x80, 0x800, 0x10000};
+        if(m_cp_ < min_cp[m_size_] || m_cp_ > 0x10FFFF) return false;
+        return m_cp_ < 0xD800 || m_cp_ > 0xDFFF;
+    }
+
+    /// The bits of the character decoded so far
+    char32_t m_cp_ = 0;
+
+    /// How many continuation bytes we are waiting on
+    unsigned m_need_ = 0;
+
+    /// How many bytes the current character is encoded in
+    unsigned m_size_ = 0;
+};
+
+/** @brief The number of columns @p str takes up when displayed.
+ *
+ *  @p str is assumed to be UTF-8 (and hence may simply be ASCII). Each
+ *  character contributes `code_point_width` columns. Strings which are pure
+ *  ASCII are handled without decoding.
+ *
+ *  @param[in] str The string of interest.
+ *
+ *  @return The display width of @p str.
+ *
+ *  @throw None No throw guarantee.
+ */
+inline std::size_t display_width(std::string_view str) noexcept {
+    std::size_t i = 0;
+    std::size_t w = 0;
+    // ASCII fast path
+    for(; i < str.size(); ++i) {
+        const auto c = static_cast<unsigned char>(str[i]);
+        if(c >= 0x80) break;
+        w += (c >= 0x20 && c != 0x7F);
+    }
+
+    Utf8Decoder decoder;
+    char32_t cps[2];
+    for(; i < str.size(); ++i) {
+        const auto n = decoder.push(str[i], cps);
+        for(std::size_t j = 0; j < n; ++j) w += code_point_width(cps[j]);
+    }
+    if(decoder.pending()) w += code_point_width(Utf8Decoder::replacement);
+    return w;
+}
+
+} // namespace utilities::strings
@@ -15,8 +15,11 @@
  */
 
 #include "utilities/printing/demangler.hpp"
+#include <cctype>
 #include <memory>
-#include <regex>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 
 #if __has_include(<cxxabi.h>)
 #include <cxxabi.h>
@@ -25,10 +28,27 @@
 namespace utilities::printing {
 
 // Removes all whitespace characters that are immediately
-// before a closing angle bracket in a string.
+// before a closing angle bracket in a string. This is equivalent to
+// regex_replace-ing "\\s+(?=\\>)" with "", but done in a single pass.
 std::string remove_spaces(const std::string& str) {
-    static const std::regex r("\\s+(?=\\>)");
-    return std::regex_replace(str, r, "");
+    auto is_space = [](char c) { return std::isspace((unsigned char)c) != 0; };
+
+    std::string rv;
+    rv.reserve(str.size());
+    const auto n = str.size();
+    for(std::size_t i = 0; i < n;) {
+        if(!is_space(str[i])) {
+            rv += str[i++];
+            continue;
+        }
+        // Find the end of this run of whitespace
+        auto j = i;
+        while(j < n && is_space(str[j])) ++j;
+        // Keep the run unless it's followed by a '>'
+        if(j == n || str[j] != '>') rv.append(str, i, j - i);
+        i = j;
+    }
+    return rv;
 }
 
 std::string Demangler::demangle(const char* t) {
@@ -45,4 +65,22 @@ std::string Demangler::demangle(const char* t) {
 #endif
 }
 
+std::string_view Demangler::demangle_cached(const std::type_index& t) {
+    // Node-based, so rehashing never moves the strings we hand out views of
+    static std::unordered_map<std::type_index, std::string> cache;
+    static std::shared_mutex mutex;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto itr = cache.find(t);
+        if(itr != cache.end()) return itr->second;
+    }
+
+    // Demangle without holding the lock; if another thread beat us to it the
+    // name it stored wins
+    auto name = demangle(t);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return cache.try_emplace(t, std::move(name)).first->second;
+}
+
 } // namespace utilities::printing
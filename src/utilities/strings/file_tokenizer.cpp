@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/strings/file_tokenizer.hpp"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define UTILITIES_HAS_MMAP
+#else
+#include <fstream>
+#endif
+
+namespace utilities::strings {
+namespace {
+
+[[noreturn]] void throw_error(const std::string& what, const std::string& path,
+                              int err) {
+    std::string msg = what + " '" + path + "': " + std::strerror(err);
+    throw std::runtime_error(msg);
+}
+
+} // namespace
+
+#ifdef UTILITIES_HAS_MMAP
+
+FileTokenizer::FileTokenizer(const std::string& path, bool sequential) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd == -1) throw_error("Unable to open", path, errno);
+
+    struct stat info;
+    if(::fstat(fd, &info) == -1) {
+        const auto err = errno;
+        ::close(fd);
+        throw_error("Unable to stat", path, err);
+    }
+
+    // mmap-ing zero bytes is an error, so empty files are never mapped
+    const auto size = static_cast<size_type>(info.st_size);
+    if(size > 0) {
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED) {
+            const auto err = errno;
+            ::close(fd);
+            throw_error("Unable to map", path, err);
+        }
+        m_data_ = static_cast<const char*>(p);
+        m_size_ = size;
+    }
+
+    // The mapping keeps the file alive, we no longer need the descriptor
+    ::close(fd);
+
+    if(sequential) advise_sequential();
+}
+
+void FileTokenizer::advise_sequential() noexcept {
+    if(m_data_ == nullptr) return;
+    ::madvise(const_cast<char*>(m_data_), m_size_, MADV_SEQUENTIAL);
+}
+
+void FileTokenizer::unmap_() noexcept {
+    if(m_data_ != nullptr) ::munmap(const_cast<char*>(m_data_), m_size_);
+    m_data_ = nullptr;
+    m_size_ = 0;
+}
+
+#else // No mmap, fall back to reading the file into a buffer
+
+FileTokenizer::FileTokenizer(const std::string& path, bool) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file) throw_error("Unable to open", path, errno);
+    const auto size = static_cast<size_type>(file.tellg());
+    file.seekg(0);
+    m_buffer_ = std::make_unique<char[]>(size);
+    if(!file.read(m_buffer_.get(), size))
+        throw_error("Unable to read", path, errno);
+    m_data_ = m_buffer_.get();
+    m_size_ = size;
+}
+
+void FileTokenizer::advise_sequential() noexcept {}
+
+void FileTokenizer::unmap_() noexcept {
+    m_buffer_.reset();
+    m_data_ = nullptr;
+    m_size_ = 0;
+}
+
+#endif
+
+FileTokenizer::~FileTokenizer() noexcept { unmap_(); }
+
+FileTokenizer::FileTokenizer(FileTokenizer&& other) noexcept :
+  m_data_(std::exchange(other.m_data_, nullptr)),
+  m_size_(std::exchange(other.m_size_, 0)),
+  m_buffer_(std::move(other.m_buffer_)) {}
+
+FileTokenizer& FileTokenizer::operator=(FileTokenizer&& rhs) noexcept {
+    if(this == &rhs) return *this;
+    unmap_();
+    m_data_   = std::exchange(rhs.m_data_, nullptr);
+    m_size_   = std::exchange(rhs.m_size_, 0);
+    m_buffer_ = std::move(rhs.m_buffer_);
+    return *this;
+}
+
+} // namespace utilities::strings
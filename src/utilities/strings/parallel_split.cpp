@@ -0,0 +1,127 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/strings/parallel_split.hpp"
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+namespace utilities::strings {
+namespace {
+
+using view_type   = std::string_view;
+using result_type = std::vector<view_type>;
+
+// Can two occurrences of delim overlap? (i.e., does it have a border)
+bool overlaps_itself(view_type delim) {
+    const auto n = delim.size();
+    for(std::size_t k = 1; k < n; ++k)
+        if(delim.substr(0, k) == delim.substr(n - k)) return true;
+    return false;
+}
+
+// Appends the substrings of chunk to out. Unless chunk is the last chunk it
+// ends with a delimiter, and the (empty) piece after that delimiter belongs to
+// the next chunk.
+void split_chunk(view_type chunk, view_type delim, bool is_last,
+                 result_type& out) {
+    std::size_t prev = 0;
+    std::size_t pos  = 0;
+    while((pos = chunk.find(delim, prev)) != view_type::npos) {
+        out.push_back(chunk.substr(prev, pos - prev));
+        prev = pos + delim.size();
+    }
+    if(is_last) out.push_back(chunk.substr(prev));
+}
+
+// Calls fxn(i) for i in [0, n) with each call on its own thread
+template<typename FxnType>
+void run_in_parallel(std::size_t n, FxnType&& fxn) {
+    std::vector<std::exception_ptr> errors(n);
+    auto wrapped = [&](std::size_t i) {
+        try {
+            fxn(i);
+        } catch(...) { errors[i] = std::current_exception(); }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    try {
+        for(std::size_t i = 1; i < n; ++i) threads.emplace_back(wrapped, i);
+    } catch(...) {
+        for(auto& t : threads) t.join();
+        throw;
+    }
+    wrapped(0);
+    for(auto& t : threads) t.join();
+
+    for(auto& e : errors)
+        if(e) std::rethrow_exception(e);
+}
+
+} // namespace
+
+result_type parallel_split_string(view_type str, view_type delim,
+                                  std::size_t nthreads,
+                                  std::size_t min_chunk_size) {
+    result_type rv;
+    if(str.empty()) return rv;
+
+    if(nthreads == 0) nthreads = std::thread::hardware_concurrency();
+    min_chunk_size        = std::max<std::size_t>(min_chunk_size, 1);
+    const auto max_chunks = str.size() / min_chunk_size;
+    nthreads = std::min(nthreads, std::max<std::size_t>(max_chunks, 1));
+
+    if(delim.empty()) {
+        rv.push_back(str);
+        return rv;
+    }
+    if(nthreads <= 1 || overlaps_itself(delim)) {
+        split_chunk(str, delim, true, rv);
+        return rv;
+    }
+
+    // Work out the chunk boundaries, each (but the last) ends on a delimiter
+    std::vector<std::size_t> bounds{0};
+    const auto nominal_size = str.size() / nthreads;
+    for(std::size_t i = 1; i < nthreads; ++i) {
+        const auto start = std::max(i * nominal_size, bounds.back());
+        const auto pos   = str.find(delim, start);
+        if(pos == view_type::npos) break;
+        bounds.push_back(pos + delim.size());
+    }
+    bounds.push_back(str.size());
+    const auto nchunks = bounds.size() - 1;
+
+    // Split the chunks
+    std::vector<result_type> parts(nchunks);
+    run_in_parallel(nchunks, [&](std::size_t i) {
+        auto chunk = str.substr(bounds[i], bounds[i + 1] - bounds[i]);
+        split_chunk(chunk, delim, i + 1 == nchunks, parts[i]);
+    });
+
+    // Gather the results, in order
+    std::vector<std::size_t> offsets(nchunks + 1, 0);
+    for(std::size_t i = 0; i < nchunks; ++i)
+        offsets[i + 1] = offsets[i] + parts[i].size();
+    rv.resize(offsets.back());
+    run_in_parallel(nchunks, [&](std::size_t i) {
+        std::copy(parts[i].begin(), parts[i].end(), rv.begin() + offsets[i]);
+    });
+    return rv;
+}
+
+} // namespace utilities::strings
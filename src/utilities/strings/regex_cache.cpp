@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/strings/regex_cache.hpp"
+
+namespace utilities::strings {
+
+using const_regex_pointer = typename RegexCache::const_regex_pointer;
+using size_type           = typename RegexCache::size_type;
+
+const_regex_pointer RegexCache::get(const pattern_type& pattern) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex_);
+        auto itr = m_index_.find(pattern);
+        if(itr != m_index_.end()) {
+            ++m_hits_;
+            // Move the entry to the front w/o invalidating any iterators
+            m_lru_.splice(m_lru_.begin(), m_lru_, itr->second);
+            return itr->second->second;
+        }
+    }
+
+    // Compiling is the expensive part, don't hold the lock while doing it
+    ++m_misses_;
+    auto p = std::make_shared<const regex_type>(pattern);
+
+    std::lock_guard<std::mutex> lock(m_mutex_);
+    if(m_max_size_ == 0) return p;
+
+    // Another thread may have beaten us to it, if so defer to its copy
+    auto itr = m_index_.find(pattern);
+    if(itr != m_index_.end()) {
+        m_lru_.splice(m_lru_.begin(), m_lru_, itr->second);
+        return itr->second->second;
+    }
+
+    m_lru_.emplace_front(pattern, p);
+    try {
+        m_index_.emplace(pattern, m_lru_.begin());
+    } catch(...) {
+        m_lru_.pop_front();
+        throw;
+    }
+    trim_();
+    return p;
+}
+
+size_type RegexCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex_);
+    return m_lru_.size();
+}
+
+void RegexCache::set_max_size(size_type max_size) {
+    std::lock_guard<std::mutex> lock(m_mutex_);
+    m_max_size_ = max_size;
+    trim_();
+}
+
+void RegexCache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex_);
+    m_index_.clear();
+    m_lru_.clear();
+    m_hits_   = 0;
+    m_misses_ = 0;
+}
+
+RegexCache& RegexCache::global() noexcept {
+    static RegexCache cache;
+    return cache;
+}
+
+void RegexCache::trim_() noexcept {
+    while(m_lru_.size() > m_max_size_) {
+        m_index_.erase(m_lru_.back().first);
+        m_lru_.pop_back();
+    }
+}
+
+} // namespace utilities::strings
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * The leaves are matrices and the model counts the flops and bytes of naive
+ * matrix arithmetic, so the estimates can be worked out by hand. A (10x100),
+ * B (100x5), C (5x50), and D (10x50) make (A * B) * C + D.
+ *
+ * Calibration is tested with made-up times which are exact multiples of the
+ * estimates. The Timer overload is only tested for picking out the nodes.
+ */
+
+namespace {
+
+using test_utilities::Matrix;
+using test_utilities::Shape;
+
+using evaluator_type = Evaluator<Matrix, test_utilities::MatrixKernels>;
+using dag_type       = evaluator_type::DAG;
+using size_type      = dag_type::size_type;
+
+struct CostModel {
+    Shape shape(const dag_type& dag, size_type i) {
+        const auto* m = dag.leaf_as<Matrix>(i);
+        if(m == nullptr) throw std::runtime_error("Not a matrix");
+        return {double(m->rows), double(m->cols)};
+    }
+
+    Shape result(const dag_type& dag, size_type i,
+                 const std::vector<Shape>& args) {
+        if(dag.kind(i) == NodeKind::multiply)
+            return {args[0].rows, args[1].cols};
+        return args[0];
+    }
+
+    CostEstimate estimate(const dag_type& dag, size_type i,
+                          const std::vector<Shape>& args, const Shape& out) {
+        switch(dag.kind(i)) {
+            case NodeKind::leaf: return {0.0, out.size(), out.size()};
+            case NodeKind::multiply: {
+                const auto flops = 2.0 * out.rows * args[0].cols * out.cols;
+                const auto bytes = args[0].size() + args[1].size() + out.size();
+                return {flops, bytes, out.size()};
+            }
+            default: {
+                const auto bytes = args[0].size() + args[1].size() + out.size();
+                return {out.rows * out.cols, bytes, out.size()};
+            }
+        }
+    }
+};
+
+/// The part of CostModel reorder_multiply_chains needs
+struct ChainModel {
+    CostModel& model;
+    Shape shape(const dag_type& dag, size_type i) {
+        return model.shape(dag, i);
+    }
+    double cost(const Shape& l, const Shape& r) {
+        return l.rows * l.cols * r.cols;
+    }
+    Shape multiply(const Shape& l, const Shape& r) { return {l.rows, r.cols}; }
+};
+
+} // namespace
+
+TEST_CASE("estimate_cost") {
+    Matrix A(10, 100), B(100, 5), C(5, 50), D(10, 50);
+    using AB_type  = Multiply<Matrix, Matrix>;
+    using ABC_type = Multiply<AB_type, Matrix>;
+    Add<ABC_type, Matrix> expr(ABC_type(AB_type(A, B), C), D);
+
+    evaluator_type e;
+    CostModel model;
+
+    SECTION("Estimates") {
+        auto dag    = e.make_dag(expr);
+        auto report = estimate_cost(dag, model);
+        REQUIRE(report.nodes.size() == dag.size());
+
+        // Flops: 2*10*100*5 + 2*10*5*50 + 10*50
+        REQUIRE(report.total.flops == 15500.0);
+
+        // Bytes: the leaves are copied (2250 elements), A*B reads A and B
+        // and writes 50 elements, (A*B)*C reads 50 + 250 and writes 500,
+        // and the sum reads and writes 500 each
+        REQUIRE(report.total.bytes == 8.0 * (2250 + 1550 + 800 + 1500));
+        REQUIRE(report.total.memory == 8.0 * (2250 + 50 + 500 + 500));
+
+        // The most is live once A*B is made and before A and B are released
+        REQUIRE(report.peak_memory == 8.0 * (1000 + 500 + 50));
+
+        const auto root = report.nodes[dag.root()];
+        REQUIRE(root == CostEstimate{500.0, 8.0 * 1500, 8.0 * 500});
+        REQUIRE(root != CostEstimate{});
+
+        // The flops are usable as the costs of evaluate_parallel
+        auto costs = report.flops();
+        REQUIRE(costs.size() == dag.size());
+        REQUIRE(costs.back() == 500.0);
+        ParallelOptions options;
+        options.costs = costs;
+        REQUIRE(e.evaluate_parallel(dag, options) == e.evaluate(expr));
+    }
+
+    SECTION("Common subexpressions are counted once") {
+        Add<AB_type, AB_type> sum(AB_type(A, B), AB_type(A, B));
+        auto report = estimate_cost(e.make_dag(sum), model);
+        REQUIRE(report.total.flops == 10000.0 + 50.0);
+    }
+
+    SECTION("Reordering makes it cheaper") {
+        Multiply<Matrix, AB_type> expr2(A, AB_type(B, C));
+        auto dag          = e.make_dag(expr2);
+        const auto before = estimate_cost(dag, model).total.flops;
+        ChainModel chain{model};
+        REQUIRE(reorder_multiply_chains(dag, chain));
+        REQUIRE(estimate_cost(dag, model).total.flops < before);
+    }
+
+    SECTION("Timings of the evaluation") {
+        auto dag    = e.make_dag(expr);
+        auto report = estimate_cost(dag, model);
+        utilities::Timer timer;
+        e.evaluate(dag, timer);
+
+        auto fit = calibrate(report, timer);
+        REQUIRE(fit.seconds_per_flop >= 0.0);
+        REQUIRE(fit.seconds_per_byte >= 0.0);
+        for(std::size_t i = 0; i < dag.size(); ++i) {
+            REQUIRE(fit.timed[i]);
+            REQUIRE(fit.predicted[i] == fit.predict(report.nodes[i]));
+        }
+        REQUIRE(fit.mispredicted().size() == dag.size());
+    }
+}
+
+TEST_CASE("calibrate") {
+    using times_type = std::map<std::size_t, double>;
+    CostReport report;
+
+    SECTION("Flops only") {
+        report.nodes = {{1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+        times_type times{{0, 0.020}, {1, 0.040}, {2, 0.050}, {3, 0.005}};
+
+        auto fit = calibrate(report, times);
+        REQUIRE(fit.seconds_per_flop == Catch::Approx(0.020));
+        REQUIRE(fit.seconds_per_byte == 0.0);
+        REQUIRE(fit.measured[2] == 0.050);
+
+        // Node 2 was predicted to be free
+        REQUIRE(fit.predicted[2] == 0.0);
+        REQUIRE(fit.mispredicted().front() == 2);
+    }
+
+    SECTION("Flops and bytes") {
+        report.nodes = {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {1.0, 1.0, 0.0}};
+        times_type times{{0, 0.020}, {1, 0.030}, {2, 0.050}};
+
+        auto fit = calibrate(report, times);
+        REQUIRE(fit.seconds_per_flop == Catch::Approx(0.020));
+        REQUIRE(fit.seconds_per_byte == Catch::Approx(0.030));
+    }
+
+    SECTION("Untimed nodes") {
+        report.nodes = {{1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}};
+        auto fit     = calibrate(report, times_type{{1, 0.020}});
+        REQUIRE_FALSE(fit.timed[0]);
+        REQUIRE(fit.timed[1]);
+        REQUIRE(fit.seconds_per_flop == Catch::Approx(0.010));
+        REQUIRE(fit.mispredicted() == std::vector<std::size_t>{1});
+    }
+
+    SECTION("Timer") {
+        report.nodes = {{1.0, 0.0, 0.0}, {2.0, 0.0, 0.0}};
+        utilities::Timer timer;
+        for(auto key : {"node 1", "node 2", "node 1x", "other"})
+            timer.time_it(key, []() {});
+
+        // Only "node 1" is a node of the DAG
+        auto fit = calibrate(report, timer);
+        REQUIRE_FALSE(fit.timed[0]);
+        REQUIRE(fit.timed[1]);
+        using seconds_type = std::chrono::duration<double>;
+        auto dt            = timer.at(dag_timer_key(1));
+        REQUIRE(fit.measured[1] == seconds_type(dt).count());
+    }
+}
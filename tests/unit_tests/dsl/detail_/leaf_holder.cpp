@@ -241,6 +241,27 @@ TEMPLATE_LIST_TEST_CASE("QualifiedLeafHolder", "", types_to_test) {
         REQUIRE(wrap_crref.template contains_type<const type>());
     }
 
+    SECTION("type_id") {
+        const auto id = detail_::type_id<type>();
+        REQUIRE(wrap_value.type_id() == id);
+        REQUIRE(wrap_cvalue.type_id() == id);
+        REQUIRE(wrap_ref.type_id() == id);
+        REQUIRE(wrap_cref.type_id() == id);
+        REQUIRE(wrap_rref.type_id() == id);
+        REQUIRE(wrap_crref.type_id() == id);
+        REQUIRE(id != detail_::type_id<int>());
+        REQUIRE(id != detail_::type_id<const type*>());
+    }
+
+    SECTION("holds_const") {
+        REQUIRE_FALSE(wrap_value.holds_const());
+        REQUIRE(wrap_cvalue.holds_const());
+        REQUIRE_FALSE(wrap_ref.holds_const());
+        REQUIRE(wrap_cref.holds_const());
+        REQUIRE_FALSE(wrap_rref.holds_const());
+        REQUIRE(wrap_crref.holds_const());
+    }
+
     SECTION("is_convertible") {
         REQUIRE(wrap_value.template is_convertible<type>());
         REQUIRE(wrap_value.template is_convertible<const type>());
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <stdexcept>
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * The kernels implement scalar arithmetic and count the multiplications, so
+ * we can check what is recomputed. The leaves are ints (which the DSL
+ * aliases) and the expression is (a*b) + (c*d), so there are three
+ * operations which can be cached.
+ */
+
+namespace {
+
+struct Kernels : test_utilities::ScalarKernels {
+    void multiply(double& out, double l, double r) {
+        if(fail) throw std::runtime_error("Multiplication failed");
+        out = l * r, ++n_multiplies;
+    }
+    std::size_t n_multiplies = 0;
+    bool fail                = false;
+};
+
+using evaluator_type = Evaluator<double, Kernels>;
+using cache_type     = EvaluationCache<evaluator_type>;
+
+} // namespace
+
+TEST_CASE("EvaluationCache") {
+    int a = 1, b = 2, c = 3, d = 4;
+    using mult_type = Multiply<int, int>;
+    Add<mult_type, mult_type> expr(mult_type(a, b), mult_type(c, d));
+
+    evaluator_type e;
+    auto& n_multiplies = e.kernels().n_multiplies;
+
+    SECTION("Only recomputes what changed") {
+        cache_type cache;
+        REQUIRE(cache.evaluate(e, expr) == 14.0);
+        REQUIRE(cache.size() == 3);
+        REQUIRE(cache.misses() == 3);
+        REQUIRE(cache.hits() == 0);
+        REQUIRE(cache.memory_usage() == 3 * sizeof(double));
+        REQUIRE(n_multiplies == 2);
+
+        // Nothing changed, the root is found and nothing else is looked at
+        REQUIRE(cache.evaluate(e, expr) == 14.0);
+        REQUIRE(cache.hits() == 1);
+        REQUIRE(n_multiplies == 2);
+
+        // Only a*b and the sum depend on a
+        a = 5;
+        cache.mark_changed(a);
+        REQUIRE(cache.evaluate(e, expr) == 22.0);
+        REQUIRE(cache.hits() == 2);
+        REQUIRE(cache.misses() == 5);
+        REQUIRE(n_multiplies == 3);
+
+        // Changes the cache isn't told about are not seen
+        a = 6;
+        REQUIRE(cache.evaluate(e, expr) == 22.0);
+
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.memory_usage() == 0);
+        REQUIRE(cache.evaluate(e, expr) == 24.0);
+    }
+
+    SECTION("Literals are part of the key") {
+        cache_type cache;
+        using scale_type = Multiply<int, double>;
+        REQUIRE(cache.evaluate(e, scale_type(a, 2.0)) == 2.0);
+        REQUIRE(cache.evaluate(e, scale_type(a, 3.0)) == 3.0);
+        REQUIRE(cache.misses() == 2);
+    }
+
+    SECTION("Aliased literals are leaves") {
+        cache_type cache;
+        double alpha = 1.0;
+        Multiply<double, int> scaled(alpha, c);
+        auto dag = e.make_dag(scaled);
+        REQUIRE(cache.evaluate(e, dag) == 3.0);
+
+        alpha = 2.0;
+        cache.mark_changed(alpha);
+        REQUIRE(cache.evaluate(e, dag) == 6.0);
+        REQUIRE(cache.misses() == 2);
+        REQUIRE(n_multiplies == 2);
+    }
+
+    SECTION("Leaves") {
+        cache_type cache;
+        REQUIRE(cache.evaluate(e, a) == 1.0);
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("Memory budget") {
+        // Each value counts as 1, so only two fit
+        cache_type cache(2, [](const double&) { return std::size_t{1}; });
+        REQUIRE(cache.evaluate(e, expr) == 14.0);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.memory_usage() == 2);
+
+        // a*b was the least recently used, so it was evicted
+        a = 5;
+        cache.mark_changed(a);
+        REQUIRE(cache.evaluate(e, expr) == 22.0);
+        REQUIRE(cache.hits() == 1); // c*d
+        REQUIRE(cache.size() == 2);
+
+        // The result is kept even if it alone is over the budget
+        cache_type tiny(1, [](const double&) { return std::size_t{2}; });
+        REQUIRE(tiny.evaluate(e, expr) == 22.0);
+        REQUIRE(tiny.size() == 1);
+    }
+
+    SECTION("Kernel throws") {
+        cache_type cache;
+        e.kernels().fail = true;
+        REQUIRE_THROWS_AS(cache.evaluate(e, expr), std::runtime_error);
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.memory_usage() == 0);
+
+        e.kernels().fail = false;
+        REQUIRE(cache.evaluate(e, expr) == 14.0);
+        REQUIRE(cache.size() == 3);
+    }
+}
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+using test_utilities::Max;
+using test_utilities::ScalarKernels;
+
+/* Testing strategy.
+ *
+ * The Evaluator only walks the tree and calls kernels, so we test it with
+ * kernels which implement scalar arithmetic. The kernels count how many times
+ * they are called so we can check that the in-place kernels are preferred
+ * when they exist. Non-commutative operations are used to make sure the
+ * operands are passed in the correct order.
+ */
+
+namespace {
+
+struct InPlaceKernels : ScalarKernels {
+    void add_assign(double& l, double r) { l += r, ++n_in_place; }
+    void subtract_assign(double& l, double r) { l -= r, ++n_in_place; }
+    void multiply_assign(double& l, double r) { l *= r, ++n_in_place; }
+    void divide_assign(double& l, double r) { l /= r, ++n_in_place; }
+    std::size_t n_in_place = 0;
+};
+
+struct VectorKernels {
+    using vector_type = std::vector<int>;
+    void leaf(vector_type& out, const vector_type& value) { out = value; }
+    void add_assign(vector_type& l, const vector_type& r) {
+        for(std::size_t i = 0; i < l.size(); ++i) l[i] += r[i];
+    }
+};
+
+} // namespace
+
+TEST_CASE("node_kind_v") {
+    STATIC_REQUIRE(node_kind_v<double> == NodeKind::leaf);
+    STATIC_REQUIRE(node_kind_v<Add<double, int>> == NodeKind::add);
+    STATIC_REQUIRE(node_kind_v<const Subtract<double, int>> ==
+                   NodeKind::subtract);
+    STATIC_REQUIRE(node_kind_v<Multiply<double, int>> == NodeKind::multiply);
+    STATIC_REQUIRE(node_kind_v<Divide<double, int>> == NodeKind::divide);
+    STATIC_REQUIRE(node_kind_v<FunctionCall<Max, double>> ==
+                   NodeKind::function_call);
+}
+
+TEST_CASE("Evaluator") {
+    using sub_type  = Subtract<double, double>;
+    using div_type  = Divide<double, double>;
+    using mult_type = Multiply<sub_type, div_type>;
+    using add_type  = Add<mult_type, int>;
+
+    // (8 - 2) * (9 / 3) + 4 = 22
+    int four = 4;
+    add_type expr(mult_type(sub_type(8.0, 2.0), div_type(9.0, 3.0)), four);
+
+    SECTION("Leaf") {
+        Evaluator<double, ScalarKernels> e;
+        REQUIRE(e.evaluate(1.5) == 1.5);
+        REQUIRE(e.evaluate(four) == 4.0);
+        REQUIRE(e.buffer_count() == 1);
+    }
+
+    SECTION("Out-of-place kernels") {
+        Evaluator<double, ScalarKernels> e;
+        REQUIRE(e.evaluate(sub_type(8.0, 2.0)) == 6.0);
+        REQUIRE(e.evaluate(div_type(9.0, 3.0)) == 3.0);
+        REQUIRE(e.evaluate(expr) == 22.0);
+
+        // Buffers are reused, so re-evaluating doesn't make more
+        const auto n = e.buffer_count();
+        REQUIRE(e.evaluate(expr) == 22.0);
+        REQUIRE(e.buffer_count() == n);
+    }
+
+    SECTION("In-place kernels") {
+        Evaluator<double, InPlaceKernels> e;
+        REQUIRE(e.evaluate(expr) == 22.0);
+        REQUIRE(e.kernels().n_in_place == 4);
+
+        // No temporaries, so only the leaves need buffers (and only as many
+        // as are alive at once)
+        Evaluator<double, ScalarKernels> out_of_place;
+        out_of_place.evaluate(expr);
+        REQUIRE(e.buffer_count() < out_of_place.buffer_count());
+    }
+
+    SECTION("Function calls") {
+        Max max;
+        using call_type = FunctionCall<Max, sub_type, double, div_type>;
+        call_type call(max, sub_type(8.0, 2.0), 1.0, div_type(9.0, 3.0));
+        Evaluator<double, ScalarKernels> e;
+        REQUIRE(e.evaluate(call) == 6.0);
+
+        // Function calls can be nested in other nodes
+        Add<call_type, double> sum(call, 1.0);
+        REQUIRE(e.evaluate(sum) == 7.0);
+    }
+
+    SECTION("Non-scalar results") {
+        using vector_type = std::vector<int>;
+        vector_type a{1, 2, 3}, b{10, 20, 30};
+        Add<Add<vector_type, vector_type>, vector_type> sum(
+          Add<vector_type, vector_type>(a, b), a);
+
+        Evaluator<vector_type, VectorKernels> e;
+        REQUIRE(e.evaluate(sum) == vector_type{12, 24, 36});
+        REQUIRE(e.buffer_count() == 2);
+    }
+
+    SECTION("N-ary operations") {
+        struct FusedKernels : InPlaceKernels {
+            using InPlaceKernels::add;
+            void add(double& out, const std::vector<const double*>& args) {
+                out = 0.0;
+                for(auto x : args) out += *x;
+                ++n_fused;
+            }
+            std::size_t n_fused = 0;
+        };
+
+        // (8 - 2) + (9 / 3) + 4 + 0.5 = 13.5
+        auto sum4 = sum(sub_type(8.0, 2.0), div_type(9.0, 3.0), four, 0.5);
+
+        Evaluator<double, ScalarKernels> binary;
+        REQUIRE(binary.evaluate(sum4) == 13.5);
+
+        // The first operand is accumulated into
+        Evaluator<double, InPlaceKernels> in_place;
+        REQUIRE(in_place.evaluate(sum4) == 13.5);
+        REQUIRE(in_place.kernels().n_in_place == 5);
+
+        // One call does the whole sum
+        Evaluator<double, FusedKernels> fused;
+        REQUIRE(fused.evaluate(sum4) == 13.5);
+        REQUIRE(fused.kernels().n_fused == 1);
+        REQUIRE(fused.kernels().n_in_place == 2);
+        const auto n = fused.buffer_count();
+        REQUIRE(fused.evaluate(sum4) == 13.5);
+        REQUIRE(fused.buffer_count() == n);
+
+        // Same for the DAG
+        auto dag = fused.make_dag(sum4);
+        REQUIRE(dag.n_children(dag.root()) == 4);
+        REQUIRE(fused.evaluate(dag) == 13.5);
+        REQUIRE(fused.kernels().n_fused == 3);
+        REQUIRE(in_place.evaluate(in_place.make_dag(sum4)) == 13.5);
+        REQUIRE(binary.evaluate(binary.make_dag(sum4)) == 13.5);
+
+        // Products work the same way
+        REQUIRE(binary.evaluate(product(2.0, four, 0.5)) == 4.0);
+        REQUIRE(in_place.evaluate(product(2.0, four, 0.5)) == 4.0);
+    }
+
+    SECTION("Usable after a kernel throws") {
+        struct ThrowingKernels : ScalarKernels {
+            void divide(double& out, double l, double r) {
+                if(r == 0.0) throw std::domain_error("Division by zero");
+                out = l / r;
+            }
+        };
+        Evaluator<double, ThrowingKernels> e;
+        REQUIRE_THROWS_AS(e.evaluate(div_type(1.0, 0.0)), std::domain_error);
+        REQUIRE(e.evaluate(expr) == 22.0);
+    }
+}
+
+TEST_CASE("Evaluator (DAG)") {
+    struct CountingKernels : InPlaceKernels {
+        void leaf(double& out, double value) { out = value, ++n_leaves; }
+        void multiply(double& out, double l, double r) {
+            out = l * r, ++n_multiplies;
+        }
+        std::size_t n_leaves     = 0;
+        std::size_t n_multiplies = 0;
+    };
+
+    // (A*B) + (A*B)/c, with A = 2, B = 3, and c = 4
+    double a = 2.0, b = 3.0, c = 4.0;
+    using mult_type = Multiply<double, double>;
+    using div_type  = Divide<mult_type, double>;
+    using add_type  = Add<mult_type, div_type>;
+    add_type expr(mult_type(a, b), div_type(mult_type(a, b), c));
+
+    Evaluator<double, CountingKernels> e;
+
+    SECTION("Common subexpressions are merged") {
+        auto dag = e.make_dag(expr);
+        // a, b, a*b, c, (a*b)/c, and the sum
+        REQUIRE(dag.size() == 6);
+        REQUIRE(dag.use_count(2) == 2);
+        REQUIRE(dag.use_count(5) == 0);
+
+        REQUIRE(e.evaluate(dag) == 7.5);
+        REQUIRE(e.kernels().n_leaves == 3);
+
+        // a*b and the sum are done in place, but a*b is used again so the
+        // division can't overwrite it
+        REQUIRE(e.kernels().n_in_place == 2);
+
+        // The tree evaluates everything
+        Evaluator<double, CountingKernels> e2;
+        REQUIRE(e2.evaluate(expr) == 7.5);
+        REQUIRE(e2.kernels().n_leaves == 5);
+    }
+
+    SECTION("Same operands") {
+        Multiply<mult_type, mult_type> square(mult_type(a, b), mult_type(a, b));
+        auto dag = e.make_dag(square);
+        REQUIRE(dag.size() == 4);
+        REQUIRE(e.evaluate(dag) == 36.0);
+        REQUIRE(e.kernels().n_multiplies == 1);
+        REQUIRE(e.kernels().n_in_place == 1);
+    }
+
+    SECTION("Owned literals with the same values are merged") {
+        Add<mult_type, mult_type> sum(mult_type(2.0, b), mult_type(2.0, b));
+        REQUIRE(e.make_dag(sum).size() == 4);
+        REQUIRE(e.evaluate(e.make_dag(sum)) == 12.0);
+    }
+
+    SECTION("Aliased literals are leaves") {
+        double a2 = 2.0;
+        Add<mult_type, mult_type> sum(mult_type(a, b), mult_type(a2, b));
+        auto dag = e.make_dag(sum);
+        // a, b, a*b, a2, a2*b, and the sum
+        REQUIRE(dag.size() == 6);
+        REQUIRE(e.evaluate(dag) == 12.0);
+
+        // Reusing the DAG reads the current values
+        a = 3.0;
+        REQUIRE(e.evaluate(dag) == 15.0);
+    }
+
+    SECTION("Leaves") {
+        auto dag = e.make_dag(a);
+        REQUIRE(dag.size() == 1);
+        REQUIRE(e.evaluate(dag) == 2.0);
+    }
+
+    SECTION("Function calls") {
+        Max max;
+        FunctionCall<Max, mult_type, double, mult_type> call(
+          max, mult_type(a, b), c, mult_type(a, b));
+        auto dag = e.make_dag(call);
+        REQUIRE(dag.size() == 5);
+        REQUIRE(e.evaluate(dag) == 6.0);
+    }
+
+    SECTION("Timed") {
+        auto dag = e.make_dag(expr);
+        utilities::Timer timer;
+        REQUIRE(e.evaluate(dag, timer) == 7.5);
+        REQUIRE(std::distance(timer.begin(), timer.end()) == 6);
+        for(std::size_t i = 0; i < dag.size(); ++i)
+            REQUIRE(timer.at(dag_timer_key(i)).count() >= 0);
+        REQUIRE(e.kernels().n_in_place == 2);
+    }
+}
+
+TEST_CASE("Evaluator (parallel)") {
+    // How many multiplications are, and have been, running at once
+    struct Counters {
+        std::atomic<int> running{0};
+        std::atomic<int> max_running{0};
+    };
+
+    struct SlowKernels : ScalarKernels {
+        void multiply(double& out, double l, double r) {
+            auto& c       = *counters;
+            const int now = ++c.running;
+            int old       = c.max_running;
+            while(old < now && !c.max_running.compare_exchange_weak(old, now))
+                ;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            --c.running;
+            if(fail) throw std::runtime_error("Multiplication failed");
+            out = l * r;
+        }
+        Counters* counters = nullptr;
+        bool fail          = false;
+    };
+    Counters counters;
+
+    struct InPlaceAdd : ScalarKernels {
+        void add_assign(double& l, double r) { l += r; }
+    };
+
+    int a = 1, b = 2, c = 3, d = 4;
+    using mult_type = Multiply<int, int>;
+    using add_type  = Add<mult_type, mult_type>;
+    add_type expr(mult_type(a, b), mult_type(c, d));
+
+    ParallelOptions options;
+    options.nthreads = 2;
+
+    SECTION("Independent subtrees run concurrently") {
+        Evaluator<double, SlowKernels> e;
+        e.kernels().counters = &counters;
+        auto dag             = e.make_dag(expr);
+        REQUIRE(e.evaluate_parallel(dag, options) == 14.0);
+        REQUIRE(counters.max_running == 2);
+
+        // One thread is just evaluate
+        options.nthreads     = 1;
+        counters.max_running = 0;
+        REQUIRE(e.evaluate_parallel(dag, options) == 14.0);
+        REQUIRE(counters.max_running == 1);
+    }
+
+    SECTION("Same result as serial evaluation") {
+        // ((a*b) + (c*d)) - ((a*b) / (a + c)), a*b is shared
+        using div_type = Divide<mult_type, Add<int, int>>;
+        Subtract<add_type, div_type> expr2(
+          expr, div_type(mult_type(a, b), Add<int, int>(a, c)));
+        Evaluator<double, ScalarKernels> e;
+        auto dag        = e.make_dag(expr2);
+        const auto corr = e.evaluate(dag);
+        REQUIRE(corr == 13.5);
+
+        options.nthreads = 4;
+        REQUIRE(e.evaluate_parallel(dag, options) == corr);
+
+        options.costs.assign(dag.size(), 2.0);
+        REQUIRE(e.evaluate_parallel(dag, options) == corr);
+
+        // Too small to be respected, exceeded instead of deadlocking
+        options.max_buffers = 1;
+        REQUIRE(e.evaluate_parallel(dag, options) == corr);
+    }
+
+    SECTION("Memory limit") {
+        // ((((a + b) + c) + d) + a2) + b2 only needs two buffers at a time
+        int a2 = 5, b2 = 6;
+        using add2_type = Add<Add<int, int>, int>;
+        using add4_type = Add<Add<add2_type, int>, int>;
+        Add<add4_type, int> sum(
+          add4_type(Add<add2_type, int>(add2_type(Add<int, int>(a, b), c), d),
+                    a2),
+          b2);
+        Evaluator<double, InPlaceAdd> e;
+        auto dag = e.make_dag(sum);
+
+        options.nthreads    = 4;
+        options.max_buffers = 2;
+        REQUIRE(e.evaluate_parallel(dag, options) == 21.0);
+        REQUIRE(e.buffer_count() <= 2);
+    }
+
+    SECTION("Kernel throws") {
+        Evaluator<double, SlowKernels> e;
+        auto dag             = e.make_dag(expr);
+        e.kernels().counters = &counters;
+        e.kernels().fail     = true;
+        REQUIRE_THROWS_AS(e.evaluate_parallel(dag, options),
+                          std::runtime_error);
+
+        // Still usable
+        e.kernels().fail = false;
+        REQUIRE(e.evaluate_parallel(dag, options) == 14.0);
+    }
+
+    SECTION("Wrong number of costs") {
+        Evaluator<double, ScalarKernels> e;
+        auto dag      = e.make_dag(expr);
+        options.costs = {1.0};
+        REQUIRE_THROWS_AS(e.evaluate_parallel(dag, options),
+                          std::invalid_argument);
+    }
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+namespace {
+
+using big_type = std::array<double, 16>;
+
+// Is p in the range [first, first + n)?
+bool is_in(const void* p, const void* first, std::size_t n) {
+    auto pc = static_cast<const char*>(p);
+    auto fc = static_cast<const char*>(first);
+    return pc >= fc && pc < fc + n;
+}
+
+} // namespace
+
+TEST_CASE("ExpressionArena") {
+    ExpressionArena arena(1024);
+    REQUIRE(arena.bytes_used() == 0);
+    REQUIRE(arena.capacity() == 0);
+
+    SECTION("allocate") {
+        auto* p0 = arena.allocate(3, 1);
+        auto* p1 = arena.allocate(8, 8);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(p1) % 8 == 0);
+        REQUIRE(static_cast<char*>(p1) >= static_cast<char*>(p0) + 3);
+        REQUIRE(arena.bytes_used() >= 11);
+        REQUIRE(arena.capacity() == 1024);
+
+        // Doesn't fit in what's left of the block, so a new one is made
+        arena.allocate(1020, 1);
+        REQUIRE(arena.capacity() == 2048);
+
+        // Bigger than a block, gets its own
+        arena.allocate(5000, 64);
+        REQUIRE(arena.capacity() > 2048 + 5000);
+    }
+    SECTION("release reuses the blocks") {
+        auto* p0 = arena.allocate(100, 8);
+        arena.allocate(1000, 8);
+        const auto capacity = arena.capacity();
+        arena.release();
+        REQUIRE(arena.bytes_used() == 0);
+        REQUIRE(arena.allocate(100, 8) == p0);
+        arena.allocate(1000, 8);
+        REQUIRE(arena.capacity() == capacity);
+    }
+    SECTION("Scope") {
+        REQUIRE(ExpressionArena::current() == nullptr);
+        {
+            ExpressionArena::Scope scope(arena);
+            REQUIRE(ExpressionArena::current() == &arena);
+            ExpressionArena other;
+            {
+                ExpressionArena::Scope inner(other);
+                REQUIRE(ExpressionArena::current() == &other);
+            }
+            REQUIRE(ExpressionArena::current() == &arena);
+        }
+        REQUIRE(ExpressionArena::current() == nullptr);
+    }
+}
+
+TEST_CASE("Leaf (ExpressionArena)") {
+    ExpressionArena arena;
+    big_type big{};
+    big[0] = 1.0;
+
+    SECTION("Big holders are allocated from the active arena") {
+        Leaf heap = make_leaf(big_type(big));
+        REQUIRE(arena.bytes_used() == 0);
+        {
+            ExpressionArena::Scope scope(arena);
+            Leaf l     = make_leaf(big_type(big));
+            auto used  = arena.bytes_used();
+            auto* pbig = &l.value<big_type>();
+            REQUIRE(used >= sizeof(big_type));
+            REQUIRE(*pbig == big);
+
+            // Small holders are still stored inside the Leaf
+            Leaf small = make_leaf(1.0);
+            REQUIRE(arena.bytes_used() == used);
+
+            // Moves steal, copies go in the arena (even from the heap)
+            Leaf moved(std::move(l));
+            REQUIRE(&moved.value<big_type>() == pbig);
+            Leaf copy(heap);
+            REQUIRE(arena.bytes_used() > used);
+            REQUIRE(copy.value<big_type>() == big);
+            REQUIRE(copy == heap);
+            REQUIRE(arena.live_leaves() == 2);
+        }
+        REQUIRE(ExpressionArena::current() == nullptr);
+        Leaf copy(heap);
+        REQUIRE(copy == heap);
+        REQUIRE(arena.live_leaves() == 0);
+    }
+
+    SECTION("live_leaves") {
+        ExpressionArena::Scope scope(arena);
+        Leaf l = make_leaf(big_type(big));
+        REQUIRE(arena.live_leaves() == 1);
+        Leaf copy(l);
+        REQUIRE(arena.live_leaves() == 2);
+        Leaf moved(std::move(l));
+        REQUIRE(arena.live_leaves() == 2);
+        copy = std::move(moved);
+        REQUIRE(arena.live_leaves() == 1);
+        copy.swap(l);
+        REQUIRE(arena.live_leaves() == 1);
+        l.reset();
+        REQUIRE(arena.live_leaves() == 0);
+        arena.release();
+    }
+
+    SECTION("Arena leaves can outlive the scope (but not the arena)") {
+        Leaf l;
+        {
+            ExpressionArena::Scope scope(arena);
+            l = make_leaf(big_type(big));
+        }
+        REQUIRE(l.value<big_type>() == big);
+        Leaf copy(l); // No active arena, so this goes on the heap
+        REQUIRE(arena.live_leaves() == 1);
+        l.reset();
+        REQUIRE(arena.live_leaves() == 0);
+        REQUIRE(copy.value<big_type>() == big);
+    }
+
+    SECTION("Expression trees") {
+        using mult_type = Multiply<double, double>;
+        using add_type  = Add<mult_type, double>;
+        ExpressionArena::Scope scope(arena);
+        add_type a(mult_type(2.0, 3.0), 4.0);
+        REQUIRE(arena.bytes_used() > 0);
+        REQUIRE(a.lhs().lhs() == 2.0);
+        REQUIRE(a.lhs().rhs() == 3.0);
+        REQUIRE(a.rhs() == 4.0);
+
+        const auto& lhs = a.lhs();
+        REQUIRE(is_in(&lhs, &a, sizeof(a)) == false);
+    }
+}
+
+/* Compares building (and destroying) small expression trees with and without
+ * an ExpressionArena, a million trees by default.
+ */
+TEST_CASE("ExpressionArena benchmark", "[.][benchmark]") {
+    const auto n = test_utilities::benchmark_count(1);
+
+    using mult_type = Multiply<double, double>;
+    using sub_type  = Subtract<mult_type, double>;
+    using add_type  = Add<sub_type, mult_type>;
+    auto build      = [](double x) {
+        return add_type(sub_type(mult_type(x, 2.0), 3.0), mult_type(x, 4.0));
+    };
+
+    BENCHMARK("heap") {
+        double rv = 0.0;
+        for(std::size_t i = 0; i < n; ++i) rv += build(i).rhs().lhs();
+        return rv;
+    };
+
+    ExpressionArena arena;
+    BENCHMARK("arena") {
+        double rv = 0.0;
+        for(std::size_t i = 0; i < n; ++i) {
+            {
+                ExpressionArena::Scope scope(arena);
+                rv += build(i).rhs().lhs();
+            }
+            arena.release();
+        }
+        return rv;
+    };
+}
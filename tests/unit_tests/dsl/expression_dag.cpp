@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * ExpressionDAG is made by Evaluator::make_dag, which is tested in
+ * evaluator.cpp. Here we test the parts of the interface which rewrite rules
+ * use: inspecting nodes, making new ones (which must be hash-consed), and the
+ * rewrite driver itself (which must remove nodes which are no longer used).
+ */
+
+namespace {
+
+using Kernels  = test_utilities::ScalarKernels;
+using dag_type = Evaluator<double, Kernels>::DAG;
+
+} // namespace
+
+TEST_CASE("ExpressionDAG") {
+    int a = 2;
+    Add<double, int> expr(1.5, a);
+    Evaluator<double, Kernels> e;
+    auto dag = e.make_dag(expr);
+
+    SECTION("Accessors") {
+        REQUIRE(dag.size() == 3);
+        REQUIRE_FALSE(dag.empty());
+        REQUIRE(dag.root() == 2);
+
+        REQUIRE(dag.is_constant(0));
+        REQUIRE(dag.is_constant(0, 1.5));
+        REQUIRE_FALSE(dag.is_constant(0, 2.5));
+        REQUIRE(dag.value(0) == 1.5);
+        REQUIRE(dag.kind(0) == NodeKind::leaf);
+        REQUIRE(dag.n_children(0) == 0);
+
+        REQUIRE_FALSE(dag.is_constant(1));
+        REQUIRE(dag.kind(1) == NodeKind::leaf);
+        REQUIRE_THROWS_AS(dag.value(1), std::invalid_argument);
+
+        REQUIRE(dag.kind(2) == NodeKind::add);
+        REQUIRE(dag.n_children(2) == 2);
+        REQUIRE(dag.child(2, 0) == 0);
+        REQUIRE(dag.child(2, 1) == 1);
+        REQUIRE_THROWS_AS(dag.child(2, 2), std::out_of_range);
+        REQUIRE(dag.use_count(0) == 1);
+        REQUIRE(dag.use_count(2) == 0);
+    }
+
+    SECTION("make_constant") {
+        REQUIRE(dag.make_constant(1.5) == 0);
+        const auto i = dag.make_constant(3.0);
+        REQUIRE(i == 3);
+        REQUIRE(dag.make_constant(3.0) == i);
+        REQUIRE(dag.hash(i) == structural_hash(3.0));
+    }
+
+    SECTION("make_binary") {
+        REQUIRE(dag.make_binary(NodeKind::add, 0, 1) == 2);
+        const auto i = dag.make_binary(NodeKind::add, 1, 0);
+        REQUIRE(i == 3);
+        REQUIRE(dag.hash(i) != dag.hash(2));
+        REQUIRE(dag.use_count(0) == 2);
+        REQUIRE_THROWS_AS(dag.make_binary(NodeKind::leaf, 0, 1),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(dag.make_binary(NodeKind::add, 0, 9),
+                          std::out_of_range);
+    }
+
+    SECTION("make_nary") {
+        REQUIRE(dag.make_nary(NodeKind::add, {0, 1}) == 2);
+        const auto i = dag.make_nary(NodeKind::add, {0, 1, 0});
+        REQUIRE(i == 3);
+        REQUIRE(dag.make_nary(NodeKind::add, {0, 1, 0}) == i);
+        REQUIRE(dag.n_children(i) == 3);
+        REQUIRE(dag.child(i, 2) == 0);
+        REQUIRE(dag.use_count(0) == 3);
+        REQUIRE(dag.hash(dag.make_nary(NodeKind::multiply, {0, 1, 0})) !=
+                dag.hash(i));
+        REQUIRE_THROWS_AS(dag.make_nary(NodeKind::subtract, {0, 1, 0}),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(dag.make_nary(NodeKind::add, {0}),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(dag.make_nary(NodeKind::add, {0, 1, 9}),
+                          std::out_of_range);
+    }
+
+    SECTION("rewrite") {
+        // Replaces x + y with y * x
+        auto rule = [](dag_type& d, std::size_t i) {
+            if(d.kind(i) != NodeKind::add) return i;
+            return d.make_binary(NodeKind::multiply, d.child(i, 1),
+                                 d.child(i, 0));
+        };
+        REQUIRE(dag.rewrite(rule));
+        REQUIRE(dag.size() == 3);
+        REQUIRE(dag.kind(dag.root()) == NodeKind::multiply);
+        REQUIRE(dag.use_count(0) == 1);
+        REQUIRE(e.evaluate(dag) == 3.0);
+
+        // Nothing left to rewrite
+        REQUIRE_FALSE(dag.rewrite(rule));
+    }
+
+    SECTION("rewrite removes unused nodes") {
+        // Replaces the root with the constant 4
+        auto rule = [](dag_type& d, std::size_t i) {
+            return d.kind(i) == NodeKind::add ? d.make_constant(4.0) : i;
+        };
+        REQUIRE(dag.rewrite(rule));
+        REQUIRE(dag.size() == 1);
+        REQUIRE(dag.value(0) == 4.0);
+        REQUIRE(e.evaluate(dag) == 4.0);
+    }
+}
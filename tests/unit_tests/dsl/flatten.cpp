@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * For flatten we check the types it produces, that the leaves are still
+ * aliased, and that the flattened tree evaluates to the same value. For
+ * flatten_chains we check which nodes are merged (chains of the same kind,
+ * but not shared subexpressions) and that the DAG's value is unchanged. The
+ * kernels count the accumulations so we can see the fused kernels are used.
+ */
+
+namespace {
+
+using test_utilities::Max;
+
+// Scalar kernels which also have (and count calls to) the n-ary kernels
+struct Kernels : test_utilities::ScalarKernels {
+    using ScalarKernels::add;
+    using ScalarKernels::multiply;
+
+    void add(double& out, const std::vector<const double*>& args) {
+        out = 0.0;
+        for(auto x : args) out += *x;
+        ++n_sums;
+    }
+    void multiply(double& out, const std::vector<const double*>& args) {
+        out = 1.0;
+        for(auto x : args) out *= *x;
+        ++n_products;
+    }
+
+    std::size_t n_sums     = 0;
+    std::size_t n_products = 0;
+};
+
+} // namespace
+
+TEST_CASE("flatten") {
+    int a = 1, b = 2, c = 3, d = 4;
+    Evaluator<double, Kernels> e;
+
+    SECTION("Sums") {
+        auto expr = flatten(Add<Add<int, int>, int>(Add<int, int>(a, b), c));
+        STATIC_REQUIRE(std::is_same_v<decltype(expr), Sum<int, int, int>>);
+        REQUIRE(&expr.object<0>() == &a);
+        REQUIRE(&expr.object<2>() == &c);
+        REQUIRE(expr == sum(a, b, c));
+        REQUIRE(e.evaluate(expr) == 6.0);
+        REQUIRE(e.kernels().n_sums == 1);
+    }
+
+    SECTION("Products nested in sums") {
+        using mult_type = Multiply<Multiply<int, int>, const int>;
+        using add_type  = Add<Add<mult_type, double>, int>;
+        const int cc    = 3;
+        add_type expr(Add<mult_type, double>(
+                        mult_type(Multiply<int, int>(a, b), cc), 0.5),
+                      d);
+        auto flat         = flatten(expr);
+        using prod_type   = Product<int, int, const int>;
+        using result_type = Sum<prod_type, double, int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(flat), result_type>);
+        REQUIRE(&flat.object<0>().object<2>() == &cc);
+        REQUIRE(flat == sum(product(a, b, cc), 0.5, d));
+        REQUIRE(e.evaluate(flat) == e.evaluate(expr));
+    }
+
+    SECTION("Existing sums are spliced") {
+        auto expr = flatten(sum(a, b) + sum(c, d));
+        STATIC_REQUIRE(std::is_same_v<decltype(expr), Sum<int, int, int, int>>);
+        REQUIRE(e.evaluate(expr) == 10.0);
+    }
+
+    SECTION("Other operations") {
+        using add_type = Add<Add<int, int>, int>;
+        using sub_type = Subtract<add_type, int>;
+        sub_type expr(add_type(Add<int, int>(a, b), c), d);
+        auto flat = flatten(expr);
+        using result_type = Subtract<Sum<int, int, int>, int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(flat), result_type>);
+        REQUIRE(e.evaluate(flat) == 2.0);
+
+        Max max;
+        FunctionCall<Max, add_type, int> call(max, expr.lhs(), d);
+        auto flat_call = flatten(call);
+        using call_type = FunctionCall<Max, Sum<int, int, int>, int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(flat_call), call_type>);
+        REQUIRE(&flat_call.object<0>() == &max);
+        REQUIRE(e.evaluate(flat_call) == 6.0);
+    }
+
+    SECTION("Const expressions alias const objects") {
+        const Add<Add<int, int>, int> expr(Add<int, int>(a, b), c);
+        auto flat = flatten(expr);
+        using result_type = Sum<const int, const int, const int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(flat), result_type>);
+        REQUIRE(&flat.object<1>() == &b);
+    }
+}
+
+TEST_CASE("flatten_chains") {
+    int a = 1, b = 2, c = 3, d = 4;
+    Evaluator<double, Kernels> e;
+    using add_type = Add<Add<int, int>, int>;
+
+    SECTION("Chains are merged") {
+        // ((a + b) + c) * d * a
+        using mult_type = Multiply<Multiply<add_type, int>, int>;
+        mult_type expr(Multiply<add_type, int>(add_type(Add<int, int>(a, b), c),
+                                               d),
+                       a);
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.size() == 8);
+        REQUIRE(flatten_chains(dag));
+
+        // a, b, c, the sum, d, and the product
+        REQUIRE(dag.size() == 6);
+        const auto sum = dag.child(dag.root(), 0);
+        REQUIRE(dag.kind(sum) == NodeKind::add);
+        REQUIRE(dag.n_children(sum) == 3);
+        REQUIRE(dag.kind(dag.root()) == NodeKind::multiply);
+        REQUIRE(dag.n_children(dag.root()) == 3);
+        REQUIRE(dag.child(dag.root(), 2) == dag.child(sum, 0));
+
+        REQUIRE(e.evaluate(dag) == 24.0);
+        REQUIRE(e.kernels().n_sums == 1);
+        REQUIRE(e.kernels().n_products == 1);
+
+        // Flat already
+        REQUIRE_FALSE(flatten_chains(dag));
+    }
+
+    SECTION("Shared subexpressions are not merged") {
+        // ((a + b) + c) + ((a + b) + c) * d
+        using mult_type = Multiply<add_type, int>;
+        add_type ab_c(Add<int, int>(a, b), c);
+        Add<add_type, mult_type> expr(ab_c, mult_type(ab_c, d));
+        auto dag = e.make_dag(expr);
+        REQUIRE(flatten_chains(dag));
+
+        // ab_c is merged, but stays its own node
+        const auto shared = dag.child(dag.root(), 0);
+        REQUIRE(dag.n_children(shared) == 3);
+        REQUIRE(dag.n_children(dag.root()) == 2);
+        REQUIRE(e.evaluate(dag) == 30.0);
+    }
+
+    SECTION("Binary operations are left alone") {
+        Add<int, int> expr(a, b);
+        auto dag = e.make_dag(expr);
+        REQUIRE_FALSE(flatten_chains(dag));
+        REQUIRE(dag.size() == 3);
+    }
+
+    SECTION("Simplify leaves n-ary nodes alone") {
+        auto expr = sum(a, 0.0, b);
+        auto dag  = e.make_dag(expr);
+        REQUIRE(dag.n_children(dag.root()) == 3);
+        simplify(dag);
+        REQUIRE(dag.n_children(dag.root()) == 3);
+        REQUIRE(e.evaluate(dag) == 3.0);
+    }
+}
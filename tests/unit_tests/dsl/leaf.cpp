@@ -15,10 +15,34 @@
  */
 
 #include "../test_helpers.hpp"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include <utilities/dsl/leaf.hpp>
 
 using namespace utilities::dsl;
 
+namespace {
+
+// Number of calls to the global operator new, see the replacements below
+std::atomic<std::size_t> n_allocations{0};
+
+} // namespace
+
+/* Counting replacements of the global allocation functions. The remaining
+ * forms (array, nothrow) are specified in terms of these two.
+ */
+void* operator new(std::size_t n) {
+    ++n_allocations;
+    if(auto* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
 /* Testing notes:
  *
  * We can only actually make instances of QualifiedLeafHolder as the base
@@ -76,6 +100,17 @@ TEMPLATE_LIST_TEST_CASE("Leaf", "", types_to_test) {
         REQUIRE(wrap_crref.has_value());
     }
 
+    SECTION("is_alias") {
+        REQUIRE_FALSE(defaulted.is_alias());
+        REQUIRE(wrap_ref.is_alias());
+        REQUIRE(wrap_cref.is_alias());
+        REQUIRE_FALSE(wrap_value.is_alias());
+        REQUIRE_FALSE(wrap_cvalue.is_alias());
+        REQUIRE_FALSE(wrap_rref.is_alias());
+        REQUIRE_FALSE(wrap_crref.is_alias());
+        REQUIRE(Leaf(wrap_ref).is_alias());
+    }
+
     SECTION("value()") {
         SECTION("Return type") {
             using return_type = decltype(wrap_ref.template value<type>());
@@ -231,4 +266,80 @@ TEMPLATE_LIST_TEST_CASE("Leaf", "", types_to_test) {
         REQUIRE_THROWS_AS(unwrap_leaf<type>(defaulted), except_t);
         REQUIRE_THROWS_AS(unwrap_leaf<type>(wrap_cref), except_t);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Leaf (small buffer)") {
+    using detail_::QualifiedLeafHolder;
+    using big_type = std::array<double, 16>;
+
+    // Aliases and small values are stored inline, big values are not
+    STATIC_REQUIRE(Leaf::is_stored_inline_v<QualifiedLeafHolder<big_type&>>);
+    STATIC_REQUIRE(Leaf::is_stored_inline_v<QualifiedLeafHolder<double&&>>);
+    STATIC_REQUIRE(
+      Leaf::is_stored_inline_v<QualifiedLeafHolder<const double&&>>);
+    STATIC_REQUIRE_FALSE(
+      Leaf::is_stored_inline_v<QualifiedLeafHolder<big_type&&>>);
+
+    big_type big{};
+    big[3] = 3.0;
+    double x = 1.23;
+
+    auto alias     = make_leaf(big);
+    auto value     = make_leaf(double{4.56});
+    auto big_value = make_leaf(big_type(big));
+
+    SECTION("Copy") {
+        Leaf alias_copy(alias);
+        Leaf value_copy(value);
+        Leaf big_copy(big_value);
+        REQUIRE(&alias_copy.value<big_type>() == &big);
+        REQUIRE(value_copy.value<double>() == 4.56);
+        REQUIRE(&value_copy.value<double>() != &value.value<double>());
+        REQUIRE(big_copy.value<big_type>() == big);
+        REQUIRE(&big_copy.value<big_type>() != &big_value.value<big_type>());
+    }
+    SECTION("Move") {
+        const auto* pbig = &big_value.value<big_type>();
+        Leaf alias_moved(std::move(alias));
+        Leaf value_moved(std::move(value));
+        Leaf big_moved(std::move(big_value));
+        REQUIRE(&alias_moved.value<big_type>() == &big);
+        REQUIRE(value_moved.value<double>() == 4.56);
+        REQUIRE(&big_moved.value<big_type>() == pbig); // No reallocation
+        REQUIRE_FALSE(value.has_value());
+    }
+    SECTION("Assignment between inline and heap storage") {
+        Leaf l = make_leaf(x);
+        l      = big_value;
+        REQUIRE(l.value<big_type>() == big);
+        l = value;
+        REQUIRE(l.value<double>() == 4.56);
+        l = std::move(big_value);
+        REQUIRE(l.value<big_type>() == big);
+        l = Leaf{};
+        REQUIRE_FALSE(l.has_value());
+    }
+    SECTION("Inline holders don't allocate") {
+        const auto n0 = n_allocations.load();
+        {
+            auto l_alias = make_leaf(big);
+            auto l_value = make_leaf(x);
+            Leaf l_copy(l_value);
+            Leaf l_moved(std::move(l_alias));
+            l_copy = l_moved;
+            REQUIRE(l_copy.value<big_type>() == big);
+        }
+        REQUIRE(n_allocations.load() == n0);
+
+        // Whereas big values go on the heap (one allocation each)
+        Leaf big_copy(big_value);
+        REQUIRE(n_allocations.load() == n0 + 1);
+    }
+    SECTION("swap") {
+        value.swap(big_value);
+        REQUIRE(value.value<big_type>() == big);
+        REQUIRE(big_value.value<double>() == 4.56);
+        alias.swap(alias);
+        REQUIRE(&alias.value<big_type>() == &big);
+    }
+}
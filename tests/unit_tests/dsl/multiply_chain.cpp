@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * The leaves are small matrices, whose shapes make the order of the
+ * multiplications matter. The kernels actually multiply the matrices (and
+ * count the flops) so we can check that reordering does not change the
+ * value, but does make it cheaper. A (10x100), B (100x5), and C (5x50) are
+ * the textbook example: (A * B) * C costs 7500 flops, A * (B * C) 75000.
+ */
+
+namespace {
+
+using test_utilities::Matrix;
+using test_utilities::Shape;
+
+using evaluator_type = Evaluator<Matrix, test_utilities::MatrixKernels>;
+using dag_type       = evaluator_type::DAG;
+using size_type      = dag_type::size_type;
+
+struct CostModel {
+    std::size_t n_cost_calls = 0;
+
+    Shape shape(const dag_type& dag, size_type i) {
+        const auto* m = dag.leaf_as<Matrix>(i);
+        if(m == nullptr) throw std::runtime_error("Not a matrix");
+        return {double(m->rows), double(m->cols)};
+    }
+    double cost(const Shape& l, const Shape& r) {
+        ++n_cost_calls;
+        return l.rows * l.cols * r.cols;
+    }
+    Shape multiply(const Shape& l, const Shape& r) { return {l.rows, r.cols}; }
+};
+
+// Is node i the leaf m?
+bool is_leaf(const dag_type& dag, size_type i, const Matrix& m) {
+    return dag.leaf_as<Matrix>(i) == &m;
+}
+
+} // namespace
+
+TEST_CASE("reorder_multiply_chains") {
+    Matrix A(10, 100), B(100, 5), C(5, 50), D(50, 2);
+    evaluator_type e;
+    CostModel model;
+
+    using BC_type = Multiply<Matrix, Matrix>;
+
+    SECTION("Reorders A * (B * C)") {
+        Multiply<Matrix, BC_type> expr(A, BC_type(B, C));
+        const auto corr = e.evaluate(expr);
+        REQUIRE(e.kernels().flops == 75000);
+
+        auto dag = e.make_dag(expr);
+
+        SECTION("Dynamic programming") {
+            REQUIRE(reorder_multiply_chains(dag, model));
+        }
+        SECTION("Greedy") {
+            REQUIRE(reorder_multiply_chains(dag, model, 2));
+        }
+
+        // Should be (A * B) * C
+        REQUIRE(dag.size() == 5);
+        const auto root = dag.root();
+        const auto AB   = dag.child(root, 0);
+        REQUIRE(dag.kind(root) == NodeKind::multiply);
+        REQUIRE(dag.kind(AB) == NodeKind::multiply);
+        REQUIRE(is_leaf(dag, dag.child(AB, 0), A));
+        REQUIRE(is_leaf(dag, dag.child(AB, 1), B));
+        REQUIRE(is_leaf(dag, dag.child(root, 1), C));
+
+        e.kernels().flops = 0;
+        REQUIRE(e.evaluate(dag) == corr);
+        REQUIRE(e.kernels().flops == 7500);
+
+        // Already optimal
+        REQUIRE_FALSE(reorder_multiply_chains(dag, model));
+    }
+
+    SECTION("Longer chain") {
+        // ((A * B) * C) * D is 7500 + 1000 = 8500 flops, the best order is
+        // A * (B * (C * D)) which is 500 + 1000 + 2000 = 3500
+        using ABC_type = Multiply<Multiply<Matrix, Matrix>, Matrix>;
+        Multiply<ABC_type, Matrix> expr(
+          ABC_type(Multiply<Matrix, Matrix>(A, B), C), D);
+        const auto corr = e.evaluate(expr);
+
+        SECTION("Dynamic programming") {
+            auto dag = e.make_dag(expr);
+            REQUIRE(reorder_multiply_chains(dag, model));
+            e.kernels().flops = 0;
+            REQUIRE(e.evaluate(dag) == corr);
+            REQUIRE(e.kernels().flops == 3500);
+        }
+        SECTION("Greedy") {
+            auto dag = e.make_dag(expr);
+            REQUIRE(reorder_multiply_chains(dag, model, 0));
+            e.kernels().flops = 0;
+            REQUIRE(e.evaluate(dag) == corr);
+            REQUIRE(e.kernels().flops == 3500);
+            // 3 for the initial pairs, then 1 after each of the first two
+            // merges, plus 3 to cost the original order
+            REQUIRE(model.n_cost_calls == 5 + 3);
+        }
+    }
+
+    SECTION("Short chains are left alone") {
+        auto dag = e.make_dag(Multiply<Matrix, Matrix>(A, B));
+        REQUIRE_FALSE(reorder_multiply_chains(dag, model));
+        REQUIRE(model.n_cost_calls == 0);
+    }
+
+    SECTION("Shared products are not flattened") {
+        // B * C is used twice, so it must be computed and can't be split up
+        Add<Multiply<Matrix, BC_type>, BC_type> expr(
+          Multiply<Matrix, BC_type>(A, BC_type(B, C)), BC_type(B, C));
+        auto dag = e.make_dag(expr);
+        const auto size = dag.size();
+        REQUIRE_FALSE(reorder_multiply_chains(dag, model));
+        REQUIRE(dag.size() == size);
+    }
+}
@@ -15,6 +15,8 @@
  */
 
 #include "test_dsl.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
 #include <utilities/dsl/add.hpp>
 #include <utilities/dsl/function_call.hpp>
 
@@ -146,6 +148,16 @@ TEMPLATE_LIST_TEST_CASE("NAryOp (N == 2)", "", test_utilities::binary_types) {
         REQUIRE(std::as_const(a_cc).template object<1>() == rhs);
     }
 
+    SECTION("aliases") {
+        REQUIRE_FALSE(a_xx.template aliases<0>());
+        REQUIRE_FALSE(a_xx.template aliases<1>());
+
+        lhs_type lhs_copy{lhs};
+        dsl::Add<lhs_type, rhs_type> alias(lhs_copy, rhs_type{rhs});
+        REQUIRE(alias.template aliases<0>());
+        REQUIRE_FALSE(alias.template aliases<1>());
+    }
+
     SECTION("operator==") {
         SECTION("Same values") {
             utilities::dsl::Add<lhs_type, rhs_type> add2(lhs, rhs);
@@ -385,4 +397,42 @@ TEST_CASE("NAryOp (N == 3)") {
         REQUIRE_FALSE(a_xxx != a_cxx);
         REQUIRE(a_xxx != op0);
     }
-}
\ No newline at end of file
+}
+
+/* Measures how quickly the objects of an NAryOp can be accessed (and
+ * compared), a million times by default.
+ */
+TEST_CASE("NAryOp::object benchmark", "[.][benchmark]") {
+    const auto n = test_utilities::benchmark_count(1);
+
+    std::vector<double> v0{1.0, 2.0};
+    const std::vector<double> v1{3.0};
+    dsl::FunctionCall<std::vector<double>, const std::vector<double>, double>
+      op(v0, v1, 4.0);
+    const auto& cop = op;
+
+    BENCHMARK("object<I>()") {
+        std::size_t rv = 0;
+        for(std::size_t i = 0; i < n; ++i) {
+            rv += op.object<0>().size() + op.object<1>().size();
+            rv += static_cast<std::size_t>(op.object<2>());
+        }
+        return rv;
+    };
+
+    BENCHMARK("object<I>() const") {
+        std::size_t rv = 0;
+        for(std::size_t i = 0; i < n; ++i) {
+            rv += cop.object<0>().size() + cop.object<1>().size();
+            rv += static_cast<std::size_t>(cop.object<2>());
+        }
+        return rv;
+    };
+
+    BENCHMARK("operator==") {
+        auto copy          = op;
+        std::size_t nequal = 0;
+        for(std::size_t i = 0; i < n; ++i) nequal += (op == copy);
+        return nequal;
+    };
+}
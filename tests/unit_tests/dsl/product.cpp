@@ -0,0 +1,75 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing Strategy.
+ *
+ * Product is a strong type over NAryOp, so we test that it can be made with
+ * product() and by appending, and that it aliases (or copies) its operands like
+ * the binary operations do. Evaluating it is tested in evaluator.cpp.
+ */
+
+TEST_CASE("Product") {
+    int a = 1, b = 2;
+    const int c = 3;
+    double x    = 1.5;
+
+    SECTION("product") {
+        auto op = product(a, 1.5, c);
+        using op_type = Product<int, double, const int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(op), op_type>);
+        STATIC_REQUIRE(decltype(op)::N == 3);
+        STATIC_REQUIRE(node_kind_v<decltype(op)> == NodeKind::multiply);
+        REQUIRE(&op.object<0>() == &a); // Aliased
+        REQUIRE(op.object<1>() == 1.5);  // Copied
+        REQUIRE(&product(a, x).object<1>() == &x);
+        REQUIRE(&op.object<2>() == &c);
+    }
+
+    SECTION("Appending") {
+        auto op = product(a, b) * c;
+        using op_type = Product<int, int, const int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(op), op_type>);
+        REQUIRE(op == product(a, b, c));
+        REQUIRE(&op.object<0>() == &a);
+        REQUIRE(&op.object<2>() == &c);
+
+        // Doubles are copied out of the old operation
+        auto op3 = product(a, x) * c;
+        REQUIRE(&op3.object<1>() != &x);
+        REQUIRE(op3.object<1>() == x);
+
+        // Terms are appended as a single operand
+        using term_type = Multiply<int, int>;
+        auto op2        = product(a, b) * term_type(a, b);
+        using op2_type  = Product<int, int, term_type>;
+        STATIC_REQUIRE(std::is_same_v<decltype(op2), op2_type>);
+        REQUIRE(op2.object<2>() == term_type(a, b));
+    }
+
+    SECTION("Comparisons") {
+        REQUIRE(product(a, b, c) == product(a, b, c));
+        REQUIRE(product(a, b, c) != product(a, c, b));
+        REQUIRE(product(a, b, c) != product(a, b));
+        const auto hash = structural_hash(product(a, b, c));
+        REQUIRE(hash == structural_hash(product(a, b, c)));
+        REQUIRE(hash != structural_hash(product(a, c, b)));
+    }
+}
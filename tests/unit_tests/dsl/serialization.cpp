@@ -0,0 +1,269 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utilities/dsl/dsl.hpp>
+#include <utilities/strings/file_tokenizer.hpp>
+#include <utility>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * The leaves are ints (which the DSL aliases), doubles and strings (which
+ * it holds by value), and an empty callable. The ints get a codec, or are
+ * bound, depending on the test. Loaded expressions are checked by
+ * evaluating them and by checking which objects their leaves alias.
+ */
+
+namespace {
+
+using test_utilities::Max;
+
+/// Codecs with one for ints
+LeafCodecs int_codecs() {
+    LeafCodecs codecs;
+    codecs.add<int>(
+      "int",
+      [](const int& i, std::string& out) {
+          out.append(reinterpret_cast<const char*>(&i), sizeof(int));
+      },
+      [](std::string_view bytes) {
+          int i;
+          std::memcpy(&i, bytes.data(), sizeof(int));
+          return i;
+      });
+    return codecs;
+}
+
+} // namespace
+
+TEST_CASE("serialize/deserialize") {
+    int a = 2, b = 3;
+    using mult_type = Multiply<int, int>;
+    using expr_type = Add<mult_type, double>;
+    expr_type expr(mult_type(a, b), 1.5);
+    const auto codecs = int_codecs();
+
+    SECTION("Round trip") {
+        auto bytes  = serialize(expr, codecs);
+        auto loaded = deserialize<expr_type>(bytes, codecs);
+        auto& copy  = loaded.expression();
+        REQUIRE(copy.lhs().lhs() == 2);
+        REQUIRE(copy.lhs().rhs() == 3);
+        REQUIRE(copy.rhs() == 1.5);
+        REQUIRE(&copy.lhs().lhs() == loaded.leaf<int>(0));
+        REQUIRE(&copy.lhs().lhs() != &a); // Decoded, not aliased
+        REQUIRE(copy == expr);
+
+        // leaf checks the type
+        REQUIRE(loaded.leaf<const int>(0) == loaded.leaf<int>(0));
+        REQUIRE_THROWS_AS(loaded.leaf<double>(0), std::runtime_error);
+        REQUIRE_THROWS_AS(loaded.leaf<int>(2), std::out_of_range);
+
+        // The buffer isn't needed after loading
+        bytes.clear();
+        REQUIRE(copy.lhs().rhs() == 3);
+    }
+
+    SECTION("Layout") {
+        // Header, three nodes, two children, one constant
+        Add<double, double> sum(1.0, 2.0);
+        const auto bytes = serialize(sum);
+        REQUIRE(bytes.size() == 32 + 3 * 8 + 2 * 4 + 2 * 8);
+
+        SerializedExpression view(bytes);
+        REQUIRE(view.size() == 3);
+        REQUIRE(view.root() == 2);
+        REQUIRE(view.kind(2) == NodeKind::add);
+        REQUIRE(view.n_children(2) == 2);
+        REQUIRE(view.child(2, 0) == 0);
+        REQUIRE(view.child(2, 1) == 1);
+        REQUIRE(view.is_constant(0));
+        REQUIRE(view.value(1) == 2.0);
+        REQUIRE(view.n_leaves() == 0);
+        REQUIRE_THROWS_AS(view.child(2, 2), std::out_of_range);
+        REQUIRE_THROWS_AS(view.leaf_id(0), std::out_of_range);
+        REQUIRE_THROWS_AS(view.kind(3), std::out_of_range);
+    }
+
+    SECTION("Repeated leaves are stored once") {
+        Multiply<int, int> square(a, a);
+        const auto bytes = serialize(square, codecs);
+        SerializedExpression view(bytes);
+        REQUIRE(view.n_leaves() == 1);
+        REQUIRE(view.leaf_id(0) == view.leaf_id(1));
+        REQUIRE(view.codec(0) == "int");
+        REQUIRE(view.data(0).size() == sizeof(int));
+
+        auto loaded = deserialize<Multiply<int, int>>(view, codecs);
+        auto& copy  = loaded.expression();
+        REQUIRE(&copy.lhs() == &copy.rhs());
+        REQUIRE(copy.lhs() == 2);
+    }
+
+    SECTION("Bound leaves") {
+        // Without a codec the ints are saved as references
+        const auto bytes = serialize(expr);
+        SerializedExpression view(bytes);
+        REQUIRE(view.n_leaves() == 2);
+        REQUIRE(view.codec(0).empty());
+        REQUIRE_THROWS_AS(deserialize<expr_type>(view), std::runtime_error);
+
+        int c = 4, d = 5;
+        LeafBindings bindings;
+        bindings.bind(0, c);
+        bindings.bind(1, d);
+        auto loaded = deserialize<expr_type>(view, {}, bindings);
+        auto& copy  = loaded.expression();
+        REQUIRE(&copy.lhs().lhs() == &c);
+        REQUIRE(&copy.lhs().rhs() == &d);
+
+        // Binding takes precedence over the codec
+        LeafBindings one;
+        one.bind(1, d);
+        auto loaded2 =
+          deserialize<expr_type>(serialize(expr, codecs), codecs, one);
+        REQUIRE(loaded2.expression().lhs().lhs() == 2);
+        REQUIRE(&loaded2.expression().lhs().rhs() == &d);
+
+        // Type-checked
+        double x = 1.0;
+        LeafBindings wrong;
+        wrong.bind(0, x);
+        wrong.bind(1, d);
+        REQUIRE_THROWS_AS(deserialize<expr_type>(view, {}, wrong),
+                          std::runtime_error);
+    }
+
+    SECTION("Const leaves") {
+        using const_type = Multiply<const int, int>;
+        const_type prod(a, b);
+        auto loaded = deserialize<const_type>(serialize(prod, codecs), codecs);
+        const auto& copy = loaded.expression();
+        REQUIRE(copy.lhs() == 2);
+        REQUIRE(copy.rhs() == 3);
+
+        // Const objects can be bound to leaves aliased as const
+        const int c = 4;
+        int d       = 5;
+        LeafBindings bindings;
+        bindings.bind(0, c);
+        bindings.bind(1, d);
+        const auto bytes = serialize(prod);
+        auto bound       = deserialize<const_type>(bytes, {}, bindings);
+        REQUIRE(&bound.expression().lhs() == &c);
+        REQUIRE(bound.leaf<const int>(0) == &c);
+        REQUIRE_THROWS_AS(bound.leaf<int>(0), std::runtime_error);
+        REQUIRE(bound.leaf<int>(1) == &d);
+
+        // but not to ones aliased as mutable
+        using mutable_type = Multiply<int, int>;
+        REQUIRE_THROWS_AS(deserialize<mutable_type>(bytes, {}, bindings),
+                          std::runtime_error);
+    }
+
+    SECTION("Strings and callables") {
+        using call_type = FunctionCall<Max, int, int>;
+        Max max;
+        call_type call(max, a, b);
+        auto loaded = deserialize<call_type>(serialize(call, codecs), codecs);
+        REQUIRE(loaded.expression().object<1>() == 2);
+        REQUIRE(loaded.expression().object<2>() == 3);
+
+        using string_type = Add<std::string, std::string>;
+        string_type words(std::string("hello"), std::string("world"));
+        auto loaded2 = deserialize<string_type>(serialize(words));
+        REQUIRE(loaded2.expression() == words);
+    }
+
+    SECTION("Static expressions") {
+        auto sexpr   = static_term(a) * b + 1.5;
+        using s_type = decltype(sexpr);
+        auto loaded  = deserialize<s_type>(serialize(sexpr, codecs), codecs);
+        REQUIRE(static_evaluate(loaded.expression()) == 7.5);
+
+        // The formats are the same, so trees can move between the modes
+        auto loaded2 = deserialize<expr_type>(serialize(sexpr, codecs), codecs);
+        REQUIRE(loaded2.expression() == expr);
+    }
+
+    SECTION("Zero-copy loading from a file") {
+        auto path = std::filesystem::temp_directory_path() /
+                    "utilities_serialization.udsl";
+        std::ofstream(path, std::ios::binary) << serialize(expr, codecs);
+
+        utilities::strings::FileTokenizer file(path.string());
+        SerializedExpression view(file.contents());
+
+        // The codec sees the bytes in the mapping
+        LeafCodecs in_place;
+        const char* seen = nullptr;
+        in_place.add<int>(
+          "int", [](const int&, std::string&) {},
+          [&seen](std::string_view bytes) {
+              seen = bytes.data();
+              int i;
+              std::memcpy(&i, bytes.data(), sizeof(int));
+              return i;
+          });
+        auto loaded = deserialize<expr_type>(view, in_place);
+        REQUIRE(loaded.expression() == expr);
+        REQUIRE(seen >= file.contents().data());
+        REQUIRE(seen < file.contents().data() + file.size());
+    }
+
+    SECTION("Errors") {
+        const auto bytes = serialize(expr, codecs);
+
+        // Wrong type
+        using other_type = Add<mult_type, mult_type>;
+        REQUIRE_THROWS_AS(deserialize<other_type>(bytes, codecs),
+                          std::runtime_error);
+        using diff_type = Subtract<mult_type, double>;
+        REQUIRE_THROWS_AS(deserialize<diff_type>(bytes, codecs),
+                          std::runtime_error);
+
+        // Codec names must match
+        LeafCodecs renamed;
+        renamed.add<int>(
+          "int32", [](const int&, std::string&) {},
+          [](std::string_view) { return 0; });
+        REQUIRE_THROWS_AS(deserialize<expr_type>(bytes, renamed),
+                          std::runtime_error);
+
+        // Corrupt buffers
+        using view_type = std::string_view;
+        REQUIRE_THROWS_AS(SerializedExpression(view_type(bytes).substr(0, 40)),
+                          std::runtime_error);
+        auto bad = bytes;
+        bad[0]   = 'X';
+        REQUIRE_THROWS_AS(SerializedExpression(bad), std::runtime_error);
+        bad = bytes;
+        std::swap(bad[28], bad[31]); // Written with the other byte order
+        REQUIRE_THROWS_AS(SerializedExpression(bad), std::runtime_error);
+        bad = bytes;
+        bad[32 + 4 * 8] = 42; // Kind of the root
+        REQUIRE_THROWS_AS(SerializedExpression(bad), std::runtime_error);
+        bad = bytes;
+        bad[32 + 5 * 8 + 2 * 4] = 4; // The root is now its own child
+        REQUIRE_THROWS_AS(SerializedExpression(bad), std::runtime_error);
+    }
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * Each rule is tested on the smallest DAGs it applies to (and one it should
+ * not apply to). The leaves A, B, and C are ints, which the DSL aliases, so
+ * they are not constants. Doubles are constants. Since simplifying must not
+ * change the value of the expression, we also check that the simplified
+ * DAGs evaluate to the same values as the original trees.
+ */
+
+namespace {
+
+using evaluator_type = Evaluator<double, test_utilities::ScalarKernels>;
+using dag_type       = evaluator_type::DAG;
+
+// Number of non-leaf nodes
+std::size_t n_ops(const dag_type& dag) {
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < dag.size(); ++i)
+        n += dag.kind(i) != NodeKind::leaf;
+    return n;
+}
+
+// Simplifies expr and checks the value doesn't change, returns the DAG
+template<typename T>
+dag_type check_simplify(const T& expr) {
+    evaluator_type e;
+    const auto value = e.evaluate(expr);
+    auto dag         = e.make_dag(expr);
+    simplify(dag);
+    REQUIRE(e.evaluate(dag) == Catch::Approx(value));
+    return dag;
+}
+
+} // namespace
+
+TEST_CASE("FoldConstants") {
+    int A = 5;
+    evaluator_type e;
+    using mult_type = Multiply<double, int>;
+
+    SECTION("Two constants") {
+        auto dag = e.make_dag(Add<double, double>(2.0, 3.0));
+        REQUIRE(dag.rewrite(FoldConstants{}));
+        REQUIRE(dag.size() == 1);
+        REQUIRE(dag.value(0) == 5.0);
+    }
+    SECTION("Doesn't fold division by zero") {
+        auto dag = e.make_dag(Divide<double, double>(2.0, 0.0));
+        REQUIRE_FALSE(dag.rewrite(FoldConstants{}));
+    }
+    SECTION("2.0 * (3.0 * A)") {
+        Multiply<double, mult_type> expr(2.0, mult_type(3.0, A));
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.rewrite(FoldConstants{}));
+        REQUIRE(n_ops(dag) == 1);
+        REQUIRE(dag.value(dag.child(dag.root(), 0)) == 6.0);
+        REQUIRE(e.evaluate(dag) == 30.0);
+    }
+    SECTION("(3.0 * A) / 2.0") {
+        Divide<mult_type, double> expr(mult_type(3.0, A), 2.0);
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.rewrite(FoldConstants{}));
+        REQUIRE(dag.kind(dag.root()) == NodeKind::multiply);
+        REQUIRE(e.evaluate(dag) == 7.5);
+    }
+    SECTION("Doesn't apply") {
+        auto dag = e.make_dag(Add<int, double>(A, 1.0));
+        REQUIRE_FALSE(dag.rewrite(FoldConstants{}));
+    }
+}
+
+TEST_CASE("RemoveIdentities") {
+    int A = 5;
+    evaluator_type e;
+
+    auto check = [&](const auto& expr) {
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.rewrite(RemoveIdentities{}));
+        REQUIRE(dag.size() == 1);
+        REQUIRE(e.evaluate(dag) == 5.0);
+    };
+    check(Multiply<double, int>(1.0, A));
+    check(Multiply<int, double>(A, 1.0));
+    check(Divide<int, double>(A, 1.0));
+    check(Add<double, int>(0.0, A));
+    check(Add<int, double>(A, 0.0));
+    check(Subtract<int, double>(A, 0.0));
+
+    // 0 - A is not A
+    auto dag = e.make_dag(Subtract<double, int>(0.0, A));
+    REQUIRE_FALSE(dag.rewrite(RemoveIdentities{}));
+}
+
+TEST_CASE("CanonicalOrder") {
+    int A = 5, B = 7;
+    evaluator_type e;
+
+    SECTION("A + B and B + A become the same") {
+        Add<Add<int, int>, Add<int, int>> expr(Add<int, int>(A, B),
+                                               Add<int, int>(B, A));
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.size() == 5);
+        REQUIRE(dag.rewrite(CanonicalOrder{}));
+        REQUIRE(dag.size() == 4);
+        REQUIRE(e.evaluate(dag) == 24.0);
+    }
+    SECTION("Constants go on the left") {
+        auto dag = e.make_dag(Multiply<int, double>(A, 2.0));
+        REQUIRE(dag.rewrite(CanonicalOrder{}));
+        REQUIRE(dag.is_constant(dag.child(dag.root(), 0)));
+    }
+    SECTION("Multiplication is not commutative by default") {
+        Add<Multiply<int, int>, Multiply<int, int>> expr(
+          Multiply<int, int>(A, B), Multiply<int, int>(B, A));
+        auto dag = e.make_dag(expr);
+        dag.rewrite(CanonicalOrder{});
+        REQUIRE(dag.size() == 5);
+        REQUIRE(dag.rewrite(CanonicalOrder{true}));
+        REQUIRE(dag.size() == 4);
+    }
+    SECTION("Idempotent") {
+        auto dag = e.make_dag(Add<int, int>(A, B));
+        dag.rewrite(CanonicalOrder{});
+        REQUIRE_FALSE(dag.rewrite(CanonicalOrder{}));
+    }
+}
+
+TEST_CASE("FactorScalars") {
+    int A = 5, B = 7;
+    evaluator_type e;
+    using scaled_type = Multiply<double, int>;
+
+    SECTION("2A + 2B") {
+        Add<scaled_type, scaled_type> expr(scaled_type(2.0, A),
+                                           scaled_type(2.0, B));
+        auto dag = e.make_dag(expr);
+        REQUIRE(n_ops(dag) == 3);
+        REQUIRE(dag.rewrite(FactorScalars{}));
+        REQUIRE(n_ops(dag) == 2);
+        REQUIRE(e.evaluate(dag) == 24.0);
+    }
+    SECTION("2A - 3A") {
+        Subtract<scaled_type, scaled_type> expr(scaled_type(2.0, A),
+                                                scaled_type(3.0, A));
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.rewrite(FactorScalars{}));
+        REQUIRE(n_ops(dag) == 1);
+        REQUIRE(e.evaluate(dag) == -5.0);
+    }
+    SECTION("A + 2A") {
+        Add<int, scaled_type> expr(A, scaled_type(2.0, A));
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.rewrite(FactorScalars{}));
+        REQUIRE(n_ops(dag) == 1);
+        REQUIRE(e.evaluate(dag) == 15.0);
+    }
+    SECTION("(2A) * B") {
+        Multiply<scaled_type, int> expr(scaled_type(2.0, A), B);
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.rewrite(FactorScalars{}));
+        REQUIRE(dag.is_constant(dag.child(dag.root(), 0)));
+        REQUIRE(e.evaluate(dag) == 70.0);
+    }
+    SECTION("Doesn't apply") {
+        Add<scaled_type, scaled_type> expr(scaled_type(2.0, A),
+                                           scaled_type(3.0, B));
+        auto dag = e.make_dag(expr);
+        REQUIRE_FALSE(dag.rewrite(FactorScalars{}));
+    }
+}
+
+TEST_CASE("DistributeScalars") {
+    int A = 5, B = 7;
+    evaluator_type e;
+    using scaled_type = Multiply<double, int>;
+    using sum_type    = Add<scaled_type, scaled_type>;
+
+    // 2(3A + 4B) = 6A + 8B
+    Multiply<double, sum_type> expr(
+      2.0, sum_type(scaled_type(3.0, A), scaled_type(4.0, B)));
+    auto dag = e.make_dag(expr);
+    REQUIRE(n_ops(dag) == 4);
+    REQUIRE(dag.rewrite(DistributeScalars{}));
+    REQUIRE(n_ops(dag) == 3);
+    REQUIRE(e.evaluate(dag) == 86.0);
+
+    // Not all terms are scaled
+    Multiply<double, Add<int, scaled_type>> expr2(
+      2.0, Add<int, scaled_type>(A, scaled_type(4.0, B)));
+    auto dag2 = e.make_dag(expr2);
+    REQUIRE_FALSE(dag2.rewrite(DistributeScalars{}));
+}
+
+TEST_CASE("simplify") {
+    int A = 5, B = 7;
+    using scaled_type = Multiply<double, int>;
+
+    SECTION("2.0 * (3.0 * A)") {
+        auto dag = check_simplify(Multiply<double, scaled_type>(
+          2.0, scaled_type(3.0, A)));
+        REQUIRE(n_ops(dag) == 1);
+    }
+    SECTION("(1.0 * A + 0.0) * (2.0 + 3.0)") {
+        using inner_type = Add<scaled_type, double>;
+        using sum_type   = Add<double, double>;
+        auto dag         = check_simplify(Multiply<inner_type, sum_type>(
+          inner_type(scaled_type(1.0, A), 0.0), sum_type(2.0, 3.0)));
+        REQUIRE(n_ops(dag) == 1);
+    }
+    SECTION("(2A + 2B) / 4 + B") {
+        using sum_type = Add<scaled_type, scaled_type>;
+        using div_type = Divide<sum_type, double>;
+        auto dag       = check_simplify(Add<div_type, int>(
+          div_type(sum_type(scaled_type(2.0, A), scaled_type(2.0, B)), 4.0),
+          B));
+        REQUIRE(n_ops(dag) <= 3);
+    }
+    SECTION("Nothing to do") {
+        evaluator_type e;
+        auto dag = e.make_dag(Subtract<int, int>(A, B));
+        REQUIRE_FALSE(simplify(dag));
+    }
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include <utilities/dsl/dsl.hpp>
+#include <vector>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * StaticOp is the tuple-based counterpart to NAryOp, so we check that it
+ * holds its objects the same way (literals and terms by value, everything
+ * else by pointer) without any type-erasure, that the operators build the
+ * expected types, and that the generic machinery (structural hashing, the
+ * Evaluator, and make_dag) works with it. static_evaluate is tested on static
+ * and type-erased trees.
+ */
+
+namespace {
+
+using Kernels = test_utilities::ScalarKernels;
+using test_utilities::Max;
+
+// Can `L * R` be written?
+template<typename L, typename R, typename = void>
+struct CanMultiply : std::false_type {};
+
+template<typename L, typename R>
+struct CanMultiply<L, R,
+                   std::void_t<decltype(std::declval<L>() * std::declval<R>())>>
+  : std::true_type {};
+
+} // namespace
+
+TEST_CASE("StaticOp") {
+    int a = 1, b = 2, c = 3;
+    double x = 1.5;
+
+    using mult_type = StaticMultiply<int, int>;
+    using add_type  = StaticAdd<mult_type, int>;
+
+    SECTION("Storage") {
+        // Nothing but the pointers/values
+        STATIC_REQUIRE(sizeof(mult_type) == 2 * sizeof(int*));
+        STATIC_REQUIRE(sizeof(StaticAdd<double, double>) == 2 * sizeof(double));
+
+        StaticAdd<int, double> op(a, x);
+        REQUIRE(&op.object<0>() == &a); // Aliased
+        REQUIRE(&op.object<1>() != &x); // Copied
+        REQUIRE(op.object<1>() == x);
+
+        // Mutable access respects const-ness
+        op.object<0>() = 4;
+        REQUIRE(a == 4);
+        StaticAdd<const int, int> cop(a, b);
+        STATIC_REQUIRE(std::is_same_v<decltype(cop.object<0>()), const int&>);
+    }
+
+    SECTION("Operators") {
+        auto expr = static_term(a) * b + c;
+        STATIC_REQUIRE(std::is_same_v<decltype(expr), add_type>);
+        REQUIRE(&expr.object<0>().object<0>() == &a);
+        REQUIRE(&expr.object<0>().object<1>() == &b);
+        REQUIRE(&expr.object<1>() == &c);
+        REQUIRE(static_evaluate(expr) == 5);
+
+        const int ca = 7;
+        auto expr2   = static_term(ca) - static_term(x) / c;
+        using div_type = StaticDivide<double, int>;
+        STATIC_REQUIRE(std::is_same_v<decltype(expr2),
+                                      StaticSubtract<const int, div_type>>);
+        REQUIRE(static_evaluate(expr2) == 6.5);
+    }
+
+    SECTION("Temporaries") {
+        // Literals and terms are held by value, so temporaries are fine
+        auto expr = static_term(a) * 2.0 + (static_term(b) * c);
+        REQUIRE(expr.object<0>().object<1>() == 2.0);
+        REQUIRE(static_evaluate(expr) == 8.0);
+
+        // Other objects would be aliased, so temporaries are rejected
+        using vector_type = std::vector<int>;
+        using lhs_type    = StaticRef<vector_type>;
+        STATIC_REQUIRE(CanMultiply<lhs_type, vector_type&>::value);
+        STATIC_REQUIRE_FALSE(CanMultiply<lhs_type, vector_type>::value);
+        STATIC_REQUIRE_FALSE(CanMultiply<lhs_type, const vector_type>::value);
+        STATIC_REQUIRE(CanMultiply<lhs_type, lhs_type>::value);
+        using op_type = StaticMultiply<vector_type, vector_type>;
+        STATIC_REQUIRE(
+          std::is_constructible_v<op_type, vector_type&, vector_type&>);
+        STATIC_REQUIRE_FALSE(
+          std::is_constructible_v<op_type, vector_type&, vector_type>);
+    }
+
+    SECTION("Function calls") {
+        Max max;
+        auto expr = static_call(max, static_term(a) + b, c);
+        REQUIRE(&expr.object<0>() == &max);
+        REQUIRE(static_evaluate(expr) == 3);
+        REQUIRE(static_evaluate(static_call(max, static_term(c) * c, a)) == 9);
+    }
+
+    SECTION("Comparisons") {
+        auto expr = static_term(a) * b + c;
+        REQUIRE(expr == static_term(a) * b + c);
+        REQUIRE_FALSE(expr != static_term(a) * b + c);
+        REQUIRE(expr != static_term(a) * b - c);
+        REQUIRE(expr != static_term(a) * c + b);
+        REQUIRE(expr != static_term(a) * b + x);
+    }
+
+    SECTION("Structural hashing") {
+        auto expr = static_term(a) * b + c;
+        const auto hash = structural_hash(expr);
+        REQUIRE(hash == structural_hash(static_term(a) * b + c));
+        REQUIRE(structurally_equal(expr, static_term(a) * b + c));
+        REQUIRE_FALSE(structurally_equal(expr, static_term(b) * a + c));
+    }
+
+    SECTION("Evaluator") {
+        Evaluator<double, Kernels> e;
+        auto expr = (static_term(a) * b + c) / (static_term(a) * b);
+        REQUIRE(e.evaluate(expr) == 2.5);
+
+        // a, b, a * b (only once), c, the sum, and the quotient
+        auto dag = e.make_dag(expr);
+        REQUIRE(dag.size() == 6);
+        REQUIRE(e.evaluate(dag) == 2.5);
+    }
+
+    SECTION("static_evaluate on type-erased terms") {
+        Add<Multiply<int, int>, int> expr(Multiply<int, int>(a, b), c);
+        REQUIRE(static_evaluate(expr) == 5);
+        REQUIRE(&static_evaluate(a) == &a);
+
+        // Sums and products may have more than two operands
+        REQUIRE(static_evaluate(sum(a, b, c)) == 6);
+        REQUIRE(static_evaluate(product(a, b, c, x)) == 9.0);
+        StaticOp<NodeKind::add, int, int, int> op(a, b, c);
+        REQUIRE(static_evaluate(op) == 6);
+    }
+}
+
+/* Compares evaluating a*b + c/d with the type-erased terms and the static
+ * ones, a million times by default.
+ */
+TEST_CASE("StaticOp benchmark", "[.][benchmark]") {
+    const auto n = test_utilities::benchmark_count(1);
+
+    int a = 1, b = 2, c = 3, d = 4;
+    Add<Multiply<int, int>, Divide<int, int>> erased(Multiply<int, int>(a, b),
+                                                     Divide<int, int>(c, d));
+    auto fixed = static_term(a) * b + static_term(c) / d;
+
+    BENCHMARK("type-erased") {
+        long rv = 0;
+        for(std::size_t i = 0; i < n; ++i) {
+            a = int(i);
+            rv += static_evaluate(erased);
+        }
+        return rv;
+    };
+
+    BENCHMARK("static") {
+        long rv = 0;
+        for(std::size_t i = 0; i < n; ++i) {
+            a = int(i);
+            rv += static_evaluate(fixed);
+        }
+        return rv;
+    };
+}
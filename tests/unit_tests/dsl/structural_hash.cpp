@@ -0,0 +1,129 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_dsl.hpp"
+#include <utilities/dsl/dsl.hpp>
+
+using namespace utilities::dsl;
+
+/* Testing strategy.
+ *
+ * Structural hashing must be consistent with structurally_equal, i.e., equal
+ * trees must hash the same. We check that aliased leaves are compared by
+ * address, by-value leaves by value, and that the hash cached in the nodes is
+ * invalidated when the node is modified. Literals an operation aliases may
+ * change after the hash is cached, so they must be hashed and compared by
+ * address.
+ */
+
+TEST_CASE("structural_hash") {
+    std::vector<int> a{1, 2, 3}, a_copy{1, 2, 3}, b{4, 5, 6};
+
+    SECTION("Leaves") {
+        // Aliased leaves hash by address
+        REQUIRE(structural_hash(a) == structural_hash(a));
+        REQUIRE(structural_hash(a) != structural_hash(a_copy));
+
+        // By-value leaves hash by value
+        REQUIRE(structural_hash(1.5) == structural_hash(1.5));
+        REQUIRE(structural_hash(1.5) != structural_hash(2.5));
+        REQUIRE(structural_hash(std::string("c")) ==
+                structural_hash(std::string("c")));
+    }
+
+    SECTION("Operations") {
+        using mult_type = Multiply<std::vector<int>, std::vector<int>>;
+        mult_type ab(a, b), ab2(a, b), ba(b, a), a_copy_b(a_copy, b);
+        REQUIRE(ab.hash() == ab2.hash());
+        REQUIRE(structural_hash(ab) == ab.hash());
+        REQUIRE(ab.hash() != ba.hash());
+        REQUIRE(ab.hash() != a_copy_b.hash());
+
+        // The kind of operation matters
+        Add<std::vector<int>, std::vector<int>> a_plus_b(a, b);
+        REQUIRE(ab.hash() != a_plus_b.hash());
+
+        // Nested
+        Divide<mult_type, double> x(ab, 2.0), y(ab2, 2.0), z(ab, 3.0);
+        REQUIRE(x.hash() == y.hash());
+        REQUIRE(x.hash() != z.hash());
+    }
+
+    SECTION("Mutable access invalidates the cache") {
+        Add<double, double> x(1.0, 2.0), y(1.0, 3.0);
+        REQUIRE(x.hash() != y.hash());
+        x.rhs() = 3.0;
+        REQUIRE(x.hash() == y.hash());
+    }
+
+    SECTION("Copies share the hash") {
+        Add<double, std::vector<int>> x(1.0, a);
+        const auto h = x.hash();
+        auto copy    = x;
+        REQUIRE(copy.hash() == h);
+    }
+
+    SECTION("Aliased literals hash by address") {
+        using scale_type = Multiply<double, std::vector<int>>;
+        double alpha     = 1.0;
+        scale_type x(alpha, a), y(alpha, a);
+        const auto h = x.hash();
+        REQUIRE(y.hash() == h);
+        REQUIRE(scale_type(1.0, a).hash() != h);
+
+        // Changing alpha doesn't make the cached hash stale
+        alpha = 2.0;
+        REQUIRE(scale_type(alpha, a).hash() == h);
+
+        double beta = 2.0;
+        REQUIRE(scale_type(beta, a).hash() != h);
+    }
+}
+
+TEST_CASE("structurally_equal") {
+    std::vector<int> a{1, 2, 3}, a_copy{1, 2, 3}, b{4, 5, 6};
+    using mult_type = Multiply<std::vector<int>, std::vector<int>>;
+
+    REQUIRE(structurally_equal(a, a));
+    REQUIRE_FALSE(structurally_equal(a, a_copy));
+    REQUIRE(structurally_equal(1.5, 1.5));
+    REQUIRE_FALSE(structurally_equal(1.5, 2.5));
+    REQUIRE_FALSE(structurally_equal(1.5, 1));
+
+    mult_type ab(a, b), ab2(a, b), a_copy_b(a_copy, b);
+    REQUIRE(structurally_equal(ab, ab2));
+    REQUIRE_FALSE(structurally_equal(ab, a_copy_b));
+
+    // operator== compares values, structurally_equal compares identities
+    REQUIRE(ab == a_copy_b);
+
+    Add<mult_type, double> x(ab, 1.0), y(ab2, 1.0), z(ab, 2.0);
+    REQUIRE(structurally_equal(x, y));
+    REQUIRE_FALSE(structurally_equal(x, z));
+    REQUIRE_FALSE(structurally_equal(x, ab));
+
+    SECTION("Aliased literals are compared by address") {
+        using scale_type = Multiply<double, std::vector<int>>;
+        double alpha = 1.0, beta = 1.0;
+        scale_type s(alpha, a);
+        structural_hash(s);
+        alpha = 2.0;
+        REQUIRE(structurally_equal(s, scale_type(alpha, a)));
+        REQUIRE_FALSE(structurally_equal(s, scale_type(beta, a)));
+        REQUIRE_FALSE(structurally_equal(s, scale_type(2.0, a)));
+        REQUIRE(structurally_equal(scale_type(2.0, a), scale_type(2.0, a)));
+    }
+}
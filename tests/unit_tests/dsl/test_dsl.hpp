@@ -15,8 +15,11 @@
  */
 
 #include "../test_helpers.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <map>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 /* Testing strategy.
@@ -57,4 +60,79 @@ inline auto binary_values() {
 /// Tuple type returned from binary_values
 using binary_types = decltype(binary_values());
 
+/// Function object for testing FunctionCall (leaves must be comparable)
+struct Max {
+    int operator()(int a, int b) const { return a < b ? b : a; }
+    bool operator==(const Max&) const noexcept { return true; }
+};
+
+/// Kernels for evaluating expressions of doubles (and ints) to a double
+struct ScalarKernels {
+    void leaf(double& out, double value) { out = value; }
+    void leaf(double& out, int value) { out = value; }
+    void add(double& out, double l, double r) { out = l + r; }
+    void subtract(double& out, double l, double r) { out = l - r; }
+    void multiply(double& out, double l, double r) { out = l * r; }
+    void divide(double& out, double l, double r) { out = l / r; }
+
+    void function_call(double& out, const Max&,
+                       const std::vector<const double*>& args) {
+        out = *args.front();
+        for(auto x : args) out = std::max(out, *x);
+    }
+};
+
+/** @brief A small dense matrix, for testing the cost-based optimizations.
+ *
+ *  The elements are not all the same, so reordering products which changes
+ *  the result would be noticed.
+ */
+struct Matrix {
+    std::size_t rows;
+    std::size_t cols;
+    std::vector<double> data;
+
+    Matrix() : Matrix(0, 0) {}
+
+    Matrix(std::size_t r, std::size_t c) : rows(r), cols(c), data(r * c) {
+        for(std::size_t i = 0; i < data.size(); ++i) data[i] = i % 7 + 1.0;
+    }
+
+    bool operator==(const Matrix& rhs) const {
+        return rows == rhs.rows && cols == rhs.cols && data == rhs.data;
+    }
+};
+
+/// Naive matrix arithmetic, which counts the multiply-adds of products
+struct MatrixKernels {
+    std::size_t flops = 0;
+
+    void leaf(Matrix& out, const Matrix& value) { out = value; }
+    void add(Matrix& out, const Matrix& l, const Matrix& r) {
+        out = l;
+        for(std::size_t i = 0; i < r.data.size(); ++i) out.data[i] += r.data[i];
+    }
+    void multiply(Matrix& out, const Matrix& l, const Matrix& r) {
+        Matrix rv(l.rows, r.cols);
+        for(std::size_t i = 0; i < l.rows; ++i)
+            for(std::size_t j = 0; j < r.cols; ++j) {
+                double sum = 0.0;
+                for(std::size_t k = 0; k < l.cols; ++k)
+                    sum += l.data[i * l.cols + k] * r.data[k * r.cols + j];
+                rv.data[i * r.cols + j] = sum;
+            }
+        flops += l.rows * l.cols * r.cols;
+        out = std::move(rv);
+    }
+};
+
+/// The shape of a Matrix, as used by cost models
+struct Shape {
+    double rows;
+    double cols;
+
+    /// The size of a matrix of this shape, in bytes
+    double size() const { return 8.0 * rows * cols; }
+};
+
 } // namespace test_utilities
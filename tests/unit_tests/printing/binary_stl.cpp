@@ -0,0 +1,293 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_helpers.hpp"
+#include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <deque>
+#include <filesystem>
+#include <forward_list>
+#include <fstream>
+#include <list>
+#include <map>
+#include <optional>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utilities/printing/binary_stl.hpp>
+#include <utilities/strings/file_tokenizer.hpp>
+#include <utility>
+#include <vector>
+
+using namespace utilities::printing;
+
+namespace {
+
+template<typename T>
+std::string to_binary(const T& x) {
+    std::stringstream ss;
+    write_binary(ss, x);
+    return ss.str();
+}
+
+// Writes x and reads it back as a U
+template<typename U, typename T>
+U round_trip(const T& x) {
+    return read_binary<U>(to_binary(x));
+}
+
+template<typename T>
+T round_trip(const T& x) {
+    return round_trip<T, T>(x);
+}
+
+// Is p inside of buffer?
+bool points_into(const void* p, const std::string& buffer) {
+    const auto* c = static_cast<const char*>(p);
+    return c >= buffer.data() && c < buffer.data() + buffer.size();
+}
+
+} // namespace
+
+TEST_CASE("ArrayView") {
+    std::vector<int> v{1, 2, 3};
+    ArrayView<int> defaulted;
+    ArrayView<int> view(v.data(), v.size());
+
+    REQUIRE(defaulted.empty());
+    REQUIRE(defaulted.size() == 0);
+    REQUIRE(defaulted.begin() == defaulted.end());
+    REQUIRE_FALSE(view.empty());
+    REQUIRE(view.size() == 3);
+    REQUIRE(view.data() == v.data());
+    REQUIRE(view[1] == 2);
+    REQUIRE(std::vector<int>(view.begin(), view.end()) == v);
+}
+
+TEST_CASE("write_binary") {
+    SECTION("Scalars") {
+        REQUIRE(to_binary(true) == std::string(1, '\1'));
+        REQUIRE(to_binary(std::int32_t{1}).size() == 4);
+        REQUIRE(to_binary(1.0).size() == sizeof(double));
+    }
+    SECTION("Strings are length-prefixed") {
+        const auto bytes = to_binary(std::string("hi"));
+        REQUIRE(bytes.size() == 10);
+        REQUIRE(bytes.substr(8) == "hi");
+        REQUIRE(to_binary("hi") == bytes);
+        REQUIRE(to_binary(std::string_view("hi")) == bytes);
+    }
+    SECTION("Arithmetic arrays are aligned") {
+        // bool flag, 8 byte size, 7 bytes of padding, then the doubles
+        const auto bytes = to_binary(std::make_pair(true, std::vector{1.0}));
+        REQUIRE(bytes.size() == 24);
+        REQUIRE(bytes.substr(9, 7) == std::string(7, '\0'));
+    }
+    SECTION("Returns the stream") {
+        std::stringstream ss;
+        write_binary(ss, 1.0) << "done";
+        REQUIRE(ss.str().substr(sizeof(double)) == "done");
+    }
+}
+
+TEST_CASE("read_binary") {
+    SECTION("Scalars") {
+        REQUIRE(round_trip(true));
+        REQUIRE_FALSE(round_trip(false));
+        REQUIRE(round_trip('x') == 'x');
+        REQUIRE(round_trip(-42) == -42);
+        REQUIRE(round_trip(3.14) == 3.14);
+        REQUIRE(round_trip(2.5f) == 2.5f);
+    }
+    SECTION("Strings") {
+        REQUIRE(round_trip(std::string("hello")) == "hello");
+        REQUIRE(round_trip(std::string{}) == "");
+        REQUIRE(round_trip<std::string>("hello") == "hello");
+    }
+    SECTION("Optional, pair, and tuple") {
+        REQUIRE(round_trip(std::optional<int>{}) == std::nullopt);
+        REQUIRE(round_trip(std::optional<int>{3}) == 3);
+        auto p = std::make_pair(1, std::string("a"));
+        REQUIRE(round_trip(p) == p);
+        auto t = std::make_tuple(1, 2.5, std::string("b"), true);
+        REQUIRE(round_trip(t) == t);
+        REQUIRE(round_trip(std::tuple<>{}) == std::tuple<>{});
+    }
+    SECTION("Sequences") {
+        std::vector<double> v{1.0, 2.0, 3.0};
+        REQUIRE(round_trip(v) == v);
+        REQUIRE(round_trip(std::vector<double>{}).empty());
+        std::vector<std::string> vs{"a", "", "c"};
+        REQUIRE(round_trip(vs) == vs);
+        std::vector<bool> vb{true, false, true};
+        REQUIRE(round_trip(vb) == vb);
+        std::array<int, 3> a{1, 2, 3};
+        REQUIRE(round_trip(a) == a);
+        std::array<std::string, 2> as{"a", "b"};
+        REQUIRE(round_trip(as) == as);
+        std::deque<int> d{1, 2};
+        REQUIRE(round_trip(d) == d);
+        std::list<int> l{3, 4};
+        REQUIRE(round_trip(l) == l);
+        std::forward_list<int> f{5, 6, 7};
+        REQUIRE(round_trip(f) == f);
+    }
+    SECTION("Sets") {
+        std::set<int> s{3, 1, 2};
+        REQUIRE(round_trip(s) == s);
+        std::multiset<int> ms{1, 1, 2};
+        REQUIRE(round_trip(ms) == ms);
+        std::unordered_set<int> us{1, 2};
+        REQUIRE(round_trip(us) == us);
+        std::unordered_multiset<int> ums{1, 1};
+        REQUIRE(round_trip(ums) == ums);
+    }
+    SECTION("Maps") {
+        std::map<std::string, int> m{{"a", 1}, {"b", 2}};
+        REQUIRE(round_trip(m) == m);
+        std::multimap<int, int> mm{{1, 1}, {1, 2}};
+        REQUIRE(round_trip(mm) == mm);
+        std::unordered_map<int, std::string> um{{1, "a"}};
+        REQUIRE(round_trip(um) == um);
+        std::unordered_multimap<int, int> umm{{1, 1}, {1, 1}};
+        REQUIRE(round_trip(umm) == umm);
+    }
+    SECTION("Adaptors") {
+        std::queue<int> q;
+        std::stack<int> s;
+        std::priority_queue<int> pq;
+        for(auto x : {3, 1, 2}) {
+            q.push(x);
+            s.push(x);
+            pq.push(x);
+        }
+        REQUIRE(round_trip(q) == q);
+        REQUIRE(round_trip(s) == s);
+        auto pq2 = round_trip(pq);
+        std::vector<int> popped;
+        for(; !pq2.empty(); pq2.pop()) popped.push_back(pq2.top());
+        REQUIRE(popped == std::vector<int>{3, 2, 1});
+    }
+    SECTION("Nesting") {
+        std::map<std::string, std::vector<std::optional<double>>> m{
+          {"x", {1.0, std::nullopt}}, {"y", {}}};
+        REQUIRE(round_trip(m) == m);
+    }
+}
+
+TEST_CASE("BinaryReader") {
+    SECTION("Several values") {
+        std::stringstream ss;
+        BinaryWriter writer(ss);
+        writer.write(1).write(std::string("a")).write(std::vector{2.0});
+        REQUIRE(writer.size() == ss.str().size());
+
+        const auto bytes = ss.str();
+        BinaryReader reader(bytes);
+        REQUIRE(reader.read<int>() == 1);
+        REQUIRE(reader.read<std::string>() == "a");
+        REQUIRE_FALSE(reader.done());
+        REQUIRE(reader.read<ArrayView<double>>()[0] == 2.0);
+        REQUIRE(reader.done());
+        REQUIRE(reader.offset() == bytes.size());
+        REQUIRE(reader.remaining() == 0);
+    }
+    SECTION("Views do not copy") {
+        std::map<std::string, std::vector<double>> m{{"a", {1.0, 2.0}},
+                                                     {"b", {3.0}}};
+        const auto bytes = to_binary(m);
+        using view_map   = std::map<std::string_view, ArrayView<double>>;
+        const auto views = read_binary<view_map>(bytes);
+        REQUIRE(views.size() == 2);
+        for(const auto& [k, v] : views) {
+            REQUIRE(points_into(k.data(), bytes));
+            REQUIRE(points_into(v.data(), bytes));
+            const auto& corr = m.at(std::string(k));
+            REQUIRE(std::vector<double>(v.begin(), v.end()) == corr);
+        }
+    }
+    SECTION("Truncated data") {
+        const auto bytes = to_binary(std::vector<int>{1, 2, 3});
+        for(std::size_t n = 0; n < bytes.size(); ++n) {
+            std::string_view partial(bytes.data(), n);
+            using vector_type = std::vector<int>;
+            REQUIRE_THROWS_AS(read_binary<vector_type>(partial),
+                              std::out_of_range);
+        }
+    }
+    SECTION("Bogus size") {
+        const auto bytes = to_binary(std::uint64_t(-1));
+        REQUIRE_THROWS_AS(read_binary<std::vector<std::string>>(bytes),
+                          std::out_of_range);
+    }
+    SECTION("Wrong array size") {
+        const auto bytes = to_binary(std::vector<int>{1, 2});
+        using array_type = std::array<int, 3>;
+        REQUIRE_THROWS_AS(read_binary<array_type>(bytes), std::runtime_error);
+    }
+    SECTION("Misaligned view") {
+        const auto bytes = " " + to_binary(std::vector<double>{1.0});
+        BinaryReader reader(std::string_view(bytes).substr(1));
+        // The buffer is allocated aligned, so this offsets it by one byte
+        REQUIRE_THROWS_AS(reader.read<ArrayView<double>>(), std::runtime_error);
+    }
+    SECTION("Checkpoint and restart from a file") {
+        auto path = std::filesystem::temp_directory_path() /
+                    "utilities_binary_stl.bin";
+        std::vector<double> v(1000);
+        for(std::size_t i = 0; i < v.size(); ++i) v[i] = i * 0.5;
+        {
+            std::ofstream file(path, std::ios::binary);
+            BinaryWriter(file).write(std::string("step 42")).write(v);
+        }
+        utilities::strings::FileTokenizer file(path.string());
+        BinaryReader reader(file.contents());
+        REQUIRE(reader.read<std::string_view>() == "step 42");
+        auto view = reader.read<ArrayView<double>>();
+        REQUIRE(std::vector<double>(view.begin(), view.end()) == v);
+        REQUIRE(reader.done());
+    }
+}
+
+/* Compares writing and reading a map<string, vector<double>> in the binary
+ * format (reading it back both by copying and as views), for a million
+ * doubles by default.
+ */
+TEST_CASE("binary_stl benchmark", "[.][benchmark]") {
+    const auto n         = test_utilities::benchmark_count(1);
+    const std::size_t nv = 1000;
+    std::map<std::string, std::vector<double>> m;
+    for(std::size_t i = 0; i < n / nv; ++i)
+        m["key" + std::to_string(i)] = std::vector<double>(nv, 1.0 / (i + 1));
+    const auto bytes = to_binary(m);
+
+    BENCHMARK("write_binary") { return to_binary(m).size(); };
+
+    BENCHMARK("read_binary (copies)") {
+        return read_binary<std::map<std::string, std::vector<double>>>(bytes)
+          .size();
+    };
+
+    BENCHMARK("read_binary (views)") {
+        using view_map = std::map<std::string_view, ArrayView<double>>;
+        return read_binary<view_map>(bytes).size();
+    };
+}
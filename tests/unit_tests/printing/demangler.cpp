@@ -15,6 +15,7 @@
  */
 
 #include "../catch.hpp"
+#include <thread>
 #include <utilities/printing/demangler.hpp>
 #include <vector>
 
@@ -58,3 +59,36 @@ TEST_CASE("Demangler : string literal") {
     REQUIRE(Demangler::demangle(typeid(double).name()) == corr2);
     REQUIRE(Demangler::demangle(typeid(matrix_t).name()) == corr3);
 }
+
+TEST_CASE("Demangler : demangle_cached") {
+    SECTION("Same names as demangle") {
+        REQUIRE(Demangler::demangle_cached<int>() == corr1);
+        REQUIRE(Demangler::demangle_cached(typeid(double)) == corr2);
+        REQUIRE(Demangler::demangle_cached<matrix_t>() == corr3);
+    }
+    SECTION("Views are stable") {
+        auto name = Demangler::demangle_cached<matrix_t>();
+        for(int i = 0; i < 100; ++i) Demangler::demangle_cached<int>();
+        REQUIRE(Demangler::demangle_cached<matrix_t>().data() == name.data());
+    }
+    SECTION("Concurrent lookups") {
+        std::vector<std::thread> threads;
+        std::vector<std::string_view> names(8);
+        for(std::size_t i = 0; i < names.size(); ++i)
+            threads.emplace_back([&names, i]() {
+                names[i] = Demangler::demangle_cached<std::vector<char>>();
+            });
+        for(auto& t : threads) t.join();
+        for(auto name : names) REQUIRE(name.data() == names[0].data());
+    }
+}
+
+namespace type_name_test {
+struct Foo {};
+} // namespace type_name_test
+
+TEST_CASE("type_name") {
+    STATIC_REQUIRE(type_name<int>() == "int");
+    STATIC_REQUIRE(type_name<double>() == "double");
+    STATIC_REQUIRE(type_name<type_name_test::Foo>() == "type_name_test::Foo");
+}
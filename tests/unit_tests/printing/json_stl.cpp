@@ -0,0 +1,134 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../catch.hpp"
+#include <array>
+#include <deque>
+#include <forward_list>
+#include <limits>
+#include <list>
+#include <map>
+#include <optional>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stack>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utilities/printing/json_stl.hpp>
+#include <utility>
+#include <vector>
+
+using namespace utilities::printing;
+
+namespace {
+
+template<typename T>
+std::string to_json(const T& x) {
+    std::stringstream ss;
+    write_json(ss, x);
+    return ss.str();
+}
+
+} // namespace
+
+TEST_CASE("write_json") {
+    SECTION("Scalars") {
+        REQUIRE(to_json(true) == "true");
+        REQUIRE(to_json(false) == "false");
+        REQUIRE(to_json(42) == "42");
+        REQUIRE(to_json(-7l) == "-7");
+        REQUIRE(to_json(1.5) == "1.5");
+        REQUIRE(to_json(0.1) == "0.1");
+        REQUIRE(to_json(1e300) == "1e+300");
+        REQUIRE(to_json(std::numeric_limits<double>::infinity()) == "null");
+        REQUIRE(to_json(std::numeric_limits<double>::quiet_NaN()) == "null");
+        REQUIRE(to_json('a') == "\"a\"");
+    }
+    SECTION("Strings") {
+        REQUIRE(to_json(std::string("hello")) == "\"hello\"");
+        REQUIRE(to_json(std::string_view("")) == "\"\"");
+        REQUIRE(to_json("a\"b\\c") == "\"a\\\"b\\\\c\"");
+        REQUIRE(to_json(std::string("\n\t\r\b\f")) == "\"\\n\\t\\r\\b\\f\"");
+        REQUIRE(to_json(std::string("\x01 \x1f")) == "\"\\u0001 \\u001f\"");
+        REQUIRE(to_json(std::string("caf\xc3\xa9")) == "\"caf\xc3\xa9\"");
+    }
+    SECTION("Optional") {
+        REQUIRE(to_json(std::optional<int>{}) == "null");
+        REQUIRE(to_json(std::optional<int>{3}) == "3");
+    }
+    SECTION("Pair and tuple") {
+        REQUIRE(to_json(std::make_pair(1, std::string("a"))) == "[1,\"a\"]");
+        REQUIRE(to_json(std::make_tuple(1, 2.5, true)) == "[1,2.5,true]");
+        REQUIRE(to_json(std::tuple<>{}) == "[]");
+    }
+    SECTION("Sequences") {
+        REQUIRE(to_json(std::vector<int>{}) == "[]");
+        REQUIRE(to_json(std::vector<int>{1, 2, 3}) == "[1,2,3]");
+        REQUIRE(to_json(std::array<int, 2>{4, 5}) == "[4,5]");
+        REQUIRE(to_json(std::deque<int>{1, 2}) == "[1,2]");
+        REQUIRE(to_json(std::list<int>{1, 2}) == "[1,2]");
+        REQUIRE(to_json(std::forward_list<int>{1, 2}) == "[1,2]");
+        REQUIRE(to_json(std::set<int>{2, 1}) == "[1,2]");
+        REQUIRE(to_json(std::multiset<int>{1, 1}) == "[1,1]");
+        REQUIRE(to_json(std::unordered_set<int>{1}) == "[1]");
+        REQUIRE(to_json(std::vector<bool>{true, false}) == "[true,false]");
+    }
+    SECTION("Adaptors") {
+        std::queue<int> q;
+        std::stack<int> s;
+        for(auto x : {1, 2, 3}) {
+            q.push(x);
+            s.push(x);
+        }
+        REQUIRE(to_json(q) == "[1,2,3]");
+        REQUIRE(to_json(s) == "[1,2,3]");
+    }
+    SECTION("Maps") {
+        std::map<std::string, int> m{{"a", 1}, {"b", 2}};
+        REQUIRE(to_json(m) == "{\"a\":1,\"b\":2}");
+        std::unordered_map<std::string, int> um{{"a", 1}};
+        REQUIRE(to_json(um) == "{\"a\":1}");
+        std::map<int, std::string> im{{1, "a"}, {2, "b"}};
+        REQUIRE(to_json(im) == "[[1,\"a\"],[2,\"b\"]]");
+        std::multimap<std::string, int> mm{{"a", 1}, {"a", 2}};
+        REQUIRE(to_json(mm) == "[[\"a\",1],[\"a\",2]]");
+        REQUIRE(to_json(std::map<std::string, int>{}) == "{}");
+    }
+    SECTION("Nesting") {
+        std::map<std::string, std::vector<std::optional<double>>> m{
+          {"x", {1.0, std::nullopt}}, {"y", {}}};
+        REQUIRE(to_json(m) == "{\"x\":[1,null],\"y\":[]}");
+    }
+    SECTION("Output larger than the buffer") {
+        std::vector<std::string> v(1000, std::string(10, 'a'));
+        std::string corr = "[";
+        for(std::size_t i = 0; i < v.size(); ++i)
+            corr += (i ? ",\"" : "\"") + v[i] + "\"";
+        corr += "]";
+        REQUIRE(to_json(v) == corr);
+
+        std::string big(10000, 'b');
+        REQUIRE(to_json(big) == "\"" + big + "\"");
+    }
+    SECTION("Returns the stream") {
+        std::stringstream ss;
+        write_json(ss, 1) << " done";
+        REQUIRE(ss.str() == "1 done");
+    }
+}
@@ -14,18 +14,24 @@
  * limitations under the License.
  */
 
-#include "../catch.hpp"
+#include "../test_helpers.hpp"
 #include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <deque>
 #include <forward_list>
 #include <functional>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <optional>
 #include <queue>
 #include <set>
 #include <sstream>
 #include <stack>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -387,3 +393,292 @@ TEST_CASE("Container of non-printable objects") {
     corr << "<" << name << " " << &v[2] << ">]";
     REQUIRE(corr.str() == ss.str());
 }
+
+namespace {
+
+// Counts how many times instances have been copied
+struct CopyCounter {
+    explicit CopyCounter(int v) : value(v) {}
+    CopyCounter(const CopyCounter& other) : value(other.value) { ++ncopies; }
+    CopyCounter(CopyCounter&&)            = default;
+    CopyCounter& operator=(const CopyCounter&) = default;
+    bool operator<(const CopyCounter& rhs) const { return value < rhs.value; }
+    int value;
+    static inline int ncopies = 0;
+};
+
+std::ostream& operator<<(std::ostream& os, const CopyCounter& c) {
+    return os << c.value;
+}
+
+} // namespace
+
+TEST_CASE("Printing options") {
+    std::stringstream ss;
+    std::vector<int> v{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+
+    SECTION("max_elements") {
+        ss << max_elements(4) << v;
+        REQUIRE(ss.str() == "[1, 2, ..., 9, 10]");
+        ss.str("");
+        ss << max_elements(3) << v;
+        REQUIRE(ss.str() == "[1, 2, ..., 10]");
+        ss.str("");
+        ss << max_elements(1) << v;
+        REQUIRE(ss.str() == "[1, ...]");
+        ss.str("");
+        ss << max_elements(10) << v;
+        REQUIRE(ss.str() == "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]");
+        ss.str("");
+        ss << max_elements(0) << v;
+        REQUIRE(ss.str() == "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10]");
+    }
+    SECTION("max_elements applies to each container") {
+        std::vector<std::vector<int>> vv{v, {1}, v};
+        ss << max_elements(2) << vv;
+        REQUIRE(ss.str() == "[[1, ..., 10], ..., [1, ..., 10]]");
+    }
+    SECTION("max_elements with other containers") {
+        std::forward_list<int> f(v.begin(), v.end());
+        std::set<int> s(v.begin(), v.end());
+        std::map<int, int> m{{1, 2}, {3, 4}, {5, 6}};
+        ss << max_elements(2) << f << s << m;
+        REQUIRE(ss.str() == "[1, ..., 10]{1, ..., 10}{(1 : 2), ..., (5 : 6)}");
+    }
+    SECTION("max_elements with container adaptors") {
+        std::queue<int> q;
+        std::stack<int> s;
+        std::priority_queue<int> pq;
+        for(auto x : {3, 10, 1, 7, 2, 9, 5, 4, 8, 6}) {
+            q.push(x);
+            s.push(x);
+            pq.push(x);
+        }
+        ss << max_elements(4) << q << s << pq;
+        REQUIRE(ss.str() == "[3, 10, ..., 8, 6][6, 8, ..., 10, 3]"
+                            "[10, 9, ..., 2, 1]");
+    }
+    SECTION("priority_queue with ties") {
+        std::priority_queue<int> pq;
+        for(auto x : {2, 1, 2, 1, 2}) pq.push(x);
+        ss << pq << max_elements(4) << pq;
+        REQUIRE(ss.str() == "[2, 2, 2, 1, 1][2, 2, ..., 1, 1]");
+    }
+    SECTION("max_depth") {
+        std::vector<std::vector<int>> vv{{1, 2}, {}, {3}};
+        ss << max_depth(1) << vv;
+        REQUIRE(ss.str() == "[[...], [], [...]]");
+        ss.str("");
+        ss << max_depth(2) << vv;
+        REQUIRE(ss.str() == "[[1, 2], [], [3]]");
+        ss.str("");
+        std::map<int, std::set<int>> m{{1, {2}}};
+        ss << max_depth(1) << m;
+        REQUIRE(ss.str() == "{(1 : {...})}");
+    }
+    SECTION("element_precision") {
+        std::vector<double> d{3.14159, 2.71828};
+        ss << element_precision(3) << d << ' ' << 3.14159;
+        REQUIRE(ss.str() == "[3.14, 2.72] 3.14159");
+        ss.str("");
+        ss << element_precision(-1) << d;
+        REQUIRE(ss.str() == "[3.14159, 2.71828]");
+    }
+    SECTION("Container adaptors are not copied") {
+        std::queue<CopyCounter> q;
+        std::stack<CopyCounter> s;
+        std::priority_queue<CopyCounter> pq;
+        for(int i = 0; i < 3; ++i) {
+            q.emplace(i);
+            s.emplace(i);
+            pq.emplace(i);
+        }
+        CopyCounter::ncopies = 0;
+        ss << q << s << pq;
+        REQUIRE(ss.str() == "[0, 1, 2][2, 1, 0][2, 1, 0]");
+        REQUIRE(CopyCounter::ncopies == 0);
+    }
+}
+
+namespace {
+
+// Prints v the way print_stl did before output was buffered
+template<typename T>
+std::string reference(std::ostream& os, const std::vector<T>& v) {
+    std::stringstream ss;
+    ss.copyfmt(os);
+    ss << '[';
+    for(std::size_t i = 0; i < v.size(); ++i) ss << (i ? ", " : "") << v[i];
+    ss << ']';
+    return ss.str();
+}
+
+// Prints some text, containing a vector, when printed
+struct HasVector {
+    std::vector<int> v;
+
+    friend std::ostream& operator<<(std::ostream& os, const HasVector& x) {
+        using utilities::printing::operator<<;
+        return os << '<' << x.v << '>';
+    }
+};
+
+// Prints "ok", or throws if explode is set
+struct Bomb {
+    bool explode = false;
+
+    friend std::ostream& operator<<(std::ostream& os, const Bomb& x) {
+        if(x.explode) throw std::runtime_error("Boom");
+        return os << "ok";
+    }
+};
+
+// Records what is written to it, and how many calls it took
+class CountingBuf : public std::streambuf {
+public:
+    std::string chars;
+    std::size_t n_calls = 0;
+
+protected:
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        ++n_calls;
+        chars.append(s, n);
+        return n;
+    }
+    int_type overflow(int_type c) override {
+        ++n_calls;
+        if(!traits_type::eq_int_type(c, traits_type::eof()))
+            chars.push_back(traits_type::to_char_type(c));
+        return traits_type::not_eof(c);
+    }
+};
+
+} // namespace
+
+TEST_CASE("Buffered printing") {
+    std::stringstream ss;
+    std::vector<double> d{0.0, -1.5, 3.14159265358979, 1.0e-300, 6.02e23,
+                          std::numeric_limits<double>::infinity(), 123456789.0};
+    std::vector<long> l{0, -1, 42, std::numeric_limits<long>::min(),
+                        std::numeric_limits<long>::max()};
+
+    SECTION("Default formatting") {
+        ss << d << l;
+        REQUIRE(ss.str() == reference(ss, d) + reference(ss, l));
+    }
+    SECTION("Floating point formatting") {
+        for(auto f : {std::ios_base::fmtflags{}, std::ios_base::fixed,
+                      std::ios_base::scientific}) {
+            for(int p : {0, 1, 3, 17}) {
+                ss.str("");
+                ss.flags(f);
+                ss.precision(p);
+                ss << d;
+                REQUIRE(ss.str() == reference(ss, d));
+            }
+        }
+    }
+    SECTION("Flags to_chars can't reproduce") {
+        ss << std::hex << std::showbase << l;
+        REQUIRE(ss.str() == reference(ss, l));
+        ss.str("");
+        ss << std::dec << std::showpos << std::uppercase << l << d;
+        REQUIRE(ss.str() == reference(ss, l) + reference(ss, d));
+        ss.str("");
+        ss << std::noshowpos << std::hexfloat << d;
+        REQUIRE(ss.str() == reference(ss, d));
+    }
+    SECTION("Field width") {
+        std::vector<int> v{1, 2};
+        ss << std::setw(4) << v;
+        REQUIRE(ss.str() == "   [1, 2]");
+    }
+    SECTION("Strings and characters") {
+        std::vector<std::string> s{"hello", "", "world"};
+        std::vector<char> c{'a', 'b'};
+        std::vector<const char*> p{"x", "y"};
+        ss << s << c << p;
+        REQUIRE(ss.str() == "[hello, , world][a, b][x, y]");
+    }
+    SECTION("Elements which print containers") {
+        std::vector<HasVector> v{{{1, 2}}, {{}}, {{3}}};
+        ss << v;
+        REQUIRE(ss.str() == "[<[1, 2]>, <[]>, <[3]>]");
+    }
+    SECTION("Output is written once per container") {
+        std::map<std::string, std::vector<double>> m{{"a", {1.5, 2.5}},
+                                                     {"b", {}}};
+        CountingBuf buf;
+        std::ostream os(&buf);
+        os << m;
+        REQUIRE(buf.chars == "{(a : [1.5, 2.5]), (b : [])}");
+        REQUIRE(buf.n_calls == 1);
+    }
+    SECTION("Output is dropped if an element throws") {
+        std::vector<std::vector<double>> before{{1.5}, {2.5}};
+        std::vector<Bomb> v{{false}, {true}, {false}};
+        std::vector<std::pair<int, int>> p{{1, 2}};
+        using error_t = std::runtime_error;
+        REQUIRE_THROWS_AS(ss << std::make_pair(before, v), error_t);
+        // Buffered output was written before printing a Bomb, nothing after
+        REQUIRE(ss.str() == "([[1.5], [2.5]], [ok, ");
+
+        // The next container is printed normally
+        ss.str("");
+        ss << p;
+        REQUIRE(ss.str() == "[(1, 2)]");
+    }
+    SECTION("Printing from multiple threads") {
+        std::vector<std::string> results(4);
+        std::vector<std::thread> threads;
+        for(std::size_t i = 0; i < results.size(); ++i) {
+            threads.emplace_back([&results, i]() {
+                std::vector<std::size_t> v(1000, i);
+                std::stringstream tss;
+                for(int j = 0; j < 100; ++j) tss << v;
+                results[i] = tss.str();
+            });
+        }
+        for(auto& t : threads) t.join();
+        for(std::size_t i = 0; i < results.size(); ++i) {
+            std::stringstream corr;
+            std::vector<std::size_t> v(1000, i);
+            for(int j = 0; j < 100; ++j) corr << reference(corr, v);
+            REQUIRE(results[i] == corr.str());
+        }
+    }
+}
+
+/* Compares printing a map<string, vector<double>> with print_stl to printing
+ * it element by element with operator<<, for a million doubles by default.
+ */
+TEST_CASE("print_stl benchmark", "[.][benchmark]") {
+    const auto n         = test_utilities::benchmark_count(1);
+    const std::size_t nv = 1000;
+    std::map<std::string, std::vector<double>> m;
+    for(std::size_t i = 0; i < n / nv; ++i) {
+        auto& v = m["key" + std::to_string(i)];
+        for(std::size_t j = 0; j < nv; ++j) v.push_back(1.0 / (i + j + 1));
+    }
+
+    BENCHMARK("operator<< per element") {
+        std::stringstream ss;
+        ss << '{';
+        bool first = true;
+        for(const auto& [k, v] : m) {
+            ss << (first ? "(" : ", (") << k << " : [";
+            for(std::size_t i = 0; i < v.size(); ++i)
+                ss << (i ? ", " : "") << v[i];
+            ss << "])";
+            first = false;
+        }
+        ss << '}';
+        return ss.str().size();
+    };
+
+    BENCHMARK("print_stl") {
+        std::stringstream ss;
+        ss << m;
+        return ss.str().size();
+    };
+}
@@ -14,20 +14,38 @@
  * limitations under the License.
  */
 
-#include "../catch.hpp"
+#include "../test_helpers.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <utilities/printing/word_wrap_stream.hpp>
+#include <utilities/strings/string_tools.hpp>
+#include <vector>
 
 using namespace utilities::printing;
 
+namespace {
+
+// A stringbuf which counts how many times it has been flushed
+struct CountingBuf : std::stringbuf {
+    int sync() override {
+        ++nsyncs;
+        return std::stringbuf::sync();
+    }
+    int nsyncs = 0;
+};
+
+} // namespace
+
 TEST_CASE("WordWrapStream") {
     std::stringstream ss;
     std::stringstream corr;
     WordWrapStream p(&ss);
     SECTION("Short sentence") {
         const auto sen = "This is a short sentence under 80 characters long";
-        p << sen;
+        p << sen << std::flush;
         corr << sen;
         REQUIRE(ss.str() == corr.str());
     }
@@ -37,39 +55,266 @@ TEST_CASE("WordWrapStream") {
           " I am not";
         const auto p2 = "being even remotely terse while writing it out on the "
                         "computer screen.";
-        p << p1 + " " + p2;
+        p << p1 + " " + p2 << std::flush;
         corr << p1 << std::endl << p2;
         REQUIRE(ss.str() == corr.str());
     }
     SECTION("80+ character word") {
         const std::string p1 = "This sentence has a long string in it";
         const std::string p2(85, 'x');
-        p << p1 + " " + p2;
+        p << p1 + " " + p2 << std::flush;
         corr << p1 << std::endl << p2;
         REQUIRE(ss.str() == corr.str());
     }
     SECTION("Sentence with endline") {
         const std::string p1 = "This sentence has a linebreak in it.\n";
         const auto p2        = "This sentence should appear on the next line.";
-        p << p1 + p2;
+        p << p1 + p2 << std::flush;
         corr << p1 << p2;
         REQUIRE(ss.str() == corr.str());
     }
     SECTION("Leading spaces") {
         const std::string p1 = "  This sentence has leading spaces.";
-        p << p1;
+        p << p1 << std::flush;
         REQUIRE(ss.str() == p1);
     }
     SECTION("std::endl") {
         const std::string p1 = "Hello world";
-        p << p1 << std::endl << p1;
+        p << p1 << std::endl << p1 << std::flush;
         corr << p1 << std::endl << p1;
         REQUIRE(ss.str() == corr.str());
     }
     SECTION("Multiple lines leading spaces") {
         const std::string p1 = "  This sentence has leading spaces";
-        p << p1 << std::endl << p1;
+        p << p1 << std::endl << p1 << std::flush;
         corr << p1 << std::endl << p1;
         REQUIRE(ss.str() == corr.str());
     }
 }
+
+TEST_CASE("WordWrapStream (buffering)") {
+    CountingBuf buf;
+    std::ostream os(&buf);
+    WordWrapStream p(&os, 10);
+
+    SECTION("Partial lines wait for a flush") {
+        p << "Hello";
+        REQUIRE(buf.str().empty());
+        p << std::flush;
+        REQUIRE(buf.str() == "Hello");
+        REQUIRE(buf.nsyncs == 1);
+    }
+    SECTION("Line breaks do not flush") {
+        p << "one two three four five\nsix seven eight nine ten";
+        const std::string corr =
+          "one two\nthree four\nfive\nsix seven\neight nine\n";
+        REQUIRE(buf.nsyncs == 0);
+        REQUIRE(buf.str() == corr);
+        p.flush();
+        REQUIRE(buf.nsyncs == 1);
+        REQUIRE(buf.str() == corr + "ten");
+    }
+    SECTION("Words may span several writes") {
+        p << "abc de" << "f gh" << 'i' << "jk";
+        p.flush();
+        REQUIRE(buf.str() == "abc def\nghijk");
+    }
+    SECTION("Formatted output") {
+        p << 12345 << ' ' << 678910 << ' ' << 1.5;
+        p.flush();
+        REQUIRE(buf.str() == "12345\n678910 1.5");
+    }
+    SECTION("std::endl resets the line") {
+        p << "12345678" << std::endl << "1234 5678";
+        p.flush();
+        REQUIRE(buf.str() == "12345678\n1234 5678");
+    }
+    SECTION("Text written after a flush") {
+        p << "abc" << std::flush << " defghi jk";
+        p.flush();
+        REQUIRE(buf.str() == "abc defghi\njk");
+    }
+    SECTION("Words longer than a line") {
+        p << "a bcdefghijklmn op\nqrstuvwxyz0123 4";
+        p.flush();
+        REQUIRE(buf.str() == "a\nbcdefghijklmn\nop\nqrstuvwxyz0123\n4");
+    }
+    SECTION("Destructor writes the partial line") {
+        {
+            WordWrapStream p2(&os, 10);
+            p2 << "partial";
+        }
+        REQUIRE(buf.str() == "partial");
+        REQUIRE(buf.nsyncs == 0);
+    }
+}
+
+TEST_CASE("WordWrapStream (large output)") {
+    const std::string word = "lorem ";
+    std::string text;
+    for(std::size_t i = 0; i < 100000; ++i) text += word;
+
+    std::stringstream ss;
+    WordWrapStream p(&ss, 80);
+    p << text << std::flush;
+
+    const auto out = ss.str();
+    std::istringstream lines(out);
+    std::size_t nlines = 0;
+    for(std::string line; std::getline(lines, line); ++nlines)
+        REQUIRE(line.size() <= 80);
+    // 13 "lorem"s (77 chars + trailing space) fit on each 80 character line
+    REQUIRE(nlines == (100000 + 12) / 13);
+}
+
+TEST_CASE("WordWrapStream (thread-safe)") {
+    std::stringstream ss;
+    WordWrapStream p(&ss, 40, true);
+    REQUIRE(p.thread_safe());
+    REQUIRE_FALSE(WordWrapStream(&ss).thread_safe());
+
+    SECTION("Single thread behaves the same") {
+        p << "one two three four five six seven eight nine ten eleven\n";
+        REQUIRE(ss.str() ==
+                "one two three four five six seven eight\nnine ten eleven\n");
+    }
+    SECTION("Paragraphs are committed when they end") {
+        p << "Hello";
+        p << " world";
+        REQUIRE(ss.str().empty());
+        p << '\n';
+        REQUIRE(ss.str() == "Hello world\n");
+        p << "partial" << std::flush;
+        REQUIRE(ss.str() == "Hello world\npartial");
+    }
+    SECTION("Writers") {
+        WordWrapStream::Writer w1(p);
+        {
+            WordWrapStream::Writer w2(p);
+            w1 << "first writer";
+            w2 << "second writer\n";
+            REQUIRE(ss.str() == "second writer\n");
+            w2 << "unfinished";
+        }
+        // Destroying a Writer commits its partial paragraph
+        REQUIRE(ss.str() == "second writer\nunfinished");
+        w1 << '\n';
+        REQUIRE(ss.str() == "second writer\nunfinishedfirst writer\n");
+    }
+    SECTION("Writers need a thread-safe stream") {
+        WordWrapStream unsafe(&ss);
+        REQUIRE_THROWS_AS(WordWrapStream::Writer(unsafe),
+                          std::invalid_argument);
+    }
+    SECTION("Many threads") {
+        // Paragraph i of thread t is "ti.0 ti.1 ... ti.nwords-1", written a
+        // word at a time so the threads' writes are interleaved
+        const std::size_t nthreads = 8, nparagraphs = 200, nwords = 25;
+        std::vector<std::thread> threads;
+        for(std::size_t t = 0; t < nthreads; ++t) {
+            threads.emplace_back([&, t]() {
+                WordWrapStream::Writer out(p);
+                for(std::size_t i = 0; i < nparagraphs; ++i) {
+                    for(std::size_t w = 0; w < nwords; ++w) {
+                        if(w) out << ' ';
+                        out << t << i << '.' << w;
+                    }
+                    out << '\n';
+                }
+            });
+        }
+        for(auto& x : threads) x.join();
+
+        // Each paragraph's words must be contiguous and in order
+        using utilities::strings::split_string;
+        std::size_t nseen = 0;
+        std::string prev;
+        for(const auto& line : split_string(ss.str(), '\n')) {
+            REQUIRE(line.size() <= 40);
+            for(const auto& word : split_string(line, ' ')) {
+                const auto dot = word.find('.');
+                const auto w   = std::stoul(word.substr(dot + 1));
+                if(w == 0) {
+                    ++nseen;
+                } else {
+                    const auto prev_dot = prev.find('.');
+                    REQUIRE(prev.substr(0, prev_dot) == word.substr(0, dot));
+                    REQUIRE(std::stoul(prev.substr(prev_dot + 1)) == w - 1);
+                }
+                prev = word;
+            }
+        }
+        REQUIRE(nseen == nthreads * nparagraphs);
+    }
+}
+
+TEST_CASE("WordWrapStream (UTF-8 and whitespace)") {
+    std::stringstream ss;
+    WordWrapStream p(&ss, 10);
+
+    SECTION("Multi-byte characters count as one column") {
+        p << "αβγδε ζηθικ λμ" << std::flush;
+        REQUIRE(ss.str() == "αβγδε\nζηθικ λμ");
+    }
+    SECTION("Characters split across writes") {
+        const std::string text = "E = -1.5 Eₕ at θ = 104.5°";
+        for(auto c : text) p << c;
+        p << std::flush;
+        REQUIRE(ss.str() == "E = -1.5\nEₕ at θ =\n104.5°");
+    }
+    SECTION("Wide characters count as two columns") {
+        p << "水水水 水水" << std::flush;
+        REQUIRE(ss.str() == "水水水\n水水");
+    }
+    SECTION("Combining characters take up no columns") {
+        const std::string e = "e\xCC\x81"; // e with a combining acute accent
+        p << e + e + e + e + e + " " + e + e + e + e << std::flush;
+        REQUIRE(ss.str() == e + e + e + e + e + " " + e + e + e + e);
+    }
+    SECTION("Tabs are break points and advance to the next tab stop") {
+        p << "ab\tcd\tef" << std::flush;
+        REQUIRE(ss.str() == "ab\tcd\nef");
+    }
+    SECTION("Other whitespace is a break point") {
+        p << "abcdefgh\vijk" << std::flush;
+        REQUIRE(ss.str() == "abcdefgh\nijk");
+        ss.str("");
+        p << "\nabcdefghij\rk" << std::flush;
+        REQUIRE(ss.str() == "\nabcdefghij\nk");
+    }
+    SECTION("Sentences longer than 65535 bytes") {
+        WordWrapStream p2(&ss, 100000);
+        const std::string word(99, 'x');
+        std::string sentence;
+        for(std::size_t i = 0; i < 1001; ++i) sentence += word + " ";
+        p2 << sentence << std::flush;
+        const auto out = ss.str();
+        const auto nl  = out.find('\n');
+        // Words (with their space) are 100 columns, break after the 1000th
+        REQUIRE(nl == 99999);
+        REQUIRE(out.size() == sentence.size());
+    }
+}
+
+/* Measures the throughput of WordWrapStream by wrapping a large amount of
+ * text, 64 MB by default.
+ */
+TEST_CASE("WordWrapStream benchmark", "[.][benchmark]") {
+    const auto nbytes          = test_utilities::benchmark_bytes(64);
+    const std::string sentence =
+      "The SCF converged in 12 iterations to an energy of -76.0267 Hartree. ";
+
+    BENCHMARK("std::ostream") {
+        std::stringstream ss;
+        for(std::size_t n = 0; n < nbytes; n += sentence.size()) ss << sentence;
+        return ss.str().size();
+    };
+
+    BENCHMARK("WordWrapStream") {
+        std::stringstream ss;
+        WordWrapStream p(&ss);
+        for(std::size_t n = 0; n < nbytes; n += sentence.size()) p << sentence;
+        p.flush();
+        return ss.str().size();
+    };
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_helpers.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utilities/strings/file_tokenizer.hpp>
+#include <vector>
+
+using namespace utilities::strings;
+using view_vec = std::vector<std::string_view>;
+
+namespace {
+
+// Writes @p contents to a temporary file and returns the file's path
+std::string make_file(const std::string& name, const std::string& contents) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary) << contents;
+    return path.string();
+}
+
+} // namespace
+
+TEST_CASE("FileTokenizer") {
+    const std::string xyz =
+      "3\n\nO 0.0 0.0 0.0\nH  0.0 0.0 1.0\nH\t1.0 0.0 0.0";
+    auto path = make_file("utilities_file_tokenizer.xyz", xyz);
+
+    SECTION("Default ctor") {
+        FileTokenizer f;
+        REQUIRE(f.empty());
+        REQUIRE(f.size() == 0);
+        REQUIRE(f.lines().empty());
+    }
+
+    SECTION("Non-existent file") {
+        REQUIRE_THROWS_AS(FileTokenizer("not/a/real/file"), std::runtime_error);
+    }
+
+    SECTION("Empty file") {
+        FileTokenizer f(make_file("utilities_file_tokenizer.empty", ""));
+        REQUIRE(f.empty());
+        REQUIRE(f.lines().empty());
+    }
+
+    SECTION("contents") {
+        FileTokenizer f(path);
+        REQUIRE(f.size() == xyz.size());
+        REQUIRE(f.contents() == xyz);
+    }
+
+    SECTION("lines") {
+        FileTokenizer f(path, true);
+        view_vec lines;
+        for(auto line : f.lines()) lines.push_back(line);
+        REQUIRE(lines == view_vec{"3", "", "O 0.0 0.0 0.0", "H  0.0 0.0 1.0",
+                                  "H\t1.0 0.0 0.0"});
+    }
+
+    SECTION("fields") {
+        FileTokenizer f(path);
+        f.advise_sequential();
+        std::vector<view_vec> fields;
+        for(auto line : f.lines()) {
+            fields.emplace_back();
+            for(auto field : FileTokenizer::fields(line))
+                fields.back().push_back(field);
+        }
+        REQUIRE(fields.size() == 5);
+        REQUIRE(fields[1].empty());
+        REQUIRE(fields[3] == view_vec{"H", "0.0", "0.0", "1.0"});
+        REQUIRE(fields[4] == view_vec{"H", "1.0", "0.0", "0.0"});
+    }
+
+    SECTION("Move ctor") {
+        FileTokenizer f(path);
+        auto data = f.contents().data();
+        FileTokenizer f2(std::move(f));
+        REQUIRE(f2.contents().data() == data);
+        REQUIRE(f2.contents() == xyz);
+    }
+
+    SECTION("Move assignment") {
+        FileTokenizer f(path);
+        FileTokenizer f2;
+        auto pf2 = &(f2 = std::move(f));
+        REQUIRE(pf2 == &f2);
+        REQUIRE(f2.contents() == xyz);
+    }
+}
+
+/* Compares FileTokenizer to reading a file with std::ifstream + std::getline.
+ *
+ * The input is a synthetic geometry-like file (see
+ * test_utilities::benchmark_bytes, default 64 MB). To benchmark on a real
+ * file instead, point UTILITIES_BENCHMARK_FILE at it.
+ */
+TEST_CASE("FileTokenizer benchmark", "[.][benchmark]") {
+    std::string path;
+    if(auto p = std::getenv("UTILITIES_BENCHMARK_FILE")) {
+        path = p;
+    } else {
+        const auto nbytes = test_utilities::benchmark_bytes(64);
+        path = (std::filesystem::temp_directory_path() /
+                "utilities_file_tokenizer_benchmark.xyz")
+                 .string();
+        std::ofstream file(path);
+        const std::string line = "H  1.234567890  -0.987654321  2.468013579\n";
+        for(std::size_t i = 0; i < nbytes; i += line.size()) file << line;
+    }
+
+    BENCHMARK("ifstream + getline") {
+        std::ifstream file(path);
+        std::string line;
+        std::size_t nfields = 0;
+        while(std::getline(file, line)) {
+            std::istringstream ss(line);
+            std::string field;
+            while(ss >> field) ++nfields;
+        }
+        return nfields;
+    };
+
+    BENCHMARK("FileTokenizer") {
+        FileTokenizer file(path);
+        std::size_t nfields = 0;
+        for(auto line : file.lines())
+            for(auto field : FileTokenizer::fields(line)) {
+                (void)field;
+                ++nfields;
+            }
+        return nfields;
+    };
+
+    BENCHMARK("FileTokenizer (sequential)") {
+        FileTokenizer file(path, true);
+        std::size_t nfields = 0;
+        for(auto line : file.lines())
+            for(auto field : FileTokenizer::fields(line)) {
+                (void)field;
+                ++nfields;
+            }
+        return nfields;
+    };
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../test_helpers.hpp"
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <string>
+#include <utilities/strings/parallel_split.hpp>
+#include <utilities/strings/string_tools.hpp>
+#include <vector>
+
+using namespace utilities::strings;
+using view_vec   = std::vector<std::string_view>;
+using string_vec = std::vector<std::string>;
+
+namespace {
+
+// Runs parallel_split_string and deep copies the results
+template<typename... Args>
+string_vec psplit(Args&&... args) {
+    auto rv = parallel_split_string(std::forward<Args>(args)...);
+    return string_vec(rv.begin(), rv.end());
+}
+
+} // namespace
+
+TEST_CASE("parallel_split_string") {
+    SECTION("Empty string") {
+        REQUIRE(parallel_split_string("", "\n", 4, 1).empty());
+    }
+    SECTION("No delimiter") {
+        auto rv = parallel_split_string("Hi there", "\n", 4, 1);
+        REQUIRE(rv == view_vec{"Hi there"});
+    }
+    SECTION("Delimiter") {
+        auto rv = parallel_split_string("L1\nL2", '\n', 4, 1);
+        REQUIRE(rv == view_vec{"L1", "L2"});
+    }
+    SECTION("Mulit-character delimiter") {
+        auto rv = parallel_split_string("Hello", "ll", 4, 1);
+        REQUIRE(rv == view_vec{"He", "o"});
+    }
+    SECTION("Self-overlapping delimiter") {
+        const std::string str = "aaaXaaaaXa";
+        REQUIRE(psplit(str, "aa", 4, 1) == split_string(str, "aa"));
+    }
+    SECTION("Views alias the input") {
+        const std::string str = "L1\nL2\nL3";
+        auto rv               = parallel_split_string(str, '\n', 3, 1);
+        REQUIRE(rv[0].data() == str.data());
+        REQUIRE(rv[2].data() == str.data() + 6);
+    }
+    SECTION("Consistent with split_string") {
+        const std::vector<std::string> strs{
+          "\n",          "a\n",           "\na",
+          "a\n\nb",      "a\nb\n",        "\n\n\n\n",
+          "abc\ndefg\nhi\n\njklmnop\nq\nrstu\nvwxyz\n",
+          "no delimiter at all in this one"};
+        for(const auto& str : strs) {
+            const auto corr = split_string(str, '\n');
+            for(std::size_t nthreads : {1, 2, 3, 4, 7, 16, 64}) {
+                REQUIRE(psplit(str, '\n', nthreads, 1) == corr);
+            }
+        }
+        const std::string str = "k0, k1, k2,, k3, k4, k5, k6, k7, k8, k9, ";
+        const auto corr       = split_string(str, ", ");
+        for(std::size_t nthreads : {1, 2, 3, 4, 7, 16, 64}) {
+            REQUIRE(psplit(str, ", ", nthreads, 1) == corr);
+        }
+    }
+    SECTION("Default arguments") {
+        std::string str;
+        for(std::size_t i = 0; i < 1000; ++i) str += std::to_string(i) + "\n";
+        REQUIRE(psplit(str, '\n') == split_string(str, '\n'));
+    }
+}
+
+/* Compares parallel_split_string to split_string and to splitting serially
+ * with SplitView, on 256 MB of input by default.
+ */
+TEST_CASE("parallel_split_string benchmark", "[.][benchmark]") {
+    const auto nbytes        = test_utilities::benchmark_bytes(256);
+    const std::string line   = "H  1.234567890  -0.987654321  2.468013579\n";
+    std::string buffer;
+    buffer.reserve(nbytes + line.size());
+    while(buffer.size() < nbytes) buffer += line;
+
+    BENCHMARK("split_string") { return split_string(buffer, '\n').size(); };
+
+    BENCHMARK("SplitView") {
+        view_vec rv;
+        for(auto x : split_view(buffer, '\n')) rv.push_back(x);
+        return rv.size();
+    };
+
+    BENCHMARK("parallel_split_string") {
+        return parallel_split_string(buffer, '\n').size();
+    };
+}
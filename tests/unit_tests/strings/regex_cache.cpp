@@ -0,0 +1,117 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../catch.hpp"
+#include <thread>
+#include <utilities/strings/regex_cache.hpp>
+#include <vector>
+
+using namespace utilities::strings;
+
+TEST_CASE("RegexCache") {
+    RegexCache cache(2);
+
+    SECTION("Ctor") {
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.max_size() == 2);
+        REQUIRE(cache.hits() == 0);
+        REQUIRE(cache.misses() == 0);
+        REQUIRE(RegexCache{}.max_size() == RegexCache::default_max_size);
+    }
+
+    SECTION("get") {
+        auto r0 = cache.get("a+");
+        REQUIRE(std::regex_match("aaa", *r0));
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.misses() == 1);
+        REQUIRE(cache.hits() == 0);
+
+        SECTION("Hit returns same regex") {
+            auto r1 = cache.get("a+");
+            REQUIRE(r1 == r0);
+            REQUIRE(cache.size() == 1);
+            REQUIRE(cache.misses() == 1);
+            REQUIRE(cache.hits() == 1);
+        }
+
+        SECTION("Evicts least recently used") {
+            cache.get("b+");
+            cache.get("a+"); // a+ is now most recently used
+            cache.get("c+"); // evicts b+
+            REQUIRE(cache.size() == 2);
+            REQUIRE(cache.get("a+") == r0);
+            REQUIRE(cache.hits() == 2);
+            cache.get("b+");
+            REQUIRE(cache.misses() == 4);
+        }
+
+        SECTION("Evicted regex stays valid") {
+            cache.get("b+");
+            cache.get("c+");
+            REQUIRE(cache.get("a+") != r0);
+            REQUIRE(std::regex_match("aaa", *r0));
+        }
+    }
+
+    SECTION("Invalid pattern") {
+        REQUIRE_THROWS_AS(cache.get("("), std::regex_error);
+        REQUIRE(cache.size() == 0);
+    }
+
+    SECTION("set_max_size") {
+        cache.get("a+");
+        cache.get("b+");
+        cache.set_max_size(1);
+        REQUIRE(cache.max_size() == 1);
+        REQUIRE(cache.size() == 1);
+        cache.get("b+");
+        REQUIRE(cache.hits() == 1);
+
+        SECTION("Zero disables caching") {
+            cache.set_max_size(0);
+            REQUIRE(cache.size() == 0);
+            auto r = cache.get("a+");
+            REQUIRE(std::regex_match("a", *r));
+            REQUIRE(cache.size() == 0);
+        }
+    }
+
+    SECTION("clear") {
+        cache.get("a+");
+        cache.get("a+");
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.hits() == 0);
+        REQUIRE(cache.misses() == 0);
+    }
+
+    SECTION("Concurrent access") {
+        std::vector<std::thread> threads;
+        for(std::size_t i = 0; i < 4; ++i) {
+            threads.emplace_back([&cache, i]() {
+                for(std::size_t j = 0; j < 100; ++j)
+                    cache.get(std::to_string((i + j) % 3));
+            });
+        }
+        for(auto& t : threads) t.join();
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.hits() + cache.misses() == 400);
+    }
+
+    SECTION("global") {
+        REQUIRE(&RegexCache::global() == &RegexCache::global());
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../catch.hpp"
+#include <string>
+#include <utilities/strings/split_view.hpp>
+#include <utilities/strings/string_tools.hpp>
+#include <vector>
+
+using namespace utilities::strings;
+using view_vec = std::vector<std::string_view>;
+
+namespace {
+
+template<typename RangeType>
+view_vec to_vector(RangeType&& r) {
+    view_vec rv;
+    for(auto x : r) rv.push_back(x);
+    return rv;
+}
+
+} // namespace
+
+TEST_CASE("SplitView") {
+    SECTION("Empty string") {
+        auto v = split_view("", "\n");
+        REQUIRE(v.empty());
+        REQUIRE(v.begin() == v.end());
+    }
+    SECTION("No delimiter") {
+        auto rv = to_vector(split_view("Hi there", "\n"));
+        REQUIRE(rv == view_vec{"Hi there"});
+    }
+    SECTION("Delimiter") {
+        REQUIRE(to_vector(split_view("L1\nL2", '\n')) == view_vec{"L1", "L2"});
+    }
+    SECTION("Mulit-character delimiter") {
+        REQUIRE(to_vector(split_view("Hello", "ll")) == view_vec{"He", "o"});
+    }
+    SECTION("Empty delimiter") {
+        REQUIRE(to_vector(split_view("Hello", "")) == view_vec{"Hello"});
+    }
+    SECTION("Consistent with split_string") {
+        for(std::string str : {"\n", "a\n", "\na", "a\n\nb", "a\nb\n"}) {
+            auto corr = split_string(str, '\n');
+            auto rv   = to_vector(split_view(str, '\n'));
+            REQUIRE(view_vec(corr.begin(), corr.end()) == rv);
+        }
+    }
+    SECTION("Views alias the input") {
+        std::string str = "L1\nL2";
+        auto v          = split_view(str, '\n');
+        auto itr        = v.begin();
+        REQUIRE(itr->data() == str.data());
+        ++itr;
+        REQUIRE(itr->data() == str.data() + 3);
+        REQUIRE(++itr == v.end());
+    }
+    SECTION("Accessors") {
+        auto v = split_view("a,b", ',');
+        REQUIRE(v.str() == "a,b");
+        REQUIRE(v.delimiter() == ",");
+    }
+}
+
+TEST_CASE("WhitespaceSplitView") {
+    SECTION("Empty string") {
+        REQUIRE(split_whitespace("").empty());
+        REQUIRE(split_whitespace(" \t\r\n").empty());
+    }
+    SECTION("Single field") {
+        REQUIRE(to_vector(split_whitespace("H")) == view_vec{"H"});
+    }
+    SECTION("Runs of whitespace") {
+        auto corr = view_vec{"H", "0.0", "-1.5", "2.0"};
+        auto rv   = to_vector(split_whitespace("  H\t0.0   -1.5 2.0 \r"));
+        REQUIRE(rv == corr);
+    }
+    SECTION("Accessors") {
+        REQUIRE(split_whitespace("a b").str() == "a b");
+    }
+}
@@ -57,6 +57,49 @@ TEMPLATE_LIST_TEST_CASE("join_string", "", types) {
             auto rv = join_string(c, ' ');
             REQUIRE(rv == "Hello World");
         }
+
+        SECTION("Multi-character delimiter") {
+            auto rv = join_string(c, std::string(", "));
+            REQUIRE(rv == "Hello, World");
+        }
+
+        SECTION("joined_size") {
+            REQUIRE(joined_size(c, "") == 10);
+            REQUIRE(joined_size(c, ", ") == 12);
+        }
+
+        SECTION("Output iterator") {
+            char buffer[16] = {};
+            auto end        = join_string(c, ", ", buffer);
+            REQUIRE(end == buffer + 12);
+            REQUIRE(std::string(buffer) == "Hello, World");
+        }
+
+        SECTION("join_string_into") {
+            std::string buffer = "Greeting: ";
+            auto pbuffer       = &join_string_into(buffer, c, ' ');
+            REQUIRE(pbuffer == &buffer);
+            REQUIRE(buffer == "Greeting: Hello World");
+        }
+    }
+}
+
+TEST_CASE("join_string (lazy ranges)") {
+    SECTION("SplitView") {
+        auto rv = join_string(split_view("a,b,,c", ','), " + ");
+        REQUIRE(rv == "a + b +  + c");
+    }
+    SECTION("WhitespaceSplitView") {
+        REQUIRE(join_string(split_whitespace("  H  0.0\t1.0 "), ',') ==
+                "H,0.0,1.0");
+    }
+    SECTION("Round trip") {
+        const std::string str = "L1\nL2\n\nL4";
+        REQUIRE(join_string(split_view(str, '\n'), '\n') == str);
+    }
+    SECTION("Range of string literals") {
+        std::vector<const char*> c{"foo", "bar"};
+        REQUIRE(join_string(c, "+") == "foo+bar");
     }
 }
 
@@ -82,6 +125,21 @@ TEST_CASE("replace") {
         REQUIRE(rv == corr);
     }
 
+    SECTION("Replacement has a regex escape sequence") {
+        const std::string msg  = "Needle in a haystack";
+        auto rv                = replace("haystack", "[$&]", msg);
+        const std::string corr = "Needle in a [haystack]";
+        REQUIRE(rv == corr);
+    }
+
+    SECTION("Repeated patterns are cached") {
+        auto& cache      = RegexCache::global();
+        replace("a|b", "c", "abc");
+        const auto nhits = cache.hits();
+        replace("a|b", "c", "abc");
+        REQUIRE(cache.hits() == nhits + 1);
+    }
+
     // These last two unit tests are for one of the common use cases: index
     // annotation manipulations
     SECTION("Semicolon") {
@@ -135,4 +193,89 @@ TEST_CASE("toupper_string") {
         REQUIRE(toupper_string("This is a full sentence! (with a side note)") ==
                 "THIS IS A FULL SENTENCE! (WITH A SIDE NOTE)");
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("parse") {
+    SECTION("Integers") {
+        REQUIRE(parse<int>("42") == 42);
+        REQUIRE(parse<int>("-42") == -42);
+        REQUIRE(parse<int>("+42") == 42);
+        REQUIRE(parse<std::size_t>(" 7\n") == 7);
+        REQUIRE(parse<long>(std::string("123456789")) == 123456789l);
+    }
+    SECTION("Floating point") {
+        REQUIRE(parse<double>("1.5") == 1.5);
+        REQUIRE(parse<double>("-2.5e-3") == -2.5e-3);
+        REQUIRE(parse<double>("+.25") == 0.25);
+        REQUIRE(parse<float>("0.5") == 0.5f);
+        REQUIRE(parse<double>("\t3.0 ") == 3.0);
+    }
+    SECTION("Fortran exponents") {
+        REQUIRE(parse<double>("1.5D-03") == 1.5e-3);
+        REQUIRE(parse<double>("-2.0d+02") == -2.0e2);
+        REQUIRE(parse<double>("0.1000000000000000D+01") == 1.0);
+        std::string long_token = "1." + std::string(80, '0') + "D2";
+        REQUIRE(parse<double>(long_token) == 100.0);
+    }
+    SECTION("Round trips with format") {
+        for(double x : {0.1, 1.0 / 3.0, -6.02214076e23, 5e-324})
+            REQUIRE(parse<double>(format(x)) == x);
+    }
+    SECTION("Not a number") {
+        using except_t = std::invalid_argument;
+        REQUIRE_THROWS_AS(parse<int>(""), except_t);
+        REQUIRE_THROWS_AS(parse<int>("  "), except_t);
+        REQUIRE_THROWS_AS(parse<int>("abc"), except_t);
+        REQUIRE_THROWS_AS(parse<int>("1.5"), except_t);
+        REQUIRE_THROWS_AS(parse<int>("+-1"), except_t);
+        REQUIRE_THROWS_AS(parse<double>("1.0abc"), except_t);
+        REQUIRE_THROWS_AS(parse<double>("1.0 2.0"), except_t);
+        REQUIRE_THROWS_AS(parse<double>("D2"), except_t);
+    }
+    SECTION("Out of range") {
+        using except_t = std::out_of_range;
+        REQUIRE_THROWS_AS(parse<unsigned short>("70000"), except_t);
+        REQUIRE_THROWS_AS(parse<double>("1.0D+999"), except_t);
+    }
+}
+
+TEST_CASE("parse_all") {
+    SECTION("Into a contiguous array") {
+        double xs[3];
+        auto end = parse_all<double>(split_whitespace("1.0 2.5D0 -3"), xs);
+        REQUIRE(end == xs + 3);
+        REQUIRE(xs[0] == 1.0);
+        REQUIRE(xs[1] == 2.5);
+        REQUIRE(xs[2] == -3.0);
+    }
+    SECTION("Into a vector") {
+        string_vec tokens{"1", "2", "3"};
+        REQUIRE(parse_all<int>(tokens) == std::vector<int>{1, 2, 3});
+        REQUIRE(parse_all<int>(split_view("4,5", ',')) ==
+                std::vector<int>{4, 5});
+        REQUIRE(parse_all<int>(string_vec{}).empty());
+    }
+    SECTION("Bad token") {
+        string_vec tokens{"1", "two", "3"};
+        REQUIRE_THROWS_AS(parse_all<int>(tokens), std::invalid_argument);
+    }
+}
+
+TEST_CASE("format") {
+    SECTION("Integers") {
+        REQUIRE(format(42) == "42");
+        REQUIRE(format(-7l) == "-7");
+        REQUIRE(format(std::size_t{0}) == "0");
+    }
+    SECTION("Floating point") {
+        REQUIRE(format(1.5) == "1.5");
+        REQUIRE(format(0.1) == "0.1");
+        REQUIRE(format(-2.5e-10) == "-2.5e-10");
+        REQUIRE(format(0.5f) == "0.5");
+    }
+    SECTION("format_to") {
+        std::string buffer = "x = ";
+        format_to(std::back_inserter(buffer), 3.25);
+        REQUIRE(buffer == "x = 3.25");
+    }
+}
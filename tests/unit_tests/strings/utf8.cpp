@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 NWChemEx-Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../catch.hpp"
+#include <string>
+#include <utilities/strings/utf8.hpp>
+#include <vector>
+
+using namespace utilities::strings;
+
+namespace {
+
+// Decodes all of str with a Utf8Decoder
+std::vector<char32_t> decode(const std::string& str) {
+    Utf8Decoder decoder;
+    std::vector<char32_t> rv;
+    char32_t cps[2];
+    for(auto c : str) {
+        const auto n = decoder.push(c, cps);
+        rv.insert(rv.end(), cps, cps + n);
+    }
+    if(decoder.pending()) rv.push_back(Utf8Decoder::replacement);
+    return rv;
+}
+
+} // namespace
+
+TEST_CASE("code_point_width") {
+    REQUIRE(code_point_width(U'a') == 1);
+    REQUIRE(code_point_width(U' ') == 1);
+    REQUIRE(code_point_width(U'\t') == 0);
+    REQUIRE(code_point_width(0x7F) == 0);
+    REQUIRE(code_point_width(U'α') == 1);
+    REQUIRE(code_point_width(U'Å') == 1);
+    REQUIRE(code_point_width(0x0301) == 0); // Combining acute accent
+    REQUIRE(code_point_width(U'水') == 2);
+    REQUIRE(code_point_width(U'한') == 2);
+    REQUIRE(code_point_width(0x1F600) == 2); // Grinning face
+}
+
+TEST_CASE("Utf8Decoder") {
+    using cp_vec = std::vector<char32_t>;
+    const auto r = Utf8Decoder::replacement;
+
+    SECTION("ASCII") { REQUIRE(decode("Hi!") == cp_vec{U'H', U'i', U'!'}); }
+    SECTION("Multi-byte") {
+        REQUIRE(decode("αβ") == cp_vec{U'α', U'β'});
+        REQUIRE(decode("∑") == cp_vec{U'∑'});
+        REQUIRE(decode("水") == cp_vec{U'水'});
+        REQUIRE(decode("\xF0\x9F\x98\x80") == cp_vec{0x1F600});
+    }
+    SECTION("Split across pushes") {
+        Utf8Decoder decoder;
+        char32_t cps[2];
+        REQUIRE(decoder.push('\xCE', cps) == 0);
+        REQUIRE(decoder.pending());
+        REQUIRE(decoder.push('\xB1', cps) == 1);
+        REQUIRE(cps[0] == U'α');
+        REQUIRE_FALSE(decoder.pending());
+    }
+    SECTION("Malformed") {
+        REQUIRE(decode("\x80") == cp_vec{r});              // Stray continuation
+        REQUIRE(decode("\xCE" "a") == cp_vec{r, U'a'});    // Truncated
+        REQUIRE(decode("\xCE\xCE\xB1") == cp_vec{r, U'α'}); // Truncated
+        REQUIRE(decode("\xC0\xAF") == cp_vec{r});          // Overlong
+        REQUIRE(decode("\xED\xA0\x80") == cp_vec{r});      // Surrogate
+        REQUIRE(decode("\xFF") == cp_vec{r});              // Invalid lead
+        REQUIRE(decode("\xE2\x88") == cp_vec{r});          // Unfinished
+    }
+    SECTION("reset") {
+        Utf8Decoder decoder;
+        char32_t cps[2];
+        decoder.push('\xCE', cps);
+        decoder.reset();
+        REQUIRE_FALSE(decoder.pending());
+        REQUIRE(decoder.push('a', cps) == 1);
+        REQUIRE(cps[0] == U'a');
+    }
+}
+
+TEST_CASE("display_width") {
+    REQUIRE(display_width("") == 0);
+    REQUIRE(display_width("Hello world") == 11);
+    REQUIRE(display_width("E = 1.5 α") == 9);
+    REQUIRE(display_width("αβγ") == 3);
+    REQUIRE(display_width("e\xCC\x81") == 1); // e + combining acute
+    REQUIRE(display_width("水水") == 4);
+    REQUIRE(display_width("a\nb") == 2);
+    REQUIRE(display_width("\xCE") == 1);
+}
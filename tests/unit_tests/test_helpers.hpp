@@ -16,10 +16,46 @@
 
 #pragma once
 #include "catch.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <string>
 #include <type_traits>
 
 namespace test_utilities {
 
+/** @brief The size of a benchmark, in bytes.
+ *
+ *  Benchmarks are tagged "[.][benchmark]", so they are hidden unless
+ *  selected (e.g., by running the tests with "[benchmark]"). Benchmarks
+ *  whose size is an amount of data use this function; the size can be set
+ *  at runtime via the environment variable UTILITIES_BENCHMARK_MB.
+ *
+ *  @param[in] default_mb The size, in megabytes, if UTILITIES_BENCHMARK_MB
+ *                        is not set.
+ *
+ *  @return The size, in bytes.
+ */
+inline std::size_t benchmark_bytes(std::size_t default_mb) {
+    auto mb = std::getenv("UTILITIES_BENCHMARK_MB");
+    return (mb ? std::stoul(mb) : default_mb) * 1024ul * 1024ul;
+}
+
+/** @brief The size of a benchmark, in items.
+ *
+ *  Like benchmark_bytes, but for benchmarks whose size is a number of
+ *  operations or elements. The size can be set at runtime via the
+ *  environment variable UTILITIES_BENCHMARK_MILLIONS.
+ *
+ *  @param[in] default_millions The number of items, in millions, if
+ *                              UTILITIES_BENCHMARK_MILLIONS is not set.
+ *
+ *  @return The number of items.
+ */
+inline std::size_t benchmark_count(std::size_t default_millions) {
+    auto n = std::getenv("UTILITIES_BENCHMARK_MILLIONS");
+    return (n ? std::stoul(n) : default_millions) * 1000000ul;
+}
+
 template<typename T>
 void test_copy_ctor(T&& object2test) {
     using clean_type = std::decay_t<T>; // Was given a reference